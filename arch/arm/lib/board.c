@@ -42,6 +42,7 @@
 #include <asm-generic/sections.h>
 #include <command.h>
 #include <environment.h>
+#include <initcall.h>
 #include <malloc.h>
 #include <stdio_dev.h>
 #include <version.h>
@@ -223,8 +224,6 @@ static int arm_pci_init(void)
  * argument, and returns an integer return code, where 0 means
  * "continue" and != 0 means "fatal error, hang the system".
  */
-typedef int (init_fnc_t) (void);
-
 int print_cpuinfo(void);
 
 void __dram_init_banksize(void)
@@ -243,7 +242,7 @@ static int mark_bootstage(void)
 	return 0;
 }
 
-init_fnc_t *init_sequence[] = {
+init_fnc_t init_sequence[] = {
 #if defined(CONFIG_ARCH_CPU_INIT)
 	arch_cpu_init,		/* basic arch cpu dependent setup */
 #endif
@@ -279,7 +278,6 @@ init_fnc_t *init_sequence[] = {
 void board_init_f(ulong bootflag)
 {
 	bd_t *bd;
-	init_fnc_t **init_fnc_ptr;
 	gd_t *id;
 	ulong addr, addr_sp;
 #ifdef CONFIG_PRAM
@@ -307,11 +305,8 @@ void board_init_f(ulong bootflag)
 	gd->fdt_blob = (void *)getenv_ulong("fdtcontroladdr", 16,
 						(uintptr_t)gd->fdt_blob);
 
-	for (init_fnc_ptr = init_sequence; *init_fnc_ptr; ++init_fnc_ptr) {
-		if ((*init_fnc_ptr)() != 0) {
-			hang ();
-		}
-	}
+	if (initcall_run_list(init_sequence))
+		hang ();
 
 	debug("monitor len: %08lX\n", gd->mon_len);
 	/*
@@ -571,6 +566,10 @@ void board_init_r(gd_t *id, ulong dest_addr)
 #endif
 	mem_malloc_init (malloc_start, TOTAL_MALLOC_LEN);
 
+#if defined(CONFIG_OF_CONTROL) && defined(CONFIG_FDTDEC_INDEX)
+	fdtdec_index_init(gd->fdt_blob);
+#endif
+
 	bootstage_relocate();
 
 #if !defined(CONFIG_SYS_NO_FLASH)
@@ -737,6 +736,9 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	}
 #endif
 
+	/* Devices must be ready before anything can use them */
+	initcall_defer_wait(INITCALL_DEFER_ALL);
+
 	/* main_loop() can return to retry autoboot, if so just run it again. */
 	for (;;) {
 		main_loop();
@@ -220,13 +220,19 @@ static int bootm_linux_fdt(int machid, bootm_headers_t *images)
 
 	rd_len = images->rd_end - images->rd_start;
 	ret = boot_ramdisk_high(lmb, images->rd_start, rd_len,
-				initrd_start, initrd_end);
+				images->rd_comp, initrd_start, initrd_end);
 	if (ret)
 		return ret;
 
 	ret = boot_relocate_fdt(lmb, of_flat_tree, &of_size);
 	if (ret)
 		return ret;
+
+	/* Collect the fixups below and make them in one pass at the end */
+	ret = fdt_txn_begin(*of_flat_tree);
+	if (ret)
+		debug("FDT fixups will be made one by one: %s\n",
+		      fdt_strerror(ret));
 #ifdef CONFIG_OF_BOARD_SETUP
 	/* Call the board-specific fixup routine */
 	ret = ft_board_setup(*of_flat_tree, gd->bd);
@@ -234,6 +240,7 @@ static int bootm_linux_fdt(int machid, bootm_headers_t *images)
 	if (ret) {
 		printf("Failed to add board information to FDT: %s\n",
 			fdt_strerror(ret));
+		fdt_txn_abort();
 		return ret;	/* FDT_ERR_... */
 	}
 #endif
@@ -249,6 +256,12 @@ static int bootm_linux_fdt(int machid, bootm_headers_t *images)
 
 	fdt_initrd(*of_flat_tree, *initrd_start, *initrd_end, 1);
 
+	ret = fdt_txn_commit(*of_flat_tree, of_size);
+	if (ret) {
+		printf("Failed to update FDT: %s\n", fdt_strerror(ret));
+		return ret;
+	}
+
 	announce_and_cleanup();
 
 	kernel_entry(0, machid, *of_flat_tree);
@@ -97,7 +97,7 @@ int do_bootm_linux(int flag, int argc, char * const argv[], bootm_headers_t *ima
 
 	rd_len = images->rd_end - images->rd_start;
 	ret = boot_ramdisk_high (lmb, images->rd_start, rd_len,
-			&initrd_start, &initrd_end);
+			images->rd_comp, &initrd_start, &initrd_end);
 	if (ret)
 		goto error;
 
@@ -274,7 +274,8 @@ static int boot_body_linux(bootm_headers_t *images)
 		return ret;
 
 	rd_len = images->rd_end - images->rd_start;
-	ret = boot_ramdisk_high (lmb, images->rd_start, rd_len, initrd_start, initrd_end);
+	ret = boot_ramdisk_high (lmb, images->rd_start, rd_len,
+			images->rd_comp, initrd_start, initrd_end);
 	if (ret)
 		return ret;
 
@@ -18,7 +18,7 @@
 # MA 02111-1307 USA
 
 PLATFORM_CPPFLAGS += -DCONFIG_SANDBOX -D__SANDBOX__ -U_FORTIFY_SOURCE
-PLATFORM_LIBS += -lrt
+PLATFORM_LIBS += -lrt -lpthread
 
 # Move to unified board system later
 CONFIG_SYS_LEGACY_BOARD := y
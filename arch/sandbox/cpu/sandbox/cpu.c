@@ -20,6 +20,7 @@
  */
 
 #include <common.h>
+#include <cpu_work.h>
 #include <os.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -60,3 +61,34 @@ void *map_physmem(phys_addr_t paddr, unsigned long len, unsigned long flags)
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
 }
+
+#ifdef CONFIG_CPU_WORK
+/* Host threads stand in for the secondary CPUs of a real SoC */
+#define SANDBOX_WORK_THREADS	3
+
+static int work_threads;
+
+static void *sandbox_cpu_work(void *arg)
+{
+	struct cpu_work *work = arg;
+
+	work->fn(work->arg);
+	return NULL;
+}
+
+int arch_cpu_work_start(struct cpu_work *work)
+{
+	if (work_threads == SANDBOX_WORK_THREADS ||
+	    os_thread_start(&work->priv, sandbox_cpu_work, work))
+		return -1;
+	work_threads++;
+
+	return 0;
+}
+
+void arch_cpu_work_wait(struct cpu_work *work)
+{
+	os_thread_join(work->priv);
+	work_threads--;
+}
+#endif
@@ -22,6 +22,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <termios.h>
 #include <time.h>
@@ -269,6 +270,22 @@ int os_parse_args(struct sandbox_state *state, int argc, char *argv[])
 	return 0;
 }
 
+int os_thread_start(void **handlep, void *(*fn)(void *), void *arg)
+{
+	pthread_t thread;
+
+	if (pthread_create(&thread, NULL, fn, arg))
+		return -1;
+	*handlep = (void *)thread;
+
+	return 0;
+}
+
+void os_thread_join(void *handle)
+{
+	pthread_join((pthread_t)handle, NULL);
+}
+
 void os_detach_shared_memory(void)
 {
 	shmctl(shm_id, IPC_RMID, NULL);
@@ -27,6 +27,7 @@
 
 #include "asm/sandbox-spi.h"
 #include "asm/sandbox-mmc.h"
+#include "asm/sandbox-eth.h"
 
 #if !defined(ARRAY_SIZE)
 #define ARRAY_SIZE(_a) (sizeof(_a) / sizeof(_a[0]))
@@ -82,7 +83,8 @@ enum sandbox_memory_region {
 	D(SPI,	"SPI FLASH ROM")		\
 	D(KEYBOARD, "Keyboard")			\
 	D(MMC0, "MMC0")				\
-	D(MMC1, "MMC1")
+	D(MMC1, "MMC1")				\
+	D(ETH, "Ethernet")
 
 enum device_t {
 #define D(n, s) SB_##n,
@@ -112,6 +114,7 @@ struct doorbell_t {
 	__u32 exit;
 	struct spi_t spi;
 	struct mmc_t mmc[2];
+	struct eth_t eth;
 	struct doorbell_command_t cmd;
 };
 
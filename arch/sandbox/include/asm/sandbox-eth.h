@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+#ifndef __SANDBOX_ETH_H
+#define __SANDBOX_ETH_H
+
+/* Largest frame exchanged with the sandbox-daemon, including headers. */
+#define SANDBOX_ETH_MAX_FRAME	1536
+
+/* Commands understood by the sandbox-daemon Ethernet device. */
+#define SANDBOX_ETH_CMD_SEND	0	/* u-boot -> daemon: transmit frame */
+#define SANDBOX_ETH_CMD_RECV	1	/* daemon -> u-boot: fetch frame */
+
+struct eth_t {
+	unsigned eth_enabled;		/* sandbox-daemon -> u-boot. */
+	unsigned char enetaddr[6];	/* sandbox-daemon -> u-boot. */
+};
+#endif
@@ -21,6 +21,24 @@
 #ifndef __SANDBOX_SPI_H
 #define __SANDBOX_SPI_H
 
+/* Commands understood by the sandbox-daemon SPI device. */
+#define SANDBOX_SPI_CMD_READ	0	/* read from the backing file */
+#define SANDBOX_SPI_CMD_WRITE	1	/* write to the backing file */
+#define SANDBOX_SPI_CMD_ERASE	2	/* erase part of the backing file */
+#define SANDBOX_SPI_CMD_XFER	3	/* clock bytes through the emulator */
+
+/*
+ * SANDBOX_SPI_CMD_XFER arguments:
+ *   command_data[1]: flags below, the same values as SPI_XFER_*
+ *   command_data[2]: number of bytes, at most sizeof(dbc_buf)
+ *   command_data[3]: bus clock in Hz, 0 -> the emulated part's maximum
+ * Data out is taken from dbc_buf, data in is returned there.
+ */
+#define SANDBOX_SPI_XFER_BEGIN	0x01	/* assert chip select first */
+#define SANDBOX_SPI_XFER_END	0x02	/* deassert chip select after */
+#define SANDBOX_SPI_XFER_DUAL	0x04	/* bytes clocked on two lines */
+#define SANDBOX_SPI_XFER_QUAD	0x08	/* bytes clocked on four lines */
+
 struct spi_t {
 	char  vendor[32];	/* not NULL terminated */
 	__u32 page_size;
@@ -31,4 +49,7 @@ extern __u32   spi_page_size;
 extern __u32   spi_page_count;
 extern char   *spi_vendor;
 extern char   *spi_file;
+extern __u32   spi_id;		/* JEDEC ID returned by the emulator */
+extern char   *spi_timing;	/* Emulator timing model */
+extern char   *spi_trace;	/* File receiving the emulator I/O trace */
 #endif
@@ -39,6 +39,8 @@
 
 #include <common.h>
 #include <command.h>
+#include <fdtdec.h>
+#include <initcall.h>
 #include <malloc.h>
 #include <stdio_dev.h>
 #include <timestamp.h>
@@ -113,8 +115,6 @@ static int display_dram_config(void)
  * argument, and returns an integer return code, where 0 means
  * "continue" and != 0 means "fatal error, hang the system".
  */
-typedef int (init_fnc_t) (void);
-
 void __dram_init_banksize(void)
 {
 /* TODO(thutt): must be able to include 'sandbox-api.h' */
@@ -127,7 +127,7 @@ void __dram_init_banksize(void)
 void dram_init_banksize(void)
 	__attribute__((weak, alias("__dram_init_banksize")));
 
-init_fnc_t *init_sequence[] = {
+init_fnc_t init_sequence[] = {
 #if defined(CONFIG_ARCH_CPU_INIT)
 	arch_cpu_init,		/* basic arch cpu dependent setup */
 #endif
@@ -152,7 +152,6 @@ init_fnc_t *init_sequence[] = {
 
 void board_init_f(ulong bootflag)
 {
-	init_fnc_t **init_fnc_ptr;
 	uchar *mem;
 	unsigned long addr_sp, addr, size;
 	int attached;
@@ -170,10 +169,8 @@ void board_init_f(ulong bootflag)
 	gd->fdt_blob = (void *)(_end_ofs + _TEXT_BASE);
 #endif
 
-	for (init_fnc_ptr = init_sequence; *init_fnc_ptr; ++init_fnc_ptr) {
-		if ((*init_fnc_ptr)() != 0)
-			hang();
-	}
+	if (initcall_run_list(init_sequence))
+		hang();
 
 	size = CONFIG_SYS_SDRAM_SIZE;
 	attached = os_attach_shared_memory((void **)&mem);
@@ -247,6 +244,10 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	mem_malloc_init((ulong)gd->ram_buf + gd->ram_size - TOTAL_MALLOC_LEN,
 			TOTAL_MALLOC_LEN);
 
+#if defined(CONFIG_OF_CONTROL) && defined(CONFIG_FDTDEC_INDEX)
+	fdtdec_index_init(gd->fdt_blob);
+#endif
+
 	/* initialize environment */
 	env_relocate();
 
@@ -291,6 +292,9 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	post_run(NULL, POST_RAM | post_bootmode_get(0));
 #endif
 
+	/* Devices must be ready before anything can use them */
+	initcall_defer_wait(INITCALL_DEFER_ALL);
+
 	sandbox_main_loop_init();
 
 	/*
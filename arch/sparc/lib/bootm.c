@@ -136,7 +136,8 @@ int do_bootm_linux(int flag, int argc, char * const argv[], bootm_headers_t * im
 
 	if (rd_len) {
 		ret = boot_ramdisk_high(lmb, images->rd_start, rd_len,
-					&initrd_start, &initrd_end);
+					images->rd_comp, &initrd_start,
+					&initrd_end);
 		if (ret) {
 			puts("### Failed to relocate RAM disk\n");
 			goto error;
@@ -36,6 +36,7 @@
 #include <watchdog.h>
 #include <command.h>
 #include <environment.h>
+#include <initcall.h>
 #include <stdio_dev.h>
 #include <version.h>
 #include <malloc.h>
@@ -138,8 +139,6 @@ static void display_flash_config(ulong size)
  * argument, and returns an integer return code, where 0 means
  * "continue" and != 0 means "fatal error, hang the system".
  */
-typedef int (init_fnc_t) (void);
-
 int calculate_relocation_address(void);
 static int copy_uboot_to_ram(void);
 static int copy_fdt_to_ram(void);
@@ -153,7 +152,7 @@ static int do_bootstage_mark(void)
 	return 0;
 }
 
-init_fnc_t *init_sequence_f[] = {
+init_fnc_t init_sequence_f[] = {
 	cpu_init_f,
 	do_bootstage_mark,
 #ifdef CONFIG_OF_CONTROL
@@ -174,7 +173,7 @@ init_fnc_t *init_sequence_f[] = {
 	NULL,
 };
 
-init_fnc_t *init_sequence_r[] = {
+init_fnc_t init_sequence_r[] = {
 	cpu_init_r,		/* basic cpu dependent setup */
 	board_early_init_r,	/* basic board dependent setup */
 	dram_init,		/* configure available RAM banks */
@@ -295,7 +294,6 @@ static int do_elf_reloc_fixups(void)
 /* Load U-Boot into RAM, initialize BSS, perform relocation adjustments */
 void board_init_f(ulong boot_flags)
 {
-	init_fnc_t **init_fnc_ptr;
 
 /*
  * It's ok to have it on the stack as the stack is not going to be changed
@@ -319,10 +317,8 @@ void board_init_f(ulong boot_flags)
 	gd->fdt_blob = (void *)getenv_ulong("fdtcontroladdr", 16,
 						(uintptr_t)gd->fdt_blob);
 
-	for (init_fnc_ptr = init_sequence_f; *init_fnc_ptr; ++init_fnc_ptr) {
-		if ((*init_fnc_ptr)() != 0)
-			hang();
-	}
+	if (initcall_run_list(init_sequence_f))
+		hang();
 
 	printf("Relocating to %p\n", (void *)gd->relocaddr);
 
@@ -364,7 +360,6 @@ void board_init_r(gd_t *id, ulong dest_addr)
 #endif
 	static bd_t bd_data;
 	static gd_t gd_data;
-	init_fnc_t **init_fnc_ptr;
 
 	bootstage_mark(BOOTSTAGE_ID_BOARD_INIT_R);
 
@@ -384,10 +379,12 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	mem_malloc_init((((ulong)dest_addr - CONFIG_SYS_MALLOC_LEN)+3)&~3,
 			CONFIG_SYS_MALLOC_LEN);
 
-	for (init_fnc_ptr = init_sequence_r; *init_fnc_ptr; ++init_fnc_ptr) {
-		if ((*init_fnc_ptr)() != 0)
-			hang();
-	}
+#if defined(CONFIG_OF_CONTROL) && defined(CONFIG_FDTDEC_INDEX)
+	fdtdec_index_init(gd->fdt_blob);
+#endif
+
+	if (initcall_run_list(init_sequence_r))
+		hang();
 	bootstage_mark(BOOTSTAGE_ID_BOARD_INIT_SEQ);
 	if (board_init())
 		printf("Warning: board_init() failed\n");
@@ -526,6 +523,9 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	post_run(NULL, POST_RAM | post_bootmode_get(0));
 #endif
 
+	/* Devices must be ready before anything can use them */
+	initcall_defer_wait(INITCALL_DEFER_ALL);
+
 	bootstage_mark(BOOTSTAGE_ID_BOARD_DONE);
 
 	/* main_loop() can return to retry autoboot, if so just run it again. */
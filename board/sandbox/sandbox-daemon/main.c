@@ -33,6 +33,7 @@
 #include "sd_mmc.h"
 #include "sd_gpio.h"
 #include "sd_keyboard.h"
+#include "sd_eth.h"
 #include "asm/sandbox-api.h"
 
 
@@ -51,6 +52,9 @@ static void help(const char *program_name)
 		"  --spi-page-count:  SPI ROM total page count\n"
 		"  --spi-page-vendor: SPI ROM vendor name\n"
 		"  --spi-page-file:   SPI ROM backing file\n"
+		"  --spi-id:          SPI ROM JEDEC ID (default 0xef4017)\n"
+		"  --spi-timing:      SPI ROM timing model, 'hz=N,pp=us,...'\n"
+		"  --spi-trace:       File receiving the SPI ROM I/O trace\n"
 		"  --mmc-file:        MMC backing file\n"
 		"  --write-protect:   Set write protect switch\n"
 		"  --recovery:        Set recovery switch\n"
@@ -58,6 +62,8 @@ static void help(const char *program_name)
 		"  --lid:             Set lid  switch\n"
 		"  --power-off:       Set power switch\n"
 		"  --keyboard-file:   Set file holding keystrokes\n"
+		"  --eth-root:        Directory served over TFTP/NFS\n"
+		"  --eth-drop:        Drop every Nth Ethernet reply\n"
 		"\n", program_name);
 	exit(0);
 }
@@ -91,6 +97,13 @@ static void process_args(int argc, char * const argv[])
 		{ "power-off",		required_argument,	NULL,	267 },
 
 		{ "keyboard-file",	required_argument,	NULL,	268 },
+
+		{ "eth-root",		required_argument,	NULL,	269 },
+		{ "eth-drop",		required_argument,	NULL,	270 },
+
+		{ "spi-id",		required_argument,	NULL,	271 },
+		{ "spi-timing",		required_argument,	NULL,	272 },
+		{ "spi-trace",		required_argument,	NULL,	273 },
 		{ NULL,			no_argument,		NULL,	0 }
 	};
 	unsigned n_mmc_files = 0;
@@ -159,6 +172,26 @@ static void process_args(int argc, char * const argv[])
 			keyboard_file = strdup(optarg);
 			break;
 
+		case 269:
+			eth_root = strdup(optarg);
+			break;
+
+		case 270:
+			eth_drop_every = strtol(optarg, NULL, 0);
+			break;
+
+		case 271:
+			spi_id = strtoul(optarg, NULL, 0);
+			break;
+
+		case 272:
+			spi_timing = strdup(optarg);
+			break;
+
+		case 273:
+			spi_trace = strdup(optarg);
+			break;
+
 		default:
 			help(argv[0]);
 			break;
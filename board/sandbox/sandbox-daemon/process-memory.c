@@ -20,6 +20,7 @@
  */
 
 #include <assert.h>
+#include <sched.h>
 #include <stdio.h>
 #include <unistd.h>
 
@@ -27,20 +28,33 @@
 #include "sd_spi.h"
 #include "sd_mmc.h"
 #include "sd_keyboard.h"
+#include "sd_eth.h"
 #include "doorbell-command.h"
 #include "shared-memory.h"
 #include "asm/sandbox-api.h"
 
+/*
+ * Number of empty polls after a request before sleeping again.  SPI
+ * bus transfers arrive a few bytes at a time, and sleeping between
+ * them would dominate the time taken by flash operations.
+ */
+#define BUSY_POLLS	100000
+
 void process_memory(void)
 {
+	unsigned idle = BUSY_POLLS;
+
 	while (1) {
 		const struct doorbell_t *db = sandbox_get_doorbell();
 		struct doorbell_command_t *dbc = sandbox_get_doorbell_command();
 
-		if (db->exit)
+		if (db->exit) {
+			spi_finish();
 			cleanup_and_exit();
+		}
 
 		if (dbc->doorbell) {
+			idle = 0;
 			dbc->result = 0;
 
 			switch (dbc->device_id) {
@@ -57,6 +71,10 @@ void process_memory(void)
 				keyboard_command(dbc);
 				break;
 
+			case SB_ETH:
+				eth_command(dbc);
+				break;
+
 			default:
 				printf("Doorbell by unhandled device: %d\n",
 				       dbc->device_id);
@@ -64,7 +82,11 @@ void process_memory(void)
 			}
 			dbc->doorbell = 0;
 		}
-		usleep(100);	/* 0.10 seconds */
+		if (idle < BUSY_POLLS) {
+			++idle;
+			sched_yield();
+		} else
+			usleep(100);	/* 0.10 seconds */
 	}
 }
 
@@ -0,0 +1,653 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sandbox Ethernet device.
+ *
+ * Rather than bridging to a host interface, the daemon implements a
+ * tiny loopback network: every frame U-Boot transmits is answered by
+ * built-in ARP, ICMP echo, TFTP and NFSv2 responders serving files
+ * from the directory given with '--eth-root'.  This is enough to run
+ * 'tftpboot', 'nfs' and 'netbench' against the real net/ stack.
+ *
+ * Every Nth reply can be discarded ('--eth-drop') to exercise the
+ * retransmission paths of the protocols.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib.h"
+#include "asm/sandbox-api.h"
+#include "doorbell-command.h"
+#include "sd_eth.h"
+
+#define ETH_HDR_SIZE		14
+#define ETH_TYPE_IP		0x0800
+#define ETH_TYPE_ARP		0x0806
+
+#define IP_HDR_SIZE		20
+#define IP_PROTO_ICMP		1
+#define IP_PROTO_UDP		17
+#define UDP_HDR_SIZE		8
+
+#define ARP_OP_REQUEST		1
+#define ARP_OP_REPLY		2
+
+#define ICMP_ECHO_REPLY		0
+#define ICMP_ECHO_REQUEST	8
+
+#define TFTP_PORT		69
+#define TFTP_SESSION_PORT	3069
+#define TFTP_RRQ		1
+#define TFTP_DATA		3
+#define TFTP_ACK		4
+#define TFTP_ERROR		5
+#define TFTP_OACK		6
+#define TFTP_MAX_BLKSIZE	1468	/* Largest block fitting a frame */
+
+#define SUNRPC_PORT		111
+#define MOUNT_PORT		635
+#define NFS_PORT		2049
+#define PROG_PORTMAP		100000
+#define PROG_NFS		100003
+#define PROG_MOUNT		100005
+#define PORTMAP_GETPORT		3
+#define MOUNT_ADDENTRY		1
+#define MOUNT_UMOUNTALL		4
+#define NFS_LOOKUP		4
+#define NFS_READ		6
+#define NFS_FHSIZE		32
+#define NFS_FATTR_WORDS		17
+#define NFSERR_NOENT		2
+#define NFSERR_INVAL		22
+#define NFS_MAX_READ		1024	/* Largest read fitting a frame */
+
+#define ETH_QUEUE_LEN		32
+
+char *eth_root;
+unsigned eth_drop_every;
+
+static const unsigned char client_mac[6] = { 0x02, 0x00, 0x5e, 0, 0, 0x01 };
+static const unsigned char server_mac[6] = { 0x02, 0x00, 0x5e, 0, 0, 0xfe };
+
+struct frame {
+	unsigned len;
+	unsigned char data[SANDBOX_ETH_MAX_FRAME];
+};
+
+/* Frames waiting to be received by U-Boot */
+static struct frame queue[ETH_QUEUE_LEN];
+static unsigned queue_head, queue_tail;
+static unsigned n_replies;
+
+/* The single TFTP transfer in progress */
+static struct {
+	int fd;
+	unsigned blksize;
+	unsigned block;		/* Last block sent, not wrapped */
+	unsigned final;		/* Last block sent was short */
+} tftp = { .fd = -1 };
+
+/* The single NFS file open */
+static struct {
+	int fd;
+	char mount_path[256];
+} nfs = { .fd = -1 };
+
+static unsigned get16(const unsigned char *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static unsigned get32(const unsigned char *p)
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void put16(unsigned char *p, unsigned v)
+{
+	p[0] = v >> 8;
+	p[1] = v;
+}
+
+static void put32(unsigned char *p, unsigned v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static unsigned ip_checksum(const unsigned char *p, unsigned len)
+{
+	unsigned long sum = 0;
+
+	for (; len > 1; p += 2, len -= 2)
+		sum += get16(p);
+	if (len)
+		sum += p[0] << 8;
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return ~sum & 0xffff;
+}
+
+/**
+ * Obtains a frame buffer for a reply to U-Boot and fills in the
+ * Ethernet header.
+ *
+ * Result == NULL -> queue full, or reply deliberately dropped
+ * Result != NULL -> frame to be completed by the caller
+ */
+static struct frame *reply_frame(unsigned type)
+{
+	struct frame *f;
+	unsigned next = (queue_tail + 1) % ETH_QUEUE_LEN;
+
+	if (eth_drop_every && ++n_replies % eth_drop_every == 0) {
+		verbose("eth: dropping reply %u\n", n_replies);
+		return NULL;
+	}
+	if (next == queue_head) {
+		verbose("eth: receive queue full, dropping reply\n");
+		return NULL;
+	}
+
+	f = &queue[queue_tail];
+	queue_tail = next;
+	memcpy(f->data, client_mac, 6);
+	memcpy(f->data + 6, server_mac, 6);
+	put16(f->data + 12, type);
+	return f;
+}
+
+/**
+ * Fills in an IPv4 header at 'ip', which carries 'len' bytes of
+ * payload from 'src' to 'dst'.
+ */
+static void build_ip(unsigned char *ip, unsigned proto, unsigned src,
+		     unsigned dst, unsigned len)
+{
+	static unsigned id;
+
+	ip[0] = 0x45;
+	ip[1] = 0;
+	put16(ip + 2, IP_HDR_SIZE + len);
+	put16(ip + 4, ++id);
+	put16(ip + 6, 0x4000);	/* Don't fragment */
+	ip[8] = 64;
+	ip[9] = proto;
+	put16(ip + 10, 0);
+	put32(ip + 12, src);
+	put32(ip + 16, dst);
+	put16(ip + 10, ip_checksum(ip, IP_HDR_SIZE));
+}
+
+/**
+ * Queues a UDP datagram for U-Boot.  The UDP checksum is left as zero,
+ * as U-Boot does not check it.
+ */
+static void send_udp(unsigned src_ip, unsigned dst_ip, unsigned sport,
+		     unsigned dport, const void *payload, unsigned len)
+{
+	struct frame *f;
+	unsigned char *ip, *udp;
+
+	if (ETH_HDR_SIZE + IP_HDR_SIZE + UDP_HDR_SIZE + len >
+	    SANDBOX_ETH_MAX_FRAME)
+		return;
+
+	f = reply_frame(ETH_TYPE_IP);
+	if (!f)
+		return;
+
+	ip = f->data + ETH_HDR_SIZE;
+	udp = ip + IP_HDR_SIZE;
+	build_ip(ip, IP_PROTO_UDP, src_ip, dst_ip, UDP_HDR_SIZE + len);
+	put16(udp, sport);
+	put16(udp + 2, dport);
+	put16(udp + 4, UDP_HDR_SIZE + len);
+	put16(udp + 6, 0);
+	memcpy(udp + UDP_HDR_SIZE, payload, len);
+	f->len = ETH_HDR_SIZE + IP_HDR_SIZE + UDP_HDR_SIZE + len;
+}
+
+static void handle_arp(const unsigned char *arp, unsigned len)
+{
+	struct frame *f;
+	unsigned char *r;
+
+	if (len < 28 || get16(arp + 6) != ARP_OP_REQUEST)
+		return;
+
+	/* Gratuitous ARP, or a probe for U-Boot's own address */
+	if (!memcmp(arp + 14, arp + 24, 4))
+		return;
+
+	f = reply_frame(ETH_TYPE_ARP);
+	if (!f)
+		return;
+
+	r = f->data + ETH_HDR_SIZE;
+	memcpy(r, arp, 6);			/* htype, ptype, hlen, plen */
+	put16(r + 6, ARP_OP_REPLY);
+	memcpy(r + 8, server_mac, 6);		/* We are everybody */
+	memcpy(r + 14, arp + 24, 4);
+	memcpy(r + 18, arp + 8, 10);		/* Requester's MAC and IP */
+	f->len = ETH_HDR_SIZE + 28;
+}
+
+static void handle_icmp(const unsigned char *ip, unsigned len)
+{
+	const unsigned char *icmp = ip + IP_HDR_SIZE;
+	struct frame *f;
+	unsigned char *r;
+
+	if (len < IP_HDR_SIZE + 8 || icmp[0] != ICMP_ECHO_REQUEST ||
+	    ETH_HDR_SIZE + len > SANDBOX_ETH_MAX_FRAME)
+		return;
+
+	f = reply_frame(ETH_TYPE_IP);
+	if (!f)
+		return;
+
+	r = f->data + ETH_HDR_SIZE;
+	build_ip(r, IP_PROTO_ICMP, get32(ip + 16), get32(ip + 12),
+		 len - IP_HDR_SIZE);
+	memcpy(r + IP_HDR_SIZE, icmp, len - IP_HDR_SIZE);
+	r[IP_HDR_SIZE] = ICMP_ECHO_REPLY;
+	put16(r + IP_HDR_SIZE + 2, 0);
+	put16(r + IP_HDR_SIZE + 2,
+	      ip_checksum(r + IP_HDR_SIZE, len - IP_HDR_SIZE));
+	f->len = ETH_HDR_SIZE + len;
+}
+
+static int open_root_file(const char *dir, const char *name)
+{
+	char path[1024];
+
+	snprintf(path, sizeof(path), "%s/%s/%s", eth_root ? eth_root : ".",
+		 dir, name);
+	verbose("eth: opening '%s'\n", path);
+	return open(path, O_RDONLY);
+}
+
+static void tftp_error(unsigned src_ip, unsigned dst_ip, unsigned dport,
+		       unsigned code, const char *msg)
+{
+	unsigned char pkt[128];
+	unsigned len = strlen(msg) + 1;
+
+	put16(pkt, TFTP_ERROR);
+	put16(pkt + 2, code);
+	memcpy(pkt + 4, msg, len);
+	send_udp(src_ip, dst_ip, TFTP_SESSION_PORT, dport, pkt, 4 + len);
+}
+
+static void tftp_send_block(unsigned src_ip, unsigned dst_ip,
+			    unsigned dport, unsigned block)
+{
+	unsigned char pkt[4 + TFTP_MAX_BLKSIZE];
+	ssize_t n;
+
+	n = pread(tftp.fd, pkt + 4, tftp.blksize,
+		  (off_t)(block - 1) * tftp.blksize);
+	if (n < 0)
+		n = 0;
+
+	put16(pkt, TFTP_DATA);
+	put16(pkt + 2, block & 0xffff);
+	tftp.block = block;
+	tftp.final = n < (ssize_t)tftp.blksize;
+	send_udp(src_ip, dst_ip, TFTP_SESSION_PORT, dport, pkt, 4 + n);
+}
+
+static void tftp_rrq(unsigned src_ip, unsigned dst_ip, unsigned dport,
+		     const unsigned char *pkt, unsigned len)
+{
+	const char *p = (const char *)pkt + 2;
+	const char *end = (const char *)pkt + len;
+	unsigned char oack[128];
+	unsigned olen = 2;
+	struct stat st;
+
+	if (tftp.fd != -1)
+		close(tftp.fd);
+
+	tftp.fd = open_root_file("", p);
+	if (tftp.fd == -1 || fstat(tftp.fd, &st)) {
+		tftp_error(src_ip, dst_ip, dport, 1, "File not found");
+		return;
+	}
+	tftp.blksize = 512;
+
+	/* Skip filename and mode, then handle 'name\0value\0' options */
+	p += strlen(p) + 1;
+	if (p < end)
+		p += strlen(p) + 1;
+	put16(oack, TFTP_OACK);
+	while (p < end && olen < sizeof(oack) - 32) {
+		const char *value = p + strlen(p) + 1;
+
+		if (value >= end)
+			break;
+		if (!strcmp(p, "blksize")) {
+			tftp.blksize = strtoul(value, NULL, 10);
+			if (tftp.blksize > TFTP_MAX_BLKSIZE)
+				tftp.blksize = TFTP_MAX_BLKSIZE;
+			if (tftp.blksize < 8)
+				tftp.blksize = 8;
+			olen += sprintf((char *)oack + olen, "blksize%c%u",
+					0, tftp.blksize) + 1;
+		} else if (!strcmp(p, "tsize")) {
+			olen += sprintf((char *)oack + olen, "tsize%c%lu",
+					0, (unsigned long)st.st_size) + 1;
+		} else if (!strcmp(p, "timeout")) {
+			olen += sprintf((char *)oack + olen, "timeout%c%s",
+					0, value) + 1;
+		}
+		p = value + strlen(value) + 1;
+	}
+
+	tftp.block = 0;
+	tftp.final = 0;
+	if (olen > 2)
+		send_udp(src_ip, dst_ip, TFTP_SESSION_PORT, dport, oack, olen);
+	else
+		tftp_send_block(src_ip, dst_ip, dport, 1);
+}
+
+static void tftp_ack(unsigned src_ip, unsigned dst_ip, unsigned dport,
+		     const unsigned char *pkt, unsigned len)
+{
+	unsigned acked;
+
+	if (tftp.fd == -1 || len < 4)
+		return;
+
+	/* Recover the full block number from the 16-bit one acked */
+	acked = tftp.block - ((tftp.block - get16(pkt + 2)) & 0xffff);
+	if (acked == tftp.block && tftp.final) {
+		close(tftp.fd);
+		tftp.fd = -1;
+		return;
+	}
+
+	/* A repeated ACK makes us resend the block that went missing */
+	tftp_send_block(src_ip, dst_ip, dport, acked + 1);
+}
+
+static void handle_tftp(unsigned src_ip, unsigned dst_ip, unsigned sport,
+			unsigned dport, const unsigned char *pkt, unsigned len)
+{
+	if (len < 2)
+		return;
+
+	if (dport == TFTP_PORT && get16(pkt) == TFTP_RRQ)
+		tftp_rrq(dst_ip, src_ip, sport, pkt, len);
+	else if (dport == TFTP_SESSION_PORT && get16(pkt) == TFTP_ACK)
+		tftp_ack(dst_ip, src_ip, sport, pkt, len);
+}
+
+/**
+ * Fills in NFSv2 file attributes for an open file.
+ */
+static unsigned char *nfs_fattr(unsigned char *p, int fd)
+{
+	struct stat st;
+
+	memset(p, 0, NFS_FATTR_WORDS * 4);
+	if (fd == -1 || fstat(fd, &st))
+		return p + NFS_FATTR_WORDS * 4;
+
+	put32(p, 1);				/* NFREG */
+	put32(p + 4, st.st_mode);
+	put32(p + 8, st.st_nlink);
+	put32(p + 20, st.st_size);
+	put32(p + 24, 4096);			/* blocksize */
+	put32(p + 32, (st.st_size + 4095) / 4096);
+	put32(p + 40, st.st_ino);
+	return p + NFS_FATTR_WORDS * 4;
+}
+
+/**
+ * Handles an ONC RPC call to the portmapper, mount or NFS programs.
+ */
+static void handle_rpc(unsigned src_ip, unsigned dst_ip, unsigned sport,
+		       unsigned dport, const unsigned char *pkt, unsigned len)
+{
+	unsigned char reply[64 + NFS_FATTR_WORDS * 4 + NFS_MAX_READ];
+	const unsigned char *args, *end = pkt + len;
+	unsigned char *r = reply + 24;
+	unsigned prog, proc, n;
+
+	if (len < 32 || get32(pkt + 4) != 0)	/* Not a call */
+		return;
+
+	prog = get32(pkt + 12);
+	proc = get32(pkt + 20);
+
+	/* Skip credential and verifier */
+	args = pkt + 24;
+	args += 8 + ((get32(args + 4) + 3) & ~3);
+	if (args + 8 > end)
+		return;
+	args += 8 + ((get32(args + 4) + 3) & ~3);
+	if (args > end)
+		return;
+
+	memcpy(reply, pkt, 4);			/* xid */
+	put32(reply + 4, 1);			/* reply */
+	memset(reply + 8, 0, 16);		/* accepted, AUTH_NONE, ok */
+
+	if (prog == PROG_PORTMAP && proc == PORTMAP_GETPORT) {
+		if (args + 4 > end)
+			return;
+		switch (get32(args)) {
+		case PROG_MOUNT:
+			put32(r, MOUNT_PORT);
+			break;
+		case PROG_NFS:
+			put32(r, NFS_PORT);
+			break;
+		default:
+			put32(r, 0);
+			break;
+		}
+		r += 4;
+	} else if (prog == PROG_MOUNT && proc == MOUNT_ADDENTRY) {
+		if (args + 4 > end)
+			return;
+		n = get32(args);
+		if (n >= sizeof(nfs.mount_path) || args + 4 + n > end)
+			n = 0;
+		memcpy(nfs.mount_path, args + 4, n);
+		nfs.mount_path[n] = '\0';
+		put32(r, 0);
+		memset(r + 4, 0, NFS_FHSIZE);
+		r += 4 + NFS_FHSIZE;
+	} else if (prog == PROG_MOUNT && proc == MOUNT_UMOUNTALL) {
+		if (nfs.fd != -1)
+			close(nfs.fd);
+		nfs.fd = -1;
+	} else if (prog == PROG_NFS && proc == NFS_LOOKUP) {
+		char name[256];
+
+		if (args + NFS_FHSIZE + 4 > end)
+			return;
+		n = get32(args + NFS_FHSIZE);
+		if (n >= sizeof(name) || args + NFS_FHSIZE + 4 + n > end)
+			return;
+		memcpy(name, args + NFS_FHSIZE + 4, n);
+		name[n] = '\0';
+
+		if (nfs.fd != -1)
+			close(nfs.fd);
+		nfs.fd = open_root_file(nfs.mount_path, name);
+		if (nfs.fd == -1) {
+			put32(r, NFSERR_NOENT);
+			r += 4;
+		} else {
+			put32(r, 0);
+			memset(r + 4, 0, NFS_FHSIZE);
+			put32(r + 4, 1);
+			r = nfs_fattr(r + 4 + NFS_FHSIZE, nfs.fd);
+		}
+	} else if (prog == PROG_NFS && proc == NFS_READ) {
+		unsigned offset, count;
+		ssize_t got;
+
+		if (args + NFS_FHSIZE + 8 > end)
+			return;
+		offset = get32(args + NFS_FHSIZE);
+		count = get32(args + NFS_FHSIZE + 4);
+		if (count > NFS_MAX_READ)
+			count = NFS_MAX_READ;
+
+		if (nfs.fd == -1) {
+			put32(r, NFSERR_INVAL);
+			r += 4;
+		} else {
+			put32(r, 0);
+			r = nfs_fattr(r + 4, nfs.fd);
+			got = pread(nfs.fd, r + 4, count, offset);
+			if (got < 0)
+				got = 0;
+			put32(r, got);
+			memset(r + 4 + got, 0, 3);
+			r += 4 + ((got + 3) & ~3);
+		}
+	} else {
+		put32(reply + 20, 3);		/* PROC_UNAVAIL */
+	}
+
+	send_udp(src_ip, dst_ip, dport, sport, reply, r - reply);
+}
+
+static void handle_ip(const unsigned char *ip, unsigned len)
+{
+	const unsigned char *udp;
+	unsigned src_ip, dst_ip, sport, dport, ulen;
+
+	if (len < IP_HDR_SIZE || ip[0] != 0x45)
+		return;
+	if (get16(ip + 2) < len)
+		len = get16(ip + 2);
+
+	if (ip[9] == IP_PROTO_ICMP) {
+		handle_icmp(ip, len);
+		return;
+	}
+	if (ip[9] != IP_PROTO_UDP || len < IP_HDR_SIZE + UDP_HDR_SIZE)
+		return;
+
+	src_ip = get32(ip + 12);
+	dst_ip = get32(ip + 16);
+	udp = ip + IP_HDR_SIZE;
+	sport = get16(udp);
+	dport = get16(udp + 2);
+	ulen = get16(udp + 4);
+	if (ulen < UDP_HDR_SIZE || IP_HDR_SIZE + ulen > len)
+		return;
+	ulen -= UDP_HDR_SIZE;
+
+	switch (dport) {
+	case TFTP_PORT:
+	case TFTP_SESSION_PORT:
+		handle_tftp(src_ip, dst_ip, sport, dport,
+			    udp + UDP_HDR_SIZE, ulen);
+		break;
+
+	case SUNRPC_PORT:
+	case MOUNT_PORT:
+	case NFS_PORT:
+		handle_rpc(dst_ip, src_ip, sport, dport,
+			   udp + UDP_HDR_SIZE, ulen);
+		break;
+	}
+}
+
+static void eth_send(struct doorbell_command_t *dbc)
+{
+	const unsigned char *frame = dbc->dbc_buf;
+	unsigned len = dbc->command_data[1];
+
+	if (len < ETH_HDR_SIZE || len > SANDBOX_ETH_MAX_FRAME) {
+		command_failure(dbc, SB_ETH);
+		return;
+	}
+
+	switch (get16(frame + 12)) {
+	case ETH_TYPE_ARP:
+		handle_arp(frame + ETH_HDR_SIZE, len - ETH_HDR_SIZE);
+		break;
+	case ETH_TYPE_IP:
+		handle_ip(frame + ETH_HDR_SIZE, len - ETH_HDR_SIZE);
+		break;
+	}
+}
+
+static void eth_recv(struct doorbell_command_t *dbc)
+{
+	struct frame *f;
+
+	dbc->command_data[1] = 0;
+	if (queue_head == queue_tail)
+		return;
+
+	f = &queue[queue_head];
+	queue_head = (queue_head + 1) % ETH_QUEUE_LEN;
+	memcpy(dbc->dbc_buf, f->data, f->len);
+	dbc->command_data[1] = f->len;
+}
+
+void eth_initialize(struct doorbell_t *db)
+{
+	if (eth_root == NULL)
+		return;		/* No Ethernet enabled */
+
+	db->eth.eth_enabled = 1;
+	memcpy(db->eth.enetaddr, client_mac, sizeof(db->eth.enetaddr));
+}
+
+void eth_command(struct doorbell_command_t *dbc)
+{
+	unsigned command = dbc->command_data[0];
+
+	switch (command) {
+	case SANDBOX_ETH_CMD_SEND:
+		eth_send(dbc);
+		break;
+
+	case SANDBOX_ETH_CMD_RECV:
+		eth_recv(dbc);
+		break;
+
+	default:
+		fprintf(stderr, "Unhandled Ethernet command '%u'\n", command);
+		command_failure(dbc, SB_ETH);
+		break;
+	}
+}
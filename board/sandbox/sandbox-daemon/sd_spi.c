@@ -38,11 +38,15 @@
 #include "doorbell-command.h"
 #include "asm/sandbox-api.h"
 #include "sd_spi.h"
+#include "sd_spi_flash.h"
 
 __u32 spi_page_size;		/* page size in bytes */
 __u32 spi_page_count;		/* number of pages */
 char *spi_vendor;
 char *spi_file;
+__u32 spi_id = 0xef4017;	/* Winbond W25Q64 */
+char *spi_timing;
+char *spi_trace;
 
 int validate_spi_arguments(void)
 {
@@ -73,6 +77,18 @@ int validate_spi_arguments(void)
 		fprintf(stderr, "--spi-file was not set.\n");
 		++error;
 	}
+
+	if (spi_page_size & (spi_page_size - 1) || spi_page_size > 4096) {
+		fprintf(stderr, "--spi-page-size must be a power of two, "
+			"at most 4096.\n");
+		++error;
+	}
+
+	if (spi_timing != NULL && spi_flash_emul_set_timing(spi_timing)) {
+		fprintf(stderr, "--spi-timing '%s' is not valid.\n",
+			spi_timing);
+		++error;
+	}
 	return error;
 }
 
@@ -85,6 +101,16 @@ void initialize_spi(struct doorbell_t *db)
 	db->spi.n_pages	  = spi_page_count;
 	strncpy(&db->spi.vendor[0], spi_vendor,
 		sizeof(db->spi.vendor) / sizeof(db->spi.vendor[0]));
+
+	if (spi_flash_emul_init(spi_page_size * spi_page_count,
+				spi_page_size))
+		fatal("Unable to set up the SPI flash emulator");
+}
+
+void spi_finish(void)
+{
+	if (spi_vendor != NULL)
+		spi_flash_emul_finish();
 }
 
 /* open_spi_file: Open SPI file.  Creates file if it does not exist. */
@@ -213,6 +239,12 @@ void spi_command(struct doorbell_command_t *dbc)
 	unsigned len = dbc->command_data[2];
 	void *buf = (void *)(uintptr_t)dbc->command_data[3];
 
+	/* Bus transfers are too frequent to log */
+	if (command == SANDBOX_SPI_CMD_XFER) {
+		spi_flash_emul_xfer(dbc);
+		return;
+	}
+
 	verbose("SPI command: [%#x, %#x, %#x, %p]\n",
 		command, offset, len, buf);
 
@@ -224,15 +256,15 @@ void spi_command(struct doorbell_command_t *dbc)
 	}
 
 	switch (command) {
-	case 0:
+	case SANDBOX_SPI_CMD_READ:
 		spi_read(dbc, fd, offset, len, buf);
 		break;
 
-	case 1:
+	case SANDBOX_SPI_CMD_WRITE:
 		spi_write(dbc, fd, offset, len, buf);
 		break;
 
-	case 2:
+	case SANDBOX_SPI_CMD_ERASE:
 		spi_erase(dbc, fd, offset, len);
 		break;
 
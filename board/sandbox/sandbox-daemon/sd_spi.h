@@ -42,4 +42,9 @@ void initialize_spi(struct doorbell_t *db);
  * @param dbc	Pointer to doorbell command data
  */
 void spi_command(struct doorbell_command_t *dbc);
+
+/**
+ * Completes the SPI flash emulator's trace before the daemon exits.
+ */
+void spi_finish(void);
 #endif
@@ -0,0 +1,770 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sandbox SPI flash emulator.
+ *
+ * The sandbox SPI bus driver hands every spi_xfer() to the daemon, and
+ * this file decodes the bytes the way a serial NOR flash would: the
+ * opcode, address and dummy bytes of each command, then its data.
+ * Reads (including fast, dual and quad reads), page programs, 4K, 32K
+ * and 64K erases, the status registers, JEDEC ID and SFDP are
+ * emulated, so the whole of drivers/mtd/spi runs against it.
+ *
+ * Programs and erases only clear or set bits as on a real part, and
+ * keep the part busy for the time given by the timing model;
+ * commands other than status reads are ignored while it is busy.
+ * Time is emulated rather than measured: every byte on the bus costs
+ * 8 / lanes clock cycles, so results do not depend on the host.
+ *
+ * With '--spi-trace' one line is written per command, followed by a
+ * summary of the run when U-Boot exits.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lib.h"
+#include "asm/sandbox-api.h"
+#include "doorbell-command.h"
+#include "sd_spi_flash.h"
+
+#define SR1_WIP			(1 << 0)
+#define SR1_WEL			(1 << 1)
+#define SR1_QE_MX		(1 << 6)	/* Macronix quad enable */
+#define SR2_QE			(1 << 1)
+
+#define JEDEC_MFR_MACRONIX	0xc2
+
+#define PS_PER_SEC		1000000000000ULL
+#define PS_PER_US		1000000ULL
+
+#define SFDP_BFPT_OFFSET	0x30
+#define SFDP_BFPT_DWORDS	16
+#define SFDP_SIZE		(SFDP_BFPT_OFFSET + SFDP_BFPT_DWORDS * 4)
+
+enum op_kind {
+	OP_READ,
+	OP_PROGRAM,
+	OP_ERASE,
+	OP_STATUS1,
+	OP_STATUS2,
+	OP_WRITE_STATUS,
+	OP_WRITE_ENABLE,
+	OP_WRITE_DISABLE,
+	OP_READ_ID,
+	OP_READ_SFDP,
+};
+
+/* Trace flags; a command with any of these set had no effect */
+#define TRACE_BUSY		(1 << 0)	/* part was busy */
+#define TRACE_NO_WEL		(1 << 1)	/* write enable not set */
+#define TRACE_LANES		(1 << 2)	/* wrong number of lines */
+#define TRACE_NO_QE		(1 << 3)	/* quad enable not set */
+#define TRACE_SHORT		(1 << 4)	/* address incomplete */
+#define TRACE_UNKNOWN		(1 << 5)	/* opcode not emulated */
+
+static const char * const trace_flag_names[] = {
+	"busy", "no-wel", "lanes", "no-qe", "short", "unknown",
+};
+
+struct flash_op {
+	unsigned char opcode;
+	const char *name;
+	enum op_kind kind;
+	unsigned char addr_bytes;
+	unsigned char dummy_bytes;
+	unsigned char addr_lanes;	/* lines for address and dummy */
+	unsigned char data_lanes;
+	unsigned erase_size;		/* 0 -> whole chip */
+	unsigned char mfr;		/* only this maker's parts, if set */
+};
+
+static const struct flash_op flash_ops[] = {
+	{ 0x01, "wrsr",    OP_WRITE_STATUS,  0, 0, 1, 1 },
+	{ 0x02, "pp",      OP_PROGRAM,       3, 0, 1, 1 },
+	{ 0x03, "read",    OP_READ,          3, 0, 1, 1 },
+	{ 0x04, "wrdi",    OP_WRITE_DISABLE, 0, 0, 1, 1 },
+	{ 0x05, "rdsr",    OP_STATUS1,       0, 0, 1, 1 },
+	{ 0x06, "wren",    OP_WRITE_ENABLE,  0, 0, 1, 1 },
+	{ 0x0b, "fread",   OP_READ,          3, 1, 1, 1 },
+	{ 0x0c, "fread4b", OP_READ,          4, 1, 1, 1 },
+	{ 0x12, "pp4b",    OP_PROGRAM,       4, 0, 1, 1 },
+	{ 0x13, "read4b",  OP_READ,          4, 0, 1, 1 },
+	{ 0x20, "se",      OP_ERASE,         3, 0, 1, 1, 4 << 10 },
+	{ 0x21, "se4b",    OP_ERASE,         4, 0, 1, 1, 4 << 10 },
+	{ 0x35, "rdsr2",   OP_STATUS2,       0, 0, 1, 1 },
+	{ 0x3b, "dread",   OP_READ,          3, 1, 1, 2 },
+	{ 0x3c, "dread4b", OP_READ,          4, 1, 1, 2 },
+	{ 0x52, "be32",    OP_ERASE,         3, 0, 1, 1, 32 << 10 },
+	{ 0x5a, "rdsfdp",  OP_READ_SFDP,     3, 1, 1, 1 },
+	/* Winbond and Spansion parts have no 4-byte 32K erase */
+	{ 0x5c, "be32_4b", OP_ERASE,         4, 0, 1, 1, 32 << 10,
+	  JEDEC_MFR_MACRONIX },
+	{ 0x60, "ce",      OP_ERASE,         0, 0, 1, 1, 0 },
+	{ 0x6b, "qread",   OP_READ,          3, 1, 1, 4 },
+	{ 0x6c, "qread4b", OP_READ,          4, 1, 1, 4 },
+	{ 0x9f, "rdid",    OP_READ_ID,       0, 0, 1, 1 },
+	{ 0xc7, "ce",      OP_ERASE,         0, 0, 1, 1, 0 },
+	{ 0xd8, "be",      OP_ERASE,         3, 0, 1, 1, 64 << 10 },
+	{ 0xdc, "be4b",    OP_ERASE,         4, 0, 1, 1, 64 << 10 },
+	/* Mode byte and four dummy clocks, on four lines */
+	{ 0xeb, "qioread", OP_READ,          3, 3, 4, 4 },
+	{ 0xec, "qioread4b", OP_READ,        4, 3, 4, 4 },
+};
+
+/* Timing model; bus clock in Hz, everything else in microseconds */
+static struct {
+	unsigned hz;
+	unsigned pp;
+	unsigned se;
+	unsigned be32;
+	unsigned be64;
+	unsigned ce;
+	unsigned wrsr;
+} timing = {
+	.hz = 50000000,
+};
+
+static const struct {
+	const char *name;
+	unsigned *value;
+} timing_params[] = {
+	{ "hz",		&timing.hz },
+	{ "pp",		&timing.pp },
+	{ "se",		&timing.se },
+	{ "be32",	&timing.be32 },
+	{ "be64",	&timing.be64 },
+	{ "ce",		&timing.ce },
+	{ "wrsr",	&timing.wrsr },
+};
+
+static struct {
+	int fd;
+	FILE *trace;
+	unsigned size;
+	unsigned page_size;
+	unsigned char sfdp[SFDP_SIZE];
+
+	unsigned long long now;		/* Emulated time, ps */
+	unsigned long long busy_until;
+	unsigned char sr1, sr2;
+
+	/* The command in progress, between chip select and deselect */
+	unsigned selected;
+	const struct flash_op *op;
+	unsigned char hdr[8];		/* opcode, address, dummy bytes */
+	unsigned hdr_len;
+	unsigned addr;
+	unsigned data_len;
+	unsigned char *page;		/* data of a page program */
+	unsigned char new_sr[2];	/* data of a status write */
+	unsigned flags;			/* TRACE_... */
+	unsigned long long start;
+} flash = { .fd = -1 };
+
+static struct {
+	unsigned long long commands;
+	unsigned long long ignored;
+	unsigned long long read_bytes[3];	/* by 1, 2 and 4 lines */
+	unsigned long long programs;
+	unsigned long long program_bytes;
+	unsigned long long erases[4];		/* 4K, 32K, 64K, chip */
+	unsigned long long polls;
+	unsigned long long busy;		/* ps */
+} stats;
+
+int spi_flash_emul_set_timing(const char *model)
+{
+	char *copy, *param, *save;
+	unsigned i;
+	int ret = 0;
+
+	copy = strdup(model);
+	for (param = strtok_r(copy, ",", &save); param && !ret;
+	     param = strtok_r(NULL, ",", &save)) {
+		char *value = strchr(param, '=');
+
+		ret = -1;
+		if (value == NULL)
+			break;
+		*value++ = '\0';
+		for (i = 0; i < ARRAY_SIZE(timing_params); ++i) {
+			if (strcmp(param, timing_params[i].name) == 0) {
+				*timing_params[i].value = strtoul(value,
+								  NULL, 0);
+				ret = 0;
+				break;
+			}
+		}
+	}
+	free(copy);
+
+	if (ret || timing.hz == 0)
+		return -1;
+	return 0;
+}
+
+static unsigned log2_of(unsigned n)
+{
+	unsigned shift = 0;
+
+	while (n >>= 1)
+		++shift;
+	return shift;
+}
+
+static void put32(unsigned char *p, unsigned v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static unsigned macronix(void)
+{
+	return (spi_id >> 16) == JEDEC_MFR_MACRONIX;
+}
+
+/*
+ * Build a JESD216B header and basic flash parameter table describing
+ * the emulated part.
+ */
+static void build_sfdp(void)
+{
+	unsigned char *bfpt = &flash.sfdp[SFDP_BFPT_OFFSET];
+	unsigned char *p = flash.sfdp;
+
+	memset(flash.sfdp, '\0', sizeof(flash.sfdp));
+	memcpy(p, "SFDP", 4);
+	p[4] = 6;			/* revision 1.6 */
+	p[5] = 1;
+	p[6] = 0;			/* one parameter header */
+	p[7] = 0xff;
+
+	p += 8;
+	p[0] = 0x00;			/* basic table, id 0xff00 */
+	p[1] = 6;
+	p[2] = 1;
+	p[3] = SFDP_BFPT_DWORDS;
+	p[4] = SFDP_BFPT_OFFSET;
+	p[7] = 0xff;
+
+	/* 4K erase 20h, 1-1-2, 1-4-4 and 1-1-4 reads */
+	put32(bfpt + 0, 0x1 | (1 << 2) | (0x20 << 8) | (1 << 16) |
+	      (flash.size > (1 << 24) ? 1 << 17 : 0) | (1 << 21) | (1 << 22));
+	put32(bfpt + 4, flash.size * 8 - 1);
+	/* 1-4-4: 2 mode + 4 dummy clocks; 1-1-4: 8 dummy clocks */
+	put32(bfpt + 8, 4 | (2 << 5) | (0xeb << 8) |
+	      (8 << 16) | (0x6b << 24));
+	put32(bfpt + 12, 8 | (0x3b << 8));
+	/* 4-4-4 read bit, by which U-Boot tells an MX25L25635F from an E */
+	if (flash.size > (1 << 24))
+		put32(bfpt + 16, 1 << 4);
+	/* Erase types 4K/20h, 32K/52h, 64K/d8h */
+	put32(bfpt + 28, 12 | (0x20 << 8) | (15 << 16) | (0x52 << 24));
+	put32(bfpt + 32, 16 | (0xd8 << 8));
+	put32(bfpt + 40, log2_of(flash.page_size) << 4);
+	/* Quad enable: SR1 bit 6 on Macronix, SR2 bit 1 otherwise */
+	put32(bfpt + 56, (macronix() ? 2 : 5) << 20);
+}
+
+int spi_flash_emul_init(unsigned size, unsigned page_size)
+{
+	unsigned char erased[4096];
+	off_t end;
+
+	flash.size = size;
+	flash.page_size = page_size;
+	flash.page = malloc(page_size);
+	if (flash.page == NULL)
+		return -1;
+
+	flash.fd = open(spi_file, O_RDWR | O_CREAT, 0600);
+	if (flash.fd == -1)
+		return -1;
+
+	/* Pad the backing file with erased bytes, so reads need no care */
+	memset(erased, 0xff, sizeof(erased));
+	end = lseek(flash.fd, 0, SEEK_END);
+	while (end != (off_t)-1 && end < (off_t)size) {
+		unsigned len = size - end;
+
+		if (len > sizeof(erased))
+			len = sizeof(erased);
+		if (pwrite(flash.fd, erased, len, end) != (ssize_t)len)
+			return -1;
+		end += len;
+	}
+
+	if (spi_trace != NULL) {
+		flash.trace = fopen(spi_trace, "w");
+		if (flash.trace == NULL)
+			return -1;
+		fprintf(flash.trace, "# id %06x, %u bytes, %u Hz\n"
+			"#     time_ns op name        address    bytes"
+			"     bus_ns    busy_ns flags\n",
+			spi_id, size, timing.hz);
+		/* Nothing buffered may be inherited by the daemon child */
+		fflush(flash.trace);
+	}
+
+	build_sfdp();
+	return 0;
+}
+
+static unsigned busy(void)
+{
+	return flash.now < flash.busy_until;
+}
+
+static unsigned quad_enabled(void)
+{
+	if (macronix())
+		return flash.sr1 & SR1_QE_MX;
+	return flash.sr2 & SR2_QE;
+}
+
+static unsigned status1(void)
+{
+	return flash.sr1 | (busy() ? SR1_WIP : 0);
+}
+
+static void flash_read(unsigned addr, unsigned char *buf, unsigned len)
+{
+	while (len) {
+		unsigned n = len;
+		ssize_t got;
+
+		addr %= flash.size;
+		if (n > flash.size - addr)
+			n = flash.size - addr;
+		got = pread(flash.fd, buf, n, addr);
+		if (got < 0)
+			got = 0;
+		if ((unsigned)got < n)
+			memset(buf + got, 0xff, n - got);
+		buf += n;
+		addr += n;
+		len -= n;
+	}
+}
+
+static void flash_write(unsigned addr, const unsigned char *buf,
+			unsigned len)
+{
+	if (pwrite(flash.fd, buf, len, addr) != (ssize_t)len)
+		fprintf(stderr, "SPI flash: cannot write '%s'\n", spi_file);
+}
+
+static void flash_erase(unsigned addr, unsigned len)
+{
+	unsigned char erased[4096];
+
+	memset(erased, 0xff, sizeof(erased));
+	while (len) {
+		unsigned n = len < sizeof(erased) ? len : sizeof(erased);
+
+		flash_write(addr, erased, n);
+		addr += n;
+		len -= n;
+	}
+}
+
+/* Program the buffered page; bits can only go from 1 to 0 */
+static void flash_program(void)
+{
+	unsigned base = flash.addr & ~(flash.page_size - 1);
+	unsigned char old[4096];
+	unsigned i;
+
+	flash_read(base, old, flash.page_size);
+	for (i = 0; i < flash.page_size; ++i)
+		old[i] &= flash.page[i];
+	flash_write(base, old, flash.page_size);
+}
+
+static unsigned long long us_to_ps(unsigned us)
+{
+	return us * PS_PER_US;
+}
+
+static unsigned erase_index(unsigned size)
+{
+	switch (size) {
+	case 4 << 10:
+		return 0;
+	case 32 << 10:
+		return 1;
+	case 64 << 10:
+		return 2;
+	default:
+		return 3;
+	}
+}
+
+static unsigned long long erase_time(unsigned size)
+{
+	const unsigned times[] = {
+		timing.se, timing.be32, timing.be64, timing.ce
+	};
+
+	return us_to_ps(times[erase_index(size)]);
+}
+
+/* Carry out a write command once chip select goes high */
+static unsigned long long finish_write(void)
+{
+	const struct flash_op *op = flash.op;
+	unsigned size;
+
+	if (op->kind == OP_WRITE_ENABLE) {
+		flash.sr1 |= SR1_WEL;
+		return 0;
+	}
+	if (op->kind == OP_WRITE_DISABLE) {
+		flash.sr1 &= ~SR1_WEL;
+		return 0;
+	}
+	if (!(flash.sr1 & SR1_WEL)) {
+		flash.flags |= TRACE_NO_WEL;
+		return 0;
+	}
+	flash.sr1 &= ~SR1_WEL;
+
+	switch (op->kind) {
+	case OP_PROGRAM:
+		if (flash.data_len == 0)
+			return 0;
+		flash_program();
+		stats.programs++;
+		stats.program_bytes += flash.data_len;
+		return us_to_ps(timing.pp);
+
+	case OP_ERASE:
+		size = op->erase_size ? op->erase_size : flash.size;
+		flash.addr &= ~(size - 1);
+		flash_erase(flash.addr, size);
+		stats.erases[erase_index(op->erase_size)]++;
+		return erase_time(op->erase_size);
+
+	case OP_WRITE_STATUS:
+		if (flash.data_len == 0)
+			return 0;
+		flash.sr1 = flash.new_sr[0] & ~(SR1_WIP | SR1_WEL);
+		if (flash.data_len > 1)
+			flash.sr2 = flash.new_sr[1];
+		return us_to_ps(timing.wrsr);
+
+	default:
+		return 0;
+	}
+}
+
+static void trace_command(unsigned long long busy_ps)
+{
+	const struct flash_op *op = flash.op;
+	char flags[64];
+	unsigned i;
+
+	if (flash.trace == NULL)
+		return;
+
+	flags[0] = '\0';
+	for (i = 0; i < ARRAY_SIZE(trace_flag_names); ++i) {
+		if (!(flash.flags & (1 << i)))
+			continue;
+		if (flags[0])
+			strcat(flags, ",");
+		strcat(flags, trace_flag_names[i]);
+	}
+
+	fprintf(flash.trace, "%14llu %02x %-10s %08x %8u %10llu %10llu %s\n",
+		flash.start / 1000, flash.hdr[0],
+		op ? op->name : "?",
+		op && op->addr_bytes ? flash.addr : 0, flash.data_len,
+		(flash.now - flash.start) / 1000, busy_ps / 1000,
+		flags[0] ? flags : "-");
+}
+
+/* Chip select went high: the command in progress takes effect */
+static void deselect(void)
+{
+	const struct flash_op *op = flash.op;
+	unsigned long long busy_ps = 0;
+
+	if (!flash.selected)
+		return;
+	flash.selected = 0;
+	if (flash.hdr_len == 0)
+		return;
+
+	if (op && flash.hdr_len < 1U + op->addr_bytes + op->dummy_bytes)
+		flash.flags |= TRACE_SHORT;
+
+	if (op && !flash.flags) {
+		switch (op->kind) {
+		case OP_PROGRAM:
+		case OP_ERASE:
+		case OP_WRITE_STATUS:
+		case OP_WRITE_ENABLE:
+		case OP_WRITE_DISABLE:
+			busy_ps = finish_write();
+			flash.busy_until = flash.now + busy_ps;
+			stats.busy += busy_ps;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	stats.commands++;
+	if (flash.flags)
+		stats.ignored++;
+	trace_command(busy_ps);
+}
+
+static void select_chip(void)
+{
+	deselect();
+	flash.selected = 1;
+	flash.op = NULL;
+	flash.hdr_len = 0;
+	flash.addr = 0;
+	flash.data_len = 0;
+	flash.flags = 0;
+	flash.start = flash.now;
+}
+
+static void start_command(unsigned char opcode)
+{
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(flash_ops); ++i)
+		if (flash_ops[i].opcode == opcode &&
+		    (!flash_ops[i].mfr || flash_ops[i].mfr == spi_id >> 16))
+			flash.op = &flash_ops[i];
+
+	if (flash.op == NULL) {
+		flash.flags |= TRACE_UNKNOWN;
+		return;
+	}
+
+	/* A busy part only answers status reads */
+	if (busy() && flash.op->kind != OP_STATUS1 &&
+	    flash.op->kind != OP_STATUS2)
+		flash.flags |= TRACE_BUSY;
+
+	if (flash.op->kind == OP_PROGRAM)
+		memset(flash.page, 0xff, flash.page_size);
+}
+
+/* The opcode, address and dummy bytes are in: work out the address */
+static void end_header(void)
+{
+	const struct flash_op *op = flash.op;
+	unsigned i;
+
+	for (i = 0; i < op->addr_bytes; ++i)
+		flash.addr = flash.addr << 8 | flash.hdr[1 + i];
+	if (op->kind != OP_READ_SFDP)
+		flash.addr %= flash.size;
+
+	if ((op->addr_lanes == 4 || op->data_lanes == 4) && !quad_enabled())
+		flash.flags |= TRACE_NO_QE;
+}
+
+/* Produce up to len data bytes of a read-type command */
+static void read_data(unsigned char *din, unsigned len, unsigned lanes)
+{
+	const struct flash_op *op = flash.op;
+	unsigned i;
+
+	if (flash.flags) {
+		memset(din, 0xff, len);
+		return;
+	}
+
+	switch (op->kind) {
+	case OP_READ:
+		flash_read(flash.addr + flash.data_len, din, len);
+		stats.read_bytes[lanes / 2] += len;
+		break;
+
+	case OP_READ_SFDP:
+		for (i = 0; i < len; ++i) {
+			unsigned a = flash.addr + flash.data_len + i;
+
+			din[i] = a < sizeof(flash.sfdp) ? flash.sfdp[a] : 0xff;
+		}
+		break;
+
+	case OP_READ_ID:
+		for (i = 0; i < len; ++i) {
+			unsigned n = flash.data_len + i;
+
+			din[i] = n < 3 ? spi_id >> (16 - 8 * n) : 0;
+		}
+		break;
+
+	default:
+		memset(din, 0xff, len);
+		break;
+	}
+}
+
+/* Accept up to len data bytes of a write-type command */
+static void write_data(const unsigned char *dout, unsigned len)
+{
+	unsigned i;
+
+	for (i = 0; i < len; ++i) {
+		unsigned n = flash.data_len + i;
+
+		if (flash.op->kind == OP_PROGRAM)
+			flash.page[(flash.addr + n) & (flash.page_size - 1)] =
+				dout[i];
+		else if (flash.op->kind == OP_WRITE_STATUS && n < 2)
+			flash.new_sr[n] = dout[i];
+	}
+}
+
+void spi_flash_emul_xfer(struct doorbell_command_t *dbc)
+{
+	unsigned flags = dbc->command_data[1];
+	unsigned len = dbc->command_data[2];
+	unsigned hz = dbc->command_data[3];
+	unsigned char *buf = dbc->dbc_buf;
+	unsigned long long byte_ps;
+	unsigned lanes = 1;
+	unsigned i;
+
+	if (len > sizeof(dbc->dbc_buf)) {
+		command_failure(dbc, SB_SPI);
+		return;
+	}
+
+	if (flags & SANDBOX_SPI_XFER_QUAD)
+		lanes = 4;
+	else if (flags & SANDBOX_SPI_XFER_DUAL)
+		lanes = 2;
+	if (hz == 0 || hz > timing.hz)
+		hz = timing.hz;
+	byte_ps = 8 * PS_PER_SEC / lanes / hz;
+
+	if (flags & SANDBOX_SPI_XFER_BEGIN)
+		select_chip();
+
+	for (i = 0; i < len; ) {
+		const struct flash_op *op = flash.op;
+		unsigned need, n;
+
+		if (!flash.selected || (flash.hdr_len && op == NULL)) {
+			/* Nobody is listening */
+			memset(buf + i, 0xff, len - i);
+			flash.now += (len - i) * byte_ps;
+			break;
+		}
+
+		need = op ? 1 + op->addr_bytes + op->dummy_bytes : 1;
+		if (flash.hdr_len < need) {
+			unsigned want = flash.hdr_len ? op->addr_lanes : 1;
+
+			if (lanes != want)
+				flash.flags |= TRACE_LANES;
+			flash.hdr[flash.hdr_len++] = buf[i];
+			buf[i++] = 0xff;
+			flash.now += byte_ps;
+			if (flash.hdr_len == 1)
+				start_command(flash.hdr[0]);
+			if (flash.op && flash.hdr_len ==
+			    1U + flash.op->addr_bytes + flash.op->dummy_bytes)
+				end_header();
+			continue;
+		}
+
+		if (lanes != op->data_lanes)
+			flash.flags |= TRACE_LANES;
+
+		/*
+		 * Status bytes change as time passes, one at a time.  Polling
+		 * a busy part only burns bus time, so rather than answer
+		 * every poll, skip to the end of the operation: the next poll
+		 * sees the part ready at the same emulated time.
+		 */
+		if (op->kind == OP_STATUS1 || op->kind == OP_STATUS2) {
+			flash.now += byte_ps;
+			buf[i++] = op->kind == OP_STATUS1 ? status1() :
+				flash.sr2;
+			if (busy())
+				flash.now = flash.busy_until;
+			flash.data_len++;
+			stats.polls++;
+			continue;
+		}
+
+		n = len - i;
+		if (op->kind == OP_PROGRAM || op->kind == OP_WRITE_STATUS) {
+			if (!flash.flags)
+				write_data(buf + i, n);
+			memset(buf + i, 0xff, n);
+		} else {
+			read_data(buf + i, n, lanes);
+		}
+		flash.data_len += n;
+		flash.now += n * byte_ps;
+		i += n;
+	}
+
+	if (flags & SANDBOX_SPI_XFER_END)
+		deselect();
+}
+
+void spi_flash_emul_finish(void)
+{
+	FILE *out = flash.trace;
+	unsigned long long elapsed = flash.now / 1000;
+
+	verbose("SPI flash: %llu commands in %llu ns emulated\n",
+		stats.commands, elapsed);
+	if (out == NULL)
+		return;
+
+	fprintf(out, "# elapsed_ns %llu\n", elapsed);
+	fprintf(out, "# commands %llu ignored %llu\n",
+		stats.commands, stats.ignored);
+	fprintf(out, "# read_bytes x1 %llu x2 %llu x4 %llu\n",
+		stats.read_bytes[0], stats.read_bytes[1], stats.read_bytes[2]);
+	fprintf(out, "# programs %llu bytes %llu\n",
+		stats.programs, stats.program_bytes);
+	fprintf(out, "# erases 4k %llu 32k %llu 64k %llu chip %llu\n",
+		stats.erases[0], stats.erases[1], stats.erases[2],
+		stats.erases[3]);
+	fprintf(out, "# status_polls %llu busy_ns %llu\n",
+		stats.polls, stats.busy / 1000);
+	fclose(out);
+	flash.trace = NULL;
+}
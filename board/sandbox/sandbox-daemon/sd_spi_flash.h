@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+#ifndef __SD_SPI_FLASH_H
+#define __SD_SPI_FLASH_H
+
+#include "asm/sandbox-api.h"
+
+/**
+ * Parses a timing model given as 'name=value,...'.
+ *
+ * @param model	Timing model, see README.text
+ * @return 0 if the model is valid, -1 otherwise
+ */
+int spi_flash_emul_set_timing(const char *model);
+
+/**
+ * Opens the backing file and trace for the SPI flash emulator.
+ *
+ * @param size		Flash size in bytes
+ * @param page_size	Program page size in bytes, a power of two
+ * @return 0 on success, -1 on error
+ */
+int spi_flash_emul_init(unsigned size, unsigned page_size);
+
+/**
+ * Clocks the bytes of a SANDBOX_SPI_CMD_XFER command through the
+ * emulated flash part.
+ *
+ * @param dbc	Pointer to doorbell command data
+ */
+void spi_flash_emul_xfer(struct doorbell_command_t *dbc);
+
+/**
+ * Writes the I/O summary to the trace and closes it.
+ */
+void spi_flash_emul_finish(void);
+#endif
@@ -27,6 +27,7 @@
 #include "sd_spi.h"
 #include "sd_mmc.h"
 #include "sd_keyboard.h"
+#include "sd_eth.h"
 #include "asm/sandbox-api.h"
 
 /* ipcs -m: show shared memory. look for the value of SANDBOX_SHM_KEY. */
@@ -78,4 +79,5 @@ void initialize_shared_devices(void)
 	initialize_spi(sandbox_get_doorbell());
 	mmc_initialize(sandbox_get_doorbell());
 	keyboard_initialize(sandbox_get_doorbell());
+	eth_initialize(sandbox_get_doorbell());
 }
@@ -22,6 +22,7 @@
 #include <common.h>
 #include <ec_commands.h>
 #include <mmc.h>
+#include <netdev.h>
 #include <os.h>
 
 /*
@@ -142,3 +143,10 @@ int board_mmc_init(bd_t *bis)
 	return 0;
 }
 #endif
+
+#ifdef CONFIG_SANDBOX_ETH
+int board_eth_init(bd_t *bis)
+{
+	return sandbox_eth_initialize(bis);
+}
+#endif
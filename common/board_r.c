@@ -664,6 +664,15 @@ static int initr_modem(void)
 }
 #endif
 
+#ifdef CONFIG_INITCALL_DEFER
+static int initr_defer_wait(void)
+{
+	/* Failures are reported, but the board carries on without them */
+	initcall_defer_wait(INITCALL_DEFER_ALL);
+	return 0;
+}
+#endif
+
 static int run_main_loop(void)
 {
 	/* main_loop() can return to retry autoboot, if so just run it again */
@@ -847,6 +856,9 @@ init_fnc_t init_sequence_r[] = {
 #endif
 #ifdef CONFIG_MODEM_SUPPORT
 	initr_modem,
+#endif
+#ifdef CONFIG_INITCALL_DEFER
+	initr_defer_wait,
 #endif
 	run_main_loop,
 };
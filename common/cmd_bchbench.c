@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2012, Google Inc. All rights reserved.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Software BCH ECC throughput benchmark.
+ *
+ * Encodes pseudo-random ECC steps with lib/bch, flips a number of bits
+ * in each one, decodes and corrects them, and reports the encode and
+ * decode throughput.  Every corrected step is compared with the
+ * original data so that table or decoder changes can be checked for
+ * correctness at the same time.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <linux/bch.h>
+
+#define BCHBENCH_STEP		512
+
+static u32 bchbench_seed;
+
+/* xorshift32, good enough to scatter data and bit flips */
+static u32 bchbench_rand(void)
+{
+	u32 x = bchbench_seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	bchbench_seed = x;
+	return x;
+}
+
+static int do_bchbench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct bch_control *bch;
+	unsigned int *errloc;
+	uint8_t *data, *orig, *ecc, *calc;
+	ulong enc_ms, dec_ms, start;
+	int t = 8, pages = 64, flips, page_size = 4096;
+	int steps, step, page, i, n, failed = 0;
+	unsigned long long bytes;
+
+	if (argc > 1)
+		t = simple_strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		pages = simple_strtoul(argv[2], NULL, 10);
+	flips = t;
+	if (argc > 3)
+		flips = simple_strtoul(argv[3], NULL, 10);
+	if (t < 1 || pages < 1 || flips < 0)
+		return CMD_RET_USAGE;
+
+	/* m = 13 covers a 512-byte step plus up to 13 * t parity bits */
+	bch = init_bch(13, t, 0);
+	if (!bch) {
+		printf("bchbench: cannot set up BCH for t=%d\n", t);
+		return 1;
+	}
+
+	steps = page_size / BCHBENCH_STEP;
+	data = malloc(page_size);
+	orig = malloc(page_size);
+	ecc = malloc(steps * bch->ecc_bytes);
+	calc = malloc(bch->ecc_bytes);
+	errloc = malloc(t * sizeof(*errloc));
+	if (!data || !orig || !ecc || !calc || !errloc) {
+		puts("bchbench: out of memory\n");
+		failed = 1;
+		goto out;
+	}
+
+	bchbench_seed = 0x2545f491;
+	bytes = (unsigned long long)pages * page_size;
+	enc_ms = 0;
+	dec_ms = 0;
+	for (page = 0; page < pages; page++) {
+		for (i = 0; i < page_size; i++)
+			orig[i] = bchbench_rand();
+		memcpy(data, orig, page_size);
+
+		start = get_timer(0);
+		for (step = 0; step < steps; step++) {
+			memset(ecc + step * bch->ecc_bytes, 0, bch->ecc_bytes);
+			encode_bch(bch, data + step * BCHBENCH_STEP,
+				   BCHBENCH_STEP, ecc + step * bch->ecc_bytes);
+		}
+		enc_ms += get_timer(start);
+
+		/* Bit flips only hit the data, never the stored ECC */
+		for (i = 0; i < flips * steps; i++) {
+			u32 bit = bchbench_rand() % (BCHBENCH_STEP * 8);
+
+			step = i % steps;
+			data[step * BCHBENCH_STEP + bit / 8] ^= 1 << (bit % 8);
+		}
+
+		start = get_timer(0);
+		for (step = 0; step < steps; step++) {
+			uint8_t *buf = data + step * BCHBENCH_STEP;
+
+			memset(calc, 0, bch->ecc_bytes);
+			encode_bch(bch, buf, BCHBENCH_STEP, calc);
+			n = decode_bch(bch, NULL, BCHBENCH_STEP,
+				       ecc + step * bch->ecc_bytes, calc,
+				       NULL, errloc);
+			for (i = 0; i < n; i++)
+				if (errloc[i] < BCHBENCH_STEP * 8)
+					buf[errloc[i] / 8] ^=
+						1 << (errloc[i] % 8);
+		}
+		dec_ms += get_timer(start);
+
+		if (memcmp(data, orig, page_size))
+			failed++;
+	}
+
+	printf("%-16sm=%d t=%d, %d x %d bytes, %d flips/step\n", "code",
+	       bch->m, bch->t, pages, page_size, flips);
+	print_rate("encode", bytes, enc_ms, 1024 * 1024, "MB/s");
+	print_rate("decode", bytes, dec_ms, 1024 * 1024, "MB/s");
+	printf("%-16s%d of %d pages\n", "uncorrected", failed, pages);
+out:
+	free(errloc);
+	free(calc);
+	free(ecc);
+	free(orig);
+	free(data);
+	free_bch(bch);
+
+	return failed ? 1 : 0;
+}
+
+U_BOOT_CMD(bchbench, 4, 0, do_bchbench,
+	"measure software BCH ECC throughput",
+	"[t [pages [flips]]]\n"
+	"    - encode, corrupt and correct 4KiB pages in 512-byte steps\n"
+	"      with t-bit BCH (default t=8, 64 pages, t flips per step)"
+);
@@ -52,22 +52,8 @@
 #include <fdt_support.h>
 #endif
 
-#ifdef CONFIG_LZMA
-#include <lzma/LzmaTypes.h>
-#include <lzma/LzmaDec.h>
-#include <lzma/LzmaTools.h>
-#endif /* CONFIG_LZMA */
-
-#ifdef CONFIG_LZO
-#include <linux/lzo.h>
-#endif /* CONFIG_LZO */
-
 DECLARE_GLOBAL_DATA_PTR;
 
-#ifndef CONFIG_SYS_BOOTM_LEN
-#define CONFIG_SYS_BOOTM_LEN	0x800000	/* use 8MByte as default max gunzip size */
-#endif
-
 #ifdef CONFIG_BZIP2
 extern void bz_internal_error(int);
 #endif
@@ -172,28 +158,22 @@ void arch_preboot_os(void) __attribute__((weak, alias("__arch_preboot_os")));
 static void bootm_start_lmb(void)
 {
 #ifdef CONFIG_LMB
-	ulong		mem_start;
-	phys_size_t	mem_size;
-
-	lmb_init(&images.lmb);
-
-	mem_start = getenv_bootm_low();
-	mem_size = getenv_bootm_size();
-
-	lmb_add(&images.lmb, (phys_addr_t)mem_start, mem_size);
-
-	arch_lmb_reserve(&images.lmb);
-	board_lmb_reserve(&images.lmb);
+	boot_start_lmb(&images.lmb);
 #else
 # define lmb_reserve(lmb, base, size)
 #endif
 }
 
-static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+static int bootm_get_images(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
 {
 	void		*os_hdr;
 	int		ret;
 
+#ifdef CONFIG_LMB
+	/* The last bootm may have left the lmb with some memory */
+	lmb_release(&images.lmb);
+#endif
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = getenv_yesno("verify");
 
@@ -310,6 +290,22 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 	return 0;
 }
 
+static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = bootm_get_images(cmdtp, flag, argc, argv);
+#if defined(CONFIG_FIT)
+	/*
+	 * Drop the hashes worked out on other CPUs, whether or not we got
+	 * this far, so that no later check can pick them up
+	 */
+	fit_image_hash_finish();
+#endif
+
+	return ret;
+}
+
 #define BOOTM_ERR_RESET		-1
 #define BOOTM_ERR_OVERLAP	-2
 #define BOOTM_ERR_UNIMPLEMENTED	-3
@@ -321,11 +317,9 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	ulong blob_end = os.end;
 	ulong image_start = os.image_start;
 	ulong image_len = os.image_len;
-	__maybe_unused uint unc_len = CONFIG_SYS_BOOTM_LEN;
+	ulong unc_len;
 	int no_overlap = 0;
-#if defined(CONFIG_LZMA) || defined(CONFIG_LZO)
 	int ret;
-#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) */
 
 	const char *type_name = genimg_get_type_name(os.type);
 
@@ -336,78 +330,42 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 			no_overlap = 1;
 		} else {
 			printf("   Loading %s ... ", type_name);
+#if defined(CONFIG_FIT)
+			/*
+			 * The data is copied over the load address as its
+			 * hash is checked, so by the time a bad hash is found
+			 * whatever was there, the exception vectors on some
+			 * boards, is gone.
+			 */
+			if (images.fit_verify_os) {
+				if (!fit_image_load_check_hashes(
+						images.fit_hdr_os,
+						images.fit_noffset_os,
+						(void *)load)) {
+					puts("Bad Data Hash - must RESET "
+					     "board to recover\n");
+					bootstage_error(
+						BOOTSTAGE_ID_FIT_CHECK_HASH);
+					return BOOTM_ERR_RESET;
+				}
+			} else
+#endif
 			memmove_wd((void *)load, (void *)image_start,
 					image_len, CHUNKSZ);
 		}
 		*load_end = load + image_len;
 		puts("OK\n");
 		break;
-#ifdef CONFIG_GZIP
-	case IH_COMP_GZIP:
-		printf("   Uncompressing %s ... ", type_name);
-		if (gunzip((void *)load, unc_len,
-				(uchar *)image_start, &image_len) != 0) {
-			puts("GUNZIP: uncompress, out-of-mem or overwrite "
-				"error - must RESET board to recover\n");
-			if (boot_progress)
-				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
-			return BOOTM_ERR_RESET;
-		}
-
-		*load_end = load + image_len;
-		break;
-#endif /* CONFIG_GZIP */
-#ifdef CONFIG_BZIP2
-	case IH_COMP_BZIP2:
-		printf("   Uncompressing %s ... ", type_name);
-		/*
-		 * If we've got less than 4 MB of malloc() space,
-		 * use slower decompression algorithm which requires
-		 * at most 2300 KB of memory.
-		 */
-		int i = BZ2_bzBuffToBuffDecompress((char *)load,
-					&unc_len, (char *)image_start, image_len,
-					CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
-		if (i != BZ_OK) {
-			printf("BUNZIP2: uncompress or overwrite error %d "
-				"- must RESET board to recover\n", i);
-			if (boot_progress)
-				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
-			return BOOTM_ERR_RESET;
-		}
-
-		*load_end = load + unc_len;
-		break;
-#endif /* CONFIG_BZIP2 */
-#ifdef CONFIG_LZMA
-	case IH_COMP_LZMA: {
-		SizeT lzma_len = unc_len;
+	default:
 		printf("   Uncompressing %s ... ", type_name);
-
-		ret = lzmaBuffToBuffDecompress(
-			(unsigned char *)load, &lzma_len,
-			(unsigned char *)image_start, image_len);
-		unc_len = lzma_len;
-		if (ret != SZ_OK) {
-			printf("LZMA: uncompress or overwrite error %d "
-				"- must RESET board to recover\n", ret);
-			bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
-			return BOOTM_ERR_RESET;
+		ret = image_decomp(comp, (void *)load, CONFIG_SYS_BOOTM_LEN,
+				   (void *)image_start, image_len, &unc_len);
+		if (ret == IMAGE_DECOMP_UNSUPPORTED) {
+			printf("Unimplemented compression type %d\n", comp);
+			return BOOTM_ERR_UNIMPLEMENTED;
 		}
-		*load_end = load + unc_len;
-		break;
-	}
-#endif /* CONFIG_LZMA */
-#ifdef CONFIG_LZO
-	case IH_COMP_LZO:
-		printf("   Uncompressing %s ... ", type_name);
-
-		ret = lzop_decompress((const unsigned char *)image_start,
-					  image_len, (unsigned char *)load,
-					  &unc_len);
-		if (ret != LZO_E_OK) {
-			printf("LZO: uncompress or overwrite error %d "
-			      "- must RESET board to recover\n", ret);
+		if (ret) {
+			puts(" - must RESET board to recover\n");
 			if (boot_progress)
 				bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
 			return BOOTM_ERR_RESET;
@@ -415,10 +373,6 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 
 		*load_end = load + unc_len;
 		break;
-#endif /* CONFIG_LZO */
-	default:
-		printf("Unimplemented compression type %d\n", comp);
-		return BOOTM_ERR_UNIMPLEMENTED;
 	}
 
 	flush_cache(load, (*load_end - load) * sizeof(ulong));
@@ -525,7 +479,8 @@ int do_bootm_subcommand(cmd_tbl_t *cmdtp, int flag, int argc,
 			char str[17];
 
 			ret = boot_ramdisk_high(&images.lmb, images.rd_start,
-				rd_len, &images.initrd_start, &images.initrd_end);
+				rd_len, images.rd_comp, &images.initrd_start,
+				&images.initrd_end);
 			if (ret)
 				return ret;
 
@@ -769,6 +724,31 @@ static image_header_t *image_get_kernel(ulong img_addr, int verify)
 	return hdr;
 }
 
+#if defined(CONFIG_FIT)
+/*
+ * Work out whether bootm_load_os() will copy the kernel data as it is,
+ * in which case it can check the hashes as it goes, instead of reading
+ * the data once here and again there.
+ */
+static int fit_kernel_verify_on_load(const void *fit, int os_noffset)
+{
+	const void *data;
+	size_t len;
+	ulong load;
+	uint8_t comp;
+
+	if (!fit_image_check_type(fit, os_noffset, IH_TYPE_KERNEL) ||
+	    fit_image_get_comp(fit, os_noffset, &comp) ||
+	    comp != IH_COMP_NONE ||
+	    fit_image_get_load(fit, os_noffset, &load) ||
+	    fit_image_get_data(fit, os_noffset, &data, &len))
+		return 0;
+
+	/* As in bootm_load_os(), these are not copied */
+	return load != (ulong)fit && load != (ulong)data;
+}
+#endif /* CONFIG_FIT */
+
 /**
  * fit_check_kernel - verify FIT format kernel subimage
  * @fit_hdr: pointer to the FIT image header
@@ -932,23 +912,12 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 			/*
 			 * no kernel image node unit name, try to get config
 			 * node first. If config unit node name is NULL
-			 * fit_conf_get_node() will try to find default config
-			 * node
+			 * fit_conf_select() will pick the default or best
+			 * matching config node
 			 */
 			bootstage_mark(BOOTSTAGE_ID_FIT_NO_UNIT_NAME);
-#ifdef CONFIG_FIT_BEST_MATCH
-			if (fit_uname_config)
-				cfg_noffset =
-					fit_conf_get_node(fit_hdr,
-							  fit_uname_config);
-			else
-				cfg_noffset =
-					fit_conf_find_compat(fit_hdr,
-							     gd->fdt_blob);
-#else
-			cfg_noffset = fit_conf_get_node(fit_hdr,
-							fit_uname_config);
-#endif
+			cfg_noffset = fit_conf_select(fit_hdr,
+						      fit_uname_config);
 			if (cfg_noffset < 0) {
 				bootstage_error(BOOTSTAGE_ID_FIT_NO_UNIT_NAME);
 				return NULL;
@@ -963,6 +932,10 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 				images->fit_uname_cfg);
 			bootstage_mark(BOOTSTAGE_ID_FIT_CONFIG);
 
+			/* Hash the ramdisk and fdt while checking the kernel */
+			if (images->verify)
+				fit_conf_hash_start(fit_hdr, cfg_noffset);
+
 			os_noffset = fit_conf_get_kernel_node(fit_hdr,
 								cfg_noffset);
 			fit_uname_kernel = fit_get_name(fit_hdr, os_noffset,
@@ -981,7 +954,10 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 		printf("   Trying '%s' kernel subimage\n", fit_uname_kernel);
 
 		bootstage_mark(BOOTSTAGE_ID_FIT_CHECK_SUBIMAGE);
-		if (!fit_check_kernel(fit_hdr, os_noffset, images->verify))
+		images->fit_verify_os = images->verify &&
+			fit_kernel_verify_on_load(fit_hdr, os_noffset);
+		if (!fit_check_kernel(fit_hdr, os_noffset,
+				      images->verify && !images->fit_verify_os))
 			return NULL;
 
 		/* get kernel image data address and length */
@@ -119,6 +119,36 @@ U_BOOT_CMD(
 	"    - list files from 'dev' on 'interface' in a 'directory'"
 );
 
+#if defined(CONFIG_FIT)
+static int ext2_read_fit(void *priv, ulong offset, ulong size, void *buf)
+{
+	return ext2fs_read_at(buf, offset, size) == size ? 0 : -1;
+}
+
+/*
+ * Read the structure of a FIT image, then only the external image data
+ * that fit_load_external() asks for. Returns the number of bytes the
+ * image spans, 0 if the file is not a FIT image, or -1 on error.
+ */
+static int ext2_load_fit(void *addr, int filelen)
+{
+	int size = sizeof(struct fdt_header);
+
+	if (filelen < size || ext2fs_read_at(addr, 0, size) != size ||
+	    genimg_get_format(addr) != IMAGE_FORMAT_FIT)
+		return 0;
+
+	size = fit_get_size(addr);
+	if (size > filelen)
+		return 0;
+	if (ext2fs_read_at(addr, 0, size) != size ||
+	    fit_load_external(addr, ext2_read_fit, NULL))
+		return -1;
+
+	return fit_get_total_size(addr);
+}
+#endif
+
 /******************************************************************************
  * Ext2fs boot command intepreter. Derived from diskboot
  */
@@ -128,7 +158,7 @@ int do_ext2load (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	char *ep;
 	int dev, part = 1;
 	ulong addr = 0, part_length;
-	int filelen;
+	int filelen, len;
 	disk_partition_t info;
 	block_dev_desc_t *dev_desc = NULL;
 	char buf [12];
@@ -232,7 +262,14 @@ int do_ext2load (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	    filelen = count;
 	}
 
-	if (ext2fs_read((char *)addr, filelen) != filelen) {
+	len = 0;
+#if defined(CONFIG_FIT)
+	if (count == 0)
+		len = ext2_load_fit((void *)addr, filelen);
+#endif
+	if (len > 0) {
+		filelen = len;
+	} else if (len < 0 || ext2fs_read((char *)addr, filelen) != filelen) {
 		printf("** Unable to read \"%s\" from %s %d:%d **\n",
 			filename, argv[1], dev, part);
 		ext2fs_close();
@@ -433,6 +433,13 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 			return 1;
 		}
 		bootstage_mark(BOOTSTAGE_ID_IDE_CHECKSUM);
+#ifdef CONFIG_BOOTM_PLAN
+		/* An address given by the user is where they expect it */
+		if (argc == 1) {
+			addr = boot_plan_move(addr, info.blksz);
+			hdr = (image_header_t *)addr;
+		}
+#endif
 
 		image_print_contents(hdr);
 
@@ -473,6 +480,12 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 			return 1;
 		}
 		bootstage_mark(BOOTSTAGE_ID_IDE_FIT_READ_OK);
+		if (fit_load_external_blk((void *)addr, &ide_dev_desc[dev],
+					  info.start)) {
+			printf("** Read error on %d:%d\n", dev, part);
+			bootstage_error(BOOTSTAGE_ID_IDE_READ);
+			return 1;
+		}
 		fit_print_contents(fit_hdr);
 	}
 #endif
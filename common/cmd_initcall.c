@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <initcall.h>
+
+static int do_initcall_report(cmd_tbl_t *cmdtp, int flag, int argc,
+			      char * const argv[])
+{
+	int sort = 0;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "sort"))
+			return CMD_RET_USAGE;
+		sort = 1;
+	}
+	initcall_report(sort);
+
+	return 0;
+}
+
+U_BOOT_CMD(initcall_report, 2, 1, do_initcall_report,
+	"show how long each init function took",
+	"[sort]\n"
+	"    - list init functions in the order they ran, or slowest first"
+);
@@ -843,6 +843,18 @@ static int nand_load_image(cmd_tbl_t *cmdtp, nand_info_t *nand,
 			return 1;
 		}
 		bootstage_mark(BOOTSTAGE_ID_NAND_FIT_READ_OK);
+
+		/* Read any image data stored after the FIT structure */
+		if (fit_get_total_size(fit_hdr) > cnt) {
+			cnt = fit_get_total_size(fit_hdr);
+			r = nand_read_skip_bad(nand, offset, &cnt,
+					       (u_char *)addr);
+			if (r) {
+				puts("** Read error\n");
+				bootstage_error(BOOTSTAGE_ID_NAND_READ);
+				return 1;
+			}
+		}
 		fit_print_contents (fit_hdr);
 	}
 #endif
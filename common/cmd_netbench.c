@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2012, Google Inc. All rights reserved.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Network throughput benchmark.
+ *
+ * Runs a TFTP or NFS transfer through the normal NetLoop() and reports
+ * the achieved throughput together with the packet and retransmission
+ * counts from NetStats.  Together with the sandbox Ethernet device this
+ * allows net/ stack regressions to be measured on a plain host.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <net.h>
+
+static int do_netbench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	enum proto_t proto;
+	ulong start, ms, addr;
+	char *s, *end;
+	int size;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[1], "tftp"))
+		proto = TFTPGET;
+#ifdef CONFIG_CMD_NFS
+	else if (!strcmp(argv[1], "nfs"))
+		proto = NFS;
+#endif
+	else
+		return CMD_RET_USAGE;
+
+	s = getenv("loadaddr");
+	if (s)
+		load_addr = simple_strtoul(s, NULL, 16);
+
+	/*
+	 * Same forms as tftpboot and nfs. A "hostIPaddr:" prefix stays in
+	 * BootFile, where TftpStart() and NfsStart() pick it up.
+	 */
+	switch (argc) {
+	case 2:
+		break;
+	case 3:
+		/* Just load address, or just boot file name */
+		addr = simple_strtoul(argv[2], &end, 16);
+		if (end == argv[2] + strlen(argv[2]))
+			load_addr = addr;
+		else
+			copy_filename(BootFile, argv[2], sizeof(BootFile));
+		break;
+	default:
+		load_addr = simple_strtoul(argv[2], NULL, 16);
+		copy_filename(BootFile, argv[3], sizeof(BootFile));
+		break;
+	}
+
+	memset(&NetStats, '\0', sizeof(NetStats));
+	start = get_timer(0);
+	size = NetLoop(proto);
+	ms = get_timer(start);
+	if (size < 0) {
+		printf("netbench: %s transfer failed\n", argv[1]);
+		return 1;
+	}
+
+	printf("\n%-16s%d bytes in %lu ms\n", "transferred", size, ms);
+	print_rate("throughput", size, ms, 1024 * 1024, "MB/s");
+	print_rate("rx packets", NetStats.rx_packets, ms, 1, "packets/s");
+	print_rate("tx packets", NetStats.tx_packets, ms, 1, "packets/s");
+	printf("%-16s%lu rx, %lu tx\n", "packets", NetStats.rx_packets,
+	       NetStats.tx_packets);
+	printf("%-16s%lu\n", "retransmits", NetStats.retransmits);
+
+	return 0;
+}
+
+U_BOOT_CMD(netbench, 4, 0, do_netbench,
+	"measure network transfer throughput",
+	"tftp [loadAddress] [[hostIPaddr:]bootfilename]\n"
+#ifdef CONFIG_CMD_NFS
+	"netbench nfs [loadAddress] [[hostIPaddr:]bootfilename]\n"
+#endif
+	"    - load a file and report MB/s, packets/s and retransmits"
+);
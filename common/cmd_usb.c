@@ -521,6 +521,13 @@ int do_usbboot(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			puts("\n** Bad Header Checksum **\n");
 			return 1;
 		}
+#ifdef CONFIG_BOOTM_PLAN
+		/* An address given by the user is where they expect it */
+		if (argc == 1) {
+			addr = boot_plan_move(addr, info.blksz);
+			hdr = (image_header_t *)addr;
+		}
+#endif
 
 		image_print_contents(hdr);
 
@@ -558,6 +565,10 @@ int do_usbboot(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			puts("** Bad FIT image format\n");
 			return 1;
 		}
+		if (fit_load_external_blk((void *)addr, stor_dev, info.start)) {
+			printf("\n** Read error on %d:%d\n", dev, part);
+			return 1;
+		}
 		fit_print_contents(fit_hdr);
 	}
 #endif
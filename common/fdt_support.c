@@ -81,15 +81,15 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create)
 {
-	int nodeoff = fdt_path_offset(fdt, node);
+	int nodeoff = fdt_txn_path_offset(fdt, node);
 
 	if (nodeoff < 0)
 		return nodeoff;
 
-	if ((!create) && (fdt_get_property(fdt, nodeoff, prop, 0) == NULL))
+	if ((!create) && (fdt_txn_getprop(fdt, nodeoff, prop, NULL) == NULL))
 		return 0; /* create flag not set; so exit quietly */
 
-	return fdt_setprop(fdt, nodeoff, prop, val, len);
+	return fdt_txn_setprop(fdt, nodeoff, prop, val, len);
 }
 
 #ifdef CONFIG_OF_STDOUT_VIA_ALIAS
@@ -131,7 +131,7 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 			err = -FDT_ERR_NOSPACE;
 			if (p) {
 				memcpy(p, path, len);
-				err = fdt_setprop(fdt, chosenoff,
+				err = fdt_txn_setprop(fdt, chosenoff,
 					"linux,stdout-path", p, len);
 				free(p);
 			}
@@ -148,16 +148,45 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 }
 #endif
 
+/**
+ * fdt_set_mem_rsv: Add a memory reservation, replacing any existing one for
+ * the same address
+ *
+ * @fdt: ptr to device tree
+ * @addr: start of the reserved region
+ * @size: size of the reserved region
+ */
+int fdt_set_mem_rsv(void *fdt, u64 addr, u64 size)
+{
+	uint64_t rsv_addr, rsv_size;
+	int j, total;
+
+	total = fdt_num_mem_rsv(fdt);
+
+	/*
+	 * Look for an existing entry and update it.  If we don't find
+	 * the entry, we will j be the next available slot.
+	 */
+	for (j = 0; j < total; j++) {
+		fdt_get_mem_rsv(fdt, j, &rsv_addr, &rsv_size);
+		if (rsv_addr == addr) {
+			fdt_del_mem_rsv(fdt, j);
+			break;
+		}
+	}
+
+	return fdt_add_mem_rsv(fdt, addr, size);
+}
+
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end, int force)
 {
 	int   nodeoffset;
-	int   err, j, total;
+	int   err;
 	u32   tmp;
 	const char *path;
-	uint64_t addr, size;
 
 	/* Find the "chosen" node.  */
-	nodeoffset = fdt_path_offset (fdt, "/chosen");
+	nodeoffset = fdt_txn_path_offset(fdt, "/chosen");
 
 	/* If there is no "chosen" node in the blob return */
 	if (nodeoffset < 0) {
@@ -169,30 +198,17 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end, int force)
 	if ((initrd_start == 0) || (initrd_end == 0))
 		return 0;
 
-	total = fdt_num_mem_rsv(fdt);
-
-	/*
-	 * Look for an existing entry and update it.  If we don't find
-	 * the entry, we will j be the next available slot.
-	 */
-	for (j = 0; j < total; j++) {
-		err = fdt_get_mem_rsv(fdt, j, &addr, &size);
-		if (addr == initrd_start) {
-			fdt_del_mem_rsv(fdt, j);
-			break;
-		}
-	}
-
-	err = fdt_add_mem_rsv(fdt, initrd_start, initrd_end - initrd_start);
+	err = fdt_txn_set_mem_rsv(fdt, initrd_start,
+				  initrd_end - initrd_start);
 	if (err < 0) {
 		printf("fdt_initrd: %s\n", fdt_strerror(err));
 		return err;
 	}
 
-	path = fdt_getprop(fdt, nodeoffset, "linux,initrd-start", NULL);
+	path = fdt_txn_getprop(fdt, nodeoffset, "linux,initrd-start", NULL);
 	if ((path == NULL) || force) {
 		tmp = __cpu_to_be32(initrd_start);
-		err = fdt_setprop(fdt, nodeoffset,
+		err = fdt_txn_setprop(fdt, nodeoffset,
 			"linux,initrd-start", &tmp, sizeof(tmp));
 		if (err < 0) {
 			printf("WARNING: "
@@ -201,7 +217,7 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end, int force)
 			return err;
 		}
 		tmp = __cpu_to_be32(initrd_end);
-		err = fdt_setprop(fdt, nodeoffset,
+		err = fdt_txn_setprop(fdt, nodeoffset,
 			"linux,initrd-end", &tmp, sizeof(tmp));
 		if (err < 0) {
 			printf("WARNING: could not set linux,initrd-end %s.\n",
@@ -230,7 +246,7 @@ int fdt_chosen(void *fdt, int force)
 	/*
 	 * Find the "chosen" node.
 	 */
-	nodeoffset = fdt_path_offset (fdt, "/chosen");
+	nodeoffset = fdt_txn_path_offset(fdt, "/chosen");
 
 	/*
 	 * If there is no "chosen" node in the blob, create it.
@@ -239,7 +255,7 @@ int fdt_chosen(void *fdt, int force)
 		/*
 		 * Create a new node "/chosen" (offset 0 is root level)
 		 */
-		nodeoffset = fdt_add_subnode(fdt, 0, "chosen");
+		nodeoffset = fdt_txn_add_subnode(fdt, 0, "chosen");
 		if (nodeoffset < 0) {
 			printf("WARNING: could not create /chosen %s.\n",
 				fdt_strerror(nodeoffset));
@@ -254,9 +270,9 @@ int fdt_chosen(void *fdt, int force)
 	 */
 	str = getenv("bootargs");
 	if (str != NULL) {
-		path = fdt_getprop(fdt, nodeoffset, "bootargs", NULL);
+		path = fdt_txn_getprop(fdt, nodeoffset, "bootargs", NULL);
 		if ((path == NULL) || force) {
-			err = fdt_setprop(fdt, nodeoffset,
+			err = fdt_txn_setprop(fdt, nodeoffset,
 				"bootargs", str, strlen(str)+1);
 			if (err < 0)
 				printf("WARNING: could not set bootargs %s.\n",
@@ -265,15 +281,15 @@ int fdt_chosen(void *fdt, int force)
 	}
 
 #ifdef CONFIG_OF_STDOUT_VIA_ALIAS
-	path = fdt_getprop(fdt, nodeoffset, "linux,stdout-path", NULL);
+	path = fdt_txn_getprop(fdt, nodeoffset, "linux,stdout-path", NULL);
 	if ((path == NULL) || force)
 		err = fdt_fixup_stdout(fdt, nodeoffset);
 #endif
 
 #ifdef OF_STDOUT_PATH
-	path = fdt_getprop(fdt, nodeoffset, "linux,stdout-path", NULL);
+	path = fdt_txn_getprop(fdt, nodeoffset, "linux,stdout-path", NULL);
 	if ((path == NULL) || force) {
-		err = fdt_setprop(fdt, nodeoffset,
+		err = fdt_txn_setprop(fdt, nodeoffset,
 			"linux,stdout-path", OF_STDOUT_PATH, strlen(OF_STDOUT_PATH)+1);
 		if (err < 0)
 			printf("WARNING: could not set linux,stdout-path %s.\n",
@@ -322,8 +338,8 @@ void do_fixup_by_prop(void *fdt,
 #endif
 	off = fdt_node_offset_by_prop_value(fdt, -1, pname, pval, plen);
 	while (off != -FDT_ERR_NOTFOUND) {
-		if (create || (fdt_get_property(fdt, off, prop, 0) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+		if (create || (fdt_txn_getprop(fdt, off, prop, NULL) != NULL))
+			fdt_txn_setprop(fdt, off, prop, val, len);
 		off = fdt_node_offset_by_prop_value(fdt, off, pname, pval, plen);
 	}
 }
@@ -349,8 +365,8 @@ void do_fixup_by_compat(void *fdt, const char *compat,
 #endif
 	off = fdt_node_offset_by_compatible(fdt, -1, compat);
 	while (off != -FDT_ERR_NOTFOUND) {
-		if (create || (fdt_get_property(fdt, off, prop, 0) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+		if (create || (fdt_txn_getprop(fdt, off, prop, NULL) != NULL))
+			fdt_txn_setprop(fdt, off, prop, val, len);
 		off = fdt_node_offset_by_compatible(fdt, off, compat);
 	}
 }
@@ -404,15 +420,15 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 	}
 
 	/* update, or add and update /memory node */
-	nodeoffset = fdt_path_offset(blob, "/memory");
+	nodeoffset = fdt_txn_path_offset(blob, "/memory");
 	if (nodeoffset < 0) {
-		nodeoffset = fdt_add_subnode(blob, 0, "memory");
+		nodeoffset = fdt_txn_add_subnode(blob, 0, "memory");
 		if (nodeoffset < 0)
 			printf("WARNING: could not create /memory: %s.\n",
 					fdt_strerror(nodeoffset));
 		return nodeoffset;
 	}
-	err = fdt_setprop(blob, nodeoffset, "device_type", "memory",
+	err = fdt_txn_setprop(blob, nodeoffset, "device_type", "memory",
 			sizeof("memory"));
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n", "device_type",
@@ -431,7 +447,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 		len += size_cell_len;
 	}
 
-	err = fdt_setprop(blob, nodeoffset, "reg", tmp, len);
+	err = fdt_txn_setprop(blob, nodeoffset, "reg", tmp, len);
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n",
 				"reg", fdt_strerror(err));
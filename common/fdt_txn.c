@@ -0,0 +1,730 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Batched FDT fixups.
+ *
+ * Every fdt_setprop() or fdt_add_subnode() moves the rest of the blob up
+ * to make room, so applying many fixups to a large tree copies it many
+ * times over. Between fdt_txn_begin() and fdt_txn_commit() the fdt_txn_...
+ * functions record their edits instead, leaving the blob alone, and the
+ * commit rebuilds it in one pass: the unchanged parts of the structure and
+ * strings blocks are copied once, with the recorded edits spliced in.
+ *
+ * Existing nodes are remembered by path as well as offset, so code which
+ * writes to the blob directly during a transaction does not upset the
+ * edits recorded so far, as long as it does not add the same nodes. New
+ * nodes are given offsets beyond the end of any real blob, which libfdt
+ * rejects, until they are committed.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <fdt.h>
+#include <libfdt.h>
+#include <fdt_support.h>
+
+#define TXN_MAX_PATH		256
+#define TXN_NEW_NODE_BASE	0x7f000000
+#define TXN_ALIGN(x)		(((x) + FDT_TAGSIZE - 1) & ~(FDT_TAGSIZE - 1))
+
+struct txn_prop {
+	struct txn_prop *next;		/* newest first, as libfdt adds them */
+	struct txn_prop *next_string;	/* in the list of new strings */
+	const char *name;		/* stored after the value */
+	int len;
+	int exists;			/* replaces a property in the blob */
+	int nameoff;
+	char data[0];
+};
+
+struct txn_node {
+	struct txn_node *next;		/* all nodes, in order of creation */
+	struct txn_node *sorted;	/* existing nodes, by offset */
+	struct txn_node *children;	/* new subnodes, newest first */
+	struct txn_node *sibling;
+	struct txn_prop *props;
+	int is_new;
+	int offset;			/* in the blob, or a new node's id */
+	const char *name;		/* last component of path */
+	char path[0];
+};
+
+struct txn_rsv {
+	struct txn_rsv *next;
+	u64 addr;
+	u64 size;
+	int replaced;			/* found an entry in the blob */
+};
+
+struct txn_plan {
+	const char *strtab;		/* strings block of the blob */
+	int str_size;			/* size of strings block with new names */
+	struct txn_prop *strings;	/* properties whose names are new */
+	struct txn_prop **last_string;
+};
+
+static struct fdt_txn {
+	void *fdt;			/* blob being edited, NULL if none */
+	int struct_size;		/* to notice direct changes to the blob */
+	int new_nodes;
+	struct txn_node *nodes;
+	struct txn_node **last_node;
+	struct txn_rsv *rsvs;
+} txn;
+
+static int txn_active(const void *fdt)
+{
+	return txn.fdt && txn.fdt == fdt;
+}
+
+static int txn_node_offset(const struct txn_node *node)
+{
+	return node->is_new ? TXN_NEW_NODE_BASE + node->offset * FDT_TAGSIZE :
+		node->offset;
+}
+
+/* Find existing nodes again if something has changed the blob under us */
+static void txn_sync(void)
+{
+	struct txn_node *node;
+
+	if (fdt_size_dt_struct(txn.fdt) == txn.struct_size)
+		return;
+	for (node = txn.nodes; node; node = node->next)
+		if (!node->is_new)
+			node->offset = fdt_path_offset(txn.fdt, node->path);
+	txn.struct_size = fdt_size_dt_struct(txn.fdt);
+}
+
+static struct txn_node *txn_find(int nodeoffset)
+{
+	struct txn_node *node;
+
+	for (node = txn.nodes; node; node = node->next)
+		if (txn_node_offset(node) == nodeoffset)
+			return node;
+
+	return NULL;
+}
+
+static struct txn_node *txn_add_node(const char *path, int pathlen)
+{
+	struct txn_node *node;
+
+	node = malloc(sizeof(*node) + pathlen + 1);
+	if (!node)
+		return NULL;
+	memset(node, '\0', sizeof(*node));
+	memcpy(node->path, path, pathlen);
+	node->path[pathlen] = '\0';
+	node->name = strrchr(node->path, '/') + 1;
+	*txn.last_node = node;
+	txn.last_node = &node->next;
+
+	return node;
+}
+
+/* Find the record for a node, adding one if it is an existing node */
+static struct txn_node *txn_get(int nodeoffset, int *errp)
+{
+	char path[TXN_MAX_PATH];
+	struct txn_node *node;
+	int err;
+
+	txn_sync();
+	node = txn_find(nodeoffset);
+	if (node)
+		return node;
+
+	err = fdt_get_path(txn.fdt, nodeoffset, path, sizeof(path));
+	if (err) {
+		*errp = err;
+		return NULL;
+	}
+	node = txn_add_node(path, strlen(path));
+	if (!node) {
+		*errp = -FDT_ERR_NOSPACE;
+		return NULL;
+	}
+	node->offset = nodeoffset;
+
+	return node;
+}
+
+static struct txn_prop *txn_find_prop(struct txn_node *node,
+				      const char *name)
+{
+	struct txn_prop *prop;
+
+	for (prop = node->props; prop; prop = prop->next)
+		if (!strcmp(prop->name, name))
+			return prop;
+
+	return NULL;
+}
+
+static void txn_free(void)
+{
+	struct txn_node *node, *next_node;
+	struct txn_prop *prop, *next_prop;
+	struct txn_rsv *rsv, *next_rsv;
+
+	for (node = txn.nodes; node; node = next_node) {
+		next_node = node->next;
+		for (prop = node->props; prop; prop = next_prop) {
+			next_prop = prop->next;
+			free(prop);
+		}
+		free(node);
+	}
+	for (rsv = txn.rsvs; rsv; rsv = next_rsv) {
+		next_rsv = rsv->next;
+		free(rsv);
+	}
+	memset(&txn, '\0', sizeof(txn));
+}
+
+/**
+ * fdt_txn_begin - start recording fixups to an FDT
+ *
+ * @fdt: FDT to fix up, which must be version 17
+ *
+ * Until fdt_txn_commit() or fdt_txn_abort(), the fdt_txn_...() functions
+ * record their changes to this FDT rather than making them.
+ *
+ * @return 0 if ok, -FDT_ERR_... on error, in which case the fdt_txn_...()
+ * functions change the FDT directly
+ */
+int fdt_txn_begin(void *fdt)
+{
+	int err;
+
+	if (txn.fdt)
+		return -FDT_ERR_BADSTATE;
+	err = fdt_check_header(fdt);
+	if (err)
+		return err;
+	if (fdt_version(fdt) < 17)
+		return -FDT_ERR_BADVERSION;
+
+	txn.fdt = fdt;
+	txn.struct_size = fdt_size_dt_struct(fdt);
+	txn.last_node = &txn.nodes;
+
+	return 0;
+}
+
+/**
+ * fdt_txn_abort - drop the fixups recorded since fdt_txn_begin()
+ */
+void fdt_txn_abort(void)
+{
+	txn_free();
+}
+
+const void *fdt_txn_getprop(const void *fdt, int nodeoffset,
+			    const char *name, int *lenp)
+{
+	struct txn_node *node;
+	struct txn_prop *prop;
+
+	if (!txn_active(fdt))
+		return fdt_getprop(fdt, nodeoffset, name, lenp);
+
+	txn_sync();
+	node = txn_find(nodeoffset);
+	prop = node ? txn_find_prop(node, name) : NULL;
+	if (prop) {
+		if (lenp)
+			*lenp = prop->len;
+		return prop->data;
+	}
+	if (node && node->is_new) {
+		if (lenp)
+			*lenp = -FDT_ERR_NOTFOUND;
+		return NULL;
+	}
+
+	return fdt_getprop(fdt, nodeoffset, name, lenp);
+}
+
+int fdt_txn_setprop(void *fdt, int nodeoffset, const char *name,
+		    const void *val, int len)
+{
+	struct txn_prop *prop, **prevp;
+	struct txn_node *node;
+	int err;
+
+	if (!txn_active(fdt))
+		return fdt_setprop(fdt, nodeoffset, name, val, len);
+
+	node = txn_get(nodeoffset, &err);
+	if (!node)
+		return err;
+
+	prop = malloc(sizeof(*prop) + len + strlen(name) + 1);
+	if (!prop)
+		return -FDT_ERR_NOSPACE;
+	memset(prop, '\0', sizeof(*prop));
+	memcpy(prop->data, val, len);
+	prop->len = len;
+	prop->name = strcpy(prop->data + len, name);
+
+	/* A second change to a property replaces the first, in place */
+	for (prevp = &node->props; *prevp; prevp = &(*prevp)->next) {
+		if (!strcmp((*prevp)->name, name)) {
+			prop->next = (*prevp)->next;
+			free(*prevp);
+			*prevp = prop;
+			return 0;
+		}
+	}
+	prop->next = node->props;
+	node->props = prop;
+
+	return 0;
+}
+
+int fdt_txn_subnode_offset(const void *fdt, int parentoffset,
+			   const char *name)
+{
+	struct txn_node *parent, *node;
+	int offset;
+
+	if (!txn_active(fdt))
+		return fdt_subnode_offset(fdt, parentoffset, name);
+
+	txn_sync();
+	parent = txn_find(parentoffset);
+	if (!parent || !parent->is_new) {
+		offset = fdt_subnode_offset(fdt, parentoffset, name);
+		if (!parent || offset != -FDT_ERR_NOTFOUND)
+			return offset;
+	}
+	for (node = parent->children; node; node = node->sibling)
+		if (!strcmp(node->name, name))
+			return txn_node_offset(node);
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdt_txn_add_subnode(void *fdt, int parentoffset, const char *name)
+{
+	struct txn_node *parent, *node;
+	char path[TXN_MAX_PATH];
+	int offset, len, err;
+
+	if (!txn_active(fdt))
+		return fdt_add_subnode(fdt, parentoffset, name);
+
+	offset = fdt_txn_subnode_offset(fdt, parentoffset, name);
+	if (offset >= 0)
+		return -FDT_ERR_EXISTS;
+	else if (offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	parent = txn_get(parentoffset, &err);
+	if (!parent)
+		return err;
+	len = strlen(parent->path);
+	if (len + strlen(name) + 2 > TXN_MAX_PATH)
+		return -FDT_ERR_NOSPACE;
+
+	strcpy(path, parent->path);
+	if (len > 1)
+		path[len++] = '/';
+	strcpy(path + len, name);
+
+	node = txn_add_node(path, strlen(path));
+	if (!node)
+		return -FDT_ERR_NOSPACE;
+	node->is_new = 1;
+	node->offset = txn.new_nodes++;
+	node->sibling = parent->children;
+	parent->children = node;
+
+	return txn_node_offset(node);
+}
+
+int fdt_txn_path_offset(const void *fdt, const char *path)
+{
+	struct txn_node *node;
+	int offset;
+
+	offset = fdt_path_offset(fdt, path);
+	if (!txn_active(fdt) || offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	for (node = txn.nodes; node; node = node->next)
+		if (node->is_new && !strcmp(node->path, path))
+			return txn_node_offset(node);
+
+	return offset;
+}
+
+int fdt_txn_set_mem_rsv(void *fdt, u64 addr, u64 size)
+{
+	struct txn_rsv *rsv, **rsvp;
+
+	if (!txn_active(fdt))
+		return fdt_set_mem_rsv(fdt, addr, size);
+
+	for (rsvp = &txn.rsvs; *rsvp; rsvp = &(*rsvp)->next) {
+		if ((*rsvp)->addr == addr) {
+			(*rsvp)->size = size;
+			return 0;
+		}
+	}
+	rsv = malloc(sizeof(*rsv));
+	if (!rsv)
+		return -FDT_ERR_NOSPACE;
+	memset(rsv, '\0', sizeof(*rsv));
+	rsv->addr = addr;
+	rsv->size = size;
+	*rsvp = rsv;
+
+	return 0;
+}
+
+/* Find a string in the strings block, as libfdt does when adding one */
+static int txn_find_string(const char *strtab, int size, const char *s)
+{
+	int len = strlen(s) + 1;
+	const char *p;
+
+	for (p = strtab; p + len <= strtab + size; p++)
+		if (!memcmp(p, s, len))
+			return p - strtab;
+
+	return -1;
+}
+
+/* Choose the name offset for a new property */
+static void txn_plan_string(struct txn_plan *plan, struct txn_prop *prop)
+{
+	struct txn_prop *other;
+
+	prop->nameoff = txn_find_string(plan->strtab,
+					fdt_size_dt_strings(txn.fdt),
+					prop->name);
+	if (prop->nameoff >= 0)
+		return;
+	for (other = plan->strings; other; other = other->next_string) {
+		if (!strcmp(other->name, prop->name)) {
+			prop->nameoff = other->nameoff;
+			return;
+		}
+	}
+	prop->nameoff = plan->str_size;
+	plan->str_size += strlen(prop->name) + 1;
+	*plan->last_string = prop;
+	plan->last_string = &prop->next_string;
+}
+
+/*
+ * Work out how much a node's recorded changes add to the structure block,
+ * and where the names of its new properties go in the strings block.
+ */
+static int txn_plan_node(struct txn_plan *plan, struct txn_node *node)
+{
+	struct txn_node *child;
+	struct txn_prop *prop;
+	int size = 0, oldlen;
+
+	if (node->is_new)
+		size += 2 * FDT_TAGSIZE + TXN_ALIGN(strlen(node->name) + 1);
+	for (prop = node->props; prop; prop = prop->next) {
+		prop->exists = !node->is_new &&
+			fdt_get_property(txn.fdt, node->offset, prop->name,
+					 &oldlen);
+		if (prop->exists) {
+			size += TXN_ALIGN(prop->len) - TXN_ALIGN(oldlen);
+		} else {
+			size += sizeof(struct fdt_property) +
+				TXN_ALIGN(prop->len);
+			txn_plan_string(plan, prop);
+		}
+	}
+	for (child = node->children; child; child = child->sibling)
+		size += txn_plan_node(plan, child);
+
+	return size;
+}
+
+static char *txn_put_prop(char *p, struct txn_prop *prop, int nameoff)
+{
+	struct fdt_property *fp = (struct fdt_property *)p;
+	int len = TXN_ALIGN(prop->len);
+
+	fp->tag = cpu_to_fdt32(FDT_PROP);
+	fp->len = cpu_to_fdt32(prop->len);
+	fp->nameoff = cpu_to_fdt32(nameoff);
+	memcpy(fp->data, prop->data, prop->len);
+	memset(fp->data + prop->len, '\0', len - prop->len);
+
+	return p + sizeof(*fp) + len;
+}
+
+static char *txn_put_tag(char *p, u32 tag)
+{
+	*(u32 *)p = cpu_to_fdt32(tag);
+
+	return p + FDT_TAGSIZE;
+}
+
+static char *txn_put_children(char *p, struct txn_node *node)
+{
+	struct txn_node *child;
+	struct txn_prop *prop;
+	int len;
+
+	for (child = node->children; child; child = child->sibling) {
+		p = txn_put_tag(p, FDT_BEGIN_NODE);
+		len = strlen(child->name) + 1;
+		memcpy(p, child->name, len);
+		memset(p + len, '\0', TXN_ALIGN(len) - len);
+		p += TXN_ALIGN(len);
+		for (prop = child->props; prop; prop = prop->next)
+			p = txn_put_prop(p, prop, prop->nameoff);
+		p = txn_put_children(p, child);
+		p = txn_put_tag(p, FDT_END_NODE);
+	}
+
+	return p;
+}
+
+/*
+ * Copy the structure block, putting new properties just after their node's
+ * name and new subnodes just after its properties, where libfdt would put
+ * them.
+ */
+static int txn_put_struct(char *out, struct txn_node *sorted)
+{
+	const char *in = (const char *)txn.fdt + fdt_off_dt_struct(txn.fdt);
+	struct txn_node *node = NULL;
+	struct txn_prop *prop;
+	int offset = 0, next;
+	char *p = out;
+	u32 tag;
+
+	do {
+		tag = fdt_next_tag(txn.fdt, offset, &next);
+		if (next < 0)
+			return next;
+		if (node && tag != FDT_PROP && tag != FDT_NOP) {
+			p = txn_put_children(p, node);
+			node = NULL;
+		}
+
+		prop = NULL;
+		if (node && tag == FDT_PROP) {
+			const struct fdt_property *fp;
+
+			fp = (const struct fdt_property *)(in + offset);
+			prop = txn_find_prop(node, fdt_string(txn.fdt,
+					fdt32_to_cpu(fp->nameoff)));
+			if (prop)
+				p = txn_put_prop(p, prop,
+						 fdt32_to_cpu(fp->nameoff));
+		}
+		if (!prop) {
+			memcpy(p, in + offset, next - offset);
+			p += next - offset;
+		}
+
+		if (tag == FDT_BEGIN_NODE && sorted &&
+		    sorted->offset == offset) {
+			node = sorted;
+			sorted = sorted->sorted;
+			for (prop = node->props; prop; prop = prop->next)
+				if (!prop->exists)
+					p = txn_put_prop(p, prop,
+							 prop->nameoff);
+		}
+		offset = next;
+	} while (tag != FDT_END);
+
+	return p - out;
+}
+
+/* Make the changes with libfdt, deepest in the blob first */
+static int txn_replay(void *fdt, int offset, struct txn_node *node)
+{
+	struct txn_node *child;
+	struct txn_prop *prop;
+	int err;
+
+	if (!node->is_new && node->sorted) {
+		err = txn_replay(fdt, node->sorted->offset, node->sorted);
+		if (err)
+			return err;
+	}
+	for (prop = node->props; prop; prop = prop->next) {
+		err = fdt_setprop(fdt, offset, prop->name, prop->data,
+				  prop->len);
+		if (err)
+			return err;
+	}
+	for (child = node->children; child; child = child->sibling) {
+		err = fdt_add_subnode(fdt, offset, child->name);
+		if (err < 0)
+			return err;
+		err = txn_replay(fdt, err, child);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+/**
+ * fdt_txn_commit - apply the fixups recorded since fdt_txn_begin()
+ *
+ * @fdt: FDT passed to fdt_txn_begin()
+ * @bufsize: space available for the FDT, which may be more than its size
+ *
+ * The FDT is rebuilt with exactly the space it needs. If there is not enough
+ * memory to rebuild it, the changes are made in place with libfdt instead.
+ * Either way the transaction is finished.
+ *
+ * @return 0 if ok, -FDT_ERR_... on error
+ */
+int fdt_txn_commit(void *fdt, int bufsize)
+{
+	struct txn_node *sorted = NULL, *node, **nodep;
+	int num_rsv, struct_size, size, i, err;
+	int rsv_off, struct_off, strings_off;
+	struct fdt_reserve_entry *re;
+	struct txn_plan plan;
+	struct txn_rsv *rsv;
+	u64 addr, rsv_size;
+	char *out;
+
+	if (!txn_active(fdt))
+		return 0;
+	txn_sync();
+
+	/* Existing nodes in the order they appear in the blob */
+	for (node = txn.nodes; node; node = node->next) {
+		if (node->is_new)
+			continue;
+		if (node->offset < 0) {
+			printf("WARNING: FDT node %s has gone, not updated\n",
+			       node->path);
+			continue;
+		}
+		for (nodep = &sorted; *nodep; nodep = &(*nodep)->sorted)
+			if ((*nodep)->offset > node->offset)
+				break;
+		node->sorted = *nodep;
+		*nodep = node;
+	}
+
+	plan.strtab = fdt_string(fdt, 0);
+	plan.str_size = fdt_size_dt_strings(fdt);
+	plan.strings = NULL;
+	plan.last_string = &plan.strings;
+	struct_size = fdt_size_dt_struct(fdt);
+	for (node = sorted; node; node = node->sorted)
+		struct_size += txn_plan_node(&plan, node);
+
+	num_rsv = fdt_num_mem_rsv(fdt);
+	for (i = 0; i < fdt_num_mem_rsv(fdt); i++) {
+		fdt_get_mem_rsv(fdt, i, &addr, &rsv_size);
+		for (rsv = txn.rsvs; rsv; rsv = rsv->next) {
+			if (!rsv->replaced && rsv->addr == addr) {
+				rsv->replaced = 1;
+				num_rsv--;
+				break;
+			}
+		}
+	}
+	for (rsv = txn.rsvs; rsv; rsv = rsv->next)
+		num_rsv++;
+
+	rsv_off = ALIGN(sizeof(struct fdt_header), 8);
+	struct_off = rsv_off + (num_rsv + 1) * sizeof(*re);
+	strings_off = struct_off + struct_size;
+	size = strings_off + plan.str_size;
+	if (size > bufsize) {
+		err = -FDT_ERR_NOSPACE;
+		goto done;
+	}
+
+	out = malloc(size);
+	if (!out) {
+		debug("%s: no memory to rebuild FDT, updating in place\n",
+		      __func__);
+		err = fdt_open_into(fdt, fdt, bufsize);
+		if (!err && sorted)
+			err = txn_replay(fdt, sorted->offset, sorted);
+		for (rsv = txn.rsvs; !err && rsv; rsv = rsv->next)
+			err = fdt_set_mem_rsv(fdt, rsv->addr, rsv->size);
+		goto done;
+	}
+
+	memcpy(out, fdt, sizeof(struct fdt_header));
+	fdt_set_totalsize(out, size);
+	fdt_set_off_mem_rsvmap(out, rsv_off);
+	fdt_set_off_dt_struct(out, struct_off);
+	fdt_set_size_dt_struct(out, struct_size);
+	fdt_set_off_dt_strings(out, strings_off);
+	fdt_set_size_dt_strings(out, plan.str_size);
+
+	re = (struct fdt_reserve_entry *)(out + rsv_off);
+	for (i = 0; i < fdt_num_mem_rsv(fdt); i++) {
+		fdt_get_mem_rsv(fdt, i, &addr, &rsv_size);
+		for (rsv = txn.rsvs; rsv; rsv = rsv->next)
+			if (rsv->replaced && rsv->addr == addr)
+				break;
+		if (rsv) {
+			rsv->replaced = 0;
+			continue;
+		}
+		re->address = cpu_to_fdt64(addr);
+		re->size = cpu_to_fdt64(rsv_size);
+		re++;
+	}
+	for (rsv = txn.rsvs; rsv; rsv = rsv->next, re++) {
+		re->address = cpu_to_fdt64(rsv->addr);
+		re->size = cpu_to_fdt64(rsv->size);
+	}
+	memset(re, '\0', sizeof(*re));
+
+	err = txn_put_struct(out + struct_off, sorted);
+	if (err >= 0 && err != struct_size)
+		err = -FDT_ERR_INTERNAL;
+	if (err >= 0) {
+		memcpy(out + strings_off, plan.strtab,
+		       fdt_size_dt_strings(fdt));
+		for (; plan.strings; plan.strings = plan.strings->next_string)
+			strcpy(out + strings_off + plan.strings->nameoff,
+			       plan.strings->name);
+		memcpy(fdt, out, size);
+		err = 0;
+	}
+	free(out);
+done:
+	txn_free();
+
+	return err;
+}
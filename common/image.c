@@ -26,6 +26,7 @@
 #ifndef USE_HOSTCC
 #include <common.h>
 #include <watchdog.h>
+#include <linux/compiler.h>
 
 #ifdef CONFIG_SHOW_BOOT_PROGRESS
 #include <status_led.h>
@@ -43,6 +44,20 @@
 #include <rtc.h>
 #endif
 
+#ifdef CONFIG_BZIP2
+#include <bzlib.h>
+#endif
+
+#ifdef CONFIG_LZMA
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaDec.h>
+#include <lzma/LzmaTools.h>
+#endif /* CONFIG_LZMA */
+
+#ifdef CONFIG_LZO
+#include <linux/lzo.h>
+#endif /* CONFIG_LZO */
+
 #include <image.h>
 
 #if defined(CONFIG_FIT) || defined(CONFIG_OF_LIBFDT)
@@ -52,11 +67,14 @@
 #endif
 
 #if defined(CONFIG_FIT)
+#include <cpu_work.h>
 #include <u-boot/md5.h>
 #include <sha1.h>
 
 static int fit_check_ramdisk(const void *fit, int os_noffset,
 		uint8_t arch, int verify);
+static int fit_image_get_data_offset(const void *fit, int noffset,
+		ulong *offset, size_t *size);
 #endif
 
 #ifdef CONFIG_CMD_BDI
@@ -476,6 +494,31 @@ phys_size_t getenv_bootm_mapsize(void)
 #endif
 }
 
+#ifdef CONFIG_LMB
+/**
+ * boot_start_lmb - set up the memory map which bootm starts with
+ * @lmb: pointer to lmb handle to set up
+ *
+ * This is the memory between "bootm_low" and "bootm_low" + "bootm_size",
+ * less what the architecture and board reserve.
+ */
+void boot_start_lmb(struct lmb *lmb)
+{
+	ulong		mem_start;
+	phys_size_t	mem_size;
+
+	lmb_init(lmb);
+
+	mem_start = getenv_bootm_low();
+	mem_size = getenv_bootm_size();
+
+	lmb_add(lmb, (phys_addr_t)mem_start, mem_size);
+
+	arch_lmb_reserve(lmb);
+	board_lmb_reserve(lmb);
+}
+#endif
+
 void memmove_wd(void *to, void *from, size_t len, ulong chunksz)
 {
 	if (to == from)
@@ -749,6 +792,221 @@ ulong genimg_get_image(ulong img_addr)
 	return ram_addr;
 }
 
+/**
+ * image_decomp_size - get the uncompressed size of image data
+ * @comp: compression type (IH_COMP_...)
+ * @image_buf: compressed data
+ * @image_len: length of compressed data
+ *
+ * gzip records the uncompressed size in its trailer and LZMA in its
+ * header, so that space can be set aside before decompressing. The other
+ * formats do not record it.
+ *
+ * returns:
+ *     uncompressed size in bytes, or 0 if it is not known
+ */
+ulong image_decomp_size(int comp, const void *image_buf, ulong image_len)
+{
+	const uchar *buf = image_buf;
+	ulong size = 0;
+	int i;
+
+	switch (comp) {
+	case IH_COMP_GZIP:
+		/* ISIZE, the last four bytes, little-endian */
+		if (image_len < 18)
+			break;
+		for (i = 1; i <= 4; i++)
+			size = (size << 8) | buf[image_len - i];
+		break;
+	case IH_COMP_LZMA:
+		/* properties (5 bytes), then a 64-bit little-endian size */
+		if (image_len < 13)
+			break;
+		for (i = 8; i >= 5; i--)
+			size = (size << 8) | buf[i];
+		/* all ones means the size is not recorded */
+		if (buf[9] | buf[10] | buf[11] | buf[12])
+			size = 0;
+		break;
+	}
+
+	return size;
+}
+
+/**
+ * image_decomp - decompress image data
+ * @comp: compression type (IH_COMP_...), other than IH_COMP_NONE
+ * @load_buf: where to put the uncompressed data
+ * @unc_len: space available at load_buf
+ * @image_buf: compressed data
+ * @image_len: length of compressed data
+ * @sizep: returns the uncompressed size
+ *
+ * This is shared by bootm for kernels, ramdisks and device trees. On a
+ * decompression error a message is printed without a trailing newline,
+ * so that the caller can say what happens next.
+ *
+ * returns:
+ *     0, on success
+ *     IMAGE_DECOMP_ERR, if the data is corrupt or does not fit
+ *     IMAGE_DECOMP_UNSUPPORTED, if the compression type is not built in
+ */
+int image_decomp(int comp, void *load_buf, ulong unc_len,
+		 const void *image_buf, ulong image_len, ulong *sizep)
+{
+	__maybe_unused int ret;
+
+	switch (comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		if (gunzip(load_buf, unc_len, (uchar *)image_buf,
+			   &image_len) != 0) {
+			puts("GUNZIP: uncompress, out-of-mem or overwrite "
+				"error");
+			return IMAGE_DECOMP_ERR;
+		}
+		*sizep = image_len;
+		break;
+#endif /* CONFIG_GZIP */
+#ifdef CONFIG_BZIP2
+	case IH_COMP_BZIP2: {
+		uint bz_len = unc_len;
+
+		/*
+		 * If we've got less than 4 MB of malloc() space,
+		 * use slower decompression algorithm which requires
+		 * at most 2300 KB of memory.
+		 */
+		ret = BZ2_bzBuffToBuffDecompress(load_buf, &bz_len,
+					(char *)image_buf, image_len,
+					CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
+		if (ret != BZ_OK) {
+			printf("BUNZIP2: uncompress or overwrite error %d",
+			       ret);
+			return IMAGE_DECOMP_ERR;
+		}
+		*sizep = bz_len;
+		break;
+	}
+#endif /* CONFIG_BZIP2 */
+#ifdef CONFIG_LZMA
+	case IH_COMP_LZMA: {
+		SizeT lzma_len = unc_len;
+
+		ret = lzmaBuffToBuffDecompress(load_buf, &lzma_len,
+					(unsigned char *)image_buf, image_len);
+		if (ret != SZ_OK) {
+			printf("LZMA: uncompress or overwrite error %d", ret);
+			return IMAGE_DECOMP_ERR;
+		}
+		*sizep = lzma_len;
+		break;
+	}
+#endif /* CONFIG_LZMA */
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO: {
+		size_t lzo_len = unc_len;
+
+		ret = lzop_decompress(image_buf, image_len, load_buf,
+				      &lzo_len);
+		if (ret != LZO_E_OK) {
+			printf("LZO: uncompress or overwrite error %d", ret);
+			return IMAGE_DECOMP_ERR;
+		}
+		*sizep = lzo_len;
+		break;
+	}
+#endif /* CONFIG_LZO */
+	default:
+		return IMAGE_DECOMP_UNSUPPORTED;
+	}
+
+	return 0;
+}
+
+#if (defined(CONFIG_SYS_BOOT_RAMDISK_HIGH) && \
+     defined(CONFIG_BOOTM_RAMDISK_DECOMP)) || \
+    (defined(CONFIG_OF_LIBFDT) && defined(CONFIG_LMB))
+/* Most pieces boot_lmb_hold() may reserve for one caller */
+#define BOOT_LMB_HELD_MAX	8
+
+/* The pieces boot_lmb_hold() reserved, for boot_lmb_unhold() to free */
+struct boot_lmb_held {
+	int cnt;
+	struct lmb_property region[BOOT_LMB_HELD_MAX];
+};
+
+/**
+ * boot_lmb_hold - keep LMB allocations clear of a region for a while
+ * @lmb: pointer to lmb handle
+ * @held: pieces reserved so far, cnt must start as 0
+ * @base: start of the region
+ * @size: size of the region
+ *
+ * Data which is still to be read, such as compressed image data, or a
+ * region still to be written, such as the kernel's load address before
+ * bootm has reserved it, is not known to the LMB. Holding it stops an
+ * allocation being placed on top of it.
+ *
+ * Only the parts of the region which are not reserved already are
+ * reserved here, and recorded in @held, so that boot_lmb_unhold() gives
+ * back exactly those and nothing which was reserved before.
+ *
+ * returns:
+ *     0, if all of the region is now reserved
+ *     -1, if @held is full, in which case nothing more was reserved
+ */
+static int boot_lmb_hold(struct lmb *lmb, struct boot_lmb_held *held,
+			 ulong base, ulong size)
+{
+	struct lmb_region *rsv = &lmb->reserved;
+	ulong end = base + size;
+	ulong rgn_base, rgn_end;
+	int first = held->cnt;
+	unsigned long i;
+
+	/* The reserved regions are sorted, so the gaps come in order */
+	for (i = 0; base < end && i <= rsv->cnt; i++) {
+		if (i < rsv->cnt) {
+			rgn_base = rsv->region[i].base;
+			rgn_end = rgn_base + rsv->region[i].size;
+		} else {
+			rgn_base = rgn_end = end;
+		}
+		if (rgn_end <= base)
+			continue;
+
+		if (rgn_base > base) {
+			if (held->cnt == BOOT_LMB_HELD_MAX) {
+				held->cnt = first;
+				return -1;
+			}
+			held->region[held->cnt].base = base;
+			held->region[held->cnt].size = min(rgn_base, end) - base;
+			held->cnt++;
+		}
+		base = rgn_end;
+	}
+
+	/* Reserving changes rsv->region[], so only do it once it is walked */
+	for (i = first; i < held->cnt; i++)
+		lmb_reserve(lmb, held->region[i].base, held->region[i].size);
+
+	return 0;
+}
+
+/* Give back what boot_lmb_hold() reserved */
+static void boot_lmb_unhold(struct lmb *lmb, struct boot_lmb_held *held)
+{
+	int i;
+
+	for (i = 0; i < held->cnt; i++)
+		lmb_free(lmb, held->region[i].base, held->region[i].size);
+	held->cnt = 0;
+}
+#endif
+
 /**
  * fit_has_config - check if there is a valid FIT configuration
  * @images: pointer to the bootm command headers structure
@@ -769,6 +1027,48 @@ int genimg_has_config(bootm_headers_t *images)
 	return 0;
 }
 
+#if defined(CONFIG_FIT_PARTIAL_LOAD) && defined(CONFIG_BOOTM_PLAN)
+/*
+ * The FIT whose data fit_plan_external() last placed, and where it put
+ * the kernel and ramdisk. A data-address property is only honoured when
+ * it matches, so that one saved with a FIT, or put in one on purpose,
+ * cannot point bootm at other memory.
+ */
+static struct {
+	const void	*fit;
+	ulong		addr[2];
+} fit_planned;
+
+/*
+ * Get the data-address of an image, if fit_load_external() read its data
+ * there during this boot. Returns 0 if so, -1 if not.
+ */
+static int fit_image_get_data_addr(const void *fit, int noffset, ulong *addr)
+{
+	const uint32_t *prop;
+	int i;
+
+	if (!fit || fit != fit_planned.fit)
+		return -1;
+	prop = fdt_getprop(fit, noffset, FIT_DATA_ADDR_PROP, NULL);
+	if (!prop)
+		return -1;
+
+	*addr = uimage_to_cpu(*prop);
+	for (i = 0; i < ARRAY_SIZE(fit_planned.addr); i++)
+		if (*addr && *addr == fit_planned.addr[i])
+			return 0;
+
+	return -1;
+}
+#endif
+
+#if defined(CONFIG_BOOTM_PLAN) && defined(CONFIG_SYS_BOOT_RAMDISK_HIGH) && \
+	defined(CONFIG_LMB)
+/* The ramdisk which boot_get_ramdisk() found and reserved where planned */
+static ulong rd_in_bootmap;
+#endif
+
 /**
  * boot_get_ramdisk - main ramdisk handling routine
  * @argc: command argument count
@@ -806,10 +1106,19 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 	int		cfg_noffset;
 	const void	*data;
 	size_t		size;
+#if defined(CONFIG_FIT_PARTIAL_LOAD) && defined(CONFIG_BOOTM_PLAN) && \
+	defined(CONFIG_SYS_BOOT_RAMDISK_HIGH) && defined(CONFIG_LMB)
+	ulong		planned;
+#endif
 #endif
 
 	*rd_start = 0;
 	*rd_end = 0;
+	images->rd_comp = IH_COMP_NONE;
+#if defined(CONFIG_BOOTM_PLAN) && defined(CONFIG_SYS_BOOT_RAMDISK_HIGH) && \
+	defined(CONFIG_LMB)
+	rd_in_bootmap = 0;
+#endif
 
 	/*
 	 * Look for a '-' which indicates to ignore the
@@ -905,6 +1214,7 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 			rd_data = image_get_data(rd_hdr);
 			rd_len = image_get_data_size(rd_hdr);
 			rd_load = image_get_load(rd_hdr);
+			images->rd_comp = image_get_comp(rd_hdr);
 			break;
 #if defined(CONFIG_FIT)
 		case IMAGE_FORMAT_FIT:
@@ -988,9 +1298,28 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 			}
 			bootstage_mark(BOOTSTAGE_ID_FIT_RD_LOAD);
 
+			if (fit_image_get_comp(fit_hdr, rd_noffset,
+						&images->rd_comp))
+				images->rd_comp = IH_COMP_NONE;
+
 			images->fit_hdr_rd = fit_hdr;
 			images->fit_uname_rd = fit_uname_ramdisk;
 			images->fit_noffset_rd = rd_noffset;
+#if defined(CONFIG_FIT_PARTIAL_LOAD) && defined(CONFIG_BOOTM_PLAN) && \
+	defined(CONFIG_SYS_BOOT_RAMDISK_HIGH) && defined(CONFIG_LMB)
+			/*
+			 * fit_load_external() read it to where
+			 * boot_ramdisk_high() is to put it. Reserve it now, so
+			 * that the cmdline and bd_info, which some
+			 * architectures allocate first, are put elsewhere.
+			 */
+			if (rd_len && !fit_image_get_data_addr(fit_hdr,
+					rd_noffset, &planned) &&
+			    planned == rd_data) {
+				lmb_reserve(&images->lmb, rd_data, rd_len);
+				rd_in_bootmap = rd_data;
+			}
+#endif
 			break;
 #endif
 		default:
@@ -1033,11 +1362,109 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 }
 
 #ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
+/*
+ * Get the highest address for the ramdisk from "initrd_high". All ones
+ * means the ramdisk is used where it is, and *copy_to_ram is cleared.
+ */
+static ulong getenv_initrd_high(int *copy_to_ram)
+{
+	ulong	initrd_high;
+	char	*s;
+
+	*copy_to_ram = 1;
+	if ((s = getenv("initrd_high")) != NULL) {
+		/* a value of "no" or a similar string will act like 0,
+		 * turning the "load high" feature off. This is intentional.
+		 */
+		initrd_high = simple_strtoul(s, NULL, 16);
+		if (initrd_high == ~0)
+			*copy_to_ram = 0;
+	} else {
+		/* not set, no restrictions to load high */
+		initrd_high = ~0;
+	}
+
+	return initrd_high;
+}
+
+#ifdef CONFIG_BOOTM_RAMDISK_DECOMP
+/*
+ * Decompress a ramdisk straight into memory allocated below initrd_high,
+ * instead of copying the compressed data there for the kernel to unpack.
+ * Returns 0 on success, -1 on failure and 1 if this compression type is
+ * not built in, in which case the ramdisk should be copied as it is.
+ */
+static int boot_ramdisk_decomp(struct lmb *lmb, ulong rd_data, ulong rd_len,
+			       uint8_t rd_comp, ulong initrd_high,
+			       ulong *initrd_start, ulong *initrd_end)
+{
+	struct boot_lmb_held held = { 0 };
+	ulong unc_len, alloc_len, size;
+	int ret;
+
+	unc_len = image_decomp_size(rd_comp, (void *)rd_data, rd_len);
+	if (!unc_len)
+		unc_len = CONFIG_SYS_BOOTM_LEN;
+	alloc_len = ALIGN(unc_len, 0x1000);
+
+	/* Nothing may be put on the compressed data until it has been read */
+	if (boot_lmb_hold(lmb, &held, rd_data, rd_len)) {
+		puts("ramdisk - allocation error\n");
+		return -1;
+	}
+	if (initrd_high && initrd_high != ~0UL)
+		*initrd_start = (ulong)lmb_alloc_base(lmb, alloc_len, 0x1000,
+						      initrd_high);
+	else
+		*initrd_start = (ulong)lmb_alloc(lmb, alloc_len, 0x1000);
+
+	if (*initrd_start == 0) {
+		puts("ramdisk - allocation error\n");
+		ret = -1;
+		goto out;
+	}
+	bootstage_mark(BOOTSTAGE_ID_COPY_RAMDISK);
+
+	printf("   Uncompressing Ramdisk to %08lx ... ", *initrd_start);
+	ret = image_decomp(rd_comp, (void *)*initrd_start, unc_len,
+			   (void *)rd_data, rd_len, &size);
+	if (ret) {
+		if (ret == IMAGE_DECOMP_UNSUPPORTED) {
+			puts("not supported, loading it compressed\n");
+			ret = 1;
+		} else {
+			puts("\n");
+			ret = -1;
+		}
+		lmb_free(lmb, *initrd_start, alloc_len);
+		*initrd_start = 0;
+		goto out;
+	}
+
+	/* Give back the space which the ramdisk turned out not to need */
+	if (alloc_len > ALIGN(size, 0x1000))
+		lmb_free(lmb, *initrd_start + ALIGN(size, 0x1000),
+			 alloc_len - ALIGN(size, 0x1000));
+	*initrd_end = *initrd_start + size;
+
+#ifdef CONFIG_MP
+	flush_cache(*initrd_start, size);
+#endif
+	printf("end %08lx OK\n", *initrd_end);
+
+out:
+	boot_lmb_unhold(lmb, &held);
+
+	return ret;
+}
+#endif /* CONFIG_BOOTM_RAMDISK_DECOMP */
+
 /**
  * boot_ramdisk_high - relocate init ramdisk
  * @lmb: pointer to lmb handle, will be used for memory mgmt
  * @rd_data: ramdisk data start address
  * @rd_len: ramdisk data length
+ * @rd_comp: ramdisk compression type (IH_COMP_...)
  * @initrd_start: pointer to a ulong variable, will hold final init ramdisk
  *      start address (after possible relocation)
  * @initrd_end: pointer to a ulong variable, will hold final init ramdisk
@@ -1046,6 +1473,9 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
  * boot_ramdisk_high() takes a relocation hint from "initrd_high" environement
  * variable and if requested ramdisk data is moved to a specified location.
  *
+ * With CONFIG_BOOTM_RAMDISK_DECOMP a compressed ramdisk is decompressed
+ * to the allocated location, instead of being copied there as it is.
+ *
  * Initrd_start and initrd_end are set to final (after relocation) ramdisk
  * start/end addresses if ramdisk image start and len were provided,
  * otherwise set initrd_start and initrd_end set to zeros.
@@ -1055,24 +1485,12 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
  *     -1 - failure
  */
 int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
-		  ulong *initrd_start, ulong *initrd_end)
+		  uint8_t rd_comp, ulong *initrd_start, ulong *initrd_end)
 {
-	char	*s;
 	ulong	initrd_high;
-	int	initrd_copy_to_ram = 1;
-
-	if ((s = getenv("initrd_high")) != NULL) {
-		/* a value of "no" or a similar string will act like 0,
-		 * turning the "load high" feature off. This is intentional.
-		 */
-		initrd_high = simple_strtoul(s, NULL, 16);
-		if (initrd_high == ~0)
-			initrd_copy_to_ram = 0;
-	} else {
-		/* not set, no restrictions to load high */
-		initrd_high = ~0;
-	}
+	int	initrd_copy_to_ram;
 
+	initrd_high = getenv_initrd_high(&initrd_copy_to_ram);
 
 #ifdef CONFIG_LOGBUFFER
 	/* Prevent initrd from overwriting logbuffer */
@@ -1082,12 +1500,34 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 	debug("## initrd_high = 0x%08lx, copy_to_ram = %d\n",
 			initrd_high, initrd_copy_to_ram);
 
+#ifdef CONFIG_BOOTM_RAMDISK_DECOMP
+	if (rd_data && rd_comp != IH_COMP_NONE) {
+		int ret;
+
+		ret = boot_ramdisk_decomp(lmb, rd_data, rd_len, rd_comp,
+					  initrd_high, initrd_start,
+					  initrd_end);
+		if (ret < 0)
+			goto error;
+		if (ret == 0)
+			goto done;
+	}
+#endif
+
 	if (rd_data) {
 		if (!initrd_copy_to_ram) {	/* zero-copy ramdisk support */
 			debug("   in-place initrd\n");
 			*initrd_start = rd_data;
 			*initrd_end = rd_data + rd_len;
 			lmb_reserve(lmb, rd_data, rd_len);
+#if defined(CONFIG_BOOTM_PLAN) && defined(CONFIG_LMB)
+		} else if (rd_data == rd_in_bootmap &&
+			   (!initrd_high || rd_data + rd_len <= initrd_high)) {
+			/* Already where it belongs, and reserved there */
+			debug("   planned initrd\n");
+			*initrd_start = rd_data;
+			*initrd_end = rd_data + rd_len;
+#endif
 		} else {
 			if (initrd_high)
 				*initrd_start = (ulong)lmb_alloc_base(lmb,
@@ -1123,6 +1563,9 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 		*initrd_start = 0;
 		*initrd_end = 0;
 	}
+#ifdef CONFIG_BOOTM_RAMDISK_DECOMP
+done:
+#endif
 	debug("   ramdisk load start = 0x%08lx, ramdisk load end = 0x%08lx\n",
 			*initrd_start, *initrd_end);
 
@@ -1163,11 +1606,8 @@ static const image_header_t *image_get_fdt(ulong fdt_addr)
 		fdt_error("uImage is not a fdt");
 		return NULL;
 	}
-	if (image_get_comp(fdt_hdr) != IH_COMP_NONE) {
-		fdt_error("uImage is compressed");
-		return NULL;
-	}
-	if (fdt_check_header((char *)image_get_data(fdt_hdr)) != 0) {
+	if (image_get_comp(fdt_hdr) == IH_COMP_NONE &&
+	    fdt_check_header((char *)image_get_data(fdt_hdr)) != 0) {
 		fdt_error("uImage data is not a fdt");
 		return NULL;
 	}
@@ -1206,11 +1646,6 @@ static int fit_check_fdt(const void *fit, int fdt_noffset, int verify)
 		return 0;
 	}
 
-	if (!fit_image_check_comp(fit, fdt_noffset, IH_COMP_NONE)) {
-		fdt_error("FDT image is compressed");
-		return 0;
-	}
-
 	return 1;
 }
 #endif /* CONFIG_FIT */
@@ -1247,6 +1682,63 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
 	}
 }
 
+/* The FDT which boot_get_fdt() decompressed into the bootmap, if any */
+static void *fdt_in_bootmap;
+
+/*
+ * Allocate of_len bytes for the FDT within the bootmap, or where fdt_high
+ * says. An fdt_high of all ones means the FDT at fdt_blob is used in place,
+ * and *in_place is set; without an fdt_blob the bootmap is used instead.
+ * Returns the address, or NULL on error (after printing a message).
+ */
+static void *boot_fdt_alloc(struct lmb *lmb, void *fdt_blob, ulong of_len,
+			    int *in_place)
+{
+	void	*of_start = 0;
+	char	*fdt_high;
+
+	*in_place = 0;
+
+	/* If fdt_high is set use it to select the relocation address */
+	fdt_high = getenv("fdt_high");
+	if (fdt_high && !fdt_blob &&
+	    simple_strtoul(fdt_high, NULL, 16) == ~0UL)
+		fdt_high = NULL;
+	if (fdt_high) {
+		void *desired_addr = (void *)simple_strtoul(fdt_high, NULL, 16);
+
+		if (((ulong) desired_addr) == ~0UL) {
+			/* All ones means use fdt in place */
+			desired_addr = fdt_blob;
+			*in_place = 1;
+		}
+		if (desired_addr) {
+			of_start =
+			    (void *)(ulong) lmb_alloc_base(lmb, of_len, 0x1000,
+							   ((ulong)
+							    desired_addr)
+							   + of_len);
+			if (desired_addr && of_start != desired_addr) {
+				puts("Failed using fdt_high value for Device Tree");
+				return NULL;
+			}
+		} else {
+			of_start =
+			    (void *)(ulong) lmb_alloc(lmb, of_len, 0x1000);
+		}
+	} else {
+		of_start =
+		    (void *)(ulong) lmb_alloc_base(lmb, of_len, 0x1000,
+						   getenv_bootm_mapsize()
+						   + getenv_bootm_low());
+	}
+
+	if (of_start == 0)
+		puts("device tree - allocation error\n");
+
+	return of_start;
+}
+
 /**
  * boot_relocate_fdt - relocate flat device tree
  * @lmb: pointer to lmb handle, will be used for memory mgmt
@@ -1258,6 +1750,9 @@ void boot_fdt_add_mem_rsv_regions(struct lmb *lmb, void *fdt_blob)
  * the bootmap.  It also expands the size of the fdt by CONFIG_SYS_FDT_PAD
  * bytes.
  *
+ * A compressed FDT which boot_get_fdt() has already decompressed into the
+ * bootmap is padded and used where it is.
+ *
  * of_flat_tree and of_size are set to final (after relocation) values
  *
  * returns:
@@ -1268,7 +1763,6 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 {
 	void	*fdt_blob = *of_flat_tree;
 	void	*of_start = 0;
-	char	*fdt_high;
 	ulong	of_len = 0;
 	int	err;
 	int	disable_relocation = 0;
@@ -1282,45 +1776,21 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 		goto error;
 	}
 
+	/* boot_get_fdt() decompressed it into the bootmap, with padding */
+	if (fdt_blob == fdt_in_bootmap) {
+		printf("   Using Device Tree in place at %p, end %p\n",
+		       fdt_blob, fdt_blob + *of_size - 1);
+		set_working_fdt_addr(fdt_blob);
+		return 0;
+	}
+
 	/* position on a 4K boundary before the alloc_current */
 	/* Pad the FDT by a specified amount */
 	of_len = *of_size + CONFIG_SYS_FDT_PAD;
 
-	/* If fdt_high is set use it to select the relocation address */
-	fdt_high = getenv("fdt_high");
-	if (fdt_high) {
-		void *desired_addr = (void *)simple_strtoul(fdt_high, NULL, 16);
-
-		if (((ulong) desired_addr) == ~0UL) {
-			/* All ones means use fdt in place */
-			desired_addr = fdt_blob;
-			disable_relocation = 1;
-		}
-		if (desired_addr) {
-			of_start =
-			    (void *)(ulong) lmb_alloc_base(lmb, of_len, 0x1000,
-							   ((ulong)
-							    desired_addr)
-							   + of_len);
-			if (desired_addr && of_start != desired_addr) {
-				puts("Failed using fdt_high value for Device Tree");
-				goto error;
-			}
-		} else {
-			of_start =
-			    (void *)(ulong) lmb_alloc(lmb, of_len, 0x1000);
-		}
-	} else {
-		of_start =
-		    (void *)(ulong) lmb_alloc_base(lmb, of_len, 0x1000,
-						   getenv_bootm_mapsize()
-						   + getenv_bootm_low());
-	}
-
-	if (of_start == 0) {
-		puts("device tree - allocation error\n");
+	of_start = boot_fdt_alloc(lmb, fdt_blob, of_len, &disable_relocation);
+	if (of_start == 0)
 		goto error;
-	}
 
 	if (disable_relocation) {
 		/* We assume there is space after the existing fdt to use for padding */
@@ -1351,7 +1821,99 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size)
 error:
 	return 1;
 }
-#endif /* CONFIG_OF_LIBFDT */
+
+/*
+ * Decompress an FDT subimage to its load address. Without one (load is 0)
+ * it goes straight into the bootmap, where boot_relocate_fdt() would put
+ * it and with the same padding, so that it need not be moved again. The
+ * kernel's load address and the image data still to be read are kept
+ * clear of it. A load address must not overlap the image, [image_start,
+ * image_end), for as much as the FDT may grow to.
+ *
+ * @return the FDT, or NULL on error (after printing a message)
+ */
+static char *boot_fdt_decomp(bootm_headers_t *images, int comp,
+			     const void *data, ulong len, ulong load,
+			     ulong image_start, ulong image_end)
+{
+	ulong unc_len, of_len, size;
+	char *of_start;
+	int ret;
+#ifdef CONFIG_LMB
+	struct lmb *lmb = &images->lmb;
+	struct boot_lmb_held held = { 0 };
+	int in_place;
+#endif
+
+	unc_len = image_decomp_size(comp, data, len);
+	if (!unc_len)
+		unc_len = CONFIG_SYS_BOOTM_LEN;
+
+	if (load) {
+		if (load < image_end && load + unc_len > image_start) {
+			fdt_error("fdt overwritten");
+			return NULL;
+		}
+		of_start = (char *)load;
+		of_len = unc_len;
+	} else {
+#ifdef CONFIG_LMB
+		of_len = ALIGN(unc_len + CONFIG_SYS_FDT_PAD, 0x1000);
+		if (boot_lmb_hold(lmb, &held, (ulong)data, len) ||
+		    boot_lmb_hold(lmb, &held, images->os.image_start,
+				  images->os.image_len) ||
+		    boot_lmb_hold(lmb, &held, images->os.load,
+				  images->os.comp == IH_COMP_NONE ?
+				  images->os.image_len :
+				  CONFIG_SYS_BOOTM_LEN) ||
+		    boot_lmb_hold(lmb, &held, images->rd_start,
+				  images->rd_end - images->rd_start)) {
+			puts("device tree - allocation error\n");
+			of_start = NULL;
+		} else {
+			of_start = boot_fdt_alloc(lmb, NULL, of_len,
+						  &in_place);
+		}
+		boot_lmb_unhold(lmb, &held);
+		if (!of_start)
+			return NULL;
+		of_len -= CONFIG_SYS_FDT_PAD;
+#else
+		fdt_error("Compressed FDT has no load address");
+		return NULL;
+#endif
+	}
+
+	printf("   Uncompressing FDT to %p ... ", of_start);
+	ret = image_decomp(comp, of_start, of_len, data, len, &size);
+	if (ret) {
+		if (ret == IMAGE_DECOMP_UNSUPPORTED)
+			printf("compression type %d not supported", comp);
+		puts(" - must RESET the board to recover.\n");
+		return NULL;
+	}
+	if (fdt_check_header(of_start) != 0 || fdt_totalsize(of_start) > size) {
+		fdt_error("uncompressed data is not a fdt");
+		return NULL;
+	}
+	puts("OK\n");
+
+#ifdef CONFIG_LMB
+	if (!load) {
+		/* Keep the FDT and its padding, and give back the rest */
+		of_len += CONFIG_SYS_FDT_PAD;
+		size = fdt_totalsize(of_start) + CONFIG_SYS_FDT_PAD;
+		if (of_len > ALIGN(size, 0x1000))
+			lmb_free(lmb, (ulong)of_start + ALIGN(size, 0x1000),
+				 of_len - ALIGN(size, 0x1000));
+		fdt_set_totalsize(of_start, size);
+		fdt_in_bootmap = of_start;
+	}
+#endif
+
+	return of_start;
+}
+#endif /* CONFIG_OF_LIBFDT */
 
 /**
  * boot_get_fdt - main fdt handling routine
@@ -1391,10 +1953,12 @@ int boot_get_fdt(int flag, int argc, char * const argv[],
 	int		fdt_noffset;
 	const void	*data;
 	size_t		size;
+	uint8_t		comp;
 #endif
 
 	*of_flat_tree = NULL;
 	*of_size = 0;
+	fdt_in_bootmap = NULL;
 
 	if (argc > 3 || genimg_has_config(images)) {
 #if defined(CONFIG_FIT)
@@ -1498,6 +2062,18 @@ int boot_get_fdt(int flag, int argc, char * const argv[],
 				goto error;
 			}
 
+			if (image_get_comp(fdt_hdr) != IH_COMP_NONE) {
+				fdt_blob = boot_fdt_decomp(images,
+						image_get_comp(fdt_hdr),
+						(void *)image_get_data(fdt_hdr),
+						image_get_data_size(fdt_hdr),
+						load_start, image_start,
+						image_end);
+				if (!fdt_blob)
+					goto error;
+				break;
+			}
+
 			debug("   Loading FDT from 0x%08lx to 0x%08lx\n",
 					image_get_data(fdt_hdr), load_start);
 
@@ -1579,8 +2155,13 @@ int boot_get_fdt(int flag, int argc, char * const argv[],
 					goto error;
 				}
 
+				if (fit_image_get_comp(fit_hdr, fdt_noffset,
+							&comp))
+					comp = IH_COMP_NONE;
+
 				/* verift that image data is a proper FDT blob */
-				if (fdt_check_header((char *)data) != 0) {
+				if (comp == IH_COMP_NONE &&
+				    fdt_check_header((char *)data) != 0) {
 					fdt_error("Subimage data is not a FTD");
 					goto error;
 				}
@@ -1592,7 +2173,18 @@ int boot_get_fdt(int flag, int argc, char * const argv[],
 				image_start = (ulong)fit_hdr;
 				image_end = fit_get_end(fit_hdr);
 
-				if (fit_image_get_load(fit_hdr, fdt_noffset,
+				if (comp != IH_COMP_NONE) {
+					if (fit_image_get_load(fit_hdr,
+							fdt_noffset,
+							&load_start))
+						load_start = 0;
+					fdt_blob = boot_fdt_decomp(images,
+							comp, data, size,
+							load_start, image_start,
+							image_end);
+					if (!fdt_blob)
+						goto error;
+				} else if (fit_image_get_load(fit_hdr, fdt_noffset,
 							&load_start) == 0) {
 					load_end = load_start + size;
 
@@ -1765,6 +2357,168 @@ int boot_get_kbd(struct lmb *lmb, bd_t **kbd)
 	return 0;
 }
 #endif /* CONFIG_SYS_BOOT_GET_KBD */
+
+#ifdef CONFIG_BOOTM_PLAN
+/* Is the region all in memory which bootm may use, and not reserved? */
+static int boot_lmb_is_free(struct lmb *lmb, ulong base, ulong size)
+{
+	struct lmb_property *mem;
+	int i;
+
+	if (base + size < base ||
+	    lmb_overlaps_region(&lmb->reserved, base, size) >= 0)
+		return 0;
+
+	for (i = 0; i < lmb->memory.cnt; i++) {
+		mem = &lmb->memory.region[i];
+		if (base >= mem->base && base + size <= mem->base + mem->size)
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * boot_plan_image - work out where to load an image
+ * @hdr: legacy image header, or the FIT blob, already in memory
+ * @plan: returns where to put the image and its parts
+ *
+ * bootm copies an uncompressed kernel from the image to its load address,
+ * and a ramdisk to the top of the memory which "initrd_high" allows.
+ * Loading them there in the first place saves the copies. This works out
+ * those places from the image and the memory map that bootm will start
+ * with, and checks that they are free.
+ *
+ * A legacy image, or a FIT image with its data embedded, is loaded in one
+ * piece, so only the kernel can be put in place, by putting the whole
+ * image just below it. A FIT image with external data can have its
+ * kernel and ramdisk read to their places separately.
+ *
+ * returns:
+ *     0, if there is a plan, with the fields not used set to 0
+ *     -1, if the image might as well go where the loader likes
+ */
+int boot_plan_image(const void *hdr, struct boot_plan *plan)
+{
+	struct lmb lmb;
+	ulong load, len, offset, image_len;
+	int external = 0;
+#if defined(CONFIG_FIT)
+	int cfg_noffset = -1, noffset;
+	const void *data;
+	size_t size;
+#ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
+	ulong initrd_high, addr;
+	int copy_to_ram;
+	__maybe_unused uint8_t comp;
+#endif
+#endif
+
+	memset(plan, '\0', sizeof(*plan));
+
+	switch (genimg_get_format((void *)hdr)) {
+	case IMAGE_FORMAT_LEGACY:
+		if (!image_check_type(hdr, IH_TYPE_KERNEL) ||
+		    image_get_comp(hdr) != IH_COMP_NONE)
+			return -1;
+		load = image_get_load(hdr);
+		len = image_get_data_size(hdr);
+		offset = image_get_header_size();
+		image_len = image_get_image_size(hdr);
+		break;
+#if defined(CONFIG_FIT)
+	case IMAGE_FORMAT_FIT:
+		cfg_noffset = fit_conf_select(hdr, NULL);
+		if (cfg_noffset < 0)
+			return -1;
+		noffset = fit_conf_get_kernel_node(hdr, cfg_noffset);
+		if (noffset < 0 ||
+		    !fit_image_check_type(hdr, noffset, IH_TYPE_KERNEL) ||
+		    !fit_image_check_comp(hdr, noffset, IH_COMP_NONE) ||
+		    fit_image_get_load(hdr, noffset, &load))
+			return -1;
+		if (!fit_image_get_data_offset(hdr, noffset, &offset, &size)) {
+			external = 1;
+		} else if (!fit_image_get_data(hdr, noffset, &data, &size)) {
+			offset = data - hdr;
+		} else {
+			return -1;
+		}
+		len = size;
+		image_len = fit_get_total_size(hdr);
+		break;
+#endif
+	default:
+		return -1;
+	}
+
+	boot_start_lmb(&lmb);
+
+	/* Leave room for loaders which read whole blocks, or grow the FIT */
+	image_len += 0x1000;
+
+	if (!external) {
+		if (load >= offset && load - offset != (ulong)hdr &&
+		    boot_lmb_is_free(&lmb, load - offset, image_len))
+			plan->image = load - offset;
+	} else if (boot_lmb_is_free(&lmb, load, len) &&
+		   (load + len <= (ulong)hdr ||
+		    load >= (ulong)hdr + image_len)) {
+		plan->kernel = load;
+	}
+
+#if defined(CONFIG_FIT) && defined(CONFIG_SYS_BOOT_RAMDISK_HIGH)
+	/* bootm reserves the kernel before it places the ramdisk */
+	lmb_reserve(&lmb, load, len);
+
+	noffset = external ? fit_conf_get_ramdisk_node(hdr, cfg_noffset) : -1;
+	initrd_high = getenv_initrd_high(&copy_to_ram);
+	if (noffset >= 0 && copy_to_ram &&
+#ifdef CONFIG_BOOTM_RAMDISK_DECOMP
+	    /* the data is decompressed from wherever it is */
+	    (fit_image_get_comp(hdr, noffset, &comp) ||
+	     comp == IH_COMP_NONE) &&
+#endif
+	    !fit_image_get_data_offset(hdr, noffset, &offset, &size)) {
+		addr = __lmb_alloc_base(&lmb, size, 0x1000, initrd_high);
+		if (addr && (addr + size <= (ulong)hdr ||
+			     addr >= (ulong)hdr + image_len))
+			plan->ramdisk = addr;
+	}
+#endif
+	lmb_release(&lmb);
+
+	debug("%s: image %08lx, kernel %08lx, ramdisk %08lx\n", __func__,
+	      plan->image, plan->kernel, plan->ramdisk);
+
+	return plan->image || plan->kernel || plan->ramdisk ? 0 : -1;
+}
+
+/**
+ * boot_plan_move - move the start of an image to where it should be loaded
+ * @addr: where the loader has read the start of a legacy image
+ * @len: how much of it the loader has read
+ *
+ * Loaders which read the image header first call this before reading the
+ * rest. See boot_plan_image().
+ *
+ * returns:
+ *     address at which to continue loading the image
+ */
+ulong boot_plan_move(ulong addr, ulong len)
+{
+	struct boot_plan plan;
+
+	if (boot_plan_image((void *)addr, &plan) || !plan.image)
+		return addr;
+
+	printf("   Loading image to %08lx, so the kernel need not be moved\n",
+	       plan.image);
+	memmove((void *)plan.image, (void *)addr, len);
+
+	return plan.image;
+}
+#endif /* CONFIG_BOOTM_PLAN */
 #endif /* !USE_HOSTCC */
 
 #if defined(CONFIG_FIT)
@@ -2390,6 +3144,38 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 	return 0;
 }
 
+/**
+ * fit_image_get_data_offset - get position of external image data
+ * @fit: pointer to the FIT format image header
+ * @noffset: component image node offset
+ * @offset: pointer to ulong, will hold data offset from fit_get_data_base()
+ * @size: pointer to size_t, will hold data size
+ *
+ * fit_image_get_data_offset() reads the data-offset and data-size properties
+ * of an image whose data is stored after the FIT blob rather than in it.
+ *
+ * returns:
+ *     0, on success
+ *     -1, if the image has no external data
+ */
+static int fit_image_get_data_offset(const void *fit, int noffset,
+		ulong *offset, size_t *size)
+{
+	const uint32_t *val;
+
+	val = fdt_getprop(fit, noffset, FIT_DATA_OFFSET_PROP, NULL);
+	if (val == NULL)
+		return -1;
+	*offset = uimage_to_cpu(*val);
+
+	val = fdt_getprop(fit, noffset, FIT_DATA_SIZE_PROP, NULL);
+	if (val == NULL)
+		return -1;
+	*size = uimage_to_cpu(*val);
+
+	return 0;
+}
+
 /**
  * fit_image_get_data - get data property and its size for a given component image node
  * @fit: pointer to the FIT format image header
@@ -2399,7 +3185,10 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
  *
  * fit_image_get_data() finds data property in a given component image node.
  * If the property is found its data start address and size are returned to
- * the caller.
+ * the caller. Images with external data are found at their data-offset
+ * past the FIT blob, which the caller must have loaded there, or at their
+ * data-address if fit_load_external() put them somewhere else during this
+ * boot. A data-address it did not add is ignored.
  *
  * returns:
  *     0, on success
@@ -2408,10 +3197,24 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 int fit_image_get_data(const void *fit, int noffset,
 		const void **data, size_t *size)
 {
+	ulong offset;
 	int len;
 
 	*data = fdt_getprop(fit, noffset, FIT_DATA_PROP, &len);
 	if (*data == NULL) {
+		if (!fit_image_get_data_offset(fit, noffset, &offset, size)) {
+#if !defined(USE_HOSTCC) && defined(CONFIG_FIT_PARTIAL_LOAD) && \
+	defined(CONFIG_BOOTM_PLAN)
+			ulong addr;
+
+			if (!fit_image_get_data_addr(fit, noffset, &addr)) {
+				*data = (void *)addr;
+				return 0;
+			}
+#endif
+			*data = fit + fit_get_data_base(fit) + offset;
+			return 0;
+		}
 		fit_get_debug(fit, noffset, FIT_DATA_PROP, len);
 		*size = 0;
 		return -1;
@@ -2421,6 +3224,39 @@ int fit_image_get_data(const void *fit, int noffset,
 	return 0;
 }
 
+/**
+ * fit_get_total_size - get size of FIT image including external data
+ * @fit: pointer to the FIT format image header
+ *
+ * returns:
+ *     number of bytes from the start of the FIT image to the end of the
+ *     last external image data, or the blob size if there is none
+ */
+ulong fit_get_total_size(const void *fit)
+{
+	ulong total = fdt_totalsize(fit);
+	ulong base = fit_get_data_base(fit);
+	int images_noffset, noffset, ndepth;
+	ulong offset;
+	size_t size;
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0)
+		return total;
+
+	for (ndepth = 0,
+	     noffset = fdt_next_node(fit, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth == 1 &&
+		    !fit_image_get_data_offset(fit, noffset, &offset, &size) &&
+		    base + offset + size > total)
+			total = base + offset + size;
+	}
+
+	return total;
+}
+
 /**
  * fit_image_hash_get_algo - get hash algorithm name
  * @fit: pointer to the FIT format image header
@@ -2721,6 +3557,220 @@ int fit_image_hash_set_value(void *fit, int noffset, uint8_t *value,
 }
 #endif /* USE_HOSTCC */
 
+#if defined(CONFIG_CPU_WORK) && !defined(USE_HOSTCC)
+/* Most images whose hashes are worked out on other CPUs at once */
+#define FIT_MAX_HASH_JOBS	8
+
+/* Most hash nodes of an image that a job handles */
+#define FIT_MAX_JOB_HASHES	4
+
+struct fit_hash_job {
+	const void *fit;		/* NULL if the slot is free */
+	int image_noffset;
+	const void *data;
+	size_t size;
+	int count;
+	struct {
+		int noffset;		/* hash node */
+		char *algo;
+		uint8_t value[FIT_MAX_HASH_LEN];
+		int value_len;
+		int err;
+	} hash[FIT_MAX_JOB_HASHES];
+	struct cpu_work work;
+};
+
+static struct fit_hash_job fit_hash_jobs[FIT_MAX_HASH_JOBS];
+
+/*
+ * As calculate_hash(), but without the watchdog resets of the *_wd()
+ * helpers, which a job on another CPU must not do
+ */
+static int fit_hash_job_calc(const void *data, int data_len, const char *algo,
+			     uint8_t *value, int *value_len)
+{
+	if (strcmp(algo, "crc32") == 0) {
+		*((uint32_t *)value) = cpu_to_uimage(crc32(0, data, data_len));
+		*value_len = 4;
+	} else if (strcmp(algo, "sha1") == 0) {
+		sha1_csum((unsigned char *)data, data_len,
+			  (unsigned char *)value);
+		*value_len = 20;
+	} else if (strcmp(algo, "md5") == 0) {
+		md5((unsigned char *)data, data_len, value);
+		*value_len = 16;
+	} else {
+		return -1;
+	}
+	return 0;
+}
+
+/* Runs on another CPU, so must not print */
+static void fit_hash_job_run(void *arg)
+{
+	struct fit_hash_job *job = arg;
+	int i;
+
+	for (i = 0; i < job->count; i++)
+		job->hash[i].err = fit_hash_job_calc(job->data, job->size,
+						     job->hash[i].algo,
+						     job->hash[i].value,
+						     &job->hash[i].value_len);
+}
+
+/**
+ * fit_image_hash_start - start working out the hashes of an image
+ * @fit: pointer to the FIT format image header
+ * @image_noffset: component image node offset
+ *
+ * fit_image_hash_start() works out the hashes of a component image on
+ * another CPU, if one is free. A later fit_image_check_hashes() for the
+ * image waits for the values and compares them, instead of working them
+ * out itself. The image data must not change until fit_image_hash_finish().
+ *
+ * returns:
+ *     0, if the hashes are being worked out
+ *     -1, if fit_image_check_hashes() must do it
+ */
+int fit_image_hash_start(const void *fit, int image_noffset)
+{
+	struct fit_hash_job *job = NULL;
+	const void *data;
+	size_t size;
+	char *algo;
+	int noffset;
+	int ndepth;
+	int i;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size))
+		return -1;
+
+	for (i = 0; i < FIT_MAX_HASH_JOBS; i++) {
+		if (fit_hash_jobs[i].fit == fit &&
+		    fit_hash_jobs[i].image_noffset == image_noffset &&
+		    fit_hash_jobs[i].data == data &&
+		    fit_hash_jobs[i].size == size)
+			return 0;
+		if (!fit_hash_jobs[i].fit && !job)
+			job = &fit_hash_jobs[i];
+	}
+	if (!job)
+		return -1;
+	job->data = data;
+	job->size = size;
+
+	job->count = 0;
+	for (ndepth = 0, noffset = fdt_next_node(fit, image_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0) &&
+	     job->count < FIT_MAX_JOB_HASHES;
+	     noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth != 1 || strncmp(fit_get_name(fit, noffset, NULL),
+				FIT_HASH_NODENAME,
+				strlen(FIT_HASH_NODENAME)) != 0)
+			continue;
+
+		/* Leave errors to be reported by fit_image_check_hashes() */
+		if (fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    (strcmp(algo, "crc32") && strcmp(algo, "sha1") &&
+		     strcmp(algo, "md5")))
+			continue;
+		job->hash[job->count].noffset = noffset;
+		job->hash[job->count].algo = algo;
+		job->count++;
+	}
+	if (!job->count)
+		return -1;
+
+	job->fit = fit;
+	job->image_noffset = image_noffset;
+	cpu_work_start(&job->work, fit_hash_job_run, job);
+
+	return 0;
+}
+
+/**
+ * fit_conf_hash_start - start working out hashes of a configuration
+ * @fit: pointer to the FIT format image header
+ * @cfg_noffset: configuration node offset
+ *
+ * fit_conf_hash_start() calls fit_image_hash_start() for the ramdisk and
+ * fdt of a configuration, so that they are hashed while the boot CPU
+ * checks the kernel.
+ *
+ * returns:
+ *     no returned results
+ */
+void fit_conf_hash_start(const void *fit, int cfg_noffset)
+{
+	int noffset;
+
+	noffset = fit_conf_get_ramdisk_node(fit, cfg_noffset);
+	if (noffset >= 0)
+		fit_image_hash_start(fit, noffset);
+	noffset = fit_conf_get_fdt_node(fit, cfg_noffset);
+	if (noffset >= 0)
+		fit_image_hash_start(fit, noffset);
+}
+
+/**
+ * fit_image_hash_finish - wait for all hashes being worked out
+ *
+ * fit_image_hash_finish() waits for every fit_image_hash_start() job and
+ * drops its results, after which the image data may change.
+ *
+ * returns:
+ *     no returned results
+ */
+void fit_image_hash_finish(void)
+{
+	int i;
+
+	for (i = 0; i < FIT_MAX_HASH_JOBS; i++) {
+		if (fit_hash_jobs[i].fit) {
+			cpu_work_wait(&fit_hash_jobs[i].work);
+			fit_hash_jobs[i].fit = NULL;
+		}
+	}
+}
+
+/*
+ * Get a hash value from fit_image_hash_start(), waiting if need be. The
+ * job must have hashed the same data, not just the same node.
+ */
+static int fit_hash_job_value(const void *fit, int noffset, const void *data,
+			      size_t size, uint8_t *value, int *value_len)
+{
+	struct fit_hash_job *job;
+	int i, j;
+
+	for (i = 0; i < FIT_MAX_HASH_JOBS; i++) {
+		job = &fit_hash_jobs[i];
+		if (job->fit != fit || job->data != data || job->size != size)
+			continue;
+		for (j = 0; j < job->count; j++) {
+			if (job->hash[j].noffset != noffset)
+				continue;
+			cpu_work_wait(&job->work);
+			if (job->hash[j].err)
+				return -1;
+			memcpy(value, job->hash[j].value,
+			       job->hash[j].value_len);
+			*value_len = job->hash[j].value_len;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+#else
+static inline int fit_hash_job_value(const void *fit, int noffset,
+				     const void *data, size_t size,
+				     uint8_t *value, int *value_len)
+{
+	return -1;
+}
+#endif /* CONFIG_CPU_WORK && !USE_HOSTCC */
+
 /**
  * fit_image_check_hashes - verify data intergity
  * @fit: pointer to the FIT format image header
@@ -2728,7 +3778,8 @@ int fit_image_hash_set_value(void *fit, int noffset, uint8_t *value,
  *
  * fit_image_check_hashes() goes over component image hash nodes,
  * re-calculates each data hash and compares with the value stored in hash
- * node.
+ * node. Hashes already worked out by fit_image_hash_start() are not
+ * calculated again.
  *
  * returns:
  *     1, if all hashes are valid
@@ -2784,7 +3835,9 @@ int fit_image_check_hashes(const void *fit, int image_noffset)
 				goto error;
 			}
 
-			if (calculate_hash(data, size, algo, value,
+			if (fit_hash_job_value(fit, noffset, data, size,
+					       value, &value_len) &&
+			    calculate_hash(data, size, algo, value,
 						&value_len)) {
 				err_msg = " error!\n"
 						"Unsupported hash algorithm";
@@ -2811,6 +3864,167 @@ error:
 	return 0;
 }
 
+#ifndef USE_HOSTCC
+/* Most hash nodes fit_image_load_check_hashes() handles in one pass */
+#define FIT_MAX_LOAD_HASHES	4
+
+/* Small enough to still be in the cache when it is copied after hashing */
+#define FIT_LOAD_CHUNKSZ	(16 * 1024)
+
+struct fit_load_hash {
+	int noffset;			/* hash node */
+	char *algo;
+	union {
+		uint32_t crc32;
+		sha1_context sha1;
+		struct MD5Context md5;
+	} ctx;
+};
+
+static int fit_load_hash_start(struct fit_load_hash *hash)
+{
+	if (strcmp(hash->algo, "crc32") == 0)
+		hash->ctx.crc32 = 0;
+	else if (strcmp(hash->algo, "sha1") == 0)
+		sha1_starts(&hash->ctx.sha1);
+	else if (strcmp(hash->algo, "md5") == 0)
+		MD5Init(&hash->ctx.md5);
+	else
+		return -1;
+
+	return 0;
+}
+
+static void fit_load_hash_update(struct fit_load_hash *hash,
+				 const void *data, size_t len)
+{
+	if (strcmp(hash->algo, "crc32") == 0)
+		hash->ctx.crc32 = crc32(hash->ctx.crc32, data, len);
+	else if (strcmp(hash->algo, "sha1") == 0)
+		sha1_update(&hash->ctx.sha1, (unsigned char *)data, len);
+	else
+		MD5Update(&hash->ctx.md5, data, len);
+}
+
+static int fit_load_hash_finish(struct fit_load_hash *hash, uint8_t *value)
+{
+	if (strcmp(hash->algo, "crc32") == 0) {
+		*((uint32_t *)value) = cpu_to_uimage(hash->ctx.crc32);
+		return 4;
+	} else if (strcmp(hash->algo, "sha1") == 0) {
+		sha1_finish(&hash->ctx.sha1, value);
+		return 20;
+	}
+	MD5Final(value, &hash->ctx.md5);
+	return 16;
+}
+
+/**
+ * fit_image_load_check_hashes - copy image data and verify it together
+ * @fit: pointer to the FIT format image header
+ * @image_noffset: component image node offset
+ * @dst: where to copy the image data
+ *
+ * fit_image_load_check_hashes() copies the component image data to dst
+ * and checks its hashes, like fit_image_check_hashes(), reading the data
+ * only once: each chunk is hashed and then copied while still in the
+ * cache. If dst overlaps the end of the data, or the image has more hash
+ * nodes than are handled here, the hashes are checked first and then the
+ * data is copied.
+ *
+ * returns:
+ *     1, if all hashes are valid
+ *     0, otherwise (or on error), in which case dst may already have
+ *        been overwritten with some or all of the data
+ */
+int fit_image_load_check_hashes(const void *fit, int image_noffset, void *dst)
+{
+	struct fit_load_hash hash[FIT_MAX_LOAD_HASHES];
+	const void	*data;
+	size_t		size, pos, chunk;
+	uint8_t		*fit_value;
+	int		fit_value_len;
+	uint8_t		value[FIT_MAX_HASH_LEN];
+	int		count = 0;
+	int		noffset;
+	int		ndepth;
+	int		i;
+	char		*err_msg = "";
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size)) {
+		printf("Can't get image data/size\n");
+		return 0;
+	}
+
+	/* Copying forwards would overwrite data before it is hashed */
+	if (dst > data && dst < data + size)
+		goto two_pass;
+
+	for (ndepth = 0, noffset = fdt_next_node(fit, image_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth != 1 || strncmp(fit_get_name(fit, noffset, NULL),
+				FIT_HASH_NODENAME,
+				strlen(FIT_HASH_NODENAME)) != 0)
+			continue;
+		if (count == FIT_MAX_LOAD_HASHES)
+			goto two_pass;
+
+		hash[count].noffset = noffset;
+		if (fit_image_hash_get_algo(fit, noffset,
+					    &hash[count].algo)) {
+			err_msg = " error!\nCan't get hash algo property";
+			goto error;
+		}
+		if (fit_load_hash_start(&hash[count])) {
+			err_msg = " error!\nUnsupported hash algorithm";
+			goto error;
+		}
+		count++;
+	}
+
+	for (pos = 0; pos < size; pos += chunk) {
+		chunk = min(size - pos, (size_t)FIT_LOAD_CHUNKSZ);
+		WATCHDOG_RESET();
+		for (i = 0; i < count; i++)
+			fit_load_hash_update(&hash[i], data + pos, chunk);
+		memmove(dst + pos, data + pos, chunk);
+	}
+
+	for (i = 0; i < count; i++) {
+		noffset = hash[i].noffset;
+		printf("%s", hash[i].algo);
+		if (fit_image_hash_get_value(fit, noffset, &fit_value,
+					     &fit_value_len)) {
+			err_msg = " error!\nCan't get hash value property";
+			goto error;
+		}
+		if (fit_load_hash_finish(&hash[i], value) != fit_value_len) {
+			err_msg = " error !\nBad hash value len";
+			goto error;
+		} else if (memcmp(value, fit_value, fit_value_len) != 0) {
+			err_msg = " error!\nBad hash value";
+			goto error;
+		}
+		printf("+ ");
+	}
+
+	return 1;
+
+two_pass:
+	if (!fit_image_check_hashes(fit, image_noffset))
+		return 0;
+	memmove_wd(dst, (void *)data, size, CHUNKSZ);
+	return 1;
+
+error:
+	printf("%s for '%s' hash node in '%s' image node\n",
+			err_msg, fit_get_name(fit, noffset, NULL),
+			fit_get_name(fit, image_noffset, NULL));
+	return 0;
+}
+#endif /* !USE_HOSTCC */
+
 /**
  * fit_all_image_check_hashes - verify data intergity for all images
  * @fit: pointer to the FIT format image header
@@ -2837,6 +4051,15 @@ int fit_all_image_check_hashes(const void *fit)
 		return 0;
 	}
 
+	/* Let other CPUs work out hashes while earlier ones are checked */
+	for (ndepth = 0,
+		noffset = fdt_next_node(fit, images_noffset, &ndepth);
+		(noffset >= 0) && (ndepth > 0);
+		noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth == 1)
+			fit_image_hash_start(fit, noffset);
+	}
+
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 		(ulong)fit);
@@ -2852,11 +4075,14 @@ int fit_all_image_check_hashes(const void *fit)
 			printf("   Hash(es) for Image %u (%s): ", count++,
 					fit_get_name(fit, noffset, NULL));
 
-			if (!fit_image_check_hashes(fit, noffset))
+			if (!fit_image_check_hashes(fit, noffset)) {
+				fit_image_hash_finish();
 				return 0;
+			}
 			printf("\n");
 		}
 	}
+	fit_image_hash_finish();
 	return 1;
 }
 
@@ -3057,6 +4283,7 @@ int fit_conf_find_compat(const void *fit, const void *fdt)
 		const char *kfdt_name;
 		int kfdt_noffset;
 		const char *cur_fdt_compat;
+		int compat_noffset;
 		int len;
 		size_t size;
 		int i;
@@ -3077,11 +4304,20 @@ int fit_conf_find_compat(const void *fit, const void *fdt)
 			continue;
 		}
 		/*
-		 * Get a pointer to this configuration's fdt.
+		 * An fdt stored outside the FIT blob carries its compatible
+		 * strings in its image node, so that a configuration can be
+		 * picked before any fdt is loaded. Otherwise get a pointer
+		 * to this configuration's fdt.
 		 */
-		if (fit_image_get_data(fit, kfdt_noffset, &kfdt, &size)) {
+		if (fdt_getprop(fit, kfdt_noffset, FIT_COMPAT_PROP, NULL)) {
+			kfdt = fit;
+			compat_noffset = kfdt_noffset;
+		} else if (fit_image_get_data(fit, kfdt_noffset, &kfdt,
+					      &size)) {
 			debug("Failed to get fdt \"%s\".\n", kfdt_name);
 			continue;
+		} else {
+			compat_noffset = 0;
 		}
 
 		len = fdt_compat_len;
@@ -3094,7 +4330,7 @@ int fit_conf_find_compat(const void *fit, const void *fdt)
 		     (!best_match_offset || best_match_pos > i); i++) {
 			int cur_len = strlen(cur_fdt_compat) + 1;
 
-			if (!fdt_node_check_compatible(kfdt, 0,
+			if (!fdt_node_check_compatible(kfdt, compat_noffset,
 						       cur_fdt_compat)) {
 				best_match_offset = noffset;
 				best_match_pos = i;
@@ -3164,6 +4400,29 @@ int fit_conf_get_node(const void *fit, const char *conf_uname)
 	return noffset;
 }
 
+/**
+ * fit_conf_select - get node offset of the configuration to boot
+ * @fit: pointer to the FIT format image header
+ * @conf_uname: configuration node unit name, or NULL
+ *
+ * fit_conf_select() picks the configuration that bootm uses when given
+ * @conf_uname. With no name, this is the configuration which best matches
+ * U-Boot's own device tree if CONFIG_FIT_BEST_MATCH is defined, and the
+ * default configuration otherwise.
+ *
+ * returns:
+ *     configuration node offset when found (>=0)
+ *     negative number on failure
+ */
+int fit_conf_select(const void *fit, const char *conf_uname)
+{
+#if defined(CONFIG_FIT_BEST_MATCH) && !defined(USE_HOSTCC)
+	if (conf_uname == NULL)
+		return fit_conf_find_compat(fit, gd->fdt_blob);
+#endif
+	return fit_conf_get_node(fit, conf_uname);
+}
+
 static int __fit_conf_get_prop_node(const void *fit, int noffset,
 		const char *prop_name)
 {
@@ -3278,6 +4537,202 @@ void fit_conf_print(const void *fit, int noffset, const char *p)
 		printf("%s  FDT:          %s\n", p, uname);
 }
 
+#ifndef USE_HOSTCC
+#if defined(CONFIG_FIT_PARTIAL_LOAD) && defined(CONFIG_BOOTM_PLAN)
+/* Room for the data-address properties which fit_plan_external() adds */
+#define FIT_PLAN_SPACE		64
+
+/*
+ * Plan where to read the kernel and ramdisk data so that bootm need not
+ * move them, and record it in data-address properties. The FIT blob is
+ * grown in place for these, so this must come before any data is read
+ * after it. Returns 0 if anything was planned, -1 if not.
+ */
+static int fit_plan_external(void *fit, ulong *kernel, ulong *ramdisk)
+{
+	struct boot_plan plan;
+	int cfg_noffset, noffset;
+	uint32_t val;
+
+	if (boot_plan_image(fit, &plan) || (!plan.kernel && !plan.ramdisk))
+		return -1;
+	if (fdt_open_into(fit, fit, fdt_totalsize(fit) + FIT_PLAN_SPACE))
+		return -1;
+
+	/* Node offsets move as each property is added */
+	if (plan.kernel) {
+		cfg_noffset = fit_conf_select(fit, NULL);
+		noffset = fit_conf_get_kernel_node(fit, cfg_noffset);
+		val = cpu_to_uimage(plan.kernel);
+		if (noffset >= 0 && !fdt_setprop(fit, noffset,
+				FIT_DATA_ADDR_PROP, &val, sizeof(val)))
+			*kernel = plan.kernel;
+	}
+	if (plan.ramdisk) {
+		cfg_noffset = fit_conf_select(fit, NULL);
+		noffset = fit_conf_get_ramdisk_node(fit, cfg_noffset);
+		val = cpu_to_uimage(plan.ramdisk);
+		if (noffset >= 0 && !fdt_setprop(fit, noffset,
+				FIT_DATA_ADDR_PROP, &val, sizeof(val)))
+			*ramdisk = plan.ramdisk;
+	}
+
+	/* Only now are these data-address properties to be trusted */
+	fit_planned.fit = fit;
+	fit_planned.addr[0] = *kernel;
+	fit_planned.addr[1] = *ramdisk;
+
+	return 0;
+}
+#endif
+
+/**
+ * fit_load_external - read external image data of a FIT image
+ * @fit: pointer to the FIT format image header, with the blob in memory
+ * @read: function reading part of the FIT image from storage
+ * @priv: private data for @read
+ *
+ * fit_load_external() reads the data of images stored after the FIT blob
+ * to where fit_image_get_data() expects it. With CONFIG_FIT_PARTIAL_LOAD
+ * only the kernel, ramdisk and fdt of the configuration picked by
+ * fit_conf_select() are read, so booting another configuration from the
+ * same load is not possible. Otherwise all external data is read at once.
+ *
+ * With CONFIG_BOOTM_PLAN as well, the kernel and ramdisk data are read
+ * straight to where bootm would otherwise copy them; see boot_plan_image().
+ *
+ * returns:
+ *     0, on success, or if the image has no external data
+ *     -1, on failure
+ */
+int fit_load_external(void *fit, fit_read_fn read, void *priv)
+{
+	ulong base = fit_get_data_base(fit);
+	ulong total = fit_get_total_size(fit);
+#ifdef CONFIG_FIT_PARTIAL_LOAD
+	static const char * const props[] = {
+		FIT_KERNEL_PROP, FIT_RAMDISK_PROP, FIT_FDT_PROP,
+	};
+	ulong addr[ARRAY_SIZE(props)];
+	ulong file_base = base;
+	int cfg_noffset, noffset, i;
+	ulong offset;
+	size_t size;
+	void *buf;
+#endif
+
+#if defined(CONFIG_FIT_PARTIAL_LOAD) && defined(CONFIG_BOOTM_PLAN)
+	/* A new image: forget where the last one's data went */
+	fit_planned.fit = NULL;
+#endif
+	if (total <= base)
+		return 0;
+
+#ifdef CONFIG_FIT_PARTIAL_LOAD
+	cfg_noffset = fit_conf_select(fit, NULL);
+	if (cfg_noffset >= 0) {
+		memset(addr, '\0', sizeof(addr));
+#ifdef CONFIG_BOOTM_PLAN
+		if (!fit_plan_external(fit, &addr[0], &addr[1])) {
+			/* The blob has grown, so the data starts later */
+			base = fit_get_data_base(fit);
+			cfg_noffset = fit_conf_select(fit, NULL);
+		}
+#endif
+		for (i = 0; i < ARRAY_SIZE(props); i++) {
+			noffset = __fit_conf_get_prop_node(fit, cfg_noffset,
+							   props[i]);
+			if (noffset < 0 || fit_image_get_data_offset(fit,
+					noffset, &offset, &size))
+				continue;
+			buf = addr[i] ? (void *)addr[i] : fit + base + offset;
+			debug("Reading '%s' data: 0x%lx bytes at 0x%lx to %p\n",
+			      fit_get_name(fit, noffset, NULL), (ulong)size,
+			      file_base + offset, buf);
+			if (read(priv, file_base + offset, size, buf))
+				return -1;
+		}
+		return 0;
+	}
+	debug("No configuration found, reading all image data\n");
+#endif
+	return read(priv, base, total - base, fit + base);
+}
+
+struct fit_blk_priv {
+	block_dev_desc_t *dev_desc;
+	ulong start;
+};
+
+/*
+ * Whole blocks are read straight into buf; a partial block at either end
+ * goes through a bounce buffer, so nothing outside buf is written. The
+ * data may be going to where bootm will run it rather than into the FIT.
+ */
+static int fit_read_blk(void *priv, ulong offset, ulong size, void *buf)
+{
+	struct fit_blk_priv *blk = priv;
+	block_dev_desc_t *dev_desc = blk->dev_desc;
+	ulong blksz = dev_desc->blksz;
+	ulong blknr = blk->start + offset / blksz;
+	ulong skip = offset % blksz;
+	ulong len, cnt;
+	char *dst = buf;
+	ALLOC_CACHE_ALIGN_BUFFER(char, bounce, blksz);
+
+	if (skip) {
+		len = min(size, blksz - skip);
+		if (dev_desc->block_read(dev_desc->dev, blknr++, 1,
+					 bounce) != 1)
+			return -1;
+		memcpy(dst, bounce + skip, len);
+		dst += len;
+		size -= len;
+	}
+	cnt = size / blksz;
+	if (cnt) {
+		if (dev_desc->block_read(dev_desc->dev, blknr, cnt,
+					 dst) != cnt)
+			return -1;
+		blknr += cnt;
+		dst += cnt * blksz;
+		size -= cnt * blksz;
+	}
+	if (size) {
+		if (dev_desc->block_read(dev_desc->dev, blknr, 1,
+					 bounce) != 1)
+			return -1;
+		memcpy(dst, bounce, size);
+		dst += size;
+	}
+	flush_cache((ulong)buf, dst - (char *)buf);
+
+	return 0;
+}
+
+/**
+ * fit_load_external_blk - read external image data from a block device
+ * @fit: pointer to the FIT format image header, with the blob in memory
+ * @dev_desc: block device holding the image
+ * @start: block number where the FIT image starts
+ *
+ * See fit_load_external().
+ *
+ * returns:
+ *     0, on success
+ *     -1, on failure
+ */
+int fit_load_external_blk(void *fit, block_dev_desc_t *dev_desc, ulong start)
+{
+	struct fit_blk_priv blk;
+
+	blk.dev_desc = dev_desc;
+	blk.start = start;
+
+	return fit_load_external(fit, fit_read_blk, &blk);
+}
+#endif /* USE_HOSTCC */
+
 /**
  * fit_check_ramdisk - verify FIT format ramdisk subimage
  * @fit_hdr: pointer to the FIT ramdisk header
@@ -74,7 +74,7 @@
 static const unsigned char us_direction[256/8] = {
 	0x28, 0x81, 0x14, 0x14, 0x20, 0x01, 0x90, 0x77,
 	0x0C, 0x20, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x40, 0x00, 0x01, 0x00, 0x01,
 	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 #define US_DIRECTION(x) ((us_direction[x>>3] >> (x & 7)) & 1)
@@ -157,6 +157,9 @@ struct us_data {
 	unsigned char	irqmaxp;		/* max packed for irq Pipe */
 	unsigned char	irqinterval;		/* Intervall for IRQ Pipe */
 	unsigned long	max_xfer_blk;		/* Max blocks per xfer */
+	unsigned char	cmd16;			/* use READ/WRITE(16) */
+	unsigned char	cbw_delay;		/* wait after each CBW */
+	unsigned short	ready_luns;		/* LUNs known to be ready */
 	ccb		*srb;			/* current srb */
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
@@ -694,7 +697,13 @@ int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
-	mdelay(5);
+	/*
+	 * Most devices accept the data phase straight after the CBW, and
+	 * NAK until they are ready. The few that don't get a short pause
+	 * once they have failed a transfer without it.
+	 */
+	if (us->cbw_delay)
+		mdelay(5);
 	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
 	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	/* DATA phase + error handling */
@@ -722,6 +731,10 @@ int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 	if (result < 0) {
 		USB_STOR_PRINTF("usb_bulk_msg error status %ld\n",
 			us->pusb_dev->status);
+		if (!us->cbw_delay) {
+			USB_STOR_PRINTF("enabling delay after CBW\n");
+			us->cbw_delay = 1;
+		}
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
@@ -995,6 +1008,24 @@ static int usb_read_capacity(ccb *srb, struct us_data *ss)
 	return -1;
 }
 
+static int usb_read_capacity_16(ccb *srb, struct us_data *ss)
+{
+	int retry = RETRIES(3);
+
+	do {
+		memset(&srb->cmd[0], 0, 16);
+		srb->cmd[0] = SCSI_RD_CAPAC16;
+		srb->cmd[1] = 0x10;	/* SERVICE ACTION IN: READ CAPACITY */
+		srb->cmd[13] = 32;
+		srb->datalen = 32;
+		srb->cmdlen = 16;
+		if (ss->transport(srb, ss) == USB_STOR_TRANSPORT_GOOD)
+			return 0;
+	} while (retry--);
+
+	return -1;
+}
+
 static int usb_read_10(ccb *srb, struct us_data *ss, unsigned long start,
 		       unsigned short blocks)
 {
@@ -1029,6 +1060,52 @@ static int usb_write_10(ccb *srb, struct us_data *ss, unsigned long start,
 	return ss->transport(srb, ss);
 }
 
+static void usb_setup_rw_16(ccb *srb, unsigned char opcode, lbaint_t start,
+			    unsigned short blocks)
+{
+	unsigned long long lba = start;
+	int i;
+
+	memset(&srb->cmd[0], 0, 16);
+	srb->cmd[0] = opcode;
+	for (i = 0; i < 8; i++)
+		srb->cmd[2 + i] = (unsigned char) (lba >> (56 - 8 * i));
+	srb->cmd[12] = ((unsigned char) (blocks >> 8)) & 0xff;
+	srb->cmd[13] = (unsigned char) blocks & 0xff;
+	srb->cmdlen = 16;
+}
+
+static int usb_read_16(ccb *srb, struct us_data *ss, lbaint_t start,
+		       unsigned short blocks)
+{
+	usb_setup_rw_16(srb, SCSI_READ16, start, blocks);
+	USB_STOR_PRINTF("read16: start " LBAF " blocks %x\n", start, blocks);
+	return ss->transport(srb, ss);
+}
+
+static int usb_write_16(ccb *srb, struct us_data *ss, lbaint_t start,
+			unsigned short blocks)
+{
+	usb_setup_rw_16(srb, SCSI_WRITE16, start, blocks);
+	USB_STOR_PRINTF("write16: start " LBAF " blocks %x\n", start, blocks);
+	return ss->transport(srb, ss);
+}
+
+/*
+ * A TEST UNIT READY before every read or write costs a full command
+ * round trip. Only issue it until the LUN has answered once; a failed
+ * transfer makes us ask again.
+ */
+static int usb_stor_check_ready(ccb *srb, struct us_data *ss)
+{
+	if (ss->ready_luns & (1 << srb->lun))
+		return 0;
+	if (usb_test_unit_ready(srb, ss))
+		return -1;
+	ss->ready_luns |= 1 << srb->lun;
+	return 0;
+}
+
 
 #ifdef CONFIG_USB_BIN_FIXUP
 /*
@@ -1061,7 +1138,7 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 	unsigned short smallblks;
 	struct usb_device *dev;
 	struct us_data *ss;
-	int retry, i;
+	int retry, i, result;
 	ccb *srb = &usb_ccb;
 
 	if (blkcnt == 0)
@@ -1085,7 +1162,7 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, ss)) {
+	if (usb_stor_check_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 		       srb->sense_buf[13]);
@@ -1104,12 +1181,17 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 		else
 			smallblks = (unsigned short) blks;
 retry_it:
-		if (smallblks == ss->max_xfer_blk)
+		if (smallblks < blks)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_read_10(srb, ss, start, smallblks)) {
+		if (ss->cmd16)
+			result = usb_read_16(srb, ss, start, smallblks);
+		else
+			result = usb_read_10(srb, ss, start, smallblks);
+		if (result) {
 			USB_STOR_PRINTF("Read ERROR\n");
+			ss->ready_luns &= ~(1 << srb->lun);
 			usb_request_sense(srb, ss);
 			if (retry--)
 				goto retry_it;
@@ -1139,7 +1221,7 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 	unsigned short smallblks;
 	struct usb_device *dev;
 	struct us_data *ss;
-	int retry, i;
+	int retry, i, result;
 	ccb *srb = &usb_ccb;
 
 	if (blkcnt == 0)
@@ -1164,7 +1246,7 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, ss)) {
+	if (usb_stor_check_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 			srb->sense_buf[13]);
@@ -1185,12 +1267,17 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 		else
 			smallblks = (unsigned short) blks;
 retry_it:
-		if (smallblks == ss->max_xfer_blk)
+		if (smallblks < blks)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_write_10(srb, ss, start, smallblks)) {
+		if (ss->cmd16)
+			result = usb_write_16(srb, ss, start, smallblks);
+		else
+			result = usb_write_10(srb, ss, start, smallblks);
+		if (result) {
 			USB_STOR_PRINTF("Write ERROR\n");
+			ss->ready_luns &= ~(1 << srb->lun);
 			usb_request_sense(srb, ss);
 			if (retry--)
 				goto retry_it;
@@ -1354,16 +1441,26 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 	return 1;
 }
 
+#ifdef CONFIG_USB_EHCI
+/*
+ * The EHCI driver chains as many qTDs as a transfer needs. Keep to 1 MiB
+ * per transfer though, so that even a full-speed device completes well
+ * within the bulk timeout.
+ */
+#define USB_MAX_READ_BLK(blksz)	((1024 * 1024) / (blksz))
+#else
 /*
  * It looks like some USB storage devices have problems handling excessive
  * numbers of blocks per transaction, 20 is a good confirmed limit.
  */
-#define USB_MAX_READ_BLK 20
+#define USB_MAX_READ_BLK(blksz)	20
+#endif
 
 int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 		      block_dev_desc_t *dev_desc)
 {
 	unsigned char perq, modi;
+	int rc16;
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned long, cap, 2);
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, usb_stor_buf, 36);
 	unsigned long *capacity, *blksz;
@@ -1428,6 +1525,9 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	cap[0] = cpu_to_be32(cap[0]);
 	cap[1] = cpu_to_be32(cap[1]);
 
+	/* READ CAPACITY(10) reports 0xffffffff for devices over 2 TiB */
+	rc16 = (cap[0] == 0xffffffff);
+
 	/* this assumes bigendian! */
 	cap[0] += 1;
 	capacity = &cap[0];
@@ -1436,17 +1536,33 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 			*capacity, *blksz);
 	dev_desc->lba = *capacity;
 	dev_desc->blksz = *blksz;
+	if (rc16) {
+		ALLOC_CACHE_ALIGN_BUFFER(unsigned char, cap16, 32);
+		unsigned long long lba = 0;
+		int i;
+
+		pccb->pdata = cap16;
+		memset(cap16, 0, 32);
+		if (usb_read_capacity_16(pccb, ss) == 0) {
+			for (i = 0; i < 8; i++)
+				lba = (lba << 8) | cap16[i];
+			dev_desc->lba = lba + 1;
+			if (dev_desc->lba != lba + 1)
+				printf("Capacity too large, use CONFIG_SYS_64BIT_LBA\n");
+			dev_desc->blksz = ((unsigned long)cap16[8] << 24) |
+					  (cap16[9] << 16) | (cap16[10] << 8) |
+					  cap16[11];
+			ss->cmd16 = 1;
+		} else {
+			printf("READ_CAP16 ERROR\n");
+			dev_desc->lba = 0xffffffff;
+		}
+	}
 	dev_desc->type = perq;
 	USB_STOR_PRINTF(" address %d\n", dev_desc->target);
 	USB_STOR_PRINTF("partype: %d\n", dev_desc->part_type);
 
-	/*
-	 * The U-Boot EHCI driver cannot handle more than 4096 * 5 bytes in a
-	 * transfer without running itself out of qt_buffers.
-	 *
-	 * Number of blocks should be capped also.
-	 */
-	ss->max_xfer_blk = min((4096 * 5) / dev_desc->blksz, USB_MAX_READ_BLK);
+	ss->max_xfer_blk = USB_MAX_READ_BLK(dev_desc->blksz);
 
 	init_part(dev_desc);
 
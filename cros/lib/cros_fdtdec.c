@@ -19,7 +19,7 @@
 
 int cros_fdtdec_config_node(const void *blob)
 {
-	int node = fdt_path_offset(blob, "/chromeos-config");
+	int node = fdtdec_path_offset(blob, "/chromeos-config");
 
 	if (node < 0)
 		VBDEBUG("failed to find /chromeos-config: %d\n", node);
@@ -249,7 +249,7 @@ int cros_fdtdec_flashmap(const void *blob, struct twostop_fmap *config)
 	int depth;
 
 	memset(config, '\0', sizeof(*config));
-	offset = fdt_node_offset_by_compatible(blob, -1,
+	offset = fdtdec_node_offset_by_compatible(blob, -1,
 			"chromeos,flashmap");
 	if (offset < 0) {
 		VBDEBUG("chromeos,flashmap node is missing\n");
@@ -315,7 +315,7 @@ int cros_fdtdec_memory(const void *blob, const char *name,
 	int node, len;
 	const fdt_addr_t *cell;
 
-	node = fdt_path_offset(blob, name);
+	node = fdtdec_path_offset(blob, name);
 	if (node < 0)
 		return node;
 
@@ -143,9 +143,9 @@ static int fdt_ensure_subnode(void *fdt, int parentoffset, const char *name)
 {
 	int err;
 
-	err = fdt_add_subnode(fdt, parentoffset, name);
+	err = fdt_txn_add_subnode(fdt, parentoffset, name);
 	if (err == -FDT_ERR_EXISTS)
-		return fdt_subnode_offset(fdt, parentoffset, name);
+		return fdt_txn_subnode_offset(fdt, parentoffset, name);
 
 	return err;
 }
@@ -158,13 +158,13 @@ static int process_cdata(crossystem_data_t *cdata, void *fdt)
 	int err;
 
 #define set_scalar_prop(name, f) \
-	fdt_setprop_cell(fdt, nodeoffset, name, cdata->f)
+	fdt_txn_setprop_cell(fdt, nodeoffset, name, cdata->f)
 #define set_array_prop(name, f) \
-	fdt_setprop(fdt, nodeoffset, name, cdata->f, sizeof(cdata->f))
+	fdt_txn_setprop(fdt, nodeoffset, name, cdata->f, sizeof(cdata->f))
 #define set_conststring_prop(name, str) \
-	fdt_setprop_string(fdt, nodeoffset, name, str)
+	fdt_txn_setprop_string(fdt, nodeoffset, name, str)
 #define set_bool_prop(name, f) \
-	((cdata->f) ? fdt_setprop(fdt, nodeoffset, name, NULL, 0) : 0)
+	((cdata->f) ? fdt_txn_setprop(fdt, nodeoffset, name, NULL, 0) : 0)
 #define CALL(expr) \
 		do { err = (expr); \
 			if (err < 0) { \
@@ -179,7 +179,7 @@ static int process_cdata(crossystem_data_t *cdata, void *fdt)
 	nodeoffset = err;
 	printf("nodeoffset = %d\n", nodeoffset);
 
-	CALL(fdt_setprop_string(fdt, nodeoffset, "compatible",
+	CALL(fdt_txn_setprop_string(fdt, nodeoffset, "compatible",
 				"chromeos-firmware"));
 
 	CALL(set_scalar_prop("total-size", total_size));
@@ -195,17 +195,17 @@ static int process_cdata(crossystem_data_t *cdata, void *fdt)
 
 	gpio_prop[1] = cpu_to_fdt32(cdata->gpio_port_recovery_switch);
 	gpio_prop[2] = cpu_to_fdt32(cdata->polarity_recovery_switch);
-	CALL(fdt_setprop(fdt, nodeoffset, "recovery-switch",
+	CALL(fdt_txn_setprop(fdt, nodeoffset, "recovery-switch",
 			   gpio_prop, sizeof(gpio_prop)));
 
 	gpio_prop[1] = cpu_to_fdt32(cdata->gpio_port_developer_switch);
 	gpio_prop[2] = cpu_to_fdt32(cdata->polarity_developer_switch);
-	CALL(fdt_setprop(fdt, nodeoffset, "developer-switch",
+	CALL(fdt_txn_setprop(fdt, nodeoffset, "developer-switch",
 			   gpio_prop, sizeof(gpio_prop)));
 
 	gpio_prop[1] = cpu_to_fdt32(cdata->gpio_port_oprom_loaded);
 	gpio_prop[2] = cpu_to_fdt32(cdata->polarity_oprom_loaded);
-	CALL(fdt_setprop(fdt, nodeoffset, "oprom-loaded",
+	CALL(fdt_txn_setprop(fdt, nodeoffset, "oprom-loaded",
 			   gpio_prop, sizeof(gpio_prop)));
 
 	CALL(set_scalar_prop("fmap-offset", fmap_offset));
@@ -240,17 +240,17 @@ static int process_cdata(crossystem_data_t *cdata, void *fdt)
 #ifdef CONFIG_ARM
 	switch (cdata->board.arm.nonvolatile_context_storage) {
 	case NONVOLATILE_STORAGE_NVRAM:
-		CALL(fdt_setprop(fdt, nodeoffset,
+		CALL(fdt_txn_setprop(fdt, nodeoffset,
 				"nonvolatile-context-storage",
 				"nvram", sizeof("nvram")));
 		break;
 	case NONVOLATILE_STORAGE_MKBP:
-		CALL(fdt_setprop(fdt, nodeoffset,
+		CALL(fdt_txn_setprop(fdt, nodeoffset,
 				"nonvolatile-context-storage",
 				"mkbp", sizeof("mkbp")));
 		break;
 	case NONVOLATILE_STORAGE_DISK:
-		CALL(fdt_setprop(fdt, nodeoffset,
+		CALL(fdt_txn_setprop(fdt, nodeoffset,
 				"nonvolatile-context-storage",
 				"disk", sizeof("disk")));
 		CALL(set_scalar_prop("nonvolatile-context-lba",
@@ -271,7 +271,7 @@ static int process_cdata(crossystem_data_t *cdata, void *fdt)
 
 	ddr_type = cros_fdt_get_mem_type();
 	if (ddr_type) {
-		CALL(fdt_setprop(fdt, nodeoffset, "ddr-type", ddr_type,
+		CALL(fdt_txn_setprop(fdt, nodeoffset, "ddr-type", ddr_type,
 				   strlen(ddr_type)));
 	}
 
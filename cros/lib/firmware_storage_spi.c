@@ -23,6 +23,7 @@ DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	SF_DEFAULT_SPEED = 1000000,
+	BACKUP_BUF_SIZE = 0x1000,	/* larger backups are malloc()ed */
 };
 
 /*
@@ -104,36 +105,26 @@ static int read_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 	return 0;
 }
 
-/*
- * FIXME: It is a reasonable assumption that sector size = 4096 bytes.
- * Nevertheless, comparing to coding this magic number here, there should be a
- * better way (maybe rewrite driver interface?) to expose this parameter from
- * eeprom driver.
- */
-#define SECTOR_SIZE 0x1000
-
 /*
  * Align the right-exclusive range [*offset_ptr:*offset_ptr+*length_ptr) with
- * SECTOR_SIZE.
+ * sector_size, the erase granularity of the flash.
  * After alignment adjustment, both offset and length will be multiple of
- * SECTOR_SIZE, and will be larger than or equal to the original range.
+ * sector_size, and will be larger than or equal to the original range.
  */
-static void align_to_sector(uint32_t *offset_ptr, uint32_t *length_ptr)
+static void align_to_sector(uint32_t sector_size, uint32_t *offset_ptr,
+		uint32_t *length_ptr)
 {
+	uint32_t end = *offset_ptr + *length_ptr;
+
 	VBDEBUG("before adjustment\n");
 	VBDEBUG("offset: 0x%x\n", *offset_ptr);
 	VBDEBUG("length: 0x%x\n", *length_ptr);
 
-	/* Adjust if offset is not multiple of SECTOR_SIZE */
-	if (*offset_ptr & (SECTOR_SIZE - 1ul)) {
-		*offset_ptr &= ~(SECTOR_SIZE - 1ul);
-	}
-
-	/* Adjust if length is not multiple of SECTOR_SIZE */
-	if (*length_ptr & (SECTOR_SIZE - 1ul)) {
-		*length_ptr &= ~(SECTOR_SIZE - 1ul);
-		*length_ptr += SECTOR_SIZE;
-	}
+	/* Round the start down and the end up to a sector boundary */
+	*offset_ptr -= *offset_ptr % sector_size;
+	if (end % sector_size)
+		end += sector_size - end % sector_size;
+	*length_ptr = end - *offset_ptr;
 
 	VBDEBUG("after adjustment\n");
 	VBDEBUG("offset: 0x%x\n", *offset_ptr);
@@ -144,7 +135,7 @@ static int write_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 		void *buf)
 {
 	struct spi_flash *flash = file->context;
-	uint8_t static_buf[SECTOR_SIZE];
+	uint8_t static_buf[BACKUP_BUF_SIZE];
 	uint8_t *backup_buf;
 	uint32_t k, n;
 	int status, ret = -1;
@@ -152,7 +143,7 @@ static int write_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 	/* We will erase <n> bytes starting from <k> */
 	k = offset;
 	n = count;
-	align_to_sector(&k, &n);
+	align_to_sector(flash->sector_size, &k, &n);
 
 	VBDEBUG("offset:          0x%08x\n", offset);
 	VBDEBUG("adjusted offset: 0x%08x\n", k);
@@ -31,6 +31,7 @@
 #include <common.h>
 #include <command.h>
 #include <i2c.h>
+#include <initcall.h>
 #include <mkbp.h>
 #include <fdtdec.h>
 #include <malloc.h>
@@ -167,7 +168,8 @@ static int ec_command(struct mkbp_dev *dev, uint8_t cmd, int cmd_version,
 		do {
 			int ret;
 
-			mdelay(50);	/* Insert some reasonable delay */
+			/* Insert some reasonable delay */
+			initcall_defer_mdelay(50);
 			ret = send_command(dev, EC_CMD_GET_COMMS_STATUS, 0,
 					NULL, 0,
 					(uint8_t **)&resp, sizeof(*resp));
@@ -283,7 +285,8 @@ static int mkbp_wait_on_hash_done(struct mkbp_dev *dev,
 
 	start = get_timer(0);
 	while (hash->status == EC_VBOOT_HASH_STATUS_BUSY) {
-		mdelay(50);	/* Insert some reasonable delay */
+		/* Insert some reasonable delay */
+		initcall_defer_mdelay(50);
 
 		p.cmd = EC_VBOOT_HASH_GET;
 		if (ec_command(dev, EC_CMD_VBOOT_HASH, 0, &p, sizeof(p),
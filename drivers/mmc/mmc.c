@@ -31,6 +31,7 @@
 #include <malloc.h>
 #include <linux/list.h>
 #include <div64.h>
+#include <initcall.h>
 
 /* Set block count limit because of 16 bit register limit on some hardware*/
 #ifndef CONFIG_SYS_MMC_MAX_BLK_COUNT
@@ -539,6 +540,7 @@ int mmc_send_op_cond(struct mmc *mmc)
 
  	/* Asking to the card its capabilities */
 	mmc->op_cond_pending = 1;
+	mmc->op_cond_start = get_timer(0);
 	for (i = 0; i < 2; i++) {
 		err = mmc_send_op_cond_iter(mmc, &cmd, i != 0);
 		if (err)
@@ -551,23 +553,26 @@ int mmc_send_op_cond(struct mmc *mmc)
 	return IN_PROGRESS;
 }
 
-int mmc_complete_op_cond(struct mmc *mmc)
+/*
+ * Ask the card once whether it has finished powering up, without waiting.
+ *
+ * @return 0 if it has, IN_PROGRESS if not yet, or an error
+ */
+static int mmc_poll_op_cond(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
 	int timeout = 1000;
-	uint start;
 	int err;
 
-	mmc->op_cond_pending = 0;
-	start = get_timer(0);
-	do {
-		err = mmc_send_op_cond_iter(mmc, &cmd, 1);
-		if (err)
-			return err;
-		if (get_timer(start) > timeout)
+	err = mmc_send_op_cond_iter(mmc, &cmd, 1);
+	if (err)
+		return err;
+	if (!(mmc->op_cond_response & OCR_BUSY)) {
+		if (get_timer(mmc->op_cond_start) > timeout)
 			return UNUSABLE_ERR;
-		udelay(100);
-	} while (!(mmc->op_cond_response & OCR_BUSY));
+		return IN_PROGRESS;
+	}
+	mmc->op_cond_pending = 0;
 
 	if (mmc_host_is_spi(mmc)) { /* read OCR for spi */
 		cmd.cmdidx = MMC_CMD_SPI_READ_OCR;
@@ -590,6 +595,18 @@ int mmc_complete_op_cond(struct mmc *mmc)
 	return 0;
 }
 
+int mmc_complete_op_cond(struct mmc *mmc)
+{
+	int err;
+
+	mmc->op_cond_start = get_timer(0);
+	while ((err = mmc_poll_op_cond(mmc)) == IN_PROGRESS)
+		udelay(100);
+	mmc->op_cond_pending = 0;
+
+	return err;
+}
+
 
 int mmc_send_ext_csd(struct mmc *mmc, unsigned char *ext_csd)
 {
@@ -1284,13 +1301,8 @@ int mmc_start_init(struct mmc *mmc)
 	return err;
 }
 
-static int mmc_complete_init(struct mmc *mmc)
+static int mmc_finish_init(struct mmc *mmc, int err)
 {
-	int err = 0;
-
-	if (mmc->op_cond_pending)
-		err = mmc_complete_op_cond(mmc);
-
 	if (!err)
 		err = mmc_startup(mmc);
 	if (err)
@@ -1301,6 +1313,37 @@ static int mmc_complete_init(struct mmc *mmc)
 	return err;
 }
 
+static int mmc_complete_init(struct mmc *mmc)
+{
+	int err = 0;
+
+	if (mmc->op_cond_pending)
+		err = mmc_complete_op_cond(mmc);
+
+	return mmc_finish_init(mmc, err);
+}
+
+#ifdef CONFIG_INITCALL_DEFER
+/*
+ * Carry on with a card's init if it is ready, without waiting for it.
+ *
+ * @return 0 if the card is ready, IN_PROGRESS if not yet, or an error
+ */
+static int mmc_poll_init(struct mmc *mmc)
+{
+	int err = 0;
+
+	if (mmc->op_cond_pending) {
+		err = mmc_poll_op_cond(mmc);
+		if (err == IN_PROGRESS)
+			return err;
+		mmc->op_cond_pending = 0;
+	}
+
+	return mmc_finish_init(mmc, err);
+}
+#endif
+
 int mmc_init(struct mmc *mmc)
 {
 	int err = IN_PROGRESS;
@@ -1356,6 +1399,7 @@ void mmc_set_preinit(struct mmc *mmc, int preinit)
 	mmc->preinit = preinit;
 }
 
+#ifndef CONFIG_INITCALL_DEFER
 static void do_preinit(void)
 {
 	struct mmc *m;
@@ -1368,6 +1412,58 @@ static void do_preinit(void)
 			mmc_start_init(m);
 	}
 }
+#else
+/*
+ * Power up the cards marked for preinit while the rest of the board
+ * starts. Only MMC cards report that they are busy; SD cards wait in
+ * mmc_start_init() as before. A card which fails is just left for
+ * mmc_init() to try again later.
+ */
+static int mmc_defer_start(void)
+{
+	struct mmc *m;
+	struct list_head *entry;
+	int pending = 0;
+	int err;
+
+	list_for_each(entry, &mmc_devices) {
+		m = list_entry(entry, struct mmc, link);
+
+		if (!m->preinit || m->has_init)
+			continue;
+		err = mmc_start_init(m);
+		if (err == IN_PROGRESS)
+			pending = 1;
+		else if (!err)
+			mmc_finish_init(m, 0);
+	}
+
+	return pending ? INITCALL_PENDING : 0;
+}
+
+static int mmc_defer_poll(void)
+{
+	struct mmc *m;
+	struct list_head *entry;
+	int pending = 0;
+
+	list_for_each(entry, &mmc_devices) {
+		m = list_entry(entry, struct mmc, link);
+
+		if (m->init_in_progress && mmc_poll_init(m) == IN_PROGRESS)
+			pending = 1;
+	}
+
+	return pending ? INITCALL_PENDING : 0;
+}
+
+static struct initcall_defer mmc_defer = {
+	.name = "mmc",
+	.id = INITCALL_DEFER_MMC,
+	.start = mmc_defer_start,
+	.poll = mmc_defer_poll,
+};
+#endif
 
 
 int mmc_initialize(bd_t *bis)
@@ -1380,6 +1476,10 @@ int mmc_initialize(bd_t *bis)
 
 	print_mmc_devices(',');
 
+#ifdef CONFIG_INITCALL_DEFER
+	initcall_defer(&mmc_defer);
+#else
 	do_preinit();
+#endif
 	return 0;
 }
@@ -1200,6 +1200,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	struct mtd_ecc_stats stats;
 	int blkcheck = (1 << (chip->phys_erase_shift - chip->page_shift)) - 1;
 	int sndcmd = 1;
+	int cache = 0;
 	int ret = 0;
 	uint32_t readlen = ops->len;
 	uint32_t oobreadlen = ops->ooblen;
@@ -1227,13 +1228,41 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		bytes = min(mtd->writesize - col, readlen);
 		aligned = (bytes == mtd->writesize);
 
-		/* Is the current page in the buffer ? */
-		if (realpage != chip->pagebuf || oob) {
+		/*
+		 * Is the current page in the buffer ? During a cache read the
+		 * chip has already loaded it, so it must be transferred anyway.
+		 */
+		if (realpage != chip->pagebuf || oob || cache) {
 			bufpoi = aligned ? buf : chip->buffers->databuf;
 
 			if (likely(sndcmd)) {
 				chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
 				sndcmd = 0;
+
+				/*
+				 * Use cache reads if more pages of this block
+				 * follow: the chip then loads the next page
+				 * while this one is transferred and corrected.
+				 */
+				cache = NAND_HAS_CACHEREAD(chip) &&
+					readlen > bytes && ((page + 1) & blkcheck);
+			}
+
+			if (cache) {
+				/*
+				 * Move the loaded page to the cache register.
+				 * READ CACHE END does not start another load,
+				 * so use it for the last page of the block or
+				 * of the request.
+				 */
+				if (readlen > bytes && ((page + 1) & blkcheck))
+					chip->cmdfunc(mtd, NAND_CMD_READCACHESEQ,
+						      -1, -1);
+				else {
+					chip->cmdfunc(mtd, NAND_CMD_READCACHEEND,
+						      -1, -1);
+					cache = 0;
+				}
 			}
 
 			/* Now read the page into the buffer */
@@ -1307,12 +1336,17 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		}
 
 		/* Check, if the chip supports auto page increment
-		 * or if we have hit a block boundary.
+		 * or if we have hit a block boundary. A cache read
+		 * goes on without a new command.
 		 */
-		if (!NAND_CANAUTOINCR(chip) || !(page & blkcheck))
+		if ((!NAND_CANAUTOINCR(chip) && !cache) || !(page & blkcheck))
 			sndcmd = 1;
 	}
 
+	/* Finish a cache read which was aborted by an error */
+	if (cache)
+		chip->cmdfunc(mtd, NAND_CMD_READCACHEEND, -1, -1);
+
 	ops->retlen = ops->len - (size_t) readlen;
 	if (oob)
 		ops->oobretlen = ops->ooblen - oobreadlen;
@@ -2576,6 +2610,10 @@ static int nand_flash_detect_onfi(struct mtd_info *mtd, struct nand_chip *chip,
 	chip->options |= (NAND_NO_READRDY |
 			NAND_NO_AUTOINCR) & NAND_CHIPOPTIONS_MSK;
 
+	/* Read cache commands supported */
+	if (le16_to_cpu(p->opt_cmd) & (1 << 1))
+		chip->options |= NAND_CACHEREAD;
+
 	return 1;
 }
 #else
@@ -3098,6 +3136,18 @@ int nand_scan_tail(struct mtd_info *mtd)
 		BUG();
 	}
 
+	/*
+	 * Cache reads need the default command function, which knows how to
+	 * wait for the cache register, and page read functions which only
+	 * transfer data and do not send read commands of their own.
+	 */
+	if (chip->cmdfunc != nand_command_lp ||
+	    (chip->ecc.read_page != nand_read_page_swecc &&
+	     chip->ecc.read_page != nand_read_page_hwecc &&
+	     chip->ecc.read_page != nand_read_page_syndrome &&
+	     chip->ecc.read_page != nand_read_page_raw))
+		chip->options &= ~NAND_CACHEREAD;
+
 	/*
 	 * The number of bytes available for a client to place data into
 	 * the out of band area
@@ -178,7 +178,10 @@ static int nand_read_page(int block, int page, uchar *dst)
 	return 0;
 }
 #else
-static int nand_read_page(int block, int page, void *dst)
+/*
+ * Transfer the page the chip has loaded and correct it
+ */
+static int nand_read_page_data(void *dst)
 {
 	struct nand_chip *this = mtd.priv;
 	u_char ecc_calc[ECCTOTAL];
@@ -190,8 +193,6 @@ static int nand_read_page(int block, int page, void *dst)
 	int eccsteps = ECCSTEPS;
 	uint8_t *p = dst;
 
-	nand_command(block, page, 0, NAND_CMD_READ0);
-
 	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize) {
 		if (this->ecc.mode != NAND_ECC_SOFT)
 			this->ecc.hwctl(&mtd, NAND_ECC_READ);
@@ -217,6 +218,50 @@ static int nand_read_page(int block, int page, void *dst)
 
 	return 0;
 }
+
+static int nand_read_page(int block, int page, void *dst)
+{
+	nand_command(block, page, 0, NAND_CMD_READ0);
+
+	return nand_read_page_data(dst);
+}
+
+#if defined(CONFIG_SPL_NAND_CACHE_READ) && (CONFIG_SYS_NAND_PAGE_SIZE > 512)
+/*
+ * Send a read cache command (no address cycles) and wait until the
+ * cache register holds the page
+ */
+static void nand_cache_command(u8 cmd)
+{
+	struct nand_chip *this = mtd.priv;
+
+	this->cmd_ctrl(&mtd, cmd, NAND_CTRL_CLE | NAND_CTRL_CHANGE);
+	this->cmd_ctrl(&mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+
+	while (!this->dev_ready(&mtd))
+		;
+}
+
+/*
+ * Read the pages from @page to the end of @block with cache reads, so
+ * the chip loads the next page while this one is transferred and
+ * corrected. The caller makes sure that at least two pages are left.
+ */
+static void nand_read_block_cached(int block, int page, uchar *dst)
+{
+	nand_command(block, page, 0, NAND_CMD_READ0);
+
+	while (page < CONFIG_SYS_NAND_PAGE_COUNT) {
+		page++;
+		nand_cache_command(page < CONFIG_SYS_NAND_PAGE_COUNT ?
+				   NAND_CMD_READCACHESEQ :
+				   NAND_CMD_READCACHEEND);
+		nand_read_page_data(dst);
+		dst += CONFIG_SYS_NAND_PAGE_SIZE;
+	}
+}
+#define HAVE_NAND_CACHE_READ
+#endif
 #endif
 
 int nand_spl_load_image(uint32_t offs, unsigned int size, void *dst)
@@ -236,6 +281,14 @@ int nand_spl_load_image(uint32_t offs, unsigned int size, void *dst)
 			/*
 			 * Skip bad blocks
 			 */
+#ifdef HAVE_NAND_CACHE_READ
+			if (page + 1 < CONFIG_SYS_NAND_PAGE_COUNT) {
+				nand_read_block_cached(block, page, dst);
+				dst += (CONFIG_SYS_NAND_PAGE_COUNT - page) *
+					CONFIG_SYS_NAND_PAGE_SIZE;
+				page = CONFIG_SYS_NAND_PAGE_COUNT;
+			}
+#endif
 			while (page < CONFIG_SYS_NAND_PAGE_COUNT) {
 				nand_read_page(block, page, dst);
 				dst += CONFIG_SYS_NAND_PAGE_SIZE;
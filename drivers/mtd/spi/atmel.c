@@ -477,6 +477,7 @@ struct spi_flash *spi_flash_probe_atmel(struct spi_slave *spi, u8 *idcode)
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
 	}
+	memset(asf, '\0', sizeof(struct atmel_spi_flash));
 
 	asf->params = params;
 	asf->flash.spi = spi;
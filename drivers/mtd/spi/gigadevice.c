@@ -17,22 +17,32 @@
 
 /* GD25Pxx-specific commands */
 #define CMD_GD25_SE		0x20	/* Sector (4K) Erase */
+#define CMD_GD25_BE32		0x52	/* Block (32K) Erase */
+#define CMD_GD25_BE		0xd8	/* Block (64K) Erase */
+#define CMD_GD25_RDSR2		0x35	/* Read Status Register (S15-S8) */
 
 struct gigadevice_spi_flash_params {
 	uint16_t	id;
 	uint16_t	nr_blocks;
+	/* Multi-I/O reads, SPI_FLASH_RD_* */
+	uint8_t		read_modes;
 	const char	*name;
 };
 
+#define GD25_READ_MODES		(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_RD_QUAD_IO)
+
 static const struct gigadevice_spi_flash_params gigadevice_spi_flash_table[] = {
 	{
 		.id			= 0x6016,
 		.nr_blocks		= 64,
+		.read_modes		= GD25_READ_MODES,
 		.name			= "GD25LQ",
 	},
 	{
 		.id			= 0x4017,
 		.nr_blocks		= 128,
+		.read_modes		= GD25_READ_MODES,
 		.name			= "GD25Q64B",
 	},
 
@@ -43,6 +53,12 @@ static int gigadevice_erase(struct spi_flash *flash, u32 offset, size_t len)
 	return spi_flash_cmd_erase(flash, CMD_GD25_SE, offset, len);
 }
 
+/* QE is S9, bit 1 of the second status byte */
+static int gigadevice_quad_enable(struct spi_flash *flash)
+{
+	return spi_flash_quad_enable_sr2(flash, CMD_GD25_RDSR2);
+}
+
 struct spi_flash *spi_flash_probe_gigadevice(struct spi_slave *spi, u8 *idcode)
 {
 	const struct gigadevice_spi_flash_params *params;
@@ -82,6 +98,10 @@ struct spi_flash *spi_flash_probe_gigadevice(struct spi_slave *spi, u8 *idcode)
 #else
 	flash->read = spi_flash_cmd_read_fast;
 #endif
+	flash->read_modes = params->read_modes;
+	flash->quad_enable = gigadevice_quad_enable;
+	spi_flash_add_erase(flash, 32 << 10, CMD_GD25_BE32);
+	spi_flash_add_erase(flash, 64 << 10, CMD_GD25_BE);
 	flash->page_size = page_size;
 	/* sector_size = page_size * pages_per_sector */
 	flash->sector_size = page_size * 16;
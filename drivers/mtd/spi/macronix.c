@@ -50,6 +50,16 @@
 #define CMD_MX25XX_RES		0xab	/* Release from DP, and Read Signature */
 
 #define MACRONIX_SR_WIP		(1 << 0)	/* Write-in-Progress */
+#define MACRONIX_SR_QE		(1 << 6)	/* Quad Enable */
+
+/* SFDP basic table dword 5: fast read 4-4-4 supported */
+#define MACRONIX_SFDP_FAST_READ_4_4_4	(1 << 4)
+
+#define MACRONIX_ID_MX25L25635	0x2019
+
+/* Parts with dual and quad reads */
+#define MX25_QUAD_READ_MODES	(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_RD_QUAD_IO)
 
 struct macronix_spi_flash_params {
 	u16 idcode;
@@ -57,6 +67,8 @@ struct macronix_spi_flash_params {
 	u16 pages_per_sector;
 	u16 sectors_per_block;
 	u16 nr_blocks;
+	u8 read_modes;
+	u8 erase_4b;		/* SPI_FLASH_ERASE_4B_* */
 	const char *name;
 };
 
@@ -115,6 +127,7 @@ static const struct macronix_spi_flash_params macronix_spi_flash_table[] = {
 		.pages_per_sector = 16,
 		.sectors_per_block = 16,
 		.nr_blocks = 64,
+		.read_modes = MX25_QUAD_READ_MODES,
 		.name = "MX25U3235E/F",
 	},
 	{
@@ -123,8 +136,20 @@ static const struct macronix_spi_flash_params macronix_spi_flash_table[] = {
 		.pages_per_sector = 16,
 		.sectors_per_block = 16,
 		.nr_blocks = 256,
+		.read_modes = MX25_QUAD_READ_MODES,
 		.name = "MX25L12855E",
 	},
+	{
+		.idcode = MACRONIX_ID_MX25L25635,
+		.page_size = 256,
+		.pages_per_sector = 16,
+		.sectors_per_block = 16,
+		.nr_blocks = 512,
+		.read_modes = MX25_QUAD_READ_MODES,
+		.erase_4b = SPI_FLASH_ERASE_4B_4K | SPI_FLASH_ERASE_4B_32K |
+			    SPI_FLASH_ERASE_4B_64K,
+		.name = "MX25L25635F",
+	},
 };
 
 static int macronix_write_status(struct spi_flash *flash, u8 sr)
@@ -157,15 +182,63 @@ static int macronix_write_status(struct spi_flash *flash, u8 sr)
 static int macronix_unlock(struct spi_flash *flash)
 {
 	int ret;
+	u8 sr;
 
-	/* Enable status register writing and clear BP# bits */
-	ret = macronix_write_status(flash, 0);
+	ret = spi_flash_cmd_read_status(flash, &sr);
+	if (ret)
+		return ret;
+
+	/* Enable status register writing and clear BP# bits, keep QE */
+	ret = macronix_write_status(flash, sr & MACRONIX_SR_QE);
 	if (ret)
 		debug("SF: fail to disable write protection\n");
 
 	return ret;
 }
 
+static int macronix_quad_enable(struct spi_flash *flash)
+{
+	int ret;
+	u8 sr;
+
+	ret = spi_flash_cmd_read_status(flash, &sr);
+	if (ret)
+		return ret;
+	if (sr & MACRONIX_SR_QE)
+		return 0;
+
+	ret = macronix_write_status(flash, sr | MACRONIX_SR_QE);
+	if (ret)
+		return ret;
+
+	ret = spi_flash_cmd_read_status(flash, &sr);
+	if (ret)
+		return ret;
+
+	return sr & MACRONIX_SR_QE ? 0 : -1;
+}
+
+/*
+ * The MX25L25635E and MX25L25635F share a JEDEC ID, but only the F has
+ * the 4-byte address opcodes. The F is told apart by the fast read 4-4-4
+ * bit in dword 5 of its SFDP basic table, which the E does not set.
+ */
+static int macronix_has_4b_opcodes(struct spi_flash *flash)
+{
+	u8 hdr[16];	/* SFDP header, then the basic table's header */
+	u32 dw5;
+
+	if (spi_flash_read_sfdp(flash->spi, 0, hdr, sizeof(hdr)) ||
+	    memcmp(hdr, "SFDP", 4) || hdr[8] != 0x00 || hdr[15] != 0xff ||
+	    hdr[11] < 5)
+		return 0;
+	if (spi_flash_read_sfdp(flash->spi, (hdr[14] << 16 | hdr[13] << 8 |
+				hdr[12]) + 16, &dw5, sizeof(dw5)))
+		return 0;
+
+	return le32_to_cpu(dw5) & MACRONIX_SFDP_FAST_READ_4_4_4;
+}
+
 static int macronix_erase(struct spi_flash *flash, u32 offset, size_t len)
 {
 	return spi_flash_cmd_erase(flash, CMD_MX25XX_SE, offset, len);
@@ -212,6 +285,7 @@ struct spi_flash *spi_flash_probe_macronix(struct spi_slave *spi, u8 *idcode)
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
 	}
+	memset(flash, '\0', sizeof(*flash));
 
 	flash->spi = spi;
 	flash->name = params->name;
@@ -225,11 +299,23 @@ struct spi_flash *spi_flash_probe_macronix(struct spi_slave *spi, u8 *idcode)
 	flash->read = spi_flash_cmd_read_fast;
 #endif
 	flash->read_sw_wp_status = macronix_read_sw_wp_status;
+	flash->read_modes = params->read_modes;
+	flash->erase_4b = params->erase_4b;
+	flash->quad_enable = macronix_quad_enable;
+	spi_flash_add_erase(flash, 64 << 10, CMD_MX25XX_BE);
 	flash->page_size = params->page_size;
 	flash->sector_size = params->page_size * params->pages_per_sector;
 	flash->size = flash->sector_size * params->sectors_per_block
 					 * params->nr_blocks;
 
+	if (params->idcode == MACRONIX_ID_MX25L25635 &&
+	    !macronix_has_4b_opcodes(flash)) {
+		printf("SF: MX25L25635E has no 4-byte opcodes, "
+		       "using the first 16 MiB\n");
+		flash->name = "MX25L25635E";
+		flash->size = 16 << 20;
+	}
+
 	/* Clear BP# bits for read-only flash */
 	macronix_unlock(flash);
 
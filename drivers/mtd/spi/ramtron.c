@@ -302,6 +302,7 @@ found:
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
 	}
+	memset(sn, '\0', sizeof(*sn));
 
 	sn->params = params;
 	sn->flash.spi = spi;
@@ -0,0 +1,320 @@
+/*
+ * JEDEC SFDP (JESD216) parameter discovery for SPI flash
+ *
+ * Copyright (c) 2012 The Chromium OS Authors.
+ *
+ * Licensed under the GPL-2 or later.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <spi_flash.h>
+#include <asm/unaligned.h>
+
+#include "spi_flash_internal.h"
+
+#define SFDP_SIGNATURE		0x50444653	/* "SFDP" */
+#define SFDP_BFPT_ID		0xff00		/* Basic Flash Parameter Table */
+#define SFDP_4BAIT_ID		0xff84		/* 4-byte Address Instruction */
+#define SFDP_MAX_HEADERS	8
+#define SFDP_BFPT_DWORDS	16
+
+struct sfdp_header {
+	u8 signature[4];
+	u8 minor;
+	u8 major;
+	u8 nph;			/* number of parameter headers - 1 */
+	u8 reserved;
+};
+
+struct sfdp_param_header {
+	u8 id_lsb;
+	u8 minor;
+	u8 major;
+	u8 length;		/* in dwords */
+	u8 ptp[3];		/* table pointer, little endian */
+	u8 id_msb;
+};
+
+/* Basic Flash Parameter Table, dword numbers as in the standard */
+#define BFPT_DW(n)			(n - 1)
+
+#define BFPT_DW1_ERASE_4K_MASK		0x3
+#define BFPT_DW1_ERASE_4K		0x1
+#define BFPT_DW1_FAST_READ_1_1_2	(1 << 16)
+#define BFPT_DW1_ADDR_SHIFT		17
+#define BFPT_DW1_ADDR_4B_ONLY		0x2
+#define BFPT_DW1_FAST_READ_1_4_4	(1 << 21)
+#define BFPT_DW1_FAST_READ_1_1_4	(1 << 22)
+
+#define BFPT_DW2_DENSITY_EXP		(1U << 31)
+
+/* 4-byte Address Instruction Table: dword 1 bit per erase type 1-4 */
+#define FBAIT_DW1_ERASE_TYPE(n)		(1 << (8 + (n)))
+
+#define BFPT_DW15_QER_SHIFT		20
+#define BFPT_DW15_QER_MASK		0x7
+
+/* Quad Enable Requirements, BFPT dword 15 */
+enum {
+	QER_NONE,
+	QER_SR2_BIT1_BUGGY,	/* bit 1 of SR2, writing SR1 alone clears it */
+	QER_SR1_BIT6,
+	QER_SR2_BIT7,		/* set through 3Eh/3Fh, not supported */
+	QER_SR2_BIT1_NO_RD,	/* SR2 cannot be read back, not supported */
+	QER_SR2_BIT1,
+};
+
+#define CMD_READ_STATUS2		0x35
+
+static int sfdp_quad_enable_sr2(struct spi_flash *flash)
+{
+	return spi_flash_quad_enable_sr2(flash, CMD_READ_STATUS2);
+}
+
+static int sfdp_quad_enable_sr1(struct spi_flash *flash)
+{
+	int ret;
+	u8 sr;
+
+	ret = spi_flash_cmd_read_status(flash, &sr);
+	if (ret)
+		return ret;
+	if (sr & (1 << 6))
+		return 0;
+
+	sr |= 1 << 6;
+	ret = spi_flash_cmd_write_status(flash, &sr, 1);
+	if (ret)
+		return ret;
+
+	ret = spi_flash_cmd_read_status(flash, &sr);
+	if (ret)
+		return ret;
+
+	return sr & (1 << 6) ? 0 : -1;
+}
+
+/* Record the opcode and dummy clocks of a fast read mode */
+static void sfdp_read_param(struct spi_flash *flash, u8 mode, u16 field)
+{
+	struct spi_flash_read_param *rp = &flash->read_params[ffs(mode) - 1];
+
+	if (rp->cmd)
+		return;
+	rp->cmd = field >> 8;
+	rp->dummy_clk = (field & 0x1f) + ((field >> 5) & 0x7);
+}
+
+/* Offer an erase type from dword 8 or 9, given as 2^N size and opcode */
+static void sfdp_add_erase(struct spi_flash *flash, u16 type)
+{
+	u8 shift = type & 0xff;
+
+	if (!shift || shift > 31)
+		return;
+	spi_flash_add_erase(flash, 1U << shift, type >> 8);
+	if (!flash->sector_size || flash->sector_size > 1U << shift)
+		flash->sector_size = 1U << shift;
+}
+
+/*
+ * Note which erase types have a 4-byte address opcode, from dword 1 and
+ * the opcodes in dword 2 of the 4-byte address instruction table. Only
+ * the standard opcodes are taken, since those are what the erase code
+ * sends; a type with any other opcode is not used on a 4-byte part.
+ */
+static void sfdp_parse_4bait(struct spi_flash *flash,
+			     const struct sfdp_param_header *ph,
+			     const u32 *bfpt)
+{
+	u32 dw[2];
+	u8 shift, cmd;
+	int i;
+
+	if (spi_flash_read_sfdp(flash->spi, ph->ptp[2] << 16 |
+				ph->ptp[1] << 8 | ph->ptp[0], dw, sizeof(dw)))
+		return;
+	dw[0] = le32_to_cpu(dw[0]);
+	dw[1] = le32_to_cpu(dw[1]);
+
+	for (i = 0; i < SPI_FLASH_ERASE_TYPES; i++) {
+		if (!(dw[0] & FBAIT_DW1_ERASE_TYPE(i + 1)))
+			continue;
+		shift = bfpt[BFPT_DW(8) + i / 2] >> (16 * (i % 2));
+		cmd = dw[1] >> (8 * i);
+		if (shift == 12 && cmd == CMD_ERASE_4K_4B)
+			flash->erase_4b |= SPI_FLASH_ERASE_4B_4K;
+		else if (shift == 15 && cmd == CMD_ERASE_32K_4B)
+			flash->erase_4b |= SPI_FLASH_ERASE_4B_32K;
+		else if (shift == 16 && cmd == CMD_ERASE_64K_4B)
+			flash->erase_4b |= SPI_FLASH_ERASE_4B_64K;
+	}
+}
+
+int spi_flash_parse_sfdp(struct spi_flash *flash)
+{
+	struct sfdp_header hdr;
+	struct sfdp_param_header phdr[SFDP_MAX_HEADERS], *ph = NULL;
+	struct sfdp_param_header *fbait = NULL;
+	u32 dw[SFDP_BFPT_DWORDS];
+	int i, nph, len, qer;
+	u32 d, sector_size;
+	u8 modes = 0;
+
+	if (spi_flash_read_sfdp(flash->spi, 0, &hdr, sizeof(hdr)))
+		return -1;
+	if (get_unaligned_le32(hdr.signature) != SFDP_SIGNATURE ||
+	    hdr.major != 1) {
+		debug("SF: No SFDP tables\n");
+		return -1;
+	}
+
+	nph = min(hdr.nph + 1, SFDP_MAX_HEADERS);
+	if (spi_flash_read_sfdp(flash->spi, sizeof(hdr), phdr,
+				nph * sizeof(*phdr)))
+		return -1;
+
+	/* Later revisions of the basic table override earlier ones */
+	for (i = 0; i < nph; i++) {
+		d = phdr[i].id_msb << 8 | phdr[i].id_lsb;
+		if (d == SFDP_BFPT_ID && phdr[i].major == 1 &&
+		    phdr[i].length >= 9)
+			ph = &phdr[i];
+		else if (d == SFDP_4BAIT_ID && phdr[i].major == 1 &&
+			 phdr[i].length >= 2)
+			fbait = &phdr[i];
+	}
+	if (!ph)
+		return -1;
+
+	len = min(ph->length, SFDP_BFPT_DWORDS);
+	memset(dw, '\0', sizeof(dw));
+	if (spi_flash_read_sfdp(flash->spi, ph->ptp[2] << 16 |
+				ph->ptp[1] << 8 | ph->ptp[0], dw, len * 4))
+		return -1;
+	for (i = 0; i < len; i++)
+		dw[i] = le32_to_cpu(dw[i]);
+
+	debug("SF: SFDP %d.%d basic table, %d dwords\n", ph->major,
+	      ph->minor, len);
+
+	if (!flash->size) {
+		d = dw[BFPT_DW(2)];
+		if (d & BFPT_DW2_DENSITY_EXP) {
+			d &= ~BFPT_DW2_DENSITY_EXP;
+			if (d < 3 || d > 34)
+				return -1;
+			flash->size = 1U << (d - 3);
+		} else {
+			flash->size = (d + 1) >> 3;
+		}
+	}
+
+	if (!flash->page_size)
+		flash->page_size = len >= 11 ?
+			1 << ((dw[BFPT_DW(11)] >> 4) & 0xf) : 256;
+
+	/* Erase types; with no vendor sector size, use the smallest */
+	sector_size = flash->sector_size;
+	for (i = BFPT_DW(8); i <= BFPT_DW(9); i++) {
+		sfdp_add_erase(flash, dw[i]);
+		sfdp_add_erase(flash, dw[i] >> 16);
+	}
+	d = dw[BFPT_DW(1)];
+	if ((d & BFPT_DW1_ERASE_4K_MASK) == BFPT_DW1_ERASE_4K)
+		sfdp_add_erase(flash, 12 | (d & 0xff00));
+	if (sector_size)
+		flash->sector_size = sector_size;
+
+	if (((d >> BFPT_DW1_ADDR_SHIFT) & 0x3) == BFPT_DW1_ADDR_4B_ONLY)
+		flash->addr_width = 4;
+	if (fbait)
+		sfdp_parse_4bait(flash, fbait, dw);
+
+	if (d & BFPT_DW1_FAST_READ_1_1_2) {
+		modes |= SPI_FLASH_RD_DUAL;
+		sfdp_read_param(flash, SPI_FLASH_RD_DUAL, dw[BFPT_DW(4)]);
+	}
+	if (d & BFPT_DW1_FAST_READ_1_1_4) {
+		modes |= SPI_FLASH_RD_QUAD;
+		sfdp_read_param(flash, SPI_FLASH_RD_QUAD, dw[BFPT_DW(3)] >> 16);
+	}
+	if (d & BFPT_DW1_FAST_READ_1_4_4) {
+		modes |= SPI_FLASH_RD_QUAD_IO;
+		sfdp_read_param(flash, SPI_FLASH_RD_QUAD_IO, dw[BFPT_DW(3)]);
+	}
+
+	if (flash->read_modes)
+		return 0;
+
+	/* Quad reads need the part's quad-enable bit to be known */
+	if ((modes & (SPI_FLASH_RD_QUAD | SPI_FLASH_RD_QUAD_IO)) &&
+	    !flash->quad_enable) {
+		qer = len >= 15 ? (dw[BFPT_DW(15)] >> BFPT_DW15_QER_SHIFT) &
+			BFPT_DW15_QER_MASK : -1;
+		switch (qer) {
+		case QER_NONE:
+			break;
+		case QER_SR2_BIT1_BUGGY:
+		case QER_SR2_BIT1:
+			flash->quad_enable = sfdp_quad_enable_sr2;
+			break;
+		case QER_SR1_BIT6:
+			flash->quad_enable = sfdp_quad_enable_sr1;
+			break;
+		default:
+			modes &= ~(SPI_FLASH_RD_QUAD | SPI_FLASH_RD_QUAD_IO);
+			break;
+		}
+	}
+	flash->read_modes = modes;
+
+	return 0;
+}
+
+static int sfdp_erase(struct spi_flash *flash, u32 offset, size_t len)
+{
+	int i;
+
+	for (i = 0; i < SPI_FLASH_ERASE_TYPES; i++)
+		if (flash->erase_shift[i] &&
+		    1U << flash->erase_shift[i] == flash->sector_size)
+			return spi_flash_cmd_erase(flash, flash->erase_cmd[i],
+						   offset, len);
+
+	return -1;
+}
+
+struct spi_flash *spi_flash_probe_sfdp(struct spi_slave *spi, u8 *idcode)
+{
+	struct spi_flash *flash;
+
+	flash = malloc(sizeof(*flash));
+	if (!flash) {
+		debug("SF: Failed to allocate memory\n");
+		return NULL;
+	}
+	memset(flash, '\0', sizeof(*flash));
+
+	flash->spi = spi;
+	flash->name = "SFDP";
+
+	if (spi_flash_parse_sfdp(flash) || !flash->size ||
+	    !flash->sector_size) {
+		free(flash);
+		return NULL;
+	}
+
+	flash->write = spi_flash_cmd_write_multi;
+	flash->erase = sfdp_erase;
+#ifdef CONFIG_SPI_FLASH_NO_FAST_READ
+	flash->read = spi_flash_cmd_read_slow;
+#else
+	flash->read = spi_flash_cmd_read_fast;
+#endif
+
+	debug("SF: SFDP part %02x%02x%02x\n", idcode[0], idcode[1], idcode[2]);
+
+	return flash;
+}
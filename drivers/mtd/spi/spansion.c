@@ -38,6 +38,7 @@
 #define CMD_S25FLXX_WREN	0x06	/* Write Enable */
 #define CMD_S25FLXX_WRDI	0x04	/* Write Disable */
 #define CMD_S25FLXX_RDSR	0x05	/* Read Status Register */
+#define CMD_S25FLXX_RCR		0x35	/* Read Configuration Register */
 #define CMD_S25FLXX_WRSR	0x01	/* Write Status Register */
 #define CMD_S25FLXX_PP		0x02	/* Page Program */
 #define CMD_S25FLXX_SE		0xd8	/* Sector Erase */
@@ -50,10 +51,16 @@
 #define SPSN_ID_S25FL032A	0x0215
 #define SPSN_ID_S25FL064A	0x0216
 #define SPSN_ID_S25FL128P	0x2018
+#define SPSN_ID_S25FL256S	0x0219
 #define SPSN_EXT_ID_S25FL128P_256KB	0x0300
 #define SPSN_EXT_ID_S25FL128P_64KB	0x0301
 #define SPSN_EXT_ID_S25FL032P		0x4d00
 #define SPSN_EXT_ID_S25FL129P		0x4d01
+#define SPSN_EXT_ID_S25FL256S_64KB	0x4d01
+
+/* P and S family parts read in dual and quad modes */
+#define SPSN_QUAD_READ_MODES	(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_RD_QUAD_IO)
 
 struct spansion_spi_flash_params {
 	u16 idcode1;
@@ -61,6 +68,8 @@ struct spansion_spi_flash_params {
 	u16 page_size;
 	u16 pages_per_sector;
 	u16 nr_sectors;
+	u8 read_modes;
+	u8 erase_4b;		/* SPI_FLASH_ERASE_4B_* */
 	const char *name;
 };
 
@@ -119,6 +128,7 @@ static const struct spansion_spi_flash_params spansion_spi_flash_table[] = {
 		.page_size = 256,
 		.pages_per_sector = 256,
 		.nr_sectors = 64,
+		.read_modes = SPSN_QUAD_READ_MODES,
 		.name = "S25FL032P",
 	},
 	{
@@ -127,8 +137,19 @@ static const struct spansion_spi_flash_params spansion_spi_flash_table[] = {
 		.page_size = 256,
 		.pages_per_sector = 256,
 		.nr_sectors = 256,
+		.read_modes = SPSN_QUAD_READ_MODES,
 		.name = "S25FL129P_64K",
 	},
+	{
+		.idcode1 = SPSN_ID_S25FL256S,
+		.idcode2 = SPSN_EXT_ID_S25FL256S_64KB,
+		.page_size = 256,
+		.pages_per_sector = 256,
+		.nr_sectors = 512,
+		.read_modes = SPSN_QUAD_READ_MODES,
+		.erase_4b = SPI_FLASH_ERASE_4B_4K | SPI_FLASH_ERASE_4B_64K,
+		.name = "S25FL256S_64K",
+	},
 };
 
 static int spansion_erase(struct spi_flash *flash, u32 offset, size_t len)
@@ -136,6 +157,12 @@ static int spansion_erase(struct spi_flash *flash, u32 offset, size_t len)
 	return spi_flash_cmd_erase(flash, CMD_S25FLXX_SE, offset, len);
 }
 
+/* The QUAD bit sits in the configuration register */
+static int spansion_quad_enable(struct spi_flash *flash)
+{
+	return spi_flash_quad_enable_sr2(flash, CMD_S25FLXX_RCR);
+}
+
 struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 {
 	const struct spansion_spi_flash_params *params;
@@ -164,6 +191,7 @@ struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
 	}
+	memset(flash, '\0', sizeof(*flash));
 
 	flash->spi = spi;
 	flash->name = params->name;
@@ -171,6 +199,9 @@ struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = spansion_erase;
 	flash->read = spi_flash_cmd_read_fast;
+	flash->read_modes = params->read_modes;
+	flash->erase_4b = params->erase_4b;
+	flash->quad_enable = spansion_quad_enable;
 	flash->page_size = params->page_size;
 	flash->sector_size = params->page_size * params->pages_per_sector;
 	flash->size = flash->sector_size * params->nr_sectors;
@@ -16,12 +16,51 @@
 
 #include "spi_flash_internal.h"
 
-static void spi_flash_addr(u32 addr, u8 *cmd)
+/*
+ * Read commands in order of preference. The dummy bytes follow the address
+ * on the same lines; for quad I/O the first of them is the mode byte, which
+ * is sent as zero so the part never enters continuous read mode.
+ */
+static const struct spi_flash_read_op {
+	u8 mode;		/* SPI_FLASH_RD_*, 0 for single line */
+	u8 cmd;
+	u8 cmd_4b;
+	u8 dummy;
+	u8 addr_lanes;		/* SPI_XFER_* lines after the opcode */
+	u8 data_lanes;		/* SPI_XFER_* lines for the data */
+} spi_flash_read_ops[] = {
+	{ SPI_FLASH_RD_QUAD_IO, CMD_READ_ARRAY_QUAD_IO,
+		CMD_READ_ARRAY_QUAD_IO_4B, 3, SPI_XFER_QUAD, SPI_XFER_QUAD },
+	{ SPI_FLASH_RD_QUAD, CMD_READ_ARRAY_QUAD,
+		CMD_READ_ARRAY_QUAD_4B, 1, 0, SPI_XFER_QUAD },
+	{ SPI_FLASH_RD_DUAL, CMD_READ_ARRAY_DUAL,
+		CMD_READ_ARRAY_DUAL_4B, 1, 0, SPI_XFER_DUAL },
+	{ 0, CMD_READ_ARRAY_FAST, CMD_READ_ARRAY_FAST_4B, 1, 0, 0 },
+};
+
+static const struct spi_flash_read_op *spi_flash_read_op(u8 mode)
+{
+	const struct spi_flash_read_op *op = spi_flash_read_ops;
+
+	while (op->mode && op->mode != mode)
+		op++;
+
+	return op;
+}
+
+/* Fill in the address after cmd[0], returning the command length so far */
+static size_t spi_flash_addr(struct spi_flash *flash, u32 addr, u8 *cmd)
 {
+	size_t i = 1;
+
 	/* cmd[0] is actual command */
-	cmd[1] = addr >> 16;
-	cmd[2] = addr >> 8;
-	cmd[3] = addr >> 0;
+	if (flash->addr_width == 4)
+		cmd[i++] = addr >> 24;
+	cmd[i++] = addr >> 16;
+	cmd[i++] = addr >> 8;
+	cmd[i++] = addr >> 0;
+
+	return i;
 }
 
 #ifdef CONFIG_NEW_SPI_XFER
@@ -79,27 +118,12 @@ int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 	return ret;
 }
 
-int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
-		size_t len, void *data)
-{
-	u8 cmd[5];
-
-	cmd[0] = CMD_READ_ARRAY_FAST;
-	spi_flash_addr(offset, cmd);
-	cmd[4] = 0x00;
-
-	return spi_flash_read_common(flash, cmd, sizeof(cmd), data, len);
-}
-
-int spi_flash_cmd_read_slow(struct spi_flash *flash, u32 offset,
-		size_t len, void *data)
+int spi_flash_read_lanes(struct spi_flash *flash, const u8 *cmd,
+		size_t cmd_len, unsigned long addr_lanes, void *data,
+		size_t data_len, unsigned long data_lanes)
 {
-	u8 cmd[4];
-
-	cmd[0] = CMD_READ_ARRAY_SLOW;
-	spi_flash_addr(offset, cmd);
-
-	return spi_flash_read_common(flash, cmd, sizeof(cmd), data, len);
+	/* This interface has no way to ask for more lines */
+	return spi_flash_read_common(flash, cmd, cmd_len, data, data_len);
 }
 
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
@@ -195,16 +219,46 @@ int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 	return ret;
 }
 
-int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
-		size_t len, void *data)
+int spi_flash_read_lanes(struct spi_flash *flash, const u8 *cmd,
+		size_t cmd_len, unsigned long addr_lanes, void *data,
+		size_t data_len, unsigned long data_lanes)
 {
-	u8 cmd[5];
+	struct spi_slave *spi = flash->spi;
+	int ret;
 
-	cmd[0] = CMD_READ_ARRAY_FAST;
-	spi_flash_addr(offset, cmd);
-	cmd[4] = 0x00;
+	if (!addr_lanes && !data_lanes)
+		return spi_flash_read_common(flash, cmd, cmd_len,
+					     data, data_len);
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPI, "SPI read");
+	spi_claim_bus(spi);
+
+	/* The opcode always goes out on a single line */
+	if (addr_lanes) {
+		ret = spi_xfer(spi, 8, cmd, NULL, SPI_XFER_BEGIN);
+		if (!ret)
+			ret = spi_xfer(spi, (cmd_len - 1) * 8, cmd + 1, NULL,
+				       addr_lanes);
+	} else {
+		ret = spi_xfer(spi, cmd_len * 8, cmd, NULL, SPI_XFER_BEGIN);
+	}
+
+	if (ret) {
+		debug("SF: Failed to send command (%zu bytes): %d\n",
+				cmd_len, ret);
+		spi_xfer(spi, 0, NULL, NULL, SPI_XFER_END);
+	} else {
+		ret = spi_xfer(spi, data_len * 8, NULL, data,
+			       data_lanes | SPI_XFER_END);
+		if (ret)
+			debug("SF: Failed to transfer %zu bytes of data: %d\n",
+					data_len, ret);
+	}
 
-	return spi_flash_read_common(flash, cmd, sizeof(cmd), data, len);
+	spi_release_bus(spi);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPI);
+
+	return ret;
 }
 
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
@@ -267,13 +321,42 @@ int spi_flash_cmd_read_status(struct spi_flash *flash, u8 *result)
 
 #endif /* CONFIG_NEW_SPI_XFER */
 
+int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
+		size_t len, void *data)
+{
+	const struct spi_flash_read_op *op = spi_flash_read_op(flash->read_mode);
+	u8 cmd[SPI_FLASH_CMD_LEN];
+	size_t cmd_len;
+
+	cmd[0] = flash->read_cmd;
+	cmd_len = spi_flash_addr(flash, offset, cmd);
+	memset(&cmd[cmd_len], 0, flash->read_dummy);
+	cmd_len += flash->read_dummy;
+
+	return spi_flash_read_lanes(flash, cmd, cmd_len, op->addr_lanes,
+				    data, len, op->data_lanes);
+}
+
+int spi_flash_cmd_read_slow(struct spi_flash *flash, u32 offset,
+		size_t len, void *data)
+{
+	u8 cmd[SPI_FLASH_CMD_LEN];
+	size_t cmd_len;
+
+	cmd[0] = flash->addr_width == 4 ? CMD_READ_ARRAY_SLOW_4B :
+		CMD_READ_ARRAY_SLOW;
+	cmd_len = spi_flash_addr(flash, offset, cmd);
+
+	return spi_flash_read_common(flash, cmd, cmd_len, data, len);
+}
+
 int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 		size_t len, const void *buf)
 {
 	unsigned long byte_addr, page_size;
-	size_t chunk_len, actual;
+	size_t chunk_len, actual, cmd_len;
 	int ret;
-	u8 cmd[4];
+	u8 cmd[SPI_FLASH_CMD_LEN];
 
 	page_size = min(flash->page_size, CONTROLLER_PAGE_LIMIT);
 	byte_addr = offset % page_size;
@@ -284,16 +367,15 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 		return ret;
 	}
 
-	cmd[0] = CMD_PAGE_PROGRAM;
+	cmd[0] = flash->addr_width == 4 ? CMD_PAGE_PROGRAM_4B :
+		CMD_PAGE_PROGRAM;
 	for (actual = 0; actual < len; actual += chunk_len) {
 		chunk_len = min(len - actual, page_size - byte_addr);
 
-		cmd[1] = (offset >> 16) & 0xff;
-		cmd[2] = (offset >> 8) & 0xff;
-		cmd[3] = (offset >> 0) & 0xff;
+		cmd_len = spi_flash_addr(flash, offset, cmd);
 
-		debug("PP: 0x%p => cmd = { 0x%02x 0x%02x%02x%02x } chunk_len = %zu\n",
-		      buf + actual, cmd[0], cmd[1], cmd[2], cmd[3], chunk_len);
+		debug("PP: 0x%p => cmd = { 0x%02x 0x%08x } chunk_len = %zu\n",
+		      buf + actual, cmd[0], offset, chunk_len);
 
 		ret = spi_flash_cmd_write_enable(flash);
 		if (ret < 0) {
@@ -301,7 +383,7 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 			break;
 		}
 
-		ret = spi_flash_cmd_write(flash->spi, cmd, 4,
+		ret = spi_flash_cmd_write(flash->spi, cmd, cmd_len,
 					  buf + actual, chunk_len);
 		if (ret < 0) {
 			debug("SF: write failed\n");
@@ -329,41 +411,180 @@ int spi_flash_cmd_wait_ready(struct spi_flash *flash, unsigned long timeout)
 		CMD_READ_STATUS, STATUS_WIP);
 }
 
+int spi_flash_cmd_write_status(struct spi_flash *flash, const u8 *sr,
+			       size_t len)
+{
+	u8 cmd = CMD_WRITE_STATUS;
+	int ret;
+
+	ret = spi_flash_cmd_write_enable(flash);
+	if (ret) {
+		debug("SF: enabling write failed\n");
+		return ret;
+	}
+
+	ret = spi_flash_cmd_write(flash->spi, &cmd, 1, sr, len);
+	if (ret) {
+		debug("SF: fail to write status register\n");
+		return ret;
+	}
+
+	return spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+}
+
+int spi_flash_quad_enable_sr2(struct spi_flash *flash, u8 cmd)
+{
+	u8 sr[2];
+	int ret;
+
+	ret = spi_flash_cmd_read_status(flash, &sr[0]);
+	if (!ret)
+		ret = spi_flash_cmd(flash->spi, cmd, &sr[1], 1);
+	if (ret)
+		return ret;
+	if (sr[1] & (1 << 1))
+		return 0;
+
+	sr[1] |= 1 << 1;
+	ret = spi_flash_cmd_write_status(flash, sr, sizeof(sr));
+	if (ret)
+		return ret;
+
+	/* The bit does not stick if the status register is locked */
+	ret = spi_flash_cmd(flash->spi, cmd, &sr[1], 1);
+	if (ret)
+		return ret;
+
+	return sr[1] & (1 << 1) ? 0 : -1;
+}
+
+int spi_flash_read_sfdp(struct spi_slave *spi, u32 addr, void *buf,
+			size_t len)
+{
+	u8 cmd[5];
+
+	cmd[0] = CMD_READ_SFDP;
+	cmd[1] = addr >> 16;
+	cmd[2] = addr >> 8;
+	cmd[3] = addr >> 0;
+	cmd[4] = 0x00;
+
+	return spi_flash_cmd_read(spi, cmd, sizeof(cmd), buf, len);
+}
+
+/*
+ * Map an erase command to the 4-byte address one, 0 if the part does not
+ * offer one. Not every part has all three, so only those it declares in
+ * erase_4b are used.
+ */
+static u8 spi_flash_erase_cmd_4b(struct spi_flash *flash, u8 erase_cmd)
+{
+	switch (erase_cmd) {
+	case CMD_ERASE_4K:
+		if (flash->erase_4b & SPI_FLASH_ERASE_4B_4K)
+			return CMD_ERASE_4K_4B;
+		break;
+	case CMD_ERASE_32K:
+		if (flash->erase_4b & SPI_FLASH_ERASE_4B_32K)
+			return CMD_ERASE_32K_4B;
+		break;
+	case CMD_ERASE_64K:
+		if (flash->erase_4b & SPI_FLASH_ERASE_4B_64K)
+			return CMD_ERASE_64K_4B;
+		break;
+	}
+
+	return 0;
+}
+
+void spi_flash_add_erase(struct spi_flash *flash, u32 size, u8 cmd)
+{
+	u8 shift = ffs(size) - 1;
+	int i;
+
+	for (i = 0; i < SPI_FLASH_ERASE_TYPES; i++) {
+		if (flash->erase_shift[i] == shift)
+			return;
+		if (!flash->erase_shift[i]) {
+			flash->erase_shift[i] = shift;
+			flash->erase_cmd[i] = cmd;
+			return;
+		}
+	}
+}
+
+/*
+ * Pick the largest erase block that starts at offset and fits in the rest
+ * of the range, the sector itself if nothing larger does. Returns its size
+ * and the command that erases it.
+ */
+static u32 spi_flash_erase_block(struct spi_flash *flash, u8 sector_cmd,
+				 u32 offset, u32 end, u8 *cmd)
+{
+	u32 size, best = flash->sector_size;
+	int i;
+
+	*cmd = sector_cmd;
+	for (i = 0; i < SPI_FLASH_ERASE_TYPES; i++) {
+		if (!flash->erase_shift[i])
+			continue;
+		size = 1U << flash->erase_shift[i];
+		if (size <= best || offset % size || end - offset < size)
+			continue;
+		if (flash->addr_width == 4 &&
+		    !spi_flash_erase_cmd_4b(flash, flash->erase_cmd[i]))
+			continue;
+		best = size;
+		*cmd = flash->erase_cmd[i];
+	}
+
+	return best;
+}
+
 int spi_flash_cmd_erase(struct spi_flash *flash, u8 erase_cmd,
 			u32 offset, size_t len)
 {
 	u32 start, end, erase_size;
+	size_t cmd_len;
 	int ret;
-	u8 cmd[4];
+	u8 cmd[SPI_FLASH_CMD_LEN];
 
-	erase_size = flash->sector_size;
-	if (offset % erase_size || len % erase_size) {
+	if (offset % flash->sector_size || len % flash->sector_size) {
 		debug("SF: Erase offset/length not multiple of erase size\n");
 		return -1;
 	}
 
+	if (flash->addr_width == 4 &&
+	    !spi_flash_erase_cmd_4b(flash, erase_cmd)) {
+		debug("SF: No 4-byte address erase command\n");
+		return -1;
+	}
+
 	ret = spi_claim_bus(flash->spi);
 	if (ret) {
 		debug("SF: Unable to claim SPI bus\n");
 		return ret;
 	}
 
-	cmd[0] = erase_cmd;
 	start = offset;
 	end = start + len;
 
 	while (offset < end) {
-		spi_flash_addr(offset, cmd);
+		erase_size = spi_flash_erase_block(flash, erase_cmd, offset,
+						   end, &cmd[0]);
+		if (flash->addr_width == 4)
+			cmd[0] = spi_flash_erase_cmd_4b(flash, cmd[0]);
+		cmd_len = spi_flash_addr(flash, offset, cmd);
 		offset += erase_size;
 
-		debug("SF: erase %2x %2x %2x %2x (%x)\n", cmd[0], cmd[1],
-		      cmd[2], cmd[3], offset);
+		debug("SF: erase %2x %08x (%x)\n", cmd[0], offset - erase_size,
+		      offset);
 
 		ret = spi_flash_cmd_write_enable(flash);
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_write(flash->spi, cmd, sizeof(cmd), NULL, 0);
+		ret = spi_flash_cmd_write(flash->spi, cmd, cmd_len, NULL, 0);
 		if (ret)
 			goto out;
 
@@ -448,6 +669,99 @@ static const struct {
 };
 #define IDCODE_LEN (IDCODE_CONT_LEN + IDCODE_PART_LEN)
 
+unsigned int __weak spi_get_rx_caps(struct spi_slave *slave)
+{
+	return 0;
+}
+
+/*
+ * Work out the opcode and dummy bytes for a read op, taking a non-standard
+ * command for its mode into account. Returns -1 if the command cannot be
+ * issued.
+ */
+static int spi_flash_read_param(struct spi_flash *flash,
+				const struct spi_flash_read_op *op,
+				u8 *cmd, u8 *dummy)
+{
+	const struct spi_flash_read_param *rp;
+	unsigned int bits;
+
+	*cmd = flash->addr_width == 4 ? op->cmd_4b : op->cmd;
+	*dummy = op->dummy;
+	if (!op->mode)
+		return 0;
+
+	rp = &flash->read_params[ffs(op->mode) - 1];
+	if (!rp->cmd)
+		return 0;
+
+	/* Only the standard opcodes have known 4-byte address forms */
+	if (flash->addr_width == 4) {
+		if (rp->cmd != op->cmd)
+			return -1;
+	} else {
+		*cmd = rp->cmd;
+	}
+
+	/* Dummy clocks run on the address lines */
+	bits = rp->dummy_clk;
+	if (op->addr_lanes & SPI_XFER_QUAD)
+		bits *= 4;
+	else if (op->addr_lanes & SPI_XFER_DUAL)
+		bits *= 2;
+	if (bits % 8 || bits / 8 > SPI_FLASH_CMD_LEN - 5)
+		return -1;
+	*dummy = bits / 8;
+
+	return 0;
+}
+
+/*
+ * Pick the address width and the fastest read command that both the part
+ * and the controller support. Quad modes are dropped if the part's
+ * quad-enable bit cannot be set.
+ */
+static void spi_flash_setup_read(struct spi_flash *flash)
+{
+	const struct spi_flash_read_op *op;
+	unsigned int caps = 0;
+	u8 modes, cmd, dummy;
+
+	if (!flash->addr_width)
+		flash->addr_width = flash->size > (1 << 24) ? 4 : 3;
+
+	/* Parts set up for slow or vendor-specific reads stay as they are */
+	modes = 0;
+	if (flash->read == spi_flash_cmd_read_fast)
+		modes = flash->read_modes;
+#ifndef CONFIG_NEW_SPI_XFER
+	caps = spi_get_rx_caps(flash->spi);
+#endif
+	if (!(caps & SPI_XFER_DUAL))
+		modes &= ~SPI_FLASH_RD_DUAL;
+	if (!(caps & SPI_XFER_QUAD))
+		modes &= ~(SPI_FLASH_RD_QUAD | SPI_FLASH_RD_QUAD_IO);
+	if ((modes & (SPI_FLASH_RD_QUAD | SPI_FLASH_RD_QUAD_IO)) &&
+	    flash->quad_enable && flash->quad_enable(flash)) {
+		debug("SF: Failed to enable quad mode\n");
+		modes &= ~(SPI_FLASH_RD_QUAD | SPI_FLASH_RD_QUAD_IO);
+	}
+
+	for (op = spi_flash_read_ops; op->mode; op++)
+		if ((modes & op->mode) &&
+		    !spi_flash_read_param(flash, op, &cmd, &dummy))
+			break;
+	if (!op->mode)
+		spi_flash_read_param(flash, op, &cmd, &dummy);
+
+	flash->read_mode = op->mode;
+	flash->read_cmd = cmd;
+	flash->read_dummy = dummy;
+
+	debug("SF: %d-byte address, read command %02x, %d dummy bytes\n",
+	      flash->addr_width, flash->read_cmd, flash->read_dummy);
+}
+
 struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs,
 		unsigned int max_hz, unsigned int spi_mode)
 {
@@ -493,11 +807,20 @@ struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs,
 				break;
 		}
 
+#ifdef CONFIG_SPI_FLASH_SFDP
+	if (flash)
+		spi_flash_parse_sfdp(flash);
+	else
+		flash = spi_flash_probe_sfdp(spi, idp);
+#endif
+
 	if (!flash) {
 		printf("SF: Unsupported manufacturer %02x\n", *idp);
 		goto err_manufacturer_probe;
 	}
 
+	spi_flash_setup_read(flash);
+
 	printf("SF: Detected %s with page size ", flash->name);
 	print_size(flash->sector_size, ", total ");
 	print_size(flash->size, "\n");
@@ -18,12 +18,36 @@
 #define CMD_READ_ARRAY_SLOW		0x03
 #define CMD_READ_ARRAY_FAST		0x0b
 #define CMD_READ_ARRAY_LEGACY		0xe8
+#define CMD_READ_ARRAY_DUAL		0x3b
+#define CMD_READ_ARRAY_QUAD		0x6b
+#define CMD_READ_ARRAY_QUAD_IO		0xeb
 
+#define CMD_WRITE_STATUS		0x01
 #define CMD_PAGE_PROGRAM		0x02
 #define CMD_WRITE_DISABLE		0x04
 #define CMD_READ_STATUS			0x05
 #define CMD_WRITE_ENABLE		0x06
 
+#define CMD_ERASE_4K			0x20
+#define CMD_ERASE_32K			0x52
+#define CMD_ERASE_64K			0xd8
+
+/* 4-byte address variants, used on parts larger than 16 MiB */
+#define CMD_READ_ARRAY_SLOW_4B		0x13
+#define CMD_READ_ARRAY_FAST_4B		0x0c
+#define CMD_READ_ARRAY_DUAL_4B		0x3c
+#define CMD_READ_ARRAY_QUAD_4B		0x6c
+#define CMD_READ_ARRAY_QUAD_IO_4B	0xec
+#define CMD_PAGE_PROGRAM_4B		0x12
+#define CMD_ERASE_4K_4B			0x21
+#define CMD_ERASE_32K_4B		0x5c
+#define CMD_ERASE_64K_4B		0xdc
+
+#define CMD_READ_SFDP			0x5a
+
+/* Largest opcode + address + dummy sequence sent ahead of the data */
+#define SPI_FLASH_CMD_LEN		16
+
 /* Common status */
 #define STATUS_WIP			0x01
 
@@ -80,6 +104,15 @@ static inline int spi_flash_cmd_write_disable(struct spi_flash *flash)
 int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 		size_t cmd_len, void *data, size_t data_len);
 
+/*
+ * Same as spi_flash_read_common() except that the bytes following the
+ * opcode are sent on addr_lanes and the data is read on data_lanes, both
+ * a SPI_XFER_DUAL/SPI_XFER_QUAD flag or 0 for a single line.
+ */
+int spi_flash_read_lanes(struct spi_flash *flash, const u8 *cmd,
+		size_t cmd_len, unsigned long addr_lanes, void *data,
+		size_t data_len, unsigned long data_lanes);
+
 /* Send a command to the device and wait for some bit to clear itself. */
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
 			   u8 cmd, u8 poll_bit);
@@ -90,13 +123,47 @@ int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
  */
 int spi_flash_cmd_wait_ready(struct spi_flash *flash, unsigned long timeout);
 
-/* Erase sectors. */
+/*
+ * Erase sectors. erase_cmd erases one sector; runs of whole larger blocks
+ * offered with spi_flash_add_erase() are erased with a single command.
+ */
 int spi_flash_cmd_erase(struct spi_flash *flash, u8 erase_cmd,
 			u32 offset, size_t len);
 
+/* Offer an erase block of size bytes (a power of two) erased by cmd */
+void spi_flash_add_erase(struct spi_flash *flash, u32 size, u8 cmd);
+
 /* Read the status register */
 int spi_flash_cmd_read_status(struct spi_flash *flash, u8 *result);
 
+/*
+ * Write len bytes of status (and configuration) registers with the
+ * write-status command and wait for the write to complete.
+ */
+int spi_flash_cmd_write_status(struct spi_flash *flash, const u8 *sr,
+			       size_t len);
+
+/*
+ * Set the quad-enable bit held in bit 1 of the second status or
+ * configuration register, read with cmd and written after the first
+ * status register. This is the layout Winbond, Spansion and GigaDevice
+ * parts share.
+ */
+int spi_flash_quad_enable_sr2(struct spi_flash *flash, u8 cmd);
+
+/* Read len bytes of the JEDEC SFDP area from addr; the bus must be claimed */
+int spi_flash_read_sfdp(struct spi_slave *spi, u32 addr, void *buf,
+			size_t len);
+
+/*
+ * Read the JEDEC SFDP tables and fill in the parameters the probe left
+ * unset; the bus must be claimed.
+ */
+int spi_flash_parse_sfdp(struct spi_flash *flash);
+
+/* Set up a part from its SFDP tables alone */
+struct spi_flash *spi_flash_probe_sfdp(struct spi_slave *spi, u8 *idcode);
+
 /* Manufacturer-specific probe functions */
 struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode);
 struct spi_flash *spi_flash_probe_atmel(struct spi_slave *spi, u8 *idcode);
@@ -27,6 +27,8 @@
 #define CMD_SST_BP		0x02	/* Byte Program */
 #define CMD_SST_AAI_WP		0xAD	/* Auto Address Increment Word Program */
 #define CMD_SST_SE		0x20	/* Sector Erase */
+#define CMD_SST_BE32		0x52	/* Block (32K) Erase */
+#define CMD_SST_BE		0xd8	/* Block (64K) Erase */
 
 #define SST_SR_WIP		(1 << 0)	/* Write-in-Progress */
 #define SST_SR_WEL		(1 << 1)	/* Write enable */
@@ -266,6 +268,7 @@ spi_flash_probe_sst(struct spi_slave *spi, u8 *idcode)
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
 	}
+	memset(stm, '\0', sizeof(*stm));
 
 	stm->params = params;
 	stm->flash.spi = spi;
@@ -276,6 +279,8 @@ spi_flash_probe_sst(struct spi_slave *spi, u8 *idcode)
 	else
 		stm->flash.write = spi_flash_cmd_write_multi;
 	stm->flash.erase = sst_erase;
+	spi_flash_add_erase(&stm->flash, 32 << 10, CMD_SST_BE32);
+	spi_flash_add_erase(&stm->flash, 64 << 10, CMD_SST_BE);
 	stm->flash.read = spi_flash_cmd_read_fast;
 	stm->flash.page_size = SST_PAGE_SIZE;
 	stm->flash.sector_size = SST_SECTOR_SIZE;
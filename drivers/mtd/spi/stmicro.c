@@ -46,11 +46,24 @@
 #define CMD_M25PXX_DP		0xb9	/* Deep Power-down */
 #define CMD_M25PXX_RES		0xab	/* Release from DP, and Read Signature */
 
+/* N25Q memory type, the second JEDEC ID byte */
+#define STM_TYPE_N25Q		0xba
+
+/*
+ * N25Q parts need no quad-enable bit. Their quad I/O read defaults to ten
+ * dummy clocks, which does not fit the generic command, so only the dual
+ * and quad output reads are used.
+ */
+#define N25Q_READ_MODES		(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD)
+
+/* A mem_type of 0 matches any type but N25Q, as M25P entries always did */
 struct stmicro_spi_flash_params {
+	u8 mem_type;
 	u8 idcode1;
 	u16 page_size;
 	u16 pages_per_sector;
 	u16 nr_sectors;
+	u8 read_modes;
 	const char *name;
 };
 
@@ -111,6 +124,33 @@ static const struct stmicro_spi_flash_params stmicro_spi_flash_table[] = {
 		.nr_sectors = 64,
 		.name = "M25P128",
 	},
+	{
+		.mem_type = STM_TYPE_N25Q,
+		.idcode1 = 0x16,
+		.page_size = 256,
+		.pages_per_sector = 256,
+		.nr_sectors = 64,
+		.read_modes = N25Q_READ_MODES,
+		.name = "N25Q32",
+	},
+	{
+		.mem_type = STM_TYPE_N25Q,
+		.idcode1 = 0x17,
+		.page_size = 256,
+		.pages_per_sector = 256,
+		.nr_sectors = 128,
+		.read_modes = N25Q_READ_MODES,
+		.name = "N25Q64",
+	},
+	{
+		.mem_type = STM_TYPE_N25Q,
+		.idcode1 = 0x18,
+		.page_size = 256,
+		.pages_per_sector = 256,
+		.nr_sectors = 256,
+		.read_modes = N25Q_READ_MODES,
+		.name = "N25Q128",
+	},
 };
 
 static int stmicro_erase(struct spi_flash *flash, u32 offset, size_t len)
@@ -139,13 +179,16 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 
 	for (i = 0; i < ARRAY_SIZE(stmicro_spi_flash_table); i++) {
 		params = &stmicro_spi_flash_table[i];
-		if (params->idcode1 == idcode[2]) {
+		if (params->idcode1 == idcode[2] &&
+		    (params->mem_type == idcode[1] ||
+		     (!params->mem_type && idcode[1] != STM_TYPE_N25Q))) {
 			break;
 		}
 	}
 
 	if (i == ARRAY_SIZE(stmicro_spi_flash_table)) {
-		debug("SF: Unsupported STMicro ID %02x\n", idcode[1]);
+		debug("SF: Unsupported STMicro ID %02x%02x\n",
+		      idcode[1], idcode[2]);
 		return NULL;
 	}
 
@@ -154,6 +197,7 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
 	}
+	memset(flash, '\0', sizeof(*flash));
 
 	flash->spi = spi;
 	flash->name = params->name;
@@ -161,6 +205,7 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = stmicro_erase;
 	flash->read = spi_flash_cmd_read_fast;
+	flash->read_modes = params->read_modes;
 	flash->page_size = params->page_size;
 	flash->sector_size = params->page_size * params->pages_per_sector;
 	flash->size = flash->sector_size * params->nr_sectors;
@@ -14,6 +14,7 @@
 #define CMD_W25_WREN		0x06	/* Write Enable */
 #define CMD_W25_WRDI		0x04	/* Write Disable */
 #define CMD_W25_RDSR		0x05	/* Read Status Register */
+#define CMD_W25_RDSR2		0x35	/* Read Status Register 2 */
 #define CMD_W25_WRSR		0x01	/* Write Status Register */
 #define CMD_W25_READ		0x03	/* Read Data Bytes */
 #define CMD_W25_FAST_READ	0x0b	/* Read Data Bytes at Higher Speed */
@@ -31,9 +32,18 @@ struct winbond_spi_flash_params {
 	uint16_t	pages_per_sector;
 	uint16_t	sectors_per_block;
 	uint16_t	nr_blocks;
+	/* Multi-I/O reads, SPI_FLASH_RD_* */
+	uint8_t		read_modes;
+	/* Erases with a 4-byte address, SPI_FLASH_ERASE_4B_* */
+	uint8_t		erase_4b;
 	const char	*name;
 };
 
+/* W25X parts read in dual mode, W25Q parts in dual and quad modes */
+#define W25X_READ_MODES		SPI_FLASH_RD_DUAL
+#define W25Q_READ_MODES		(SPI_FLASH_RD_DUAL | SPI_FLASH_RD_QUAD | \
+				 SPI_FLASH_RD_QUAD_IO)
+
 static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 	{
 		.id			= 0x3013,
@@ -41,6 +51,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 8,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X40",
 	},
 	{
@@ -49,6 +60,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 32,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X16",
 	},
 	{
@@ -57,6 +69,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 64,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X32",
 	},
 	{
@@ -65,6 +78,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 128,
+		.read_modes		= W25X_READ_MODES,
 		.name			= "W25X64",
 	},
 	{
@@ -73,6 +87,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 32,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q16",
 	},
 	{
@@ -81,6 +96,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 64,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q32",
 	},
 	{
@@ -89,6 +105,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 128,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q64",
 	},
 	{
@@ -97,14 +114,28 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 256,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q128",
 	},
+	{
+		.id			= 0x4019,
+		.l2_page_size		= 8,
+		.pages_per_sector	= 16,
+		.sectors_per_block	= 16,
+		.nr_blocks		= 512,
+		.read_modes		= W25Q_READ_MODES,
+		/* No 4-byte form of the 32K erase */
+		.erase_4b		= SPI_FLASH_ERASE_4B_4K |
+					  SPI_FLASH_ERASE_4B_64K,
+		.name			= "W25Q256",
+	},
 	{
 		.id			= 0x5014,
 		.l2_page_size		= 8,
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 128,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q80",
 	},
 	{
@@ -113,6 +144,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 64,
+		.read_modes		= W25Q_READ_MODES,
 		.name			= "W25Q32",
 	},
 
@@ -123,6 +155,11 @@ static int winbond_erase(struct spi_flash *flash, u32 offset, size_t len)
 	return spi_flash_cmd_erase(flash, CMD_W25_SE, offset, len);
 }
 
+static int winbond_quad_enable(struct spi_flash *flash)
+{
+	return spi_flash_quad_enable_sr2(flash, CMD_W25_RDSR2);
+}
+
 static int winbond_read_sw_wp_status(struct spi_flash *flash, u8 *result)
 {
 	int r;
@@ -165,6 +202,7 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
 	}
+	memset(flash, '\0', sizeof(*flash));
 
 	flash->spi = spi;
 	flash->name = params->name;
@@ -180,6 +218,10 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 	flash->read = spi_flash_cmd_read_fast;
 #endif
 	flash->read_sw_wp_status = winbond_read_sw_wp_status;
+	flash->read_modes = params->read_modes;
+	flash->erase_4b = params->erase_4b;
+	flash->quad_enable = winbond_quad_enable;
+	spi_flash_add_erase(flash, 64 << 10, CMD_W25_BE);
 	flash->page_size = page_size;
 	flash->sector_size = page_size * params->pages_per_sector;
 	flash->size = page_size * params->pages_per_sector
@@ -55,6 +55,9 @@ static int paranoid_check_si(struct ubi_device *ubi, struct ubi_scan_info *si);
 #define paranoid_check_si(ubi, si) 0
 #endif
 
+/* Returned by 'scan_fastmap()' if the MTD device has to be fully scanned */
+#define UBI_NO_FASTMAP 1
+
 /* Temporary variables used during scanning */
 static struct ubi_ec_hdr *ech;
 static struct ubi_vid_hdr *vidh;
@@ -704,6 +707,10 @@ struct ubi_scan_leb *ubi_scan_get_free_peb(struct ubi_device *ubi,
 	int err = 0, i;
 	struct ubi_scan_leb *seb;
 
+	err = ubi_invalidate_fastmap(ubi);
+	if (err)
+		return ERR_PTR(err);
+
 	if (!list_empty(&si->free)) {
 		seb = list_entry(si->free.next, struct ubi_scan_leb, u.list);
 		list_del(&seb->u.list);
@@ -896,32 +903,521 @@ adjust_mean_ec:
 	return 0;
 }
 
+/**
+ * alloc_si - allocate empty scanning information.
+ */
+static struct ubi_scan_info *alloc_si(void)
+{
+	struct ubi_scan_info *si;
+
+	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
+	if (!si)
+		return NULL;
+
+	INIT_LIST_HEAD(&si->corr);
+	INIT_LIST_HEAD(&si->free);
+	INIT_LIST_HEAD(&si->erase);
+	INIT_LIST_HEAD(&si->alien);
+	si->volumes = RB_ROOT;
+	si->is_empty = 1;
+	return si;
+}
+
+#ifdef CONFIG_MTD_UBI_FASTMAP
+/* What the fastmap says a physical eraseblock is, see 'scan_fastmap()' */
+enum {
+	FM_PEB_UNKNOWN = 0,
+	FM_PEB_FREE,
+	FM_PEB_USED,
+	FM_PEB_SCRUB,
+	FM_PEB_ERASE,
+	FM_PEB_MAPPED,
+	FM_PEB_POOL,
+	FM_PEB_FASTMAP,
+};
+
+/**
+ * find_fastmap_sb - find the newest fastmap super block.
+ * @ubi: UBI device description object
+ *
+ * Only the first %UBI_FM_MAX_START physical eraseblocks may hold the fastmap
+ * super block, so only their headers are read. Returns the physical
+ * eraseblock number, %-ENOENT if there is no fastmap, or another negative
+ * error code in case of failure.
+ */
+static int find_fastmap_sb(struct ubi_device *ubi)
+{
+	int err, pnum, found = -ENOENT;
+	unsigned long long sqnum, max_sqnum = 0;
+
+	for (pnum = 0; pnum < ubi->peb_count && pnum < UBI_FM_MAX_START;
+	     pnum++) {
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			return err;
+		else if (err)
+			continue;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+		if (err < 0)
+			return err;
+		else if (err && err != UBI_IO_BITFLIPS)
+			continue;
+
+		if (be32_to_cpu(vidh->vol_id) != UBI_FM_SB_VOLUME_ID)
+			continue;
+
+		sqnum = be64_to_cpu(vidh->sqnum);
+		if (found < 0 || sqnum > max_sqnum) {
+			found = pnum;
+			max_sqnum = sqnum;
+		}
+	}
+
+	return found;
+}
+
+/**
+ * fm_get - take the next object from the fastmap data.
+ * @fm_raw: fastmap data
+ * @fm_pos: current position, moved past the object
+ * @fm_size: size of the fastmap data
+ * @len: size of the object
+ *
+ * Returns a pointer to the object or %NULL if the fastmap data is too short.
+ */
+static void *fm_get(void *fm_raw, int *fm_pos, int fm_size, int len)
+{
+	void *p = fm_raw + *fm_pos;
+
+	if (len < 0 || len > fm_size - *fm_pos)
+		return NULL;
+
+	*fm_pos += len;
+	return p;
+}
+
+/**
+ * fm_claim - record what a physical eraseblock in the fastmap is used for.
+ * @ubi: UBI device description object
+ * @kind: per-PEB table of %FM_PEB_* values
+ * @pnum: physical eraseblock number
+ * @what: what @pnum is used for
+ *
+ * Returns zero in case of success and %-EINVAL if @pnum is out of range or
+ * the fastmap has already mentioned it.
+ */
+static int fm_claim(const struct ubi_device *ubi, uint8_t *kind, int pnum,
+		    int what)
+{
+	if (pnum < 0 || pnum >= ubi->peb_count ||
+	    kind[pnum] != FM_PEB_UNKNOWN) {
+		dbg_bld("bad fastmap PEB %d", pnum);
+		return -EINVAL;
+	}
+
+	kind[pnum] = what;
+	return 0;
+}
+
+/**
+ * fm_add_ec - account an erase counter taken from the fastmap.
+ * @si: scanning information
+ * @ec: erase counter
+ */
+static void fm_add_ec(struct ubi_scan_info *si, int ec)
+{
+	si->ec_sum += ec;
+	si->ec_count += 1;
+	if (ec > si->max_ec)
+		si->max_ec = ec;
+	if (ec < si->min_ec)
+		si->min_ec = ec;
+}
+
+/**
+ * fm_add_leb - add a logical eraseblock described by the fastmap.
+ * @ubi: UBI device description object
+ * @si: scanning information
+ * @fmvh: fastmap volume header of the volume @lnum belongs to
+ * @lnum: logical eraseblock number
+ * @pnum: physical eraseblock number
+ * @ec: erase counter of @pnum
+ * @scrub: if @pnum has to be scrubbed
+ *
+ * The fastmap does not keep the VID headers, so one is made up from @fmvh and
+ * handed to 'ubi_scan_add_used()'. The sequence number is zero, so any copy
+ * of the same LEB found in the pools later on is considered newer. Returns
+ * zero in case of success and a negative error code in case of failure.
+ */
+static int fm_add_leb(struct ubi_device *ubi, struct ubi_scan_info *si,
+		      const struct ubi_fm_volhdr *fmvh, int lnum, int pnum,
+		      int ec, int scrub)
+{
+	memset(vidh, 0, sizeof(struct ubi_vid_hdr));
+	vidh->vol_id = fmvh->vol_id;
+	vidh->lnum = cpu_to_be32(lnum);
+	vidh->used_ebs = fmvh->used_ebs;
+	vidh->data_pad = fmvh->data_pad;
+	if (be32_to_cpu(fmvh->vol_id) == UBI_LAYOUT_VOLUME_ID)
+		vidh->compat = UBI_LAYOUT_VOLUME_COMPAT;
+
+	if (fmvh->vol_type == UBI_STATIC_VOLUME) {
+		vidh->vol_type = UBI_VID_STATIC;
+		vidh->data_size = fmvh->last_eb_bytes;
+	} else
+		vidh->vol_type = UBI_VID_DYNAMIC;
+
+	return ubi_scan_add_used(ubi, si, pnum, ec, vidh, scrub);
+}
+
+/**
+ * scan_fastmap - attach from the fastmap instead of scanning every PEB.
+ * @ubi: UBI device description object
+ * @sip: scanning information, replaced by an empty one if %UBI_NO_FASTMAP is
+ * returned
+ *
+ * Linux keeps a snapshot of its scanning information (the fastmap) in a few
+ * physical eraseblocks near the start of the device. If a valid one is found,
+ * the free, used and erase lists and the volume trees are taken from it, and
+ * only the PEBs of the fastmap pools, which may have been written after the
+ * snapshot was taken, are read. The fastmap PEBs themselves go to the @alien
+ * list so that nothing touches them until 'invalidate_fastmap()' does.
+ *
+ * Returns zero if the device was attached from the fastmap, %UBI_NO_FASTMAP
+ * if it has to be scanned, or a negative error code in case of failure.
+ */
+static int scan_fastmap(struct ubi_device *ubi, struct ubi_scan_info **sip)
+{
+	struct ubi_scan_info *si = *sip;
+	struct ubi_fm_sb *fmsb;
+	struct ubi_fm_hdr *fmhdr;
+	struct ubi_fm_scan_pool *fmpl[2];
+	struct ubi_fm_ec *fmec;
+	struct ubi_fm_volhdr *fmvh;
+	struct ubi_fm_eba *fmeba;
+	void *fm_raw = NULL;
+	uint8_t *kind = NULL;
+	int *ecs = NULL;
+	int err, i, j, pnum, sb_pnum, used_blocks, fm_size, fm_pos, found;
+	int counts[4];
+	static const uint8_t kinds[4] = {
+		FM_PEB_FREE, FM_PEB_USED, FM_PEB_SCRUB, FM_PEB_ERASE
+	};
+	uint32_t crc;
+
+	ubi->fm_sb_pnum = -1;
+
+	err = sb_pnum = find_fastmap_sb(ubi);
+	if (err < 0)
+		goto out;
+
+	/* The super block heads the fastmap data and tells its size */
+	err = -ENOMEM;
+	fmsb = kmalloc(sizeof(struct ubi_fm_sb), GFP_KERNEL);
+	if (!fmsb)
+		goto out;
+
+	err = ubi_io_read_data(ubi, fmsb, sb_pnum, 0, sizeof(*fmsb));
+	used_blocks = be32_to_cpu(fmsb->used_blocks);
+	if ((err && err != UBI_IO_BITFLIPS) ||
+	    be32_to_cpu(fmsb->magic) != UBI_FM_SB_MAGIC ||
+	    fmsb->version != UBI_FM_FMT_VERSION ||
+	    used_blocks < 1 || used_blocks > UBI_FM_MAX_BLOCKS ||
+	    be32_to_cpu(fmsb->block_loc[0]) != sb_pnum) {
+		kfree(fmsb);
+		err = -EINVAL;
+		goto out;
+	}
+
+	fm_size = ubi->leb_size * used_blocks;
+	fm_raw = vmalloc(fm_size);
+	if (!fm_raw) {
+		kfree(fmsb);
+		err = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < used_blocks; i++) {
+		pnum = be32_to_cpu(fmsb->block_loc[i]);
+		if (pnum < 0 || pnum >= ubi->peb_count) {
+			err = -EINVAL;
+			break;
+		}
+
+		if (i > 0) {
+			err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+			if (err && err != UBI_IO_BITFLIPS)
+				break;
+			if (be32_to_cpu(vidh->vol_id) != UBI_FM_DATA_VOLUME_ID) {
+				err = -EINVAL;
+				break;
+			}
+		}
+
+		err = ubi_io_read_data(ubi, fm_raw + i * ubi->leb_size, pnum,
+				       0, ubi->leb_size);
+		if (err && err != UBI_IO_BITFLIPS)
+			break;
+		err = 0;
+	}
+	kfree(fmsb);
+	if (err)
+		goto out;
+
+	fm_pos = 0;
+	fmsb = fm_get(fm_raw, &fm_pos, fm_size, sizeof(*fmsb));
+	crc = be32_to_cpu(fmsb->data_crc);
+	fmsb->data_crc = 0;
+	if (crc32(UBI_CRC32_INIT, fm_raw, fm_size) != crc) {
+		dbg_bld("fastmap data CRC error");
+		err = -EINVAL;
+		goto out;
+	}
+
+	err = -EINVAL;
+	fmhdr = fm_get(fm_raw, &fm_pos, fm_size, sizeof(*fmhdr));
+	if (!fmhdr || be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC)
+		goto out;
+
+	for (i = 0; i < 2; i++) {
+		fmpl[i] = fm_get(fm_raw, &fm_pos, fm_size, sizeof(*fmpl[i]));
+		if (!fmpl[i] ||
+		    be32_to_cpu(fmpl[i]->magic) != UBI_FM_POOL_MAGIC ||
+		    be16_to_cpu(fmpl[i]->size) > UBI_FM_MAX_POOL_SIZE)
+			goto out;
+	}
+
+	err = -ENOMEM;
+	kind = kzalloc(ubi->peb_count, GFP_KERNEL);
+	ecs = kmalloc(ubi->peb_count * sizeof(int), GFP_KERNEL);
+	if (!kind || !ecs)
+		goto out;
+
+	/* The fastmap PEBs must not be used until the fastmap is invalidated */
+	for (i = 0; i < used_blocks; i++) {
+		int ec = be32_to_cpu(fmsb->block_ec[i]);
+
+		pnum = be32_to_cpu(fmsb->block_loc[i]);
+		err = fm_claim(ubi, kind, pnum, FM_PEB_FASTMAP);
+		if (err)
+			goto out;
+
+		err = add_to_list(si, pnum, ec, &si->alien);
+		if (err)
+			goto out;
+		si->alien_peb_count += 1;
+		fm_add_ec(si, ec);
+	}
+
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < be16_to_cpu(fmpl[i]->size); j++) {
+			pnum = be32_to_cpu(fmpl[i]->pebs[j]);
+			err = fm_claim(ubi, kind, pnum, FM_PEB_POOL);
+			if (err)
+				goto out;
+		}
+
+	counts[0] = be32_to_cpu(fmhdr->free_peb_count);
+	counts[1] = be32_to_cpu(fmhdr->used_peb_count);
+	counts[2] = be32_to_cpu(fmhdr->scrub_peb_count);
+	counts[3] = be32_to_cpu(fmhdr->erase_peb_count);
+
+	for (i = 0; i < 4; i++) {
+		if (counts[i] < 0 || counts[i] > ubi->peb_count) {
+			err = -EINVAL;
+			goto out;
+		}
+
+		for (j = 0; j < counts[i]; j++) {
+			int ec;
+
+			err = -EINVAL;
+			fmec = fm_get(fm_raw, &fm_pos, fm_size, sizeof(*fmec));
+			if (!fmec)
+				goto out;
+
+			pnum = be32_to_cpu(fmec->pnum);
+			ec = be32_to_cpu(fmec->ec);
+			if (ec < 0 || ec > UBI_MAX_ERASECOUNTER)
+				goto out;
+
+			err = fm_claim(ubi, kind, pnum, kinds[i]);
+			if (err)
+				goto out;
+
+			if (kinds[i] == FM_PEB_FREE)
+				err = add_to_list(si, pnum, ec, &si->free);
+			else if (kinds[i] == FM_PEB_ERASE)
+				err = add_to_list(si, pnum, ec, &si->erase);
+			else
+				ecs[pnum] = ec;
+			if (err)
+				goto out;
+			fm_add_ec(si, ec);
+		}
+	}
+
+	for (i = 0; i < be32_to_cpu(fmhdr->vol_count); i++) {
+		int reserved_pebs;
+
+		err = -EINVAL;
+		fmvh = fm_get(fm_raw, &fm_pos, fm_size, sizeof(*fmvh));
+		if (!fmvh || be32_to_cpu(fmvh->magic) != UBI_FM_VHDR_MAGIC ||
+		    (fmvh->vol_type != UBI_DYNAMIC_VOLUME &&
+		     fmvh->vol_type != UBI_STATIC_VOLUME))
+			goto out;
+
+		fmeba = fm_get(fm_raw, &fm_pos, fm_size, sizeof(*fmeba));
+		if (!fmeba || be32_to_cpu(fmeba->magic) != UBI_FM_EBA_MAGIC)
+			goto out;
+
+		reserved_pebs = be32_to_cpu(fmeba->reserved_pebs);
+		if (reserved_pebs < 0 || reserved_pebs > ubi->peb_count ||
+		    !fm_get(fm_raw, &fm_pos, fm_size,
+			    reserved_pebs * sizeof(__be32)))
+			goto out;
+
+		for (j = 0; j < reserved_pebs; j++) {
+			int scrub;
+
+			pnum = be32_to_cpu(fmeba->pnum[j]);
+			if (pnum < 0)
+				continue;
+
+			err = -EINVAL;
+			if (pnum >= ubi->peb_count)
+				goto out;
+
+			/* The pool scan below finds out what is there now */
+			if (kind[pnum] == FM_PEB_POOL)
+				continue;
+
+			if (kind[pnum] != FM_PEB_USED &&
+			    kind[pnum] != FM_PEB_SCRUB)
+				goto out;
+
+			scrub = kind[pnum] == FM_PEB_SCRUB;
+			kind[pnum] = FM_PEB_MAPPED;
+			err = fm_add_leb(ubi, si, fmvh, j, pnum, ecs[pnum],
+					 scrub);
+			if (err)
+				goto out;
+		}
+	}
+
+	/*
+	 * Make sure the fastmap accounts for every PEB exactly once; a used
+	 * PEB no volume refers to means the fastmap does not match the flash.
+	 */
+	found = be32_to_cpu(fmhdr->bad_peb_count);
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		if (kind[pnum] == FM_PEB_USED || kind[pnum] == FM_PEB_SCRUB) {
+			dbg_bld("fastmap PEB %d is used but not mapped", pnum);
+			err = -EINVAL;
+			goto out;
+		}
+		if (kind[pnum] != FM_PEB_UNKNOWN)
+			found += 1;
+	}
+	if (found != ubi->peb_count) {
+		dbg_bld("fastmap covers %d PEBs, device has %d",
+			found, ubi->peb_count);
+		err = -EINVAL;
+		goto out;
+	}
+
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < be16_to_cpu(fmpl[i]->size); j++) {
+			cond_resched();
+
+			err = process_eb(ubi, si, be32_to_cpu(fmpl[i]->pebs[j]));
+			if (err < 0)
+				goto out;
+		}
+
+	si->bad_peb_count += be32_to_cpu(fmhdr->bad_peb_count);
+	si->is_empty = 0;
+	if (si->max_sqnum < be64_to_cpu(fmsb->sqnum))
+		si->max_sqnum = be64_to_cpu(fmsb->sqnum);
+
+	ubi->fm_sb_pnum = sb_pnum;
+	ubi->fm_sb_ec = be32_to_cpu(fmsb->block_ec[0]);
+	ubi_msg("attached from fastmap at PEB %d", sb_pnum);
+	err = 0;
+
+out:
+	kfree(ecs);
+	kfree(kind);
+	vfree(fm_raw);
+
+	if (err == -ENOENT)
+		dbg_bld("no fastmap found");
+	else if (err < 0 && err != -ENOMEM)
+		ubi_warn("fastmap at PEB %d is unusable (%d), scanning",
+			 sb_pnum, err);
+
+	if (err == 0 || err == -ENOMEM)
+		return err;
+
+	/* Start the full scan over from scratch */
+	si = alloc_si();
+	if (!si)
+		return -ENOMEM;
+	ubi_scan_destroy_si(*sip);
+	*sip = si;
+	return UBI_NO_FASTMAP;
+}
+/**
+ * ubi_invalidate_fastmap - make sure a stale fastmap is never attached from.
+ * @ubi: UBI device description object
+ *
+ * U-Boot attaches from a fastmap but never writes one, so any change to the
+ * flash makes the fastmap stale. Before the first such change the fastmap
+ * super block is erased; the next attach, ours or Linux's, then scans and
+ * drops the remaining fastmap PEBs. Returns zero in case of success and a
+ * negative error code in case of failure.
+ */
+int ubi_invalidate_fastmap(struct ubi_device *ubi)
+{
+	int err, pnum = ubi->fm_sb_pnum;
+
+	if (pnum < 0)
+		return 0;
+
+	ubi_msg("invalidate fastmap at PEB %d", pnum);
+	err = ubi_scan_erase_peb(ubi, NULL, pnum, ubi->fm_sb_ec + 1);
+	if (err)
+		return err;
+
+	ubi->fm_sb_pnum = -1;
+	return 0;
+}
+#else
+#define scan_fastmap(ubi, sip) UBI_NO_FASTMAP
+#endif /* CONFIG_MTD_UBI_FASTMAP */
+
 /**
  * ubi_scan - scan an MTD device.
  * @ubi: UBI device description object
  *
  * This function does full scanning of an MTD device and returns complete
- * information about it. In case of failure, an error code is returned.
+ * information about it. With %CONFIG_MTD_UBI_FASTMAP, the information is
+ * taken from a valid fastmap instead, if there is one. In case of failure, an
+ * error code is returned.
  */
 struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 {
-	int err, pnum;
+	int err, pnum, fastmap;
 	struct rb_node *rb1, *rb2;
 	struct ubi_scan_volume *sv;
 	struct ubi_scan_leb *seb;
 	struct ubi_scan_info *si;
 
-	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
+	si = alloc_si();
 	if (!si)
 		return ERR_PTR(-ENOMEM);
 
-	INIT_LIST_HEAD(&si->corr);
-	INIT_LIST_HEAD(&si->free);
-	INIT_LIST_HEAD(&si->erase);
-	INIT_LIST_HEAD(&si->alien);
-	si->volumes = RB_ROOT;
-	si->is_empty = 1;
-
 	err = -ENOMEM;
 	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
 	if (!ech)
@@ -931,16 +1427,23 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	if (!vidh)
 		goto out_ech;
 
-	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
-		cond_resched();
+	err = scan_fastmap(ubi, &si);
+	if (err < 0)
+		goto out_vidh;
+	fastmap = !err;
 
-		dbg_msg("process PEB %d", pnum);
-		err = process_eb(ubi, si, pnum);
-		if (err < 0)
-			goto out_vidh;
-	}
+	if (!fastmap) {
+		for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+			cond_resched();
 
-	dbg_msg("scanning is finished");
+			dbg_msg("process PEB %d", pnum);
+			err = process_eb(ubi, si, pnum);
+			if (err < 0)
+				goto out_vidh;
+		}
+
+		dbg_msg("scanning is finished");
+	}
 
 	/* Calculate mean erase counter */
 	if (si->ec_count) {
@@ -974,7 +1477,11 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 		if (seb->ec == UBI_SCAN_UNKNOWN_EC)
 			seb->ec = si->mean_ec;
 
-	err = paranoid_check_si(ubi, si);
+	/*
+	 * The fastmap does not carry sequence numbers, so there is nothing to
+	 * compare the on-flash headers with.
+	 */
+	err = fastmap ? 0 : paranoid_check_si(ubi, si);
 	if (err) {
 		if (err > 0)
 			err = -EINVAL;
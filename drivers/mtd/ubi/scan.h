@@ -161,5 +161,13 @@ int ubi_scan_erase_peb(struct ubi_device *ubi, const struct ubi_scan_info *si,
 		       int pnum, int ec);
 struct ubi_scan_info *ubi_scan(struct ubi_device *ubi);
 void ubi_scan_destroy_si(struct ubi_scan_info *si);
+#ifdef CONFIG_MTD_UBI_FASTMAP
+int ubi_invalidate_fastmap(struct ubi_device *ubi);
+#else
+static inline int ubi_invalidate_fastmap(struct ubi_device *ubi)
+{
+	return 0;
+}
+#endif
 
 #endif /* !__UBI_SCAN_H__ */
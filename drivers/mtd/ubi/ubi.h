@@ -336,6 +336,9 @@ struct ubi_wl_entry;
  * @bad_allowed: whether the MTD device admits of bad physical eraseblocks or
  *               not
  * @mtd: MTD device descriptor
+ * @fm_sb_pnum: PEB holding the fastmap super block the device was attached
+ *              from, or %-1 if it was attached by scanning
+ * @fm_sb_ec: erase counter of @fm_sb_pnum
  *
  * @peb_buf1: a buffer of PEB size used for different purposes
  * @peb_buf2: another buffer of PEB size used for different purposes
@@ -415,6 +418,10 @@ struct ubi_device {
 	int vid_hdr_shift;
 	int bad_allowed;
 	struct mtd_info *mtd;
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	int fm_sb_pnum;
+	int fm_sb_ec;
+#endif
 
 	void *peb_buf1;
 	void *peb_buf2;
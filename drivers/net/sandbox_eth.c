@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sandbox Ethernet device.
+ *
+ * Frames are handed to the sandbox-daemon through the doorbell area.
+ * The daemon implements a small loopback network (ARP, TFTP and NFS
+ * responders) so that the net/ stack can be exercised, and its
+ * throughput measured, on a host without any real network hardware.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <net.h>
+#include <netdev.h>
+
+#include "asm/sandbox-api.h"
+
+static int sb_eth_init(struct eth_device *dev, bd_t *bis)
+{
+	return 0;
+}
+
+static int sb_eth_send(struct eth_device *dev, volatile void *packet,
+		       int length)
+{
+	struct doorbell_command_t *dbc = sandbox_get_doorbell_command();
+
+	if (length > SANDBOX_ETH_MAX_FRAME)
+		return -1;
+
+	memcpy(dbc->dbc_buf, (void *)packet, length);
+	dbc->device_id = SB_ETH;
+	dbc->command_data[0] = SANDBOX_ETH_CMD_SEND;
+	dbc->command_data[1] = length;
+	sandbox_ring_doorbell();
+
+	return dbc->result;
+}
+
+static int sb_eth_recv(struct eth_device *dev)
+{
+	struct doorbell_command_t *dbc = sandbox_get_doorbell_command();
+	int length;
+
+	/* Drain everything the daemon has queued for us */
+	for (;;) {
+		dbc->device_id = SB_ETH;
+		dbc->command_data[0] = SANDBOX_ETH_CMD_RECV;
+		dbc->command_data[1] = 0;
+		sandbox_ring_doorbell();
+
+		length = dbc->command_data[1];
+		if (dbc->result || length <= 0)
+			break;
+		if (length > PKTSIZE_ALIGN)
+			continue;
+
+		memcpy((void *)NetRxPackets[0], dbc->dbc_buf, length);
+		NetReceive(NetRxPackets[0], length);
+	}
+
+	return 0;
+}
+
+static void sb_eth_halt(struct eth_device *dev)
+{
+}
+
+int sandbox_eth_initialize(bd_t *bis)
+{
+	struct doorbell_t *db = sandbox_get_doorbell();
+	struct eth_device *dev;
+
+	if (!db->eth.eth_enabled)
+		return 0;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return -1;
+
+	strcpy(dev->name, "sandbox-eth");
+	memcpy(dev->enetaddr, db->eth.enetaddr, sizeof(dev->enetaddr));
+	dev->init = sb_eth_init;
+	dev->send = sb_eth_send;
+	dev->recv = sb_eth_recv;
+	dev->halt = sb_eth_halt;
+
+	eth_register(dev);
+
+	return 1;
+}
@@ -25,6 +25,125 @@
 #include <spi_flash.h>
 #include "asm/sandbox-api.h"
 
+#ifdef CONFIG_SPI_FLASH
+
+/*
+ * SPI bus whose transfers are decoded by the sandbox-daemon's flash
+ * emulator, so that the generic SPI flash code runs unchanged.
+ */
+
+struct sandbox_spi_slave {
+	struct spi_slave slave;
+	unsigned int max_hz;
+};
+
+static inline struct sandbox_spi_slave *to_sandbox_spi(struct spi_slave *slave)
+{
+	return container_of(slave, struct sandbox_spi_slave, slave);
+}
+
+int spi_cs_is_valid(unsigned int bus, unsigned int cs)
+{
+	return bus == 0 && cs == 0 &&
+		sandbox_get_doorbell()->spi.vendor[0] != '\0';
+}
+
+struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
+				  unsigned int max_hz, unsigned int mode)
+{
+	struct sandbox_spi_slave *ss;
+
+	if (!spi_cs_is_valid(bus, cs))
+		return NULL;
+
+	ss = malloc(sizeof(*ss));
+	if (!ss)
+		return NULL;
+
+	ss->slave.bus = bus;
+	ss->slave.cs = cs;
+	ss->max_hz = max_hz;
+
+	return &ss->slave;
+}
+
+void spi_free_slave(struct spi_slave *slave)
+{
+	free(to_sandbox_spi(slave));
+}
+
+int spi_claim_bus(struct spi_slave *slave)
+{
+	return 0;
+}
+
+void spi_release_bus(struct spi_slave *slave)
+{
+}
+
+unsigned int spi_get_rx_caps(struct spi_slave *slave)
+{
+	return SPI_XFER_DUAL | SPI_XFER_QUAD;
+}
+
+int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
+	     void *din, unsigned long flags)
+{
+	struct sandbox_spi_slave *ss = to_sandbox_spi(slave);
+	struct doorbell_command_t *dbc = sandbox_get_doorbell_command();
+	unsigned int len = bitlen / 8;
+	const u8 *out = dout;
+	u8 *in = din;
+
+	if (bitlen % 8) {
+		debug("%s: bitlen %u is not a whole number of bytes\n",
+		      __func__, bitlen);
+		return -1;
+	}
+
+	ASSERT_ON_COMPILE(SPI_XFER_BEGIN == SANDBOX_SPI_XFER_BEGIN &&
+			  SPI_XFER_END == SANDBOX_SPI_XFER_END &&
+			  SPI_XFER_DUAL == SANDBOX_SPI_XFER_DUAL &&
+			  SPI_XFER_QUAD == SANDBOX_SPI_XFER_QUAD);
+
+	/* Long transfers go through the doorbell buffer in pieces */
+	do {
+		unsigned int chunk = min(len,
+					 (unsigned int)sizeof(dbc->dbc_buf));
+		unsigned long xflags = flags;
+
+		if (chunk < len)
+			xflags &= ~SPI_XFER_END;
+
+		if (out) {
+			memcpy(dbc->dbc_buf, out, chunk);
+			out += chunk;
+		} else {
+			memset(dbc->dbc_buf, 0xff, chunk);
+		}
+
+		dbc->device_id = SB_SPI;
+		dbc->command_data[0] = SANDBOX_SPI_CMD_XFER;
+		dbc->command_data[1] = xflags;
+		dbc->command_data[2] = chunk;
+		dbc->command_data[3] = ss->max_hz;
+		sandbox_ring_doorbell();
+		if (dbc->result)
+			return -1;
+
+		if (in) {
+			memcpy(in, dbc->dbc_buf, chunk);
+			in += chunk;
+		}
+		len -= chunk;
+		flags &= ~SPI_XFER_BEGIN;
+	} while (len);
+
+	return 0;
+}
+
+#else
+
 static int read(struct spi_flash *flash, u32 offset, size_t len, void *buf)
 {
 	struct doorbell_command_t *dbc = sandbox_get_doorbell_command();
@@ -35,7 +154,7 @@ static int read(struct spi_flash *flash, u32 offset, size_t len, void *buf)
 		dest = dbc->dbc_buf;
 
 	dbc->device_id = SB_SPI;
-	dbc->command_data[0] = 0; /* read */
+	dbc->command_data[0] = SANDBOX_SPI_CMD_READ;
 	dbc->command_data[1] = offset;
 	dbc->command_data[2] = len;
 	dbc->command_data[3] = (u32)(uintptr_t)dest;
@@ -60,7 +179,7 @@ static int write(struct spi_flash *flash, u32 offset,
 	}
 
 	dbc->device_id = SB_SPI;
-	dbc->command_data[0] = 1; /* write */
+	dbc->command_data[0] = SANDBOX_SPI_CMD_WRITE;
 	dbc->command_data[1] = offset;
 	dbc->command_data[2] = len;
 	dbc->command_data[3] = (u32)(uintptr_t)buf;
@@ -73,7 +192,7 @@ static int erase(struct spi_flash *flash, u32 offset, size_t len)
 	struct doorbell_command_t *dbc = sandbox_get_doorbell_command();
 
 	dbc->device_id = SB_SPI;
-	dbc->command_data[0] = 2; /* erase */
+	dbc->command_data[0] = SANDBOX_SPI_CMD_ERASE;
 	dbc->command_data[1] = offset;
 	dbc->command_data[2] = len;
 	sandbox_ring_doorbell();
@@ -124,3 +243,4 @@ void spi_flash_free(struct spi_flash *flash)
 	free(flash);
 }
 
+#endif /* CONFIG_SPI_FLASH */
@@ -33,17 +33,30 @@ extern unsigned char new[];
 
 #include "ehci.h"
 
+/* Number of endpoints which keep a QH in the async schedule */
+#ifndef EHCI_QH_POOL_SIZE
+#define EHCI_QH_POOL_SIZE	8
+#endif
+
+/* qTDs must not cross a 4K page, nor share a cache line */
+#define QTD_ALIGN	(ARCH_DMA_MINALIGN > 64 ? ARCH_DMA_MINALIGN : 64)
+
 static struct ehci_ctrl {
 	struct ehci_hccr *hccr;	/* R/O registers, not need for volatile */
 	volatile struct ehci_hcor *hcor;
 	int rootdev;
 	uint16_t portreset;
 	struct QH qh_list __attribute__((aligned(ARCH_DMA_MINALIGN)));
-	struct QH qh_pool __attribute__((aligned(ARCH_DMA_MINALIGN)));
-	struct qTD td_pool[3] __attribute__((aligned(ARCH_DMA_MINALIGN)));
+	struct QH qh_pool[EHCI_QH_POOL_SIZE]
+		__attribute__((aligned(ARCH_DMA_MINALIGN)));
+	struct qTD td_stop __attribute__((aligned(QTD_ALIGN)));
 	struct QH periodic_queue __attribute__((aligned(ARCH_DMA_MINALIGN)));
 	uint32_t *periodic_list;
-	int ntds;
+	int qh_used;		/* QHs of qh_pool linked into the schedule */
+	int qh_victim;		/* next QH to reuse once they all are */
+	int async_enabled;
+	struct qTD *tds;
+	int td_count;
 	uint32_t port_enable_mask;
 } ehcic[CONFIG_USB_MAX_CONTROLLER_COUNT];
 
@@ -144,11 +157,6 @@ static int handshake(uint32_t *ptr, uint32_t mask, uint32_t done, int usec)
 	return -1;
 }
 
-static void ehci_free(void *p, size_t sz)
-{
-
-}
-
 static int ehci_reset(volatile struct ehci_hcor *hcor)
 {
 	uint32_t cmd;
@@ -185,48 +193,164 @@ out:
 	return ret;
 }
 
-static void *ehci_alloc(struct ehci_ctrl *ctrl, size_t sz, size_t align)
+static void ehci_enable_async(struct ehci_ctrl *ctrl)
 {
-	void *p;
+	volatile struct ehci_hcor *hcor = ctrl->hcor;
+	uint32_t cmd, usbsts;
 
-	switch (sz) {
-	case sizeof(struct QH):
-		p = &ctrl->qh_pool;
-		ctrl->ntds = 0;
-		break;
-	case sizeof(struct qTD):
-		if (ctrl->ntds == 3) {
-			debug("out of TDs\n");
+	if (ctrl->async_enabled)
+		return;
+
+	usbsts = ehci_readl(&hcor->or_usbsts);
+	ehci_writel(&hcor->or_usbsts, (usbsts & 0x3f));
+
+	cmd = ehci_readl(&hcor->or_usbcmd);
+	cmd |= CMD_ASE;
+	ehci_writel(&hcor->or_usbcmd, cmd);
+
+	if (handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, STD_ASS,
+		      100 * 1000) < 0) {
+		printf("EHCI fail timeout STD_ASS set\n");
+		return;
+	}
+	ctrl->async_enabled = 1;
+}
+
+static void ehci_disable_async(struct ehci_ctrl *ctrl)
+{
+	volatile struct ehci_hcor *hcor = ctrl->hcor;
+	uint32_t cmd;
+
+	if (!ctrl->async_enabled)
+		return;
+
+	cmd = ehci_readl(&hcor->or_usbcmd);
+	cmd &= ~CMD_ASE;
+	ehci_writel(&hcor->or_usbcmd, cmd);
+
+	if (handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, 0,
+		      100 * 1000) < 0)
+		printf("EHCI fail timeout STD_ASS reset\n");
+	ctrl->async_enabled = 0;
+}
+
+/*
+ * Put a QH back in the idle state, with nothing queued and no pointers
+ * left into qTDs that are about to be reused.
+ */
+static void ehci_park_qh(struct QH *qh)
+{
+	qh->qh_overlay.qt_token = 0;
+	qh->qh_overlay.qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	dmb();
+	qh->qh_overlay.qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+	flush_dcache_range((uint32_t)qh, (uint32_t)qh + sizeof(struct QH));
+}
+
+/*
+ * Take a QH out of the async schedule. While the schedule runs, the
+ * controller may still hold a pointer to it until the next async
+ * advance, so ring the doorbell and wait for that first.
+ */
+static void ehci_unlink_qh(struct ehci_ctrl *ctrl, struct QH *qh)
+{
+	volatile struct ehci_hcor *hcor = ctrl->hcor;
+	struct QH *prev = &ctrl->qh_list;
+	uint32_t cmd;
+
+	while ((hc32_to_cpu(prev->qh_link) & ~0x1f) != (uint32_t)qh) {
+		prev = (struct QH *)(hc32_to_cpu(prev->qh_link) & ~0x1f);
+		if (prev == &ctrl->qh_list)
+			return;		/* not linked */
+	}
+
+	prev->qh_link = qh->qh_link;
+	dmb();
+	flush_dcache_range((uint32_t)prev, (uint32_t)prev + sizeof(struct QH));
+
+	if (!ctrl->async_enabled)
+		return;
+
+	cmd = ehci_readl(&hcor->or_usbcmd);
+	ehci_writel(&hcor->or_usbcmd, cmd | CMD_IAAD);
+	if (handshake((uint32_t *)&hcor->or_usbsts, STS_IAA, STS_IAA,
+		      100 * 1000) < 0)
+		printf("EHCI fail timeout STS_IAA set\n");
+	ehci_writel(&hcor->or_usbsts, STS_IAA);
+}
+
+/*
+ * Find the QH for an endpoint. QHs stay linked into the async schedule
+ * between transfers, so that the schedule does not have to be stopped
+ * and restarted for every transfer; when the pool is exhausted the
+ * oldest one is unlinked and reused.
+ */
+static struct QH *ehci_get_qh(struct ehci_ctrl *ctrl, uint32_t endpt1,
+			      uint32_t endpt2)
+{
+	struct QH *qh;
+	int i;
+
+	for (i = 0; i < ctrl->qh_used; i++) {
+		qh = &ctrl->qh_pool[i];
+		if (qh->qh_endpt1 == endpt1 && qh->qh_endpt2 == endpt2)
+			return qh;
+	}
+
+	if (ctrl->qh_used < EHCI_QH_POOL_SIZE) {
+		qh = &ctrl->qh_pool[ctrl->qh_used++];
+	} else {
+		qh = &ctrl->qh_pool[ctrl->qh_victim];
+		ctrl->qh_victim = (ctrl->qh_victim + 1) % EHCI_QH_POOL_SIZE;
+		ehci_unlink_qh(ctrl, qh);
+	}
+
+	memset(qh, 0, sizeof(*qh));
+	qh->qh_endpt1 = endpt1;
+	qh->qh_endpt2 = endpt2;
+	qh->qh_curtd = cpu_to_hc32(QT_NEXT_TERMINATE);
+	qh->qh_overlay.qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+	qh->qh_overlay.qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+
+	/* Link it in right after the head of the reclaim list */
+	qh->qh_link = ctrl->qh_list.qh_link;
+	flush_dcache_range((uint32_t)qh, (uint32_t)qh + sizeof(struct QH));
+	dmb();
+	ctrl->qh_list.qh_link = cpu_to_hc32((uint32_t)qh | QH_LINK_TYPE_QH);
+	flush_dcache_range((uint32_t)&ctrl->qh_list,
+		(uint32_t)&ctrl->qh_list + sizeof(struct QH));
+
+	return qh;
+}
+
+/*
+ * Return an array of 'count' zeroed qTDs. The array is kept around and
+ * only grows, so a steady stream of transfers does not hit malloc().
+ */
+static struct qTD *ehci_get_tds(struct ehci_ctrl *ctrl, int count)
+{
+	if (count > ctrl->td_count) {
+		free(ctrl->tds);
+		ctrl->tds = memalign(QTD_ALIGN, count * sizeof(struct qTD));
+		if (ctrl->tds == NULL) {
+			ctrl->td_count = 0;
 			return NULL;
 		}
-		p = &ctrl->td_pool[ctrl->ntds];
-		ctrl->ntds++;
-		break;
-	default:
-		debug("unknown allocation size\n");
-		return NULL;
+		ctrl->td_count = count;
 	}
 
-	memset(p, 0, sz);
-	return p;
+	memset(ctrl->tds, 0, count * sizeof(struct qTD));
+	return ctrl->tds;
 }
 
 static int ehci_td_buffer(struct qTD *td, void *buf, size_t sz)
 {
 	uint32_t delta, next;
 	uint32_t addr = (uint32_t)buf;
-	size_t rsz = roundup(sz, ARCH_DMA_MINALIGN);
 	int idx;
 
-	if (sz != rsz)
-		debug("EHCI-HCD: Misaligned buffer size (%08x)\n", sz);
-
-	if (addr & (ARCH_DMA_MINALIGN - 1))
-		debug("EHCI-HCD: Misaligned buffer address (%p)\n", buf);
-
 	idx = 0;
 	while (idx < 5) {
-		flush_dcache_range(addr, addr + rsz);
 		td->qt_buffer[idx] = cpu_to_hc32(addr);
 		td->qt_buffer_hi[idx] = 0;
 		next = (addr + 4096) & ~4095;
@@ -246,21 +370,65 @@ static int ehci_td_buffer(struct qTD *td, void *buf, size_t sz)
 	return 0;
 }
 
+/*
+ * Bytes of the data stage to put in a qTD starting at 'buf'. All but the
+ * last qTD are cut at a page boundary, which keeps them a multiple of the
+ * packet size so that only the last qTD can end in a short packet.
+ */
+static int ehci_td_length(uint32_t buf, int left)
+{
+	int max = (5 * 4096 - (buf & 4095)) & ~4095;
+
+	return left < max ? left : max;
+}
+
+static void ehci_fill_td(struct qTD *td, struct qTD *next, uint32_t altnext,
+			 uint32_t token)
+{
+	td->qt_next = next ? cpu_to_hc32((uint32_t)next) :
+			     cpu_to_hc32(QT_NEXT_TERMINATE);
+	td->qt_altnext = cpu_to_hc32(altnext);
+	td->qt_token = cpu_to_hc32(token);
+}
+
+/*
+ * Check whether the controller is done with the qTD chain: either the last
+ * qTD completed, a qTD halted, or a short packet ended a bulk IN transfer.
+ * A short data stage of a control transfer moves on to the status stage.
+ */
+static int ehci_tds_done(struct qTD *td, int count, int control)
+{
+	uint32_t token;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		token = hc32_to_cpu(td[i].qt_token);
+		if (token & 0x80)
+			return 0;
+		if (token & 0x40)
+			return 1;
+		if ((token >> 16) & 0x7fff) {
+			if (!control)
+				return 1;
+			i = count - 2;
+		}
+	}
+
+	return 1;
+}
+
 static int
 ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		   int length, struct devrequest *req)
 {
 	struct QH *qh;
-	struct qTD *td;
+	struct qTD *td, *tds;
 	unsigned long ts;
-	uint32_t *tdp;
-	uint32_t endpt, token, usbsts;
-	uint32_t c, toggle;
-	uint32_t cmd;
+	uint32_t endpt1, endpt2, token, altnext;
+	uint32_t c, toggle, addr;
 	int timeout;
-	int ret = 0;
+	int ntds, ndata, first_data, left, xfr, maxp, i;
 	struct ehci_ctrl *ctrl = dev->controller;
-	volatile struct ehci_hcor *hcor = ctrl->hcor;
 
 	debug("dev=%p, pipe=%lx, buffer=%p, length=%d, req=%p\n", dev, pipe,
 	      buffer, length, req);
@@ -271,139 +439,126 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		      le16_to_cpu(req->value), le16_to_cpu(req->value),
 		      le16_to_cpu(req->index));
 
-	qh = ehci_alloc(ctrl, sizeof(struct QH), ARCH_DMA_MINALIGN);
-	if (qh == NULL) {
-		debug("unable to allocate QH\n");
-		return -1;
-	}
+	if (((uint32_t)buffer & (ARCH_DMA_MINALIGN - 1)) ||
+	    (length & (ARCH_DMA_MINALIGN - 1)))
+		debug("EHCI-HCD: Misaligned buffer (%p, %08x)\n", buffer,
+		      length);
 
 	toggle = usb_gettoggle(dev, usb_pipeendpoint(pipe), usb_pipeout(pipe));
+	maxp = usb_maxpacket(dev, pipe);
 
-	qh->qh_link = cpu_to_hc32((uint32_t)&ctrl->qh_list | QH_LINK_TYPE_QH);
 	c = (usb_pipespeed(pipe) != USB_SPEED_HIGH &&
 	     usb_pipeendpoint(pipe) == 0) ? 1 : 0;
-	endpt = (8 << 28) |
+	endpt1 = (8 << 28) |
 	    (c << 27) |
-	    (usb_maxpacket(dev, pipe) << 16) |
+	    (maxp << 16) |
 	    (0 << 15) |
 	    (1 << 14) |
 	    (usb_pipespeed(pipe) << 12) |
 	    (usb_pipeendpoint(pipe) << 8) |
 	    (0 << 7) | (usb_pipedevice(pipe) << 0);
-	qh->qh_endpt1 = cpu_to_hc32(endpt);
-	endpt = (1 << 30) |
+	endpt2 = (1 << 30) |
 	    (dev->portnr << 23) |
 	    (dev->parent->devnum << 16) | (0 << 8) | (0 << 0);
-	qh->qh_endpt2 = cpu_to_hc32(endpt);
-	qh->qh_overlay.qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
 
-	td = NULL;
-	tdp = &qh->qh_overlay.qt_next;
+	/* Count the qTDs: setup, the data stage split by pages, status */
+	ndata = 0;
+	addr = (uint32_t)buffer;
+	for (left = length; left > 0; left -= xfr) {
+		xfr = ehci_td_length(addr, left);
+		addr += xfr;
+		ndata++;
+	}
+	if (ndata == 0 && req == NULL)
+		ndata = 1;	/* zero-length bulk transfer */
+	first_data = (req != NULL) ? 1 : 0;
+	ntds = first_data + ndata + ((req != NULL) ? 1 : 0);
+
+	tds = ehci_get_tds(ctrl, ntds);
+	if (tds == NULL) {
+		debug("unable to allocate %d TDs\n", ntds);
+		return -1;
+	}
+
+	/*
+	 * On a short packet the controller follows the alternate pointer:
+	 * straight to the status stage of a control transfer, or to an
+	 * inactive qTD which stops the queue for a bulk transfer.
+	 */
+	if (req != NULL)
+		altnext = (uint32_t)&tds[ntds - 1];
+	else if (usb_pipein(pipe))
+		altnext = (uint32_t)&ctrl->td_stop;
+	else
+		altnext = QT_NEXT_TERMINATE;
 
+	td = tds;
 	if (req != NULL) {
-		td = ehci_alloc(ctrl, sizeof(struct qTD), ARCH_DMA_MINALIGN);
-		if (td == NULL) {
-			debug("unable to allocate SETUP td\n");
-			goto fail;
-		}
-		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
-		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
 		token = (0 << 31) |
 		    (sizeof(*req) << 16) |
 		    (0 << 15) | (0 << 12) | (3 << 10) | (2 << 8) | (0x80 << 0);
-		td->qt_token = cpu_to_hc32(token);
+		ehci_fill_td(td, td + 1, QT_NEXT_TERMINATE, token);
 		if (ehci_td_buffer(td, req, sizeof(*req)) != 0) {
 			debug("unable construct SETUP td\n");
-			ehci_free(td, sizeof(*td));
-			goto fail;
+			return -1;
 		}
-		writel(cpu_to_hc32((uint32_t)td), tdp);
-		/* Flush the pointer which points at this new descriptor. */
-		flush_dcache_range((uint32_t)tdp, (uint32_t)tdp + sizeof(*tdp));
-		tdp = &td->qt_next;
+		flush_dcache_range((uint32_t)req,
+			(uint32_t)req + roundup(sizeof(*req), ARCH_DMA_MINALIGN));
 		toggle = 1;
-		/*
-		 * Make sure all the accesses to the td are finished, and then
-		 * flush it out to memory.
-		 */
-		dmb();
-		flush_dcache_range((uint32_t)td,
-			(uint32_t)td + sizeof(struct qTD));
+		td++;
 	}
 
-	if (length > 0 || req == NULL) {
-		td = ehci_alloc(ctrl, sizeof(struct qTD), ARCH_DMA_MINALIGN);
-		if (td == NULL) {
-			debug("unable to allocate DATA td\n");
-			goto fail;
-		}
-		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
-		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	if (length > 0)
+		flush_dcache_range((uint32_t)buffer,
+			(uint32_t)buffer + roundup(length, ARCH_DMA_MINALIGN));
+
+	addr = (uint32_t)buffer;
+	left = length;
+	for (i = 0; i < ndata; i++, td++) {
+		xfr = ehci_td_length(addr, left);
 		token = (toggle << 31) |
-		    (length << 16) |
-		    ((req == NULL ? 1 : 0) << 15) |
+		    (xfr << 16) |
+		    ((req == NULL && i == ndata - 1 ? 1 : 0) << 15) |
 		    (0 << 12) |
 		    (3 << 10) |
 		    ((usb_pipein(pipe) ? 1 : 0) << 8) | (0x80 << 0);
-		td->qt_token = cpu_to_hc32(token);
-		if (ehci_td_buffer(td, buffer, length) != 0) {
+		ehci_fill_td(td, td + 1 < tds + ntds ? td + 1 : NULL,
+			     altnext, token);
+		if (ehci_td_buffer(td, (void *)addr, xfr) != 0) {
 			debug("unable construct DATA td\n");
-			ehci_free(td, sizeof(*td));
-			goto fail;
+			return -1;
 		}
-		writel(cpu_to_hc32((uint32_t)td), tdp);
-		flush_dcache_range((uint32_t)tdp, (uint32_t)tdp + sizeof(*tdp));
-		tdp = &td->qt_next;
-		dmb();
-		flush_dcache_range((uint32_t)td,
-			(uint32_t)td + sizeof(struct qTD));
+		if (maxp && ((xfr + maxp - 1) / maxp) & 1)
+			toggle ^= 1;
+		addr += xfr;
+		left -= xfr;
 	}
 
 	if (req != NULL) {
-		td = ehci_alloc(ctrl, sizeof(struct qTD), ARCH_DMA_MINALIGN);
-		if (td == NULL) {
-			debug("unable to allocate ACK td\n");
-			goto fail;
-		}
-		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
-		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
-		token = (toggle << 31) |
+		token = (1 << 31) |
 		    (0 << 16) |
 		    (1 << 15) |
 		    (0 << 12) |
 		    (3 << 10) |
 		    ((usb_pipein(pipe) ? 0 : 1) << 8) | (0x80 << 0);
-		td->qt_token = cpu_to_hc32(token);
-		writel(cpu_to_hc32((uint32_t)td), tdp);
-		flush_dcache_range((uint32_t)tdp, (uint32_t)tdp + sizeof(*tdp));
-		tdp = &td->qt_next;
-		dmb();
-		flush_dcache_range((uint32_t)td,
-			(uint32_t)td + sizeof(struct qTD));
+		ehci_fill_td(td, NULL, QT_NEXT_TERMINATE, token);
 	}
 
-	ctrl->qh_list.qh_link = cpu_to_hc32((uint32_t) qh | QH_LINK_TYPE_QH);
-
-	/* Ensure our writes have happened, and then flush the dcache. */
+	/* Make sure all the accesses to the tds are finished, then flush. */
 	dmb();
-	flush_dcache_range((uint32_t)(&ctrl->qh_list),
-		(uint32_t)(&ctrl->qh_list) + sizeof(struct QH));
-	flush_dcache_range((uint32_t)qh, (uint32_t)qh + sizeof(struct QH));
+	flush_dcache_range((uint32_t)tds,
+		(uint32_t)tds + ntds * sizeof(struct qTD));
 
-	usbsts = ehci_readl(&hcor->or_usbsts);
-	ehci_writel(&hcor->or_usbsts, (usbsts & 0x3f));
+	qh = ehci_get_qh(ctrl, cpu_to_hc32(endpt1), cpu_to_hc32(endpt2));
 
-	/* Enable async. schedule. */
-	cmd = ehci_readl(&hcor->or_usbcmd);
-	cmd |= CMD_ASE;
-	ehci_writel(&hcor->or_usbcmd, cmd);
+	/* Hand the chain to the (idle) QH */
+	qh->qh_overlay.qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	qh->qh_overlay.qt_token = 0;
+	dmb();
+	qh->qh_overlay.qt_next = cpu_to_hc32((uint32_t)tds);
+	flush_dcache_range((uint32_t)qh, (uint32_t)qh + sizeof(struct QH));
 
-	ret = handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, STD_ASS,
-			100 * 1000);
-	if (ret < 0) {
-		printf("EHCI fail timeout STD_ASS set\n");
-		goto fail;
-	}
+	ehci_enable_async(ctrl);
 
 	/* Wait for TDs to be processed. */
 	ts = get_timer(0);
@@ -411,18 +566,15 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	do {
 		/* Invalidate dcache */
 		dmb();
-		invalidate_dcache_range((uint32_t)td,
-			(uint32_t)td + sizeof(struct qTD));
+		invalidate_dcache_range((uint32_t)tds,
+			(uint32_t)tds + ntds * sizeof(struct qTD));
 
-		token = hc32_to_cpu(readl(&td->qt_token));
-		if (!(token & 0x80))
+		if (ehci_tds_done(tds, ntds, req != NULL))
 			break;
 		WATCHDOG_RESET();
 	} while (get_timer(ts) < timeout);
 
 	dmb();
-	invalidate_dcache_range((uint32_t)(&ctrl->qh_list),
-		(uint32_t)(&ctrl->qh_list) + sizeof(struct QH));
 	invalidate_dcache_range((uint32_t)qh,
 		(uint32_t)qh + sizeof(struct QH));
 
@@ -430,27 +582,17 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	invalidate_dcache_range(((uint32_t)buffer & ~(ARCH_DMA_MINALIGN - 1)),
 		((uint32_t)buffer & ~(ARCH_DMA_MINALIGN - 1)) + roundup(length, ARCH_DMA_MINALIGN));
 
-	/* Disable async schedule. */
-	cmd = ehci_readl(&hcor->or_usbcmd);
-	cmd &= ~CMD_ASE;
-	ehci_writel(&hcor->or_usbcmd, cmd);
-
-	/* Check that the TD processing happened */
-	if (token & 0x80) {
+	token = hc32_to_cpu(qh->qh_overlay.qt_token);
+	if (!ehci_tds_done(tds, ntds, req != NULL)) {
 		printf("EHCI timed out on TD - token=%#x\n", token);
+		/*
+		 * Stop the schedule so the controller lets go of the qTDs;
+		 * it is started again by the next transfer.
+		 */
+		ehci_disable_async(ctrl);
+		token = 0x80;
 	}
 
-	ret = handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, 0,
-			100 * 1000);
-	if (ret < 0) {
-		printf("EHCI fail timeout STD_ASS reset\n");
-		goto fail;
-	}
-
-	ctrl->qh_list.qh_link = cpu_to_hc32((uint32_t)&ctrl->qh_list
-						| QH_LINK_TYPE_QH);
-
-	token = hc32_to_cpu(qh->qh_overlay.qt_token);
 	if (!(token & 0x80)) {
 		debug("TOKEN=%#x\n", token);
 		switch (token & 0xfc) {
@@ -477,26 +619,29 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 				dev->status |= USB_ST_STALLED;
 			break;
 		}
-		dev->act_len = length - ((token >> 16) & 0x7fff);
+		dev->act_len = 0;
+		addr = (uint32_t)buffer;
+		left = length;
+		for (i = 0; i < ndata && left > 0; i++) {
+			xfr = ehci_td_length(addr, left);
+			token = hc32_to_cpu(tds[first_data + i].qt_token);
+			if (token & 0x80)
+				break;
+			dev->act_len += xfr - ((token >> 16) & 0x7fff);
+			addr += xfr;
+			left -= xfr;
+		}
 	} else {
 		dev->act_len = 0;
 		debug("dev=%u, usbsts=%#x, p[1]=%#x, p[2]=%#x\n",
-		      dev->devnum, ehci_readl(&hcor->or_usbsts),
-		      ehci_readl(&hcor->or_portsc[0]),
-		      ehci_readl(&hcor->or_portsc[1]));
+		      dev->devnum, ehci_readl(&ctrl->hcor->or_usbsts),
+		      ehci_readl(&ctrl->hcor->or_portsc[0]),
+		      ehci_readl(&ctrl->hcor->or_portsc[1]));
 	}
 
-	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
+	ehci_park_qh(qh);
 
-fail:
-	td = (void *)hc32_to_cpu(qh->qh_overlay.qt_next);
-	while (td != (void *)QT_NEXT_TERMINATE) {
-		qh->qh_overlay.qt_next = td->qt_next;
-		ehci_free(td, sizeof(*td));
-		td = (void *)hc32_to_cpu(qh->qh_overlay.qt_next);
-	}
-	ehci_free(qh, sizeof(*qh));
-	return -1;
+	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
 
 static inline int min3(int a, int b, int c)
@@ -780,6 +925,8 @@ void ehci_hcd_set_port_enable_mask(int index, uint32_t mask)
 
 void usb_lowlevel_stop(int index)
 {
+	ehci_disable_async(&ehcic[index]);
+	ehcic[index].qh_used = 0;
 	ehci_hcd_stop(index);
 }
 
@@ -791,6 +938,7 @@ void *usb_lowlevel_init(int index)
 	volatile struct ehci_hcor *hcor;
 	struct QH *qh_list;
 	struct QH *periodic;
+	struct qTD *td;
 
 	ehcic[index].port_enable_mask = -1U;
 
@@ -824,6 +972,16 @@ void *usb_lowlevel_init(int index)
 
 	/* Set async. queue head pointer. */
 	ehci_writel(&hcor->or_asynclistaddr, (uint32_t)qh_list);
+	ehcic[index].qh_used = 0;
+	ehcic[index].qh_victim = 0;
+	ehcic[index].async_enabled = 0;
+
+	/* Inactive qTD which short bulk IN transfers stop on */
+	td = &ehcic[index].td_stop;
+	memset(td, 0, sizeof(*td));
+	td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+	td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	flush_dcache_range((uint32_t)td, (uint32_t)td + sizeof(*td));
 
 	/* Set up periodic list */
 	/* Step 1: Parent QH for all periodic transfers. */
@@ -848,6 +848,23 @@ int ext2fs_read (char *buf, unsigned len) {
 }
 
 
+int ext2fs_read_at(char *buf, unsigned pos, unsigned len)
+{
+	unsigned int filesize;
+
+	if (ext2fs_root == NULL || ext2fs_file == NULL)
+		return 0;
+
+	filesize = __le32_to_cpu(ext2fs_file->inode.size);
+	if (pos >= filesize)
+		return 0;
+	if (len > filesize - pos)
+		len = filesize - pos;
+
+	return ext2fs_read_file(ext2fs_file, pos, len, buf);
+}
+
+
 int ext2fs_mount (unsigned part_length) {
 	struct ext2_data *data;
 	int status;
@@ -145,6 +145,114 @@
 /* keeps pointer to currentlu processed partition */
 static struct part_info *current_part;
 
+#if (defined(CONFIG_JFFS2_NAND) && defined(CONFIG_CMD_NAND)) || \
+    defined(CONFIG_CMD_ONENAND)
+#define JFFS2_FL_CACHE
+/*
+ * Read cache shared by the NAND and OneNAND accessors.
+ *
+ * It holds CONFIG_JFFS2_CACHE_SLOTS windows of flash, each of the
+ * device's cache size (NAND_CACHE_SIZE or ONENAND_CACHE_SIZE) and
+ * aligned to it, and on a miss replaces the least recently used one.
+ * The cache is emptied whenever the partition is (re)scanned.
+ */
+#ifndef CONFIG_JFFS2_CACHE_SLOTS
+#define CONFIG_JFFS2_CACHE_SLOTS	8
+#endif
+
+struct fl_cache_slot {
+	u8 *buf;
+	u32 size;		/* allocated size of buf */
+	u32 off;		/* flash offset of the window */
+	u32 len;		/* window length, 0 if the slot is empty */
+	struct mtdids *id;	/* device the window was read from */
+	u32 used;		/* LRU stamp */
+};
+
+static struct fl_cache_slot fl_cache[CONFIG_JFFS2_CACHE_SLOTS];
+static u32 fl_cache_clock;
+static u32 fl_cache_hits;
+static u32 fl_cache_misses;
+
+typedef int (*fl_read_fn)(struct mtdids *id, u32 off, u32 len, u_char *buf);
+
+static void fl_cache_invalidate(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_JFFS2_CACHE_SLOTS; i++)
+		fl_cache[i].len = 0;
+}
+
+/* Return the slot holding the window around 'off', reading it if needed */
+static struct fl_cache_slot *
+fl_cache_get(struct mtdids *id, u32 off, u32 window, fl_read_fn read)
+{
+	struct fl_cache_slot *slot, *victim = NULL;
+	u32 start = off - off % window;
+	int i;
+
+	for (i = 0; i < CONFIG_JFFS2_CACHE_SLOTS; i++) {
+		slot = &fl_cache[i];
+		if (slot->len == window && slot->off == start &&
+		    slot->id == id) {
+			fl_cache_hits++;
+			slot->used = ++fl_cache_clock;
+			return slot;
+		}
+		/* prefer an empty slot, then the least recently used one */
+		if (victim == NULL ||
+		    (victim->len && (!slot->len || slot->used < victim->used)))
+			victim = slot;
+	}
+
+	fl_cache_misses++;
+	victim->len = 0;
+	if (victim->size < window) {
+		/* The evicted slot's buffer is too small; replace it */
+		free(victim->buf);
+		victim->buf = malloc(window);
+		victim->size = victim->buf ? window : 0;
+		if (!victim->buf) {
+			printf("fl_cache_get: can't alloc cache size %d bytes\n",
+			       window);
+			return NULL;
+		}
+	}
+	if (read(id, start, window, victim->buf))
+		return NULL;
+
+	victim->off = start;
+	victim->len = window;
+	victim->id = id;
+	victim->used = ++fl_cache_clock;
+	return victim;
+}
+
+static int read_fl_cached(u32 off, u32 size, u_char *buf, u32 window,
+			  fl_read_fn read)
+{
+	struct mtdids *id = current_part->dev->id;
+	struct fl_cache_slot *slot;
+	u32 bytes_read = 0;
+	u32 pos, cpy_bytes;
+
+	while (bytes_read < size) {
+		pos = off + bytes_read;
+		slot = fl_cache_get(id, pos, window, read);
+		if (!slot)
+			return -1;
+		cpy_bytes = slot->off + slot->len - pos;
+		if (cpy_bytes > size - bytes_read)
+			cpy_bytes = size - bytes_read;
+		memcpy(buf + bytes_read, slot->buf + pos - slot->off,
+		       cpy_bytes);
+		bytes_read += cpy_bytes;
+	}
+	return bytes_read;
+}
+#endif
+
 #if (defined(CONFIG_JFFS2_NAND) && \
      defined(CONFIG_CMD_NAND) )
 #include <nand.h>
@@ -167,49 +275,23 @@ static struct part_info *current_part;
 #endif
 #define NAND_CACHE_SIZE (NAND_CACHE_PAGES*NAND_PAGE_SIZE)
 
-static u8* nand_cache = NULL;
-static u32 nand_cache_off = (u32)-1;
-
-static int read_nand_cached(u32 off, u32 size, u_char *buf)
+static int read_nand_window(struct mtdids *id, u32 off, u32 len, u_char *buf)
 {
-	struct mtdids *id = current_part->dev->id;
-	u32 bytes_read = 0;
-	size_t retlen;
-	int cpy_bytes;
-
-	while (bytes_read < size) {
-		if ((off + bytes_read < nand_cache_off) ||
-		    (off + bytes_read >= nand_cache_off+NAND_CACHE_SIZE)) {
-			nand_cache_off = (off + bytes_read) & NAND_PAGE_MASK;
-			if (!nand_cache) {
-				/* This memory never gets freed but 'cause
-				   it's a bootloader, nobody cares */
-				nand_cache = malloc(NAND_CACHE_SIZE);
-				if (!nand_cache) {
-					printf("read_nand_cached: can't alloc cache size %d bytes\n",
-					       NAND_CACHE_SIZE);
-					return -1;
-				}
-			}
+	size_t retlen = len;
 
-			retlen = NAND_CACHE_SIZE;
-			if (nand_read(&nand_info[id->num], nand_cache_off,
-						&retlen, nand_cache) != 0 ||
-					retlen != NAND_CACHE_SIZE) {
-				printf("read_nand_cached: error reading nand off %#x size %d bytes\n",
-						nand_cache_off, NAND_CACHE_SIZE);
-				return -1;
-			}
-		}
-		cpy_bytes = nand_cache_off + NAND_CACHE_SIZE - (off + bytes_read);
-		if (cpy_bytes > size - bytes_read)
-			cpy_bytes = size - bytes_read;
-		memcpy(buf + bytes_read,
-		       nand_cache + off + bytes_read - nand_cache_off,
-		       cpy_bytes);
-		bytes_read += cpy_bytes;
+	if (nand_read(&nand_info[id->num], off, &retlen, buf) != 0 ||
+			retlen != len) {
+		printf("read_nand_cached: error reading nand off %#x size %d bytes\n",
+				off, len);
+		return -1;
 	}
-	return bytes_read;
+	return 0;
+}
+
+static int read_nand_cached(u32 off, u32 size, u_char *buf)
+{
+	return read_fl_cached(off, size, buf, NAND_CACHE_SIZE,
+			      read_nand_window);
 }
 
 static void *get_fl_mem_nand(u32 off, u32 size, void *ext_buf)
@@ -267,48 +349,24 @@ static void put_fl_mem_nand(void *buf)
 #endif
 #define ONENAND_CACHE_SIZE (ONENAND_CACHE_PAGES*ONENAND_PAGE_SIZE)
 
-static u8* onenand_cache;
-static u32 onenand_cache_off = (u32)-1;
-
-static int read_onenand_cached(u32 off, u32 size, u_char *buf)
+static int read_onenand_window(struct mtdids *id, u32 off, u32 len,
+			       u_char *buf)
 {
-	u32 bytes_read = 0;
 	size_t retlen;
-	int cpy_bytes;
-
-	while (bytes_read < size) {
-		if ((off + bytes_read < onenand_cache_off) ||
-		    (off + bytes_read >= onenand_cache_off + ONENAND_CACHE_SIZE)) {
-			onenand_cache_off = (off + bytes_read) & ONENAND_PAGE_MASK;
-			if (!onenand_cache) {
-				/* This memory never gets freed but 'cause
-				   it's a bootloader, nobody cares */
-				onenand_cache = malloc(ONENAND_CACHE_SIZE);
-				if (!onenand_cache) {
-					printf("read_onenand_cached: can't alloc cache size %d bytes\n",
-					       ONENAND_CACHE_SIZE);
-					return -1;
-				}
-			}
 
-			retlen = ONENAND_CACHE_SIZE;
-			if (onenand_read(&onenand_mtd, onenand_cache_off, retlen,
-						&retlen, onenand_cache) != 0 ||
-					retlen != ONENAND_CACHE_SIZE) {
-				printf("read_onenand_cached: error reading nand off %#x size %d bytes\n",
-					onenand_cache_off, ONENAND_CACHE_SIZE);
-				return -1;
-			}
-		}
-		cpy_bytes = onenand_cache_off + ONENAND_CACHE_SIZE - (off + bytes_read);
-		if (cpy_bytes > size - bytes_read)
-			cpy_bytes = size - bytes_read;
-		memcpy(buf + bytes_read,
-		       onenand_cache + off + bytes_read - onenand_cache_off,
-		       cpy_bytes);
-		bytes_read += cpy_bytes;
+	if (onenand_read(&onenand_mtd, off, len, &retlen, buf) != 0 ||
+			retlen != len) {
+		printf("read_onenand_cached: error reading nand off %#x size %d bytes\n",
+			off, len);
+		return -1;
 	}
-	return bytes_read;
+	return 0;
+}
+
+static int read_onenand_cached(u32 off, u32 size, u_char *buf)
+{
+	return read_fl_cached(off, size, buf, ONENAND_CACHE_SIZE,
+			      read_onenand_window);
 }
 
 static void *get_fl_mem_onenand(u32 off, u32 size, void *ext_buf)
@@ -662,8 +720,11 @@ jffs2_free_cache(struct part_info *part)
 		pL = (struct b_lists *)part->jffs2_priv;
 		free_nodes(&pL->frag);
 		free_nodes(&pL->dir);
+		free(pL->fragTab);
+		free(pL->dirTab);
 		free(pL->readbuf);
 		free(pL);
+		part->jffs2_priv = NULL;
 	}
 }
 
@@ -686,6 +747,109 @@ jffs_init_1pass_list(struct part_info *part)
 	return 0;
 }
 
+/* Inode nodes sort by inode number, oldest version first */
+static int compare_frag_keys(const void *a, const void *b)
+{
+	const struct b_node *na = *(const struct b_node **)a;
+	const struct b_node *nb = *(const struct b_node **)b;
+
+	if (na->ino != nb->ino)
+		return na->ino < nb->ino ? -1 : 1;
+	if (na->version != nb->version)
+		return na->version < nb->version ? -1 : 1;
+	return na->offset < nb->offset ? -1 : na->offset > nb->offset;
+}
+
+/* Dirents sort by parent inode and name hash, oldest version first */
+static int compare_dirent_keys(const void *a, const void *b)
+{
+	const struct b_node *na = *(const struct b_node **)a;
+	const struct b_node *nb = *(const struct b_node **)b;
+
+	if (na->pino != nb->pino)
+		return na->pino < nb->pino ? -1 : 1;
+	if (na->nhash != nb->nhash)
+		return na->nhash < nb->nhash ? -1 : 1;
+	if (na->version != nb->version)
+		return na->version < nb->version ? -1 : 1;
+	return na->offset < nb->offset ? -1 : na->offset > nb->offset;
+}
+
+static struct b_node **
+build_table(struct b_list *list, int (*compar)(const void *, const void *))
+{
+	struct b_node **tab;
+	struct b_node *b;
+	u32 i = 0;
+
+	/* one spare entry so that an empty list still gets a table */
+	tab = malloc((list->listCount + 1) * sizeof(*tab));
+	if (tab == NULL)
+		return NULL;
+
+	for (b = list->listHead; b != NULL; b = b->next)
+		tab[i++] = b;
+	qsort(tab, i, sizeof(*tab), compar);
+
+	return tab;
+}
+
+/*
+ * Build the sorted lookup tables once all nodes are on the lists, so
+ * that name and inode lookups are binary searches on the cached keys
+ * rather than walks over the lists reading every node from flash.
+ */
+static int
+jffs2_1pass_build_tables(struct b_lists *pL)
+{
+	pL->fragTab = build_table(&pL->frag, compare_frag_keys);
+	pL->dirTab = build_table(&pL->dir, compare_dirent_keys);
+
+	return pL->fragTab != NULL && pL->dirTab != NULL;
+}
+
+/* Find the nodes of an inode in fragTab: [return value, *end) */
+static u32
+find_frags(struct b_lists *pL, u32 ino, u32 *end)
+{
+	u32 lo = 0, hi = pL->frag.listCount, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (pL->fragTab[mid]->ino < ino)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (hi = lo; hi < pL->frag.listCount &&
+	     pL->fragTab[hi]->ino == ino; hi++)
+		;
+	*end = hi;
+	return lo;
+}
+
+/* Find the dirents with a parent and name hash in dirTab */
+static u32
+find_dirents(struct b_lists *pL, u32 pino, u32 nhash, u32 *end)
+{
+	u32 lo = 0, hi = pL->dir.listCount, mid;
+	struct b_node *b;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		b = pL->dirTab[mid];
+		if (b->pino < pino || (b->pino == pino && b->nhash < nhash))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (hi = lo; hi < pL->dir.listCount && pL->dirTab[hi]->pino == pino &&
+	     pL->dirTab[hi]->nhash == nhash; hi++)
+		;
+	*end = hi;
+	return lo;
+}
+
 /* find the inode from the slashless name given a parent */
 static long
 jffs2_1pass_read_inode(struct b_lists *pL, u32 inode, char *dest)
@@ -693,115 +857,101 @@ jffs2_1pass_read_inode(struct b_lists *pL, u32 inode, char *dest)
 	struct b_node *b;
 	struct jffs2_raw_inode *jNode;
 	u32 totalSize = 0;
-	u32 latestVersion = 0;
 	uchar *lDest;
 	uchar *src;
 	int i;
-	u32 counter = 0;
-#ifdef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-	/* Find file size before loading any data, so fragments that
-	 * start past the end of file can be ignored. A fragment
-	 * that is partially in the file is loaded, so extra data may
-	 * be loaded up to the next 4K boundary above the file size.
-	 * This shouldn't cause trouble when loading kernel images, so
-	 * we will live with it.
+	u32 n, end;
+
+	/* The nodes of the inode are in fragTab with the latest version
+	 * last, so if there is overlapping data the latest version is
+	 * used.  Find file size from the newest node before loading any
+	 * data, so fragments that start past the end of file can be
+	 * ignored. A fragment that is partially in the file is loaded,
+	 * so extra data may be loaded up to the next 4K boundary above
+	 * the file size. This shouldn't cause trouble when loading kernel
+	 * images, so we will live with it.
 	 */
-	for (b = pL->frag.listHead; b != NULL; b = b->next) {
-		jNode = (struct jffs2_raw_inode *) get_fl_mem(b->offset,
+	n = find_frags(pL, inode, &end);
+	if (n < end) {
+		jNode = (struct jffs2_raw_inode *) get_fl_mem(
+			pL->fragTab[end - 1]->offset,
 			sizeof(struct jffs2_raw_inode), pL->readbuf);
-		if ((inode == jNode->ino)) {
-			/* get actual file length from the newest node */
-			if (jNode->version >= latestVersion) {
-				totalSize = jNode->isize;
-				latestVersion = jNode->version;
-			}
-		}
+		totalSize = jNode->isize;
 		put_fl_mem(jNode, pL->readbuf);
 	}
-#endif
 
-	for (b = pL->frag.listHead; b != NULL; b = b->next) {
+	for (; n < end; n++) {
+		b = pL->fragTab[n];
 		jNode = (struct jffs2_raw_inode *) get_node_mem(b->offset,
 								pL->readbuf);
-		if ((inode == jNode->ino)) {
 #if 0
-			putLabeledWord("\r\n\r\nread_inode: totlen = ", jNode->totlen);
-			putLabeledWord("read_inode: inode = ", jNode->ino);
-			putLabeledWord("read_inode: version = ", jNode->version);
-			putLabeledWord("read_inode: isize = ", jNode->isize);
-			putLabeledWord("read_inode: offset = ", jNode->offset);
-			putLabeledWord("read_inode: csize = ", jNode->csize);
-			putLabeledWord("read_inode: dsize = ", jNode->dsize);
-			putLabeledWord("read_inode: compr = ", jNode->compr);
-			putLabeledWord("read_inode: usercompr = ", jNode->usercompr);
-			putLabeledWord("read_inode: flags = ", jNode->flags);
+		putLabeledWord("\r\n\r\nread_inode: totlen = ", jNode->totlen);
+		putLabeledWord("read_inode: inode = ", jNode->ino);
+		putLabeledWord("read_inode: version = ", jNode->version);
+		putLabeledWord("read_inode: isize = ", jNode->isize);
+		putLabeledWord("read_inode: offset = ", jNode->offset);
+		putLabeledWord("read_inode: csize = ", jNode->csize);
+		putLabeledWord("read_inode: dsize = ", jNode->dsize);
+		putLabeledWord("read_inode: compr = ", jNode->compr);
+		putLabeledWord("read_inode: usercompr = ", jNode->usercompr);
+		putLabeledWord("read_inode: flags = ", jNode->flags);
 #endif
 
-#ifndef CONFIG_SYS_JFFS2_SORT_FRAGMENTS
-			/* get actual file length from the newest node */
-			if (jNode->version >= latestVersion) {
-				totalSize = jNode->isize;
-				latestVersion = jNode->version;
+		if(dest) {
+			src = ((uchar *) jNode) + sizeof(struct jffs2_raw_inode);
+			/* ignore data behind latest known EOF */
+			if (jNode->offset > totalSize) {
+				put_fl_mem(jNode, pL->readbuf);
+				continue;
+			}
+			if (b->datacrc == CRC_UNKNOWN)
+				b->datacrc = data_crc(jNode) ?
+					CRC_OK : CRC_BAD;
+			if (b->datacrc == CRC_BAD) {
+				put_fl_mem(jNode, pL->readbuf);
+				continue;
 			}
-#endif
-
-			if(dest) {
-				src = ((uchar *) jNode) + sizeof(struct jffs2_raw_inode);
-				/* ignore data behind latest known EOF */
-				if (jNode->offset > totalSize) {
-					put_fl_mem(jNode, pL->readbuf);
-					continue;
-				}
-				if (b->datacrc == CRC_UNKNOWN)
-					b->datacrc = data_crc(jNode) ?
-						CRC_OK : CRC_BAD;
-				if (b->datacrc == CRC_BAD) {
-					put_fl_mem(jNode, pL->readbuf);
-					continue;
-				}
 
-				lDest = (uchar *) (dest + jNode->offset);
+			lDest = (uchar *) (dest + jNode->offset);
 #if 0
-				putLabeledWord("read_inode: src = ", src);
-				putLabeledWord("read_inode: dest = ", lDest);
+			putLabeledWord("read_inode: src = ", src);
+			putLabeledWord("read_inode: dest = ", lDest);
 #endif
-				switch (jNode->compr) {
-				case JFFS2_COMPR_NONE:
-					ldr_memcpy(lDest, src, jNode->dsize);
-					break;
-				case JFFS2_COMPR_ZERO:
-					for (i = 0; i < jNode->dsize; i++)
-						*(lDest++) = 0;
-					break;
-				case JFFS2_COMPR_RTIME:
-					rtime_decompress(src, lDest, jNode->csize, jNode->dsize);
-					break;
-				case JFFS2_COMPR_DYNRUBIN:
-					/* this is slow but it works */
-					dynrubin_decompress(src, lDest, jNode->csize, jNode->dsize);
-					break;
-				case JFFS2_COMPR_ZLIB:
-					zlib_decompress(src, lDest, jNode->csize, jNode->dsize);
-					break;
+			switch (jNode->compr) {
+			case JFFS2_COMPR_NONE:
+				ldr_memcpy(lDest, src, jNode->dsize);
+				break;
+			case JFFS2_COMPR_ZERO:
+				for (i = 0; i < jNode->dsize; i++)
+					*(lDest++) = 0;
+				break;
+			case JFFS2_COMPR_RTIME:
+				rtime_decompress(src, lDest, jNode->csize, jNode->dsize);
+				break;
+			case JFFS2_COMPR_DYNRUBIN:
+				/* this is slow but it works */
+				dynrubin_decompress(src, lDest, jNode->csize, jNode->dsize);
+				break;
+			case JFFS2_COMPR_ZLIB:
+				zlib_decompress(src, lDest, jNode->csize, jNode->dsize);
+				break;
 #if defined(CONFIG_JFFS2_LZO)
-				case JFFS2_COMPR_LZO:
-					lzo_decompress(src, lDest, jNode->csize, jNode->dsize);
-					break;
+			case JFFS2_COMPR_LZO:
+				lzo_decompress(src, lDest, jNode->csize, jNode->dsize);
+				break;
 #endif
-				default:
-					/* unknown */
-					putLabeledWord("UNKNOWN COMPRESSION METHOD = ", jNode->compr);
-					put_fl_mem(jNode, pL->readbuf);
-					return -1;
-					break;
-				}
+			default:
+				/* unknown */
+				putLabeledWord("UNKNOWN COMPRESSION METHOD = ", jNode->compr);
+				put_fl_mem(jNode, pL->readbuf);
+				return -1;
+				break;
 			}
+		}
 
 #if 0
-			putLabeledWord("read_inode: totalSize = ", totalSize);
+		putLabeledWord("read_inode: totalSize = ", totalSize);
 #endif
-		}
-		counter++;
 		put_fl_mem(jNode, pL->readbuf);
 	}
 
@@ -818,35 +968,28 @@ jffs2_1pass_find_inode(struct b_lists * pL, const char *name, u32 pino)
 	struct b_node *b;
 	struct jffs2_raw_dirent *jDir;
 	int len;
-	u32 counter;
-	u32 version = 0;
+	u32 first, n;
 	u32 inode = 0;
 
 	/* name is assumed slash free */
 	len = strlen(name);
 
-	counter = 0;
-	/* we need to search all and return the inode with the highest version */
-	for(b = pL->dir.listHead; b; b = b->next, counter++) {
+	/* we need the inode with the highest version: the candidates are
+	 * sorted oldest first, so walk them backwards and stop at the
+	 * first one whose name really matches
+	 */
+	first = find_dirents(pL, pino,
+			     crc32_no_comp(0, (unsigned char *)name, len), &n);
+	while (n-- > first) {
+		b = pL->dirTab[n];
+		if (!b->ino)	/* 0 for unlink */
+			continue;
+
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
-		if ((pino == jDir->pino) && (len == jDir->nsize) &&
-		    (jDir->ino) &&	/* 0 for unlink */
-		    (!strncmp((char *)jDir->name, name, len))) {	/* a match */
-			if (jDir->version < version) {
-				put_fl_mem(jDir, pL->readbuf);
-				continue;
-			}
-
-			if (jDir->version == version && inode != 0) {
-				/* I'm pretty sure this isn't legal */
-				putstr(" ** ERROR ** ");
-				putnstr(jDir->name, jDir->nsize);
-				putLabeledWord(" has dup version =", version);
-			}
+		if ((len == jDir->nsize) &&
+		    (!strncmp((char *)jDir->name, name, len)))	/* a match */
 			inode = jDir->ino;
-			version = jDir->version;
-		}
 #if 0
 		putstr("\r\nfind_inode:p&l ->");
 		putnstr(jDir->name, jDir->nsize);
@@ -854,9 +997,10 @@ jffs2_1pass_find_inode(struct b_lists * pL, const char *name, u32 pino)
 		putLabeledWord("pino = ", jDir->pino);
 		putLabeledWord("nsize = ", jDir->nsize);
 		putLabeledWord("b = ", (u32) b);
-		putLabeledWord("counter = ", counter);
 #endif
 		put_fl_mem(jDir, pL->readbuf);
+		if (inode)
+			break;
 	}
 	return inode;
 }
@@ -946,40 +1090,34 @@ static inline u32 dump_inode(struct b_lists * pL, struct jffs2_raw_dirent *d, st
 static u32
 jffs2_1pass_list_inodes(struct b_lists * pL, u32 pino)
 {
-	struct b_node *b;
+	struct b_node *b, *b2;
 	struct jffs2_raw_dirent *jDir;
+	struct jffs2_raw_inode *i;
+	u32 n, end, first, last;
+
+	/* the dirents of a directory are contiguous in dirTab */
+	for (n = find_dirents(pL, pino, 0, &end); n < pL->dir.listCount &&
+	     pL->dirTab[n]->pino == pino; n++) {
+		b = pL->dirTab[n];
+		if (!b->ino)	/* ino=0 -> unlink */
+			continue;
 
-	for (b = pL->dir.listHead; b; b = b->next) {
 		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
 								pL->readbuf);
-		if ((pino == jDir->pino) && (jDir->ino)) { /* ino=0 -> unlink */
-			u32 i_version = 0;
-			struct jffs2_raw_inode ojNode;
-			struct jffs2_raw_inode *jNode, *i = NULL;
-			struct b_node *b2 = pL->frag.listHead;
-
-			while (b2) {
-				jNode = (struct jffs2_raw_inode *)
-					get_fl_mem(b2->offset, sizeof(ojNode), &ojNode);
-				if (jNode->ino == jDir->ino && jNode->version >= i_version) {
-					i_version = jNode->version;
-					if (i)
-						put_fl_mem(i, NULL);
-
-					if (jDir->type == DT_LNK)
-						i = get_node_mem(b2->offset,
-								 NULL);
-					else
-						i = get_fl_mem(b2->offset,
-							       sizeof(*i),
-							       NULL);
-				}
-				b2 = b2->next;
-			}
 
-			dump_inode(pL, jDir, i);
-			put_fl_mem(i, NULL);
+		/* the newest node of the inode is the last one */
+		i = NULL;
+		first = find_frags(pL, b->ino, &last);
+		if (first < last) {
+			b2 = pL->fragTab[last - 1];
+			if (jDir->type == DT_LNK)
+				i = get_node_mem(b2->offset, NULL);
+			else
+				i = get_fl_mem(b2->offset, sizeof(*i), NULL);
 		}
+
+		dump_inode(pL, jDir, i);
+		put_fl_mem(i, NULL);
 		put_fl_mem(jDir, pL->readbuf);
 	}
 	return pino;
@@ -1045,74 +1183,66 @@ static u32
 jffs2_1pass_resolve_inode(struct b_lists * pL, u32 ino)
 {
 	struct b_node *b;
-	struct b_node *b2;
+	struct b_node *found = NULL;
 	struct jffs2_raw_dirent *jDir;
 	struct jffs2_raw_inode *jNode;
-	u8 jDirFoundType = 0;
-	u32 jDirFoundIno = 0;
-	u32 jDirFoundPino = 0;
 	char tmp[256];
-	u32 version = 0;
 	u32 pino;
+	u32 n, end;
 	unsigned char *src;
 
-	/* we need to search all and return the inode with the highest version */
-	for(b = pL->dir.listHead; b; b = b->next) {
-		jDir = (struct jffs2_raw_dirent *) get_node_mem(b->offset,
-								pL->readbuf);
-		if (ino == jDir->ino) {
-			if (jDir->version < version) {
-				put_fl_mem(jDir, pL->readbuf);
-				continue;
-			}
-
-			if (jDir->version == version && jDirFoundType) {
-				/* I'm pretty sure this isn't legal */
-				putstr(" ** ERROR ** ");
-				putnstr(jDir->name, jDir->nsize);
-				putLabeledWord(" has dup version (resolve) = ",
-					version);
-			}
+	/* we need to search all and return the inode with the highest
+	 * version; the cached keys make this a walk over RAM only
+	 */
+	for (n = 0; n < pL->dir.listCount; n++) {
+		b = pL->dirTab[n];
+		if (b->ino != ino)
+			continue;
+		if (found && b->version < found->version)
+			continue;
 
-			jDirFoundType = jDir->type;
-			jDirFoundIno = jDir->ino;
-			jDirFoundPino = jDir->pino;
-			version = jDir->version;
+		if (found && b->version == found->version) {
+			/* I'm pretty sure this isn't legal */
+			jDir = (struct jffs2_raw_dirent *) get_node_mem(
+				b->offset, pL->readbuf);
+			putstr(" ** ERROR ** ");
+			putnstr(jDir->name, jDir->nsize);
+			putLabeledWord(" has dup version (resolve) = ",
+				b->version);
+			put_fl_mem(jDir, pL->readbuf);
 		}
-		put_fl_mem(jDir, pL->readbuf);
+
+		found = b;
 	}
 	/* now we found the right entry again. (shoulda returned inode*) */
-	if (jDirFoundType != DT_LNK)
-		return jDirFoundIno;
-
-	/* it's a soft link so we follow it again. */
-	b2 = pL->frag.listHead;
-	while (b2) {
-		jNode = (struct jffs2_raw_inode *) get_node_mem(b2->offset,
-								pL->readbuf);
-		if (jNode->ino == jDirFoundIno) {
-			src = (unsigned char *)jNode + sizeof(struct jffs2_raw_inode);
+	if (!found)
+		return 0;
+	if (found->type != DT_LNK)
+		return found->ino;
 
+	/* it's a soft link so we follow the newest target name */
+	n = find_frags(pL, found->ino, &end);
+	if (n == end)
+		return 0;
+	jNode = (struct jffs2_raw_inode *) get_node_mem(
+		pL->fragTab[end - 1]->offset, pL->readbuf);
+	src = (unsigned char *)jNode + sizeof(struct jffs2_raw_inode);
 #if 0
-			putLabeledWord("\t\t dsize = ", jNode->dsize);
-			putstr("\t\t target = ");
-			putnstr(src, jNode->dsize);
-			putstr("\r\n");
+	putLabeledWord("\t\t dsize = ", jNode->dsize);
+	putstr("\t\t target = ");
+	putnstr(src, jNode->dsize);
+	putstr("\r\n");
 #endif
-			strncpy(tmp, (char *)src, jNode->dsize);
-			tmp[jNode->dsize] = '\0';
-			put_fl_mem(jNode, pL->readbuf);
-			break;
-		}
-		b2 = b2->next;
-		put_fl_mem(jNode, pL->readbuf);
-	}
+	strncpy(tmp, (char *)src, jNode->dsize);
+	tmp[jNode->dsize] = '\0';
+	put_fl_mem(jNode, pL->readbuf);
+
 	/* ok so the name of the new file to find is in tmp */
 	/* if it starts with a slash it is root based else shared dirs */
 	if (tmp[0] == '/')
 		pino = 1;
 	else
-		pino = jDirFoundPino;
+		pino = found->pino;
 
 	return jffs2_1pass_search_inode(pL, tmp, pino);
 }
@@ -1228,11 +1358,12 @@ static u16 sum_get_unaligned16(u16 *ptr)
 
 static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 				struct jffs2_raw_summary *summary,
-				struct b_lists *pL)
+				struct b_lists *pL, u32 *max_totlen)
 {
 	void *sp;
 	int i, pass;
-	void *ret;
+	struct b_node *ret;
+	u32 totlen;
 
 	for (pass = 0; pass < 2; pass++) {
 		sp = summary->sum;
@@ -1254,6 +1385,15 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 								&spi->offset));
 						if (ret == NULL)
 							return -1;
+						ret->ino = sum_get_unaligned32(
+							&spi->inode);
+						ret->version =
+							sum_get_unaligned32(
+								&spi->version);
+						totlen = sum_get_unaligned32(
+							&spi->totlen);
+						if (*max_totlen < totlen)
+							*max_totlen = totlen;
 					}
 
 					sp += JFFS2_SUMMARY_INODE_SIZE;
@@ -1271,6 +1411,20 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 								&spd->offset));
 						if (ret == NULL)
 							return -1;
+						ret->ino = sum_get_unaligned32(
+							&spd->ino);
+						ret->pino = sum_get_unaligned32(
+							&spd->pino);
+						ret->version =
+							sum_get_unaligned32(
+								&spd->version);
+						ret->nhash = crc32_no_comp(0,
+							spd->name, spd->nsize);
+						ret->type = spd->type;
+						totlen = sum_get_unaligned32(
+							&spd->totlen);
+						if (*max_totlen < totlen)
+							*max_totlen = totlen;
 					}
 
 					sp += JFFS2_SUMMARY_DIRENT_SIZE(
@@ -1298,7 +1452,7 @@ static int jffs2_sum_process_sum_data(struct part_info *part, uint32_t offset,
 /* Process the summary node - called from jffs2_scan_eraseblock() */
 int jffs2_sum_scan_sumnode(struct part_info *part, uint32_t offset,
 			   struct jffs2_raw_summary *summary, uint32_t sumsize,
-			   struct b_lists *pL)
+			   struct b_lists *pL, u32 *max_totlen)
 {
 	struct jffs2_unknown_node crcnode;
 	int ret, ofs;
@@ -1345,7 +1499,8 @@ int jffs2_sum_scan_sumnode(struct part_info *part, uint32_t offset,
 	if (summary->cln_mkr)
 		dbg_summary("Summary : CLEANMARKER node \n");
 
-	ret = jffs2_sum_process_sum_data(part, offset, summary, pL);
+	ret = jffs2_sum_process_sum_data(part, offset, summary, pL,
+					 max_totlen);
 	if (ret == -EBADMSG)
 		return 0;
 	if (ret)
@@ -1433,11 +1588,224 @@ static inline uint32_t EMPTY_SCAN_SIZE(uint32_t sector_size)
 		return DEFAULT_EMPTY_SCAN_SIZE;
 }
 
+#if defined(CONFIG_JFFS2_SUMMARY) && defined(CONFIG_JFFS2_SCAN_INDEX_ADDR)
+#define JFFS2_SCAN_INDEX
+/*
+ * Scan index in a reserved RAM area.
+ *
+ * After every scan the nodes of all summarised erase blocks are saved
+ * to CONFIG_JFFS2_SCAN_INDEX_ADDR, together with the offset and CRCs of
+ * each block's summary node.  When the same partition is scanned again
+ * (after 'mtdparts' dropped the lists, or after a reset that
+ * kept RAM) a block whose summary node is unchanged is taken from the
+ * index after reading just the summary header; all other blocks are
+ * scanned as usual.
+ */
+#define JFFS2_SCAN_INDEX_MAGIC	0x4a324958	/* "J2IX" */
+
+#ifndef CONFIG_JFFS2_SCAN_INDEX_SIZE
+#define CONFIG_JFFS2_SCAN_INDEX_SIZE	(1 << 20)
+#endif
+
+struct jffs2_index_sector {
+	u32 sum_ofs;		/* summary node offset, 0 if none */
+	u32 node_crc;		/* node_crc of the summary node */
+	u32 sum_crc;		/* sum_crc of the summary node */
+	u32 first;		/* first node record of the block */
+	u32 count;		/* number of node records */
+};
+
+struct jffs2_index_node {
+	u32 offset;
+	u32 ino;
+	u32 pino;
+	u32 version;
+	u32 nhash;
+	u8 type;
+	u8 dirent;		/* 1 for a dirent, 0 for an inode node */
+	u16 pad;
+};
+
+struct jffs2_scan_index {
+	u32 magic;
+	u32 crc;		/* crc32 of everything from 'size' on */
+	u32 size;		/* bytes in use, including this header */
+	u8 dev_type;
+	u8 dev_num;
+	u16 pad;
+	u32 part_offset;
+	u32 part_size;
+	u32 sector_size;
+	u32 max_totlen;
+	u32 nr_nodes;
+	struct jffs2_index_sector sector[0];
+	/* followed by nr_nodes struct jffs2_index_node */
+};
+
+static inline struct jffs2_index_node *
+jffs2_index_nodes(struct jffs2_scan_index *idx)
+{
+	return (void *)&idx->sector[idx->part_size / idx->sector_size];
+}
+
+/* Return the index if it is intact and was built for this partition */
+static struct jffs2_scan_index *
+jffs2_index_find(struct part_info *part)
+{
+	struct jffs2_scan_index *idx =
+		(struct jffs2_scan_index *)CONFIG_JFFS2_SCAN_INDEX_ADDR;
+	u32 hdr = offsetof(struct jffs2_scan_index, size);
+
+	if (idx->magic != JFFS2_SCAN_INDEX_MAGIC ||
+	    idx->dev_type != part->dev->id->type ||
+	    idx->dev_num != part->dev->id->num ||
+	    idx->part_offset != part->offset ||
+	    idx->part_size != part->size ||
+	    idx->sector_size != part->sector_size)
+		return NULL;
+
+	if (idx->size > CONFIG_JFFS2_SCAN_INDEX_SIZE ||
+	    idx->size != sizeof(*idx) +
+			 part->size / part->sector_size *
+				sizeof(struct jffs2_index_sector) +
+			 idx->nr_nodes * sizeof(struct jffs2_index_node))
+		return NULL;
+
+	if (idx->crc != crc32_no_comp(0, (uchar *)&idx->size,
+				      idx->size - hdr))
+		return NULL;
+
+	return idx;
+}
+
+/*
+ * Take the nodes of erase block 'sector' from the index if its summary
+ * node at 'sum_ofs' is the one the index was built from.  Returns 1 if
+ * the block was restored, 0 if it has to be scanned, -1 on error.
+ */
+static int
+jffs2_index_restore(struct part_info *part, struct jffs2_scan_index *idx,
+		    u32 sector, u32 sum_ofs, struct b_lists *pL)
+{
+	struct jffs2_index_sector *is = &idx->sector[sector];
+	struct jffs2_raw_summary osum, *sum;
+	struct jffs2_index_node *rec;
+	struct b_node *b;
+	u32 i;
+	int match;
+
+	if (!sum_ofs || is->sum_ofs != sum_ofs)
+		return 0;
+
+	sum = (struct jffs2_raw_summary *)get_fl_mem(part->offset +
+		sector * part->sector_size + sum_ofs, sizeof(osum), &osum);
+	match = sum->magic == JFFS2_MAGIC_BITMASK &&
+		sum->nodetype == JFFS2_NODETYPE_SUMMARY &&
+		sum->node_crc == is->node_crc && sum->sum_crc == is->sum_crc;
+	put_fl_mem(sum, &osum);
+	if (!match)
+		return 0;
+
+	rec = jffs2_index_nodes(idx) + is->first;
+	for (i = 0; i < is->count; i++, rec++) {
+		b = insert_node(rec->dirent ? &pL->dir : &pL->frag,
+				rec->offset);
+		if (b == NULL)
+			return -1;
+		b->ino = rec->ino;
+		b->pino = rec->pino;
+		b->version = rec->version;
+		b->nhash = rec->nhash;
+		b->type = rec->type;
+	}
+
+	return 1;
+}
+
+/* Save the nodes of all summarised erase blocks to the index */
+static void
+jffs2_index_save(struct part_info *part, struct b_lists *pL,
+		 struct jffs2_index_sector *isec, u32 max_totlen)
+{
+	struct jffs2_scan_index *idx =
+		(struct jffs2_scan_index *)CONFIG_JFFS2_SCAN_INDEX_ADDR;
+	struct b_list *lists[] = { &pL->frag, &pL->dir };
+	u32 nr_sectors = part->size / part->sector_size;
+	u32 hdr = offsetof(struct jffs2_scan_index, size);
+	struct jffs2_index_sector *is;
+	struct jffs2_index_node *rec, *r;
+	struct b_node *b;
+	u32 i, l, nr_nodes, size;
+
+	idx->magic = 0;
+
+	for (i = 0; i < nr_sectors; i++)
+		isec[i].count = 0;
+	for (l = 0; l < ARRAY_SIZE(lists); l++)
+		for (b = lists[l]->listHead; b != NULL; b = b->next) {
+			is = &isec[(b->offset - part->offset) /
+				   part->sector_size];
+			if (is->sum_ofs)
+				is->count++;
+		}
+
+	nr_nodes = 0;
+	for (i = 0; i < nr_sectors; i++) {
+		isec[i].first = nr_nodes;
+		nr_nodes += isec[i].count;
+	}
+
+	size = sizeof(*idx) + nr_sectors * sizeof(*isec) +
+		nr_nodes * sizeof(*rec);
+	if (size > CONFIG_JFFS2_SCAN_INDEX_SIZE) {
+		printf("JFFS2 scan index needs %u bytes, not saved\n", size);
+		return;
+	}
+
+	idx->size = size;
+	idx->dev_type = part->dev->id->type;
+	idx->dev_num = part->dev->id->num;
+	idx->pad = 0;
+	idx->part_offset = part->offset;
+	idx->part_size = part->size;
+	idx->sector_size = part->sector_size;
+	idx->max_totlen = max_totlen;
+	idx->nr_nodes = nr_nodes;
+	memcpy(idx->sector, isec, nr_sectors * sizeof(*isec));
+
+	/* 'count' is refilled as the records are placed */
+	for (i = 0; i < nr_sectors; i++)
+		idx->sector[i].count = 0;
+	rec = jffs2_index_nodes(idx);
+	for (l = 0; l < ARRAY_SIZE(lists); l++)
+		for (b = lists[l]->listHead; b != NULL; b = b->next) {
+			is = &idx->sector[(b->offset - part->offset) /
+					  part->sector_size];
+			if (!is->sum_ofs)
+				continue;
+			r = &rec[is->first + is->count++];
+			r->offset = b->offset;
+			r->ino = b->ino;
+			r->pino = b->pino;
+			r->version = b->version;
+			r->nhash = b->nhash;
+			r->type = b->type;
+			r->dirent = lists[l] == &pL->dir;
+			r->pad = 0;
+		}
+
+	idx->crc = crc32_no_comp(0, (uchar *)&idx->size, size - hdr);
+	idx->magic = JFFS2_SCAN_INDEX_MAGIC;
+}
+#endif /* CONFIG_JFFS2_SUMMARY && CONFIG_JFFS2_SCAN_INDEX_ADDR */
+
 static u32
 jffs2_1pass_build_lists(struct part_info * part)
 {
 	struct b_lists *pL;
 	struct jffs2_unknown_node *node;
+	struct jffs2_raw_dirent *jDir;
+	struct b_node *b;
 	u32 nr_sectors = part->size/part->sector_size;
 	u32 i;
 	u32 counter4 = 0;
@@ -1446,6 +1814,10 @@ jffs2_1pass_build_lists(struct part_info * part)
 	u32 max_totlen = 0;
 	u32 buf_size = DEFAULT_EMPTY_SCAN_SIZE;
 	char *buf;
+#ifdef JFFS2_SCAN_INDEX
+	struct jffs2_scan_index *idx;
+	struct jffs2_index_sector *isec;
+#endif
 
 	/* turn off the lcd.  Refreshing the lcd adds 50% overhead to the */
 	/* jffs2 list building enterprise nope.  in newer versions the overhead is */
@@ -1454,8 +1826,18 @@ jffs2_1pass_build_lists(struct part_info * part)
 
 	/* if we are building a list we need to refresh the cache. */
 	jffs_init_1pass_list(part);
+#ifdef JFFS2_FL_CACHE
+	fl_cache_invalidate();
+#endif
 	pL = (struct b_lists *)part->jffs2_priv;
 	buf = malloc(buf_size);
+#ifdef JFFS2_SCAN_INDEX
+	idx = jffs2_index_find(part);
+	if (idx != NULL)
+		max_totlen = idx->max_totlen;
+	/* without this the scan still works, it just is not saved */
+	isec = calloc(nr_sectors, sizeof(*isec));
+#endif
 	puts ("Scanning JFFS2 FS:   ");
 
 	/* start at the beginning of the partition */
@@ -1468,6 +1850,7 @@ jffs2_1pass_build_lists(struct part_info * part)
 		struct jffs2_sum_marker *sm;
 		void *sumptr = NULL;
 		uint32_t sumlen;
+		uint32_t node_crc, sum_crc;
 		int ret;
 #endif
 
@@ -1484,6 +1867,17 @@ jffs2_1pass_build_lists(struct part_info * part)
 
 		sm = (void *)buf + buf_size - sizeof(*sm);
 		if (sm->magic == JFFS2_SUM_MAGIC) {
+#ifdef JFFS2_SCAN_INDEX
+			ret = idx ? jffs2_index_restore(part, idx, i,
+							sm->offset, pL) : 0;
+			if (ret < 0)
+				goto fail;
+			if (ret) {
+				if (isec)
+					isec[i] = idx->sector[i];
+				continue;
+			}
+#endif
 			sumlen = part->sector_size - sm->offset;
 			sumptr = buf + buf_size - sumlen;
 
@@ -1494,9 +1888,7 @@ jffs2_1pass_build_lists(struct part_info * part)
 				if (!sumptr) {
 					putstr("Can't get memory for summary "
 							"node!\n");
-					free(buf);
-					jffs2_free_cache(part);
-					return 0;
+					goto fail;
 				}
 				memcpy(sumptr + sumlen - buf_len, buf +
 						buf_size - buf_len, buf_len);
@@ -1513,17 +1905,24 @@ jffs2_1pass_build_lists(struct part_info * part)
 
 		if (sumptr) {
 			ret = jffs2_sum_scan_sumnode(part, sector_ofs, sumptr,
-					sumlen, pL);
+					sumlen, pL, &max_totlen);
+			node_crc = ((struct jffs2_raw_summary *)sumptr)->node_crc;
+			sum_crc = ((struct jffs2_raw_summary *)sumptr)->sum_crc;
 
 			if (buf_size && sumlen > buf_size)
 				free(sumptr);
-			if (ret < 0) {
-				free(buf);
-				jffs2_free_cache(part);
-				return 0;
-			}
-			if (ret)
+			if (ret < 0)
+				goto fail;
+			if (ret) {
+#ifdef JFFS2_SCAN_INDEX
+				if (isec) {
+					isec[i].sum_ofs = sm->offset;
+					isec[i].node_crc = node_crc;
+					isec[i].sum_crc = sum_crc;
+				}
+#endif
 				continue;
+			}
 
 		}
 #endif /* CONFIG_JFFS2_SUMMARY */
@@ -1633,12 +2032,13 @@ jffs2_1pass_build_lists(struct part_info * part)
 				if (!inode_crc((struct jffs2_raw_inode *) node))
 				       break;
 
-				if (insert_node(&pL->frag, (u32) part->offset +
-						ofs) == NULL) {
-					free(buf);
-					jffs2_free_cache(part);
-					return 0;
-				}
+				b = insert_node(&pL->frag, (u32) part->offset +
+						ofs);
+				if (b == NULL)
+					goto fail;
+				b->ino = ((struct jffs2_raw_inode *)node)->ino;
+				b->version =
+					((struct jffs2_raw_inode *)node)->version;
 				if (max_totlen < node->totlen)
 					max_totlen = node->totlen;
 				break;
@@ -1663,12 +2063,17 @@ jffs2_1pass_build_lists(struct part_info * part)
 					break;
 				if (! (counterN%100))
 					puts ("\b\b.  ");
-				if (insert_node(&pL->dir, (u32) part->offset +
-						ofs) == NULL) {
-					free(buf);
-					jffs2_free_cache(part);
-					return 0;
-				}
+				b = insert_node(&pL->dir, (u32) part->offset +
+						ofs);
+				if (b == NULL)
+					goto fail;
+				jDir = (struct jffs2_raw_dirent *)node;
+				b->ino = jDir->ino;
+				b->pino = jDir->pino;
+				b->version = jDir->version;
+				/* the name CRC has just been checked */
+				b->nhash = jDir->name_crc;
+				b->type = jDir->type;
 				if (max_totlen < node->totlen)
 					max_totlen = node->totlen;
 				counterN++;
@@ -1702,6 +2107,18 @@ jffs2_1pass_build_lists(struct part_info * part)
 	free(buf);
 	putstr("\b\b done.\r\n");		/* close off the dots */
 
+	if (!jffs2_1pass_build_tables(pL)) {
+		putstr("Can't get memory for lookup tables!\n");
+		buf = NULL;
+		goto fail;
+	}
+#ifdef JFFS2_SCAN_INDEX
+	if (isec) {
+		jffs2_index_save(part, pL, isec, max_totlen);
+		free(isec);
+	}
+#endif
+
 	/* We don't care if malloc failed - then each read operation will
 	 * allocate its own buffer as necessary (NAND) or will read directly
 	 * from flash (NOR).
@@ -1730,6 +2147,14 @@ jffs2_1pass_build_lists(struct part_info * part)
 	/* give visual feedback that we are done scanning the flash */
 	led_blink(0x0, 0x0, 0x1, 0x1);	/* off, forever, on 100ms, off 100ms */
 	return 1;
+
+fail:
+	free(buf);
+#ifdef JFFS2_SCAN_INDEX
+	free(isec);
+#endif
+	jffs2_free_cache(part);
+	return 0;
 }
 
 
@@ -1859,5 +2284,11 @@ jffs2_1pass_info(struct part_info * part)
 			info.compr_info[i].compr_sum,
 			info.compr_info[i].decompr_sum);
 	}
+#ifdef JFFS2_FL_CACHE
+	printf("Read cache: %d slots\n"
+		"\thits: %u\n"
+		"\tmisses: %u\n",
+		CONFIG_JFFS2_CACHE_SLOTS, fl_cache_hits, fl_cache_misses);
+#endif
 	return 1;
 }
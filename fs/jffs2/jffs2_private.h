@@ -8,6 +8,12 @@ struct b_node {
 	u32 offset;
 	struct b_node *next;
 	enum { CRC_UNKNOWN = 0, CRC_OK, CRC_BAD } datacrc;
+	/* lookup keys, cached at scan time so lookups need no flash reads */
+	u32 ino;		/* inode number, 0 for an unlink dirent */
+	u32 pino;		/* dirents only: parent inode */
+	u32 version;
+	u32 nhash;		/* dirents only: crc32 of the name */
+	u8 type;		/* dirents only: DT_* type */
 };
 
 struct b_list {
@@ -26,6 +32,8 @@ struct b_lists {
 	struct b_list dir;
 	struct b_list frag;
 	void *readbuf;
+	struct b_node **dirTab;		/* dirents by pino, nhash, version */
+	struct b_node **fragTab;	/* inodes by ino, version */
 };
 
 struct b_compr_info {
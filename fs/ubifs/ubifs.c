@@ -518,23 +518,16 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/*
+ * Decompress data node @dn of block @block into @addr, zero-padding the
+ * block up to UBIFS_BLOCK_SIZE.
+ */
+static int decode_block(struct ubifs_info *c, struct inode *inode, void *addr,
+			unsigned int block, struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -565,6 +558,25 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return decode_block(c, inode, addr, block, dn);
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -676,6 +688,61 @@ error:
 	return err;
 }
 
+/*
+ * Bulk-read blocks [block, end) of @inode into @addr: consecutive data nodes
+ * that sit back to back in one LEB are found in a single TNC walk, fetched
+ * with a single ubi_read() and then decompressed in order. Returns the number
+ * of blocks filled in (holes included), 0 if nothing could be bulk-read, in
+ * which case the caller falls back to do_readpage(), or a negative error code
+ * for a bad data node.
+ */
+static int do_bulk_read(struct ubifs_info *c, struct inode *inode, void *addr,
+			unsigned int block, unsigned int end)
+{
+	struct bu_info *bu = &c->bu;
+	unsigned int b, last;
+	void *buf;
+	int err, n;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err || !bu->cnt)
+		return 0;
+
+	/*
+	 * Blocks between the looked up key and the first node found, and
+	 * between any two nodes found, are holes.
+	 */
+	last = key_block(c, &bu->zbranch[bu->cnt - 1].key) + 1;
+	if (last > end)
+		last = end;
+	if (last <= block)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return 0;
+
+	dbg_gen("ino %lu, blocks %u-%u, %d nodes",
+		inode->i_ino, block, last - 1, bu->cnt);
+
+	buf = bu->buf;
+	n = 0;
+	for (b = block; b < last; b++, addr += UBIFS_BLOCK_SIZE) {
+		if (n < bu->cnt && key_block(c, &bu->zbranch[n].key) == b) {
+			err = decode_block(c, inode, addr, b, buf);
+			if (err)
+				return err;
+			buf += ALIGN(bu->zbranch[n].len, 8);
+			n++;
+		} else {
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		}
+	}
+
+	return last - block;
+}
+
 int ubifs_load(char *filename, u32 addr, u32 size)
 {
 	struct ubifs_info *c = ubifs_sb->s_fs_info;
@@ -683,7 +750,7 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 	char buf [10];
@@ -718,10 +785,35 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	printf("Loading file '%s' to addr 0x%08x with size %d (0x%08x)...\n",
 	       filename, addr, size, size);
 
+	/*
+	 * The bulk-read buffer is optional: without it every block is
+	 * looked up and read on its own.
+	 */
+	c->bu.buf_len = c->max_bu_buf_len;
+	c->bu.buf = malloc(c->bu.buf_len);
+
 	page.addr = (void *)addr;
 	page.index = 0;
 	page.inode = inode;
 	for (i = 0; i < count; i++) {
+		/*
+		 * Bulk-read everything but the last block, which must not
+		 * be padded beyond the requested size
+		 */
+		if (c->bu.buf && (i + 1) < count) {
+			n = do_bulk_read(c, inode, page.addr, i, count - 1);
+			if (n < 0) {
+				err = n;
+				break;
+			}
+			if (n > 0) {
+				page.addr += n * PAGE_SIZE;
+				page.index += n;
+				i += n - 1;
+				continue;
+			}
+		}
+
 		/*
 		 * Make sure to not read beyond the requested size
 		 */
@@ -736,6 +828,9 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 		page.index++;
 	}
 
+	free(c->bu.buf);
+	c->bu.buf = NULL;
+
 	if (err)
 		printf("Error reading file '%s'\n", filename);
 	else {
@@ -294,6 +294,8 @@ int	cpu_init(void);
 phys_size_t initdram (int);
 int	display_options (void);
 void	print_size(unsigned long long, const char *);
+void	print_rate(const char *name, unsigned long long count, ulong ms,
+		   unsigned long long unit, const char *unit_name);
 int	print_buffer (ulong addr, void* data, uint width, uint count, uint linelen);
 
 /* common/main.c */
@@ -48,6 +48,12 @@
 #define CONFIG_OF_BOARD_SETUP
 #define CONFIG_SYS_FDT_PAD	0x8000
 
+/* Make those changes, and the other bootm fixups, in one pass */
+#define CONFIG_OF_FIXUP_TXN
+
+/* Bring up storage in the background while the board starts */
+#define CONFIG_INITCALL_DEFER
+
 /* Make sure that the safe version of printf() is compiled in. */
 #define CONFIG_SYS_VSNPRINTF
 
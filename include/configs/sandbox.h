@@ -101,9 +101,20 @@
 /* include default commands */
 #include <config_cmd_default.h>
 
-/* We don't have networking support yet */
-#undef CONFIG_CMD_NET
-#undef CONFIG_CMD_NFS
+/* Networking, through the sandbox-daemon's loopback network */
+#define CONFIG_SANDBOX_ETH
+#define CONFIG_CMD_PING
+#define CONFIG_CMD_NETBENCH
+#define CONFIG_TFTP_TSIZE
+
+/* Software BCH ECC, with a throughput benchmark */
+#define CONFIG_BCH
+#define CONFIG_CMD_BCHBENCH
+
+/* Time the init sequence */
+#define CONFIG_INITCALL_PROFILE
+#define CONFIG_CMD_INITCALL
+#define CONFIG_INITCALL_DEFER
 
 /* GPIO */
 #define CONFIG_CMD_GPIO
@@ -119,18 +130,27 @@
 
 #define CONFIG_EXTRA_ENV_SETTINGS	"stdin=serial,sandbox-keyb\0" \
 					"stdout=serial\0" \
-					"stderr=serial\0"
+					"stderr=serial\0" \
+					"ipaddr=192.168.0.2\0" \
+					"serverip=192.168.0.1\0" \
+					"netmask=255.255.255.0\0"
 
 /* Device Tree */
 #define CONFIG_OF_CONTROL
 #define CONFIG_OF_LIBFDT
 #define CONFIG_OF_EMBED
+#define CONFIG_FDTDEC_INDEX
 #define CONFIG_DEFAULT_DEVICE_TREE sandbox
 #define CONFIG_ARCH_DEVICE_TREE sandbox
 
-/* SPI */
+/* SPI, with flash commands decoded by the sandbox-daemon's emulator */
 #define CONFIG_CMD_SF
 #define CONFIG_SANDBOX_SPI
+#define CONFIG_SPI_FLASH
+#define CONFIG_SPI_FLASH_MACRONIX
+#define CONFIG_SPI_FLASH_WINBOND
+#define CONFIG_SPI_FLASH_SFDP
+#define CONFIG_SF_DEFAULT_SPEED		50000000
 
 /* MMC */
 #define CONFIG_MMC
@@ -145,6 +165,15 @@
 /* Logical Memory Blocks */
 #define CONFIG_LMB
 
+/* FIT images, hashed by host threads standing in for secondary CPUs */
+#define CONFIG_FIT
+#define CONFIG_CPU_WORK
+#define CONFIG_FIT_PARTIAL_LOAD
+
+/* Load images where bootm wants them, and decompress ramdisks */
+#define CONFIG_BOOTM_PLAN
+#define CONFIG_BOOTM_RAMDISK_DECOMP
+
 /* Device Tree */
 #define CONFIG_OF_CONTROL
 #define CONFIG_OF_LIBFDT
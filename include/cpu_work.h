@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __CPU_WORK_H
+#define __CPU_WORK_H
+
+/*
+ * A job for another CPU, which runs while the boot CPU gets on with
+ * something else. The job may only read and write memory it is given: it
+ * must not print, allocate, reset the watchdog or touch devices. Where no
+ * other CPU is free, the job runs at once on the boot CPU instead.
+ */
+struct cpu_work {
+	void (*fn)(void *arg);
+	void *arg;
+
+	/* private to cpu_work.c and the architecture code */
+	int started;			/* 1 if running on another CPU */
+	void *priv;
+};
+
+#ifdef CONFIG_CPU_WORK
+/**
+ * Start a job, on another CPU if one is free.
+ *
+ * @param work	Job to run, which must stay valid until cpu_work_wait()
+ * @param fn	Function to run
+ * @param arg	Argument for fn
+ */
+void cpu_work_start(struct cpu_work *work, void (*fn)(void *arg), void *arg);
+
+/**
+ * Wait for a job to finish. Its results are then visible to the caller.
+ *
+ * @param work	Job passed to cpu_work_start()
+ */
+void cpu_work_wait(struct cpu_work *work);
+
+/**
+ * Hand a job to another CPU. The weak version has no other CPU to use.
+ *
+ * @param work	Job to run
+ * @return 0 if the job was started, -1 if it must be run by the caller
+ */
+int arch_cpu_work_start(struct cpu_work *work);
+
+/**
+ * Wait for a job that arch_cpu_work_start() started.
+ *
+ * @param work	Job to wait for
+ */
+void arch_cpu_work_wait(struct cpu_work *work);
+#else
+static inline void cpu_work_start(struct cpu_work *work,
+				  void (*fn)(void *arg), void *arg)
+{
+	fn(arg);
+}
+
+static inline void cpu_work_wait(struct cpu_work *work)
+{
+}
+#endif
+
+#endif
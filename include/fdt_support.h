@@ -27,6 +27,7 @@
 #ifdef CONFIG_OF_LIBFDT
 
 #include <fdt.h>
+#include <libfdt.h>
 
 u32 fdt_getprop_u32_default(const void *fdt, const char *path,
 				const char *prop, const u32 dflt);
@@ -60,6 +61,79 @@ void fdt_fixup_ethernet(void *fdt);
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create);
 void fdt_fixup_qe_firmware(void *fdt);
+int fdt_set_mem_rsv(void *fdt, u64 addr, u64 size);
+
+/*
+ * Fixup transactions. Between fdt_txn_begin() and fdt_txn_commit() these
+ * functions record changes to the FDT and the commit makes them all at
+ * once. Outside a transaction they change the FDT directly, like the
+ * libfdt functions they are named after.
+ */
+#ifdef CONFIG_OF_FIXUP_TXN
+int fdt_txn_begin(void *fdt);
+int fdt_txn_commit(void *fdt, int bufsize);
+void fdt_txn_abort(void);
+const void *fdt_txn_getprop(const void *fdt, int nodeoffset,
+			    const char *name, int *lenp);
+int fdt_txn_setprop(void *fdt, int nodeoffset, const char *name,
+		    const void *val, int len);
+int fdt_txn_subnode_offset(const void *fdt, int parentoffset,
+			   const char *name);
+int fdt_txn_add_subnode(void *fdt, int parentoffset, const char *name);
+int fdt_txn_path_offset(const void *fdt, const char *path);
+int fdt_txn_set_mem_rsv(void *fdt, u64 addr, u64 size);
+#else
+static inline int fdt_txn_begin(void *fdt) { return 0; }
+static inline int fdt_txn_commit(void *fdt, int bufsize) { return 0; }
+static inline void fdt_txn_abort(void) {}
+
+static inline const void *fdt_txn_getprop(const void *fdt, int nodeoffset,
+					  const char *name, int *lenp)
+{
+	return fdt_getprop(fdt, nodeoffset, name, lenp);
+}
+
+static inline int fdt_txn_setprop(void *fdt, int nodeoffset,
+				  const char *name, const void *val, int len)
+{
+	return fdt_setprop(fdt, nodeoffset, name, val, len);
+}
+
+static inline int fdt_txn_subnode_offset(const void *fdt, int parentoffset,
+					 const char *name)
+{
+	return fdt_subnode_offset(fdt, parentoffset, name);
+}
+
+static inline int fdt_txn_add_subnode(void *fdt, int parentoffset,
+				      const char *name)
+{
+	return fdt_add_subnode(fdt, parentoffset, name);
+}
+
+static inline int fdt_txn_path_offset(const void *fdt, const char *path)
+{
+	return fdt_path_offset(fdt, path);
+}
+
+static inline int fdt_txn_set_mem_rsv(void *fdt, u64 addr, u64 size)
+{
+	return fdt_set_mem_rsv(fdt, addr, size);
+}
+#endif
+
+static inline int fdt_txn_setprop_cell(void *fdt, int nodeoffset,
+				       const char *name, u32 val)
+{
+	val = cpu_to_fdt32(val);
+	return fdt_txn_setprop(fdt, nodeoffset, name, &val, sizeof(val));
+}
+
+static inline int fdt_txn_setprop_string(void *fdt, int nodeoffset,
+					 const char *name, const char *str)
+{
+	return fdt_txn_setprop(fdt, nodeoffset, name, str, strlen(str) + 1);
+}
 
 #ifdef CONFIG_HAS_FSL_DR_USB
 void fdt_fixup_dr_usb(void *blob, bd_t *bd);
@@ -533,4 +533,68 @@ const u8 *fdtdec_locate_byte_array(const void *blob, int node,
 int fdtdec_decode_region(const void *blob, int node,
 		const char *prop_name, void **ptrp, size_t *size);
 
+/**
+ * Find a node by its path or alias, as fdt_path_offset() does, using the
+ * FDT index when there is one for this blob.
+ *
+ * @param blob		FDT blob
+ * @param path		path of the node, or an alias optionally followed by
+ *			a path below it
+ * @return node offset if found, -ve error code on error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * Find the next node with a given compatible string, as
+ * fdt_node_offset_by_compatible() does, using the FDT index when there is
+ * one for this blob.
+ *
+ * @param blob		FDT blob
+ * @param node		node to start after, -1 to include the root
+ * @param compat	compatible string to look for
+ * @return offset of next compatible node, or -FDT_ERR_NOTFOUND if no more
+ */
+int fdtdec_node_offset_by_compatible(const void *blob, int node,
+		const char *compat);
+
+#ifdef CONFIG_FDTDEC_INDEX
+/**
+ * Build an index of the nodes in an FDT by path, alias, phandle and
+ * compatible string, which the fdtdec lookups then use instead of
+ * walking the tree. The FDT must not change while the index is in use.
+ *
+ * @param blob		FDT blob to index, normally gd->fdt_blob
+ * @return 0 if ok, -1 if the index could not be built
+ */
+int fdtdec_index_init(const void *blob);
+
+/*
+ * Lookups in the FDT index. Each returns -1 if the index cannot answer
+ * for this blob, in which case the caller should use libfdt, or 0 with
+ * the node offset or a -ve libfdt error in *nodep.
+ */
+int fdtdec_index_path(const void *blob, const char *path, int *nodep);
+int fdtdec_index_compatible(const void *blob, int node, const char *compat,
+			    int *nodep);
+int fdtdec_index_phandle(const void *blob, u32 phandle, int *nodep);
+#else
+static inline int fdtdec_index_path(const void *blob, const char *path,
+				    int *nodep)
+{
+	return -1;
+}
+
+static inline int fdtdec_index_compatible(const void *blob, int node,
+					  const char *compat, int *nodep)
+{
+	return -1;
+}
+
+static inline int fdtdec_index_phandle(const void *blob, u32 phandle,
+				       int *nodep)
+{
+	return -1;
+}
+#endif
+
 #endif /* _FDTDEC_H */
@@ -174,6 +174,14 @@
 #define IH_COMP_LZMA		3	/* lzma  Compression Used	*/
 #define IH_COMP_LZO		4	/* lzo   Compression Used	*/
 
+/* Errors from image_decomp() */
+#define IMAGE_DECOMP_ERR		-1	/* corrupt, or too large */
+#define IMAGE_DECOMP_UNSUPPORTED	-2	/* type not built in */
+
+#ifndef CONFIG_SYS_BOOTM_LEN
+#define CONFIG_SYS_BOOTM_LEN	0x800000	/* use 8MByte as default max gunzip size */
+#endif
+
 #define IH_MAGIC	0x27051956	/* Image Magic Number		*/
 #define IH_NMLEN		32	/* Image Name Length		*/
 
@@ -223,6 +231,7 @@ typedef struct bootm_headers {
 	void		*fit_hdr_os;	/* os FIT image header */
 	const char	*fit_uname_os;	/* os subimage node unit name */
 	int		fit_noffset_os;	/* os subimage node offset */
+	int		fit_verify_os;	/* check os hashes while loading it */
 
 	void		*fit_hdr_rd;	/* init ramdisk FIT image header */
 	const char	*fit_uname_rd;	/* init ramdisk subimage node unit name */
@@ -238,6 +247,7 @@ typedef struct bootm_headers {
 	ulong		ep;		/* entry point of OS */
 
 	ulong		rd_start, rd_end;/* ramdisk start/end */
+	uint8_t		rd_comp;	/* ramdisk compression type */
 
 #ifdef CONFIG_OF_LIBFDT
 	char		*ft_addr;	/* flat dev tree address */
@@ -336,6 +346,10 @@ int genimg_get_format(void *img_addr);
 int genimg_has_config(bootm_headers_t *images);
 ulong genimg_get_image(ulong img_addr);
 
+ulong image_decomp_size(int comp, const void *image_buf, ulong image_len);
+int image_decomp(int comp, void *load_buf, ulong unc_len,
+		 const void *image_buf, ulong image_len, ulong *sizep);
+
 int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 		uint8_t arch, ulong *rd_start, ulong *rd_end);
 
@@ -349,7 +363,7 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size);
 
 #ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
 int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
-		  ulong *initrd_start, ulong *initrd_end);
+		  uint8_t rd_comp, ulong *initrd_start, ulong *initrd_end);
 #endif /* CONFIG_SYS_BOOT_RAMDISK_HIGH */
 #ifdef CONFIG_SYS_BOOT_GET_CMDLINE
 int boot_get_cmdline(struct lmb *lmb, ulong *cmd_start, ulong *cmd_end);
@@ -357,6 +371,21 @@ int boot_get_cmdline(struct lmb *lmb, ulong *cmd_start, ulong *cmd_end);
 #ifdef CONFIG_SYS_BOOT_GET_KBD
 int boot_get_kbd(struct lmb *lmb, bd_t **kbd);
 #endif /* CONFIG_SYS_BOOT_GET_KBD */
+
+/*
+ * Where a loader should put an image, or the data of its kernel and
+ * ramdisk, so that bootm need not move them. 0 means no better place.
+ */
+struct boot_plan {
+	ulong		image;		/* start of the whole image */
+	ulong		kernel;		/* kernel data (FIT external data) */
+	ulong		ramdisk;	/* ramdisk data (FIT external data) */
+};
+
+#ifdef CONFIG_BOOTM_PLAN
+int boot_plan_image(const void *hdr, struct boot_plan *plan);
+ulong boot_plan_move(ulong addr, ulong len);
+#endif
 #endif /* !USE_HOSTCC */
 
 /*******************************************************************/
@@ -461,6 +490,9 @@ ulong getenv_bootm_low(void);
 phys_size_t getenv_bootm_size(void);
 phys_size_t getenv_bootm_mapsize(void);
 void memmove_wd(void *to, void *from, size_t len, ulong chunksz);
+#ifdef CONFIG_LMB
+void boot_start_lmb(struct lmb *lmb);
+#endif
 #endif
 
 static inline int image_check_magic(const image_header_t *hdr)
@@ -511,6 +543,10 @@ static inline int image_check_target_arch(const image_header_t *hdr)
 
 /* image node */
 #define FIT_DATA_PROP		"data"
+#define FIT_DATA_OFFSET_PROP	"data-offset"
+#define FIT_DATA_ADDR_PROP	"data-address"
+#define FIT_DATA_SIZE_PROP	"data-size"
+#define FIT_COMPAT_PROP		"compatible"
 #define FIT_TIMESTAMP_PROP	"timestamp"
 #define FIT_DESC_PROP		"description"
 #define FIT_ARCH_PROP		"arch"
@@ -550,16 +586,33 @@ static inline ulong fit_get_size(const void *fit)
 	return fdt_totalsize(fit);
 }
 
+/**
+ * fit_get_data_base - get where external image data starts
+ * @fit: pointer to the FIT format image header
+ *
+ * Images with a data-offset property keep their data after the FIT blob,
+ * starting at the next 4-byte boundary.
+ *
+ * returns:
+ *     offset from the start of the FIT image that data-offset counts from
+ */
+static inline ulong fit_get_data_base(const void *fit)
+{
+	return (fdt_totalsize(fit) + 3) & ~3;
+}
+
+ulong fit_get_total_size(const void *fit);
+
 /**
  * fit_get_end - get FIT image end
  * @fit: pointer to the FIT format image header
  *
  * returns:
- *     end address of the FIT image (blob) in memory
+ *     end address of the FIT image (blob and external data) in memory
  */
 static inline ulong fit_get_end(const void *fit)
 {
-	return (ulong)fit + fdt_totalsize(fit);
+	return (ulong)fit + fit_get_total_size(fit);
 }
 
 /**
@@ -600,7 +653,20 @@ int fit_image_hash_set_value(void *fit, int noffset, uint8_t *value,
 				int value_len);
 
 int fit_image_check_hashes(const void *fit, int noffset);
+int fit_image_load_check_hashes(const void *fit, int noffset, void *dst);
 int fit_all_image_check_hashes(const void *fit);
+#if defined(CONFIG_CPU_WORK) && !defined(USE_HOSTCC)
+int fit_image_hash_start(const void *fit, int image_noffset);
+void fit_conf_hash_start(const void *fit, int cfg_noffset);
+void fit_image_hash_finish(void);
+#else
+static inline int fit_image_hash_start(const void *fit, int image_noffset)
+{
+	return -1;
+}
+static inline void fit_conf_hash_start(const void *fit, int cfg_noffset) {}
+static inline void fit_image_hash_finish(void) {}
+#endif
 int fit_image_check_os(const void *fit, int noffset, uint8_t os);
 int fit_image_check_arch(const void *fit, int noffset, uint8_t arch);
 int fit_image_check_type(const void *fit, int noffset, uint8_t type);
@@ -609,12 +675,34 @@ int fit_check_format(const void *fit);
 
 int fit_conf_find_compat(const void *fit, const void *fdt);
 int fit_conf_get_node(const void *fit, const char *conf_uname);
+int fit_conf_select(const void *fit, const char *conf_uname);
 int fit_conf_get_kernel_node(const void *fit, int noffset);
 int fit_conf_get_ramdisk_node(const void *fit, int noffset);
 int fit_conf_get_fdt_node(const void *fit, int noffset);
 
 void fit_conf_print(const void *fit, int noffset, const char *p);
 
+/**
+ * fit_read_fn - read part of a FIT image from storage
+ * @priv: private data of the reader
+ * @offset: byte offset from the start of the image
+ * @size: number of bytes to read
+ * @buf: where to put them
+ *
+ * returns:
+ *     0, on success
+ *     -1, on failure
+ */
+typedef int (*fit_read_fn)(void *priv, ulong offset, ulong size, void *buf);
+
+#ifndef USE_HOSTCC
+struct block_dev_desc;
+
+int fit_load_external(void *fit, fit_read_fn read, void *priv);
+int fit_load_external_blk(void *fit, struct block_dev_desc *dev_desc,
+			  ulong start);
+#endif /* USE_HOSTCC */
+
 #ifndef USE_HOSTCC
 static inline int fit_image_check_target_arch(const void *fdt, int node)
 {
@@ -20,6 +20,108 @@
  * MA 02111-1307 USA
  */
 
+#ifndef __INITCALL_H
+#define __INITCALL_H
+
 typedef int (*init_fnc_t)(void);
 
 int initcall_run_list(init_fnc_t init_sequence[]);
+
+/**
+ * Print how long each function run by initcall_run_list() took, with
+ * CONFIG_INITCALL_PROFILE.
+ *
+ * @param sort	0 to list them in the order they ran, non-zero to list the
+ *		slowest first
+ */
+void initcall_report(int sort);
+
+/* Init steps which can wait in the background, with CONFIG_INITCALL_DEFER */
+enum initcall_defer_id {
+	INITCALL_DEFER_MMC,
+	INITCALL_DEFER_USB,
+	INITCALL_DEFER_DISPLAY,
+	INITCALL_DEFER_EC,
+	INITCALL_DEFER_BOARD,	/* first id free for board code */
+
+	INITCALL_DEFER_MAX = 32,
+};
+
+#define INITCALL_DEFER_MASK(id)	(1U << (id))
+#define INITCALL_DEFER_ALL	(~0U)
+
+/* Returned by a step's start() or poll() while it is still waiting */
+#define INITCALL_PENDING	1
+
+/*
+ * A deferred init step. start() is called once everything it depends on
+ * has finished, then poll() until it stops returning INITCALL_PENDING.
+ * Both return 0 when the step is done and -ve on error. Neither should
+ * wait for long: the point is to let other steps make progress meanwhile.
+ */
+struct initcall_defer {
+	const char *name;
+	enum initcall_defer_id id;
+	unsigned depends;		/* INITCALL_DEFER_MASK() of each */
+	int (*start)(void);
+	int (*poll)(void);		/* NULL if start() always finishes */
+
+	/* private to initcall_defer.c */
+	int state;
+	int err;
+	struct initcall_defer *next;
+};
+
+#ifdef CONFIG_INITCALL_DEFER
+/**
+ * Add a step to be run in the background. It is started straight away if
+ * it depends on nothing that is still running.
+ *
+ * @param step	Step to add, which must stay valid until it has finished
+ * @return 0 if ok, -1 if a step with the same id is already added
+ */
+int initcall_defer(struct initcall_defer *step);
+
+/**
+ * Start whatever steps are ready to start, and poll each running step
+ * once. Calls from inside a step are ignored.
+ *
+ * @return number of steps not yet finished
+ */
+int initcall_defer_poll(void);
+
+/**
+ * Run steps until all of those given have finished, and so whatever they
+ * depend on too.
+ *
+ * @param mask	INITCALL_DEFER_MASK() of each step to wait for, or
+ *		INITCALL_DEFER_ALL
+ * @return 0 if they all succeeded, -1 if any failed or could not run
+ */
+int initcall_defer_wait(unsigned mask);
+
+/**
+ * Wait for a while, polling deferred steps meanwhile. Use this instead of
+ * mdelay() in drivers which poll hardware during init.
+ *
+ * @param msec	Number of milliseconds to wait
+ */
+void initcall_defer_mdelay(unsigned long msec);
+#else
+static inline int initcall_defer_poll(void)
+{
+	return 0;
+}
+
+static inline int initcall_defer_wait(unsigned mask)
+{
+	return 0;
+}
+
+static inline void initcall_defer_mdelay(unsigned long msec)
+{
+	mdelay(msec);
+}
+#endif
+
+#endif
@@ -92,6 +92,8 @@ extern void nand_wait_ready(struct mtd_info *mtd);
 #define NAND_CMD_READSTART	0x30
 #define NAND_CMD_RNDOUTSTART	0xE0
 #define NAND_CMD_CACHEDPROG	0x15
+#define NAND_CMD_READCACHESEQ	0x31
+#define NAND_CMD_READCACHEEND	0x3f
 
 /* Extended commands for AG-AND device */
 /*
@@ -230,6 +232,13 @@ typedef enum {
 #define NAND_USE_FLASH_BBT_NO_OOB	0x00800000
 /* Create an empty BBT with no vendor information if the BBT is available */
 #define NAND_CREATE_EMPTY_BBT		0x01000000
+/*
+ * Chip supports the ONFI read cache commands, so sequential page reads can
+ * overlap the array load of the next page with the transfer of this one.
+ * Set automatically for ONFI chips which advertise it.
+ */
+#define NAND_CACHEREAD			0x02000000
+#define NAND_HAS_CACHEREAD(chip) ((chip->options & NAND_CACHEREAD))
 
 /* Options set by nand scan */
 /* Nand scan has allocated controller struct */
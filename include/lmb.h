@@ -14,6 +14,7 @@
  * 2 of the License, or (at your option) any later version.
  */
 
+/* Regions held before more space is allocated */
 #define MAX_LMB_REGIONS 8
 
 struct lmb_property {
@@ -21,10 +22,17 @@ struct lmb_property {
 	phys_size_t size;
 };
 
+/*
+ * Regions are kept sorted by base and merged when they overlap or touch,
+ * so that lookups can use a binary search. region[] starts as initial[]
+ * and is moved to the heap, twice the size, each time it fills up.
+ */
 struct lmb_region {
 	unsigned long cnt;
-	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	unsigned long max;		/* number of regions region[] holds */
+	phys_size_t size;		/* total size of all regions */
+	struct lmb_property *region;
+	struct lmb_property initial[MAX_LMB_REGIONS];
 };
 
 struct lmb {
@@ -35,6 +43,7 @@ struct lmb {
 extern struct lmb lmb;
 
 extern void lmb_init(struct lmb *lmb);
+extern void lmb_release(struct lmb *lmb);
 extern long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align);
@@ -42,7 +51,11 @@ extern phys_addr_t lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align
 			    phys_addr_t max_addr);
 extern phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align,
 			      phys_addr_t max_addr);
+extern phys_addr_t lmb_alloc_best_fit(struct lmb *lmb, phys_size_t size,
+				      ulong align, phys_addr_t max_addr);
 extern int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr);
+extern long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
+				phys_size_t size);
 extern long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 
 extern void lmb_dump_all(struct lmb *lmb);
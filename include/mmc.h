@@ -309,6 +309,7 @@ struct mmc {
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
 	uint op_cond_response;	/* the response byte from the last op_cond */
+	ulong op_cond_start;	/* get_timer() when op_cond polling began */
 };
 
 int mmc_register(struct mmc *mmc);
@@ -89,11 +89,18 @@ struct eth_device {
 	int (*mcast) (struct eth_device*, u32 ip, u8 set);
 #endif
 	int  (*write_hwaddr) (struct eth_device*);
+#ifdef CONFIG_NET_CSUM_OFFLOAD
+	int csum_offload;	/* ETH_CSUM_... flags, set after eth_register() */
+#endif
 	struct eth_device *next;
 	int index;
 	void *priv;
 };
 
+/* Checksum work a MAC may do in hardware (eth_device.csum_offload) */
+#define ETH_CSUM_RX_IP	(1 << 0)	/* Drops frames with bad IP header sum */
+#define ETH_CSUM_TX_IP	(1 << 1)	/* Inserts IP header checksum */
+
 extern int eth_initialize(bd_t *bis);	/* Initialize network subsystem */
 extern int eth_register(struct eth_device* dev);/* Register network device */
 extern int eth_unregister(struct eth_device* dev);/* Remove network device */
@@ -368,6 +375,17 @@ extern int		NetState;		/* Network loop state		*/
 
 extern int		NetRestartWrap;		/* Tried all network devices	*/
 
+/* Traffic counters, reset by whoever wants to measure a transfer */
+struct net_stats {
+	ulong	rx_packets;		/* Frames passed to NetReceive()	*/
+	ulong	rx_bytes;
+	ulong	tx_packets;		/* Frames handed to eth_send()		*/
+	ulong	tx_bytes;
+	ulong	retransmits;		/* Protocol timeouts which resent	*/
+};
+
+extern struct net_stats	NetStats;
+
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
 	TFTPSRV, TFTPPUT
@@ -429,6 +447,11 @@ extern void	NetSendPacket(volatile uchar *, int);
 /* Transmit UDP packet, performing ARP request if needed */
 extern int	NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len);
 
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+/* Resolve a MAC address ahead of the first packet sent to it */
+extern void	ArpPrefetch(IPaddr_t ip);
+#endif
+
 /* Processes a received packet */
 extern void	NetReceive(volatile uchar *, int);
 
@@ -134,6 +134,23 @@ void os_usleep(unsigned long usec);
  */
 u64 os_get_nsec(void);
 
+/**
+ * Start a new OS thread
+ *
+ * \param handlep	Holds a handle for os_thread_join() on success
+ * \param fn		Function for the thread to run
+ * \param arg		Argument for fn
+ * \return 0 if ok, -1 on error
+ */
+int os_thread_start(void **handlep, void *(*fn)(void *), void *arg);
+
+/**
+ * Wait for a thread started by os_thread_start() to finish
+ *
+ * \param handle	Handle of the thread
+ */
+void os_thread_join(void *handle);
+
 /**
  * Parse arguments and update sandbox state.
  *
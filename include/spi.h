@@ -45,6 +45,8 @@
 /* SPI transfer flags */
 #define SPI_XFER_BEGIN	0x01			/* Assert CS before transfer */
 #define SPI_XFER_END	0x02			/* Deassert CS after transfer */
+#define SPI_XFER_DUAL	0x04			/* Clock bits on IO0-1 */
+#define SPI_XFER_QUAD	0x08			/* Clock bits on IO0-3 */
 
 /* Header byte that marks the start of the message */
 #define SPI_PREAMBLE_END_BYTE	0xec
@@ -176,6 +178,20 @@ int  spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 		void *din, unsigned long flags);
 #endif
 
+/*-----------------------------------------------------------------------
+ * Report multi-line transfer support.
+ *
+ * Controllers that can clock a transfer on two or four data lines, as
+ * requested by the SPI_XFER_DUAL and SPI_XFER_QUAD flags, provide this
+ * function. The default reports single-line transfers only, so a
+ * controller must opt in before a flash is read in dual or quad mode.
+ *
+ *   slave:	The SPI slave
+ *
+ * Returns: The SPI_XFER_DUAL/SPI_XFER_QUAD flags spi_xfer() accepts.
+ */
+unsigned int spi_get_rx_caps(struct spi_slave *slave);
+
 /*-----------------------------------------------------------------------
  * Determine if a SPI chipselect is valid.
  * This function is provided by the board if the low-level SPI driver
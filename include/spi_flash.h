@@ -38,6 +38,26 @@
 #define CONTROLLER_PAGE_LIMIT	((int)(~0U>>1))
 #endif
 
+/* Multi-I/O read modes a part supports, see spi_flash.read_modes */
+#define SPI_FLASH_RD_DUAL	(1 << 0)	/* 1-1-2, dual output */
+#define SPI_FLASH_RD_QUAD	(1 << 1)	/* 1-1-4, quad output */
+#define SPI_FLASH_RD_QUAD_IO	(1 << 2)	/* 1-4-4, quad I/O */
+#define SPI_FLASH_RD_MODES	3
+
+/* Erase block sizes a part may offer, as in the JEDEC SFDP table */
+#define SPI_FLASH_ERASE_TYPES	4
+
+/* Erases a part offers with a 4-byte address, see spi_flash.erase_4b */
+#define SPI_FLASH_ERASE_4B_4K	(1 << 0)	/* 21h */
+#define SPI_FLASH_ERASE_4B_32K	(1 << 1)	/* 5Ch */
+#define SPI_FLASH_ERASE_4B_64K	(1 << 2)	/* DCh */
+
+/* A read command that differs from the standard one for its mode */
+struct spi_flash_read_param {
+	u8	cmd;		/* opcode, 0 for the standard one */
+	u8	dummy_clk;	/* dummy clocks, mode clocks included */
+};
+
 struct spi_flash {
 	struct spi_slave *spi;
 
@@ -49,6 +69,21 @@ struct spi_flash {
 	u32		page_size;
 	/* Erase (sector) size */
 	u32		sector_size;
+	/* Address bytes, 0 lets the probe pick 3 or 4 from the size */
+	u8		addr_width;
+	/* Supported multi-I/O read modes, SPI_FLASH_RD_* */
+	u8		read_modes;
+	/* Non-standard read commands, indexed by ffs(SPI_FLASH_RD_*) - 1 */
+	struct spi_flash_read_param read_params[SPI_FLASH_RD_MODES];
+	/* Read mode, opcode and dummy bytes picked at probe time */
+	u8		read_mode;
+	u8		read_cmd;
+	u8		read_dummy;
+	/* Erase block sizes as log2 (0 if unused) and their opcodes */
+	u8		erase_shift[SPI_FLASH_ERASE_TYPES];
+	u8		erase_cmd[SPI_FLASH_ERASE_TYPES];
+	/* Erases with a 4-byte address form, SPI_FLASH_ERASE_4B_* */
+	u8		erase_4b;
 
 	int		(*read)(struct spi_flash *flash, u32 offset,
 				size_t len, void *buf);
@@ -58,6 +93,8 @@ struct spi_flash {
 				size_t len);
 	int		(*read_sw_wp_status)(struct spi_flash *flash,
 				u8 *result);
+	/* Set the quad-enable bit, NULL if quad modes need no setup */
+	int		(*quad_enable)(struct spi_flash *flash);
 };
 
 struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs,
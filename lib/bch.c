@@ -46,7 +46,8 @@
  * remainder lookup tables.
  *
  * The final stage of decoding involves the following internal steps:
- * a. Syndrome computation
+ * a. Syndrome computation, 8 remainder bits at a time using syndrome lookup
+ *    tables
  * b. Error locator polynomial computation using Berlekamp-Massey algorithm
  * c. Error locator root finding (by far the most expensive step)
  *
@@ -66,7 +67,9 @@
  */
 
 #include <common.h>
-#include <ubi_uboot.h>
+#include <malloc.h>
+#include <errno.h>
+#include <linux/mtd/compat.h>
 
 #include <linux/bitops.h>
 #include <asm/byteorder.h>
@@ -334,10 +337,12 @@ static inline int a_ilog(struct bch_control *bch, unsigned int x)
 static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 			      unsigned int *syn)
 {
-	int i, j, s;
-	unsigned int m;
+	int j, b, s, l;
+	unsigned int m, e, eb, v;
 	uint32_t poly;
 	const int t = GF_T(bch);
+	const unsigned int n = GF_N(bch);
+	const uint16_t *tab;
 
 	s = bch->ecc_bits;
 
@@ -347,16 +352,31 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 		ecc[s/32] &= ~((1u << (32-m))-1);
 	memset(syn, 0, 2*t*sizeof(*syn));
 
-	/* compute v(a^j) for j=1 .. 2t-1 */
+	/*
+	 * compute v(a^j) for j=1 .. 2t-1, one byte at a time: if byte value v
+	 * holds the coefficients of X^b .. X^(b+7), its contribution to v(a^j)
+	 * is a^(j*b).syn_tab_j[v], where syn_tab_j[v] is precomputed
+	 */
 	do {
 		poly = *ecc++;
 		s -= 32;
-		while (poly) {
-			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
-
-			poly ^= (1 << i);
+		for (b = s; poly; b += 8, poly >>= 8) {
+			v = poly & 0xff;
+			if (!v)
+				continue;
+
+			/* bits below X^0 are cleared, so wrap b into 0..n-1 */
+			eb = (b < 0) ? b+n : b;
+			tab = bch->syn_tab + v;
+			for (j = 0, e = eb; j < t; j++, tab += 256) {
+				l = *tab;
+				if (l != 0xffff)
+					syn[2*j] ^= bch->a_pow_tab[mod_s(bch,
+								     l+e)];
+				/* e = (2j+3)*b mod n */
+				e = mod_s(bch, e+eb);
+				e = mod_s(bch, e+eb);
+			}
 		}
 	} while (s > 0);
 
@@ -993,6 +1013,11 @@ int decode_bch(struct bch_control *bch, const uint8_t *data, unsigned int len,
 	if (8*len > (bch->n-bch->ecc_bits))
 		return -EINVAL;
 
+	/* matching ecc bytes mean no error, skip loading and XORing them */
+	if (!syn && recv_ecc && calc_ecc &&
+	    !memcmp(recv_ecc, calc_ecc, BCH_ECC_BYTES(bch)))
+		return 0;
+
 	/* if caller does not provide syndromes, compute them */
 	if (!syn) {
 		if (!calc_ecc) {
@@ -1103,6 +1128,31 @@ static void build_mod8_tables(struct bch_control *bch, const uint32_t *g)
 	}
 }
 
+/*
+ * compute syndrome lookup tables: for odd j=1..2t-1 and each byte value v,
+ * the log of sum(a^(j*k)) over the bits k set in v (0xffff if the sum is 0)
+ */
+static void build_syn_tables(struct bch_control *bch)
+{
+	int i, j, k;
+	unsigned int x;
+	uint16_t *tab;
+	unsigned int sum[256];
+
+	for (i = 0; i < GF_T(bch); i++) {
+		j = 2*i+1;
+		tab = bch->syn_tab + 256*i;
+		sum[0] = 0;
+		tab[0] = 0xffff;
+		for (x = 1; x < 256; x++) {
+			/* add the lowest set bit to the sum of the others */
+			k = ffs(x)-1;
+			sum[x] = sum[x & (x-1)] ^ a_pow(bch, j*k);
+			tab[x] = sum[x] ? a_log(bch, sum[x]) : 0xffff;
+		}
+	}
+}
+
 /*
  * build a base for factoring degree 2 polynomials
  */
@@ -1295,6 +1345,7 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	bch->a_pow_tab = bch_alloc((1+bch->n)*sizeof(*bch->a_pow_tab), &err);
 	bch->a_log_tab = bch_alloc((1+bch->n)*sizeof(*bch->a_log_tab), &err);
 	bch->mod8_tab  = bch_alloc(words*1024*sizeof(*bch->mod8_tab), &err);
+	bch->syn_tab   = bch_alloc(t*256*sizeof(*bch->syn_tab), &err);
 	bch->ecc_buf   = bch_alloc(words*sizeof(*bch->ecc_buf), &err);
 	bch->ecc_buf2  = bch_alloc(words*sizeof(*bch->ecc_buf2), &err);
 	bch->xi_tab    = bch_alloc(m*sizeof(*bch->xi_tab), &err);
@@ -1320,6 +1371,8 @@ struct bch_control *init_bch(int m, int t, unsigned int prim_poly)
 	build_mod8_tables(bch, genpoly);
 	kfree(genpoly);
 
+	build_syn_tables(bch);
+
 	err = build_deg2_base(bch);
 	if (err)
 		goto fail;
@@ -1343,6 +1396,7 @@ void free_bch(struct bch_control *bch)
 		kfree(bch->a_pow_tab);
 		kfree(bch->a_log_tab);
 		kfree(bch->mod8_tab);
+		kfree(bch->syn_tab);
 		kfree(bch->ecc_buf);
 		kfree(bch->ecc_buf2);
 		kfree(bch->xi_tab);
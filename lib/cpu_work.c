@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+
+int __arch_cpu_work_start(struct cpu_work *work)
+{
+	return -1;
+}
+int arch_cpu_work_start(struct cpu_work *work)
+	__attribute__((weak, alias("__arch_cpu_work_start")));
+
+void __arch_cpu_work_wait(struct cpu_work *work)
+{
+}
+void arch_cpu_work_wait(struct cpu_work *work)
+	__attribute__((weak, alias("__arch_cpu_work_wait")));
+
+void cpu_work_start(struct cpu_work *work, void (*fn)(void *arg), void *arg)
+{
+	work->fn = fn;
+	work->arg = arg;
+	work->started = !arch_cpu_work_start(work);
+	if (!work->started)
+		fn(arg);
+}
+
+void cpu_work_wait(struct cpu_work *work)
+{
+	if (work->started) {
+		arch_cpu_work_wait(work);
+		work->started = 0;
+	}
+}
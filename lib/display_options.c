@@ -83,6 +83,22 @@ void print_size(unsigned long long size, const char *s)
 	printf (" %ciB%s", c, s);
 }
 
+/*
+ * Print a benchmark result as "name    xxx.yy unit_name": count items
+ * taken in ms milliseconds, scaled down by unit (e.g. 1024 * 1024 for MB/s)
+ */
+void print_rate(const char *name, unsigned long long count, ulong ms,
+		unsigned long long unit, const char *unit_name)
+{
+	unsigned long long rate;
+
+	/* Rate in hundredths of a unit per second */
+	rate = count * 1000 * 100 / (ms ? ms : 1);
+	rate /= unit;
+	printf("%-16s%llu.%02llu %s\n", name, rate / 100, rate % 100,
+	       unit_name);
+}
+
 /*
  * Print data buffer in hex and ascii form to the terminal.
  *
@@ -168,10 +168,29 @@ enum fdt_compat_id fdtdec_lookup(const void *blob, int node)
 	return COMPAT_UNKNOWN;
 }
 
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	int node;
+
+	if (!fdtdec_index_path(blob, path, &node))
+		return node;
+	return fdt_path_offset(blob, path);
+}
+
+int fdtdec_node_offset_by_compatible(const void *blob, int node,
+		const char *compat)
+{
+	int next;
+
+	if (!fdtdec_index_compatible(blob, node, compat, &next))
+		return next;
+	return fdt_node_offset_by_compatible(blob, node, compat);
+}
+
 int fdtdec_next_compatible(const void *blob, int node,
 		enum fdt_compat_id id)
 {
-	return fdt_node_offset_by_compatible(blob, node, compat_names[id]);
+	return fdtdec_node_offset_by_compatible(blob, node, compat_names[id]);
 }
 
 int fdtdec_next_alias(const void *blob, const char *name,
@@ -184,7 +203,7 @@ int fdtdec_next_alias(const void *blob, const char *name,
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
+	node = fdtdec_path_offset(blob, str);
 	if (node < 0)
 		return node;
 	err = fdt_node_check_compatible(blob, node, compat_names[id]);
@@ -217,7 +236,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 	int i, j;
 
 	/* find the alias node if present */
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = fdtdec_path_offset(blob, "/aliases");
 
 	/*
 	 * start with nothing, and we can assume that the root node can't
@@ -249,7 +268,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = fdtdec_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -342,6 +361,8 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
+	if (!fdtdec_index_phandle(blob, fdt32_to_cpu(*phandle), &lookup))
+		return lookup;
 	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
@@ -560,7 +581,7 @@ int fdtdec_get_config_int(const void *blob, const char *prop_name,
 	int config_node;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return default_val;
 	return fdtdec_get_int(blob, config_node, prop_name, default_val);
@@ -572,7 +593,7 @@ int fdtdec_get_config_bool(const void *blob, const char *prop_name)
 	const void *prop;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return 0;
 	prop = fdt_get_property(blob, config_node, prop_name, NULL);
@@ -587,7 +608,7 @@ char *fdtdec_get_config_string(const void *blob, const char *prop_name)
         int len;
 
         debug("%s: %s\n", __func__, prop_name);
-        nodeoffset = fdt_path_offset(blob, "/config");
+        nodeoffset = fdtdec_path_offset(blob, "/config");
         if (nodeoffset < 0)
                 return NULL;
 
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * A read-only index over the control FDT, so that fdtdec can find nodes
+ * by path, alias, phandle and compatible string without walking the tree
+ * from the root each time. It is built once, after relocation, and the
+ * FDT must not change afterwards. Lookups in any other FDT, and paths the
+ * index does not hold exactly, go to libfdt as before.
+ */
+
+#include <common.h>
+#include <libfdt.h>
+#include <fdtdec.h>
+#include <malloc.h>
+
+#define INDEX_MAX_DEPTH		32
+#define INDEX_MAX_PATH		256
+
+struct index_path {
+	const char *path;		/* NULL for an empty slot */
+	int offset;
+};
+
+struct index_phandle {
+	u32 phandle;
+	int offset;
+};
+
+struct index_compat {
+	const char *compat;		/* points into the FDT */
+	int offset;
+};
+
+struct index_alias {
+	const char *name;		/* points into the FDT */
+	const char *path;		/* points into the FDT */
+	int offset;
+};
+
+struct fdtdec_index {
+	const void *blob;
+	unsigned path_mask;		/* path hash table size - 1 */
+	struct index_path *paths;
+	int phandle_count;
+	struct index_phandle *phandles;
+	int compat_count;
+	struct index_compat *compats;
+	int alias_count;
+	struct index_alias *aliases;
+};
+
+/* Read before relocation, when BSS is not yet usable */
+static struct fdtdec_index *control_index __attribute__((section(".data")));
+
+static struct fdtdec_index *get_index(const void *blob)
+{
+	struct fdtdec_index *idx = control_index;
+
+	return idx && idx->blob == blob ? idx : NULL;
+}
+
+static unsigned hash_path(const char *path, int len)
+{
+	unsigned hash = 2166136261u;
+
+	while (len--)
+		hash = (hash ^ (u8)*path++) * 16777619;
+	return hash;
+}
+
+/* Find the slot holding a path, or the empty slot where it would go */
+static struct index_path *find_path(struct fdtdec_index *idx,
+				    const char *path, int len)
+{
+	unsigned i = hash_path(path, len) & idx->path_mask;
+	struct index_path *slot;
+
+	for (;; i = (i + 1) & idx->path_mask) {
+		slot = &idx->paths[i];
+		if (!slot->path || (!strncmp(slot->path, path, len) &&
+				    slot->path[len] == '\0'))
+			return slot;
+	}
+}
+
+static int compare_phandle(const void *a, const void *b)
+{
+	const struct index_phandle *pa = a, *pb = b;
+
+	if (pa->phandle != pb->phandle)
+		return pa->phandle < pb->phandle ? -1 : 1;
+	return pa->offset - pb->offset;
+}
+
+static int compare_compat(const void *a, const void *b)
+{
+	const struct index_compat *ca = a, *cb = b;
+	int ret;
+
+	ret = strcmp(ca->compat, cb->compat);
+	return ret ? ret : ca->offset - cb->offset;
+}
+
+struct index_counts {
+	int nodes;
+	int path_bytes;
+	int phandles;
+	int compats;
+	int aliases;
+};
+
+/*
+ * Walk the tree once. With idx NULL, just count what the index will hold;
+ * otherwise fill it in, copying paths to pool.
+ *
+ * @return 0 if ok, -1 if the tree is too deep or a path too long
+ */
+static int walk_nodes(const void *blob, struct index_counts *count,
+		      struct fdtdec_index *idx, char *pool)
+{
+	char path[INDEX_MAX_PATH];
+	int path_len[INDEX_MAX_DEPTH];
+	int offset, depth;
+
+	memset(count, '\0', sizeof(*count));
+	for (offset = 0, depth = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		const char *name, *compat;
+		int len, pos, compat_len;
+		u32 phandle;
+
+		if (depth >= INDEX_MAX_DEPTH)
+			return -1;
+
+		/* A node's path is its parent's plus its own name */
+		if (depth == 0) {
+			path[0] = '/';
+			pos = 1;
+		} else {
+			name = fdt_get_name(blob, offset, &len);
+			if (!name)
+				return -1;
+			pos = path_len[depth - 1];
+			if (pos + len + 2 > sizeof(path))
+				return -1;
+			if (pos > 1)
+				path[pos++] = '/';
+			memcpy(path + pos, name, len);
+			pos += len;
+		}
+		path[pos] = '\0';
+		path_len[depth] = pos;
+
+		if (idx) {
+			struct index_path *slot = find_path(idx, path, pos);
+
+			if (!slot->path) {
+				memcpy(pool + count->path_bytes, path, pos + 1);
+				slot->path = pool + count->path_bytes;
+				slot->offset = offset;
+			}
+		}
+		count->path_bytes += pos + 1;
+		count->nodes++;
+
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle) {
+			if (idx) {
+				idx->phandles[count->phandles].phandle =
+					phandle;
+				idx->phandles[count->phandles].offset = offset;
+			}
+			count->phandles++;
+		}
+
+		compat = fdt_getprop(blob, offset, "compatible", &compat_len);
+		while (compat && compat_len > 0) {
+			int slen = strnlen(compat, compat_len) + 1;
+
+			if (idx) {
+				idx->compats[count->compats].compat = compat;
+				idx->compats[count->compats].offset = offset;
+			}
+			count->compats++;
+			compat += slen;
+			compat_len -= slen;
+		}
+	}
+
+	return 0;
+}
+
+/* Record the aliases, with the nodes they refer to */
+static int walk_aliases(const void *blob, struct fdtdec_index *idx)
+{
+	int alias_node, offset, count = 0;
+
+	alias_node = fdt_path_offset(blob, "/aliases");
+	if (alias_node < 0)
+		return 0;
+
+	for (offset = fdt_first_property_offset(blob, alias_node);
+	     offset >= 0;
+	     offset = fdt_next_property_offset(blob, offset)) {
+		const struct fdt_property *prop;
+		struct index_alias *alias;
+		struct index_path *slot;
+
+		prop = fdt_get_property_by_offset(blob, offset, NULL);
+		if (!prop || !prop->len)
+			continue;
+		if (idx) {
+			alias = &idx->aliases[count];
+			alias->name = fdt_string(blob,
+						 fdt32_to_cpu(prop->nameoff));
+			alias->path = prop->data;
+			slot = find_path(idx, alias->path, strlen(alias->path));
+			alias->offset = slot->path ? slot->offset :
+				fdt_path_offset(blob, alias->path);
+		}
+		count++;
+	}
+
+	return count;
+}
+
+int fdtdec_index_init(const void *blob)
+{
+	struct index_counts count;
+	struct fdtdec_index *idx;
+	unsigned slots;
+	size_t size;
+	char *pool;
+
+	free(control_index);
+	control_index = NULL;
+
+	if (walk_nodes(blob, &count, NULL, NULL)) {
+		debug("%s: tree too deep to index\n", __func__);
+		return -1;
+	}
+	count.aliases = walk_aliases(blob, NULL);
+
+	/* Keep the hash table at most half full */
+	for (slots = 1; slots < count.nodes * 2; slots <<= 1)
+		;
+	size = sizeof(*idx) + slots * sizeof(struct index_path) +
+		count.phandles * sizeof(struct index_phandle) +
+		count.compats * sizeof(struct index_compat) +
+		count.aliases * sizeof(struct index_alias) +
+		count.path_bytes;
+	idx = malloc(size);
+	if (!idx) {
+		debug("%s: cannot allocate %zu bytes\n", __func__, size);
+		return -1;
+	}
+	memset(idx, '\0', size);
+
+	idx->blob = blob;
+	idx->path_mask = slots - 1;
+	idx->paths = (struct index_path *)(idx + 1);
+	idx->phandles = (struct index_phandle *)(idx->paths + slots);
+	idx->compats = (struct index_compat *)
+		(idx->phandles + count.phandles);
+	idx->aliases = (struct index_alias *)(idx->compats + count.compats);
+	pool = (char *)(idx->aliases + count.aliases);
+
+	walk_nodes(blob, &count, idx, pool);
+	idx->phandle_count = count.phandles;
+	idx->compat_count = count.compats;
+	qsort(idx->phandles, idx->phandle_count, sizeof(struct index_phandle),
+	      compare_phandle);
+	qsort(idx->compats, idx->compat_count, sizeof(struct index_compat),
+	      compare_compat);
+	idx->alias_count = walk_aliases(blob, idx);
+
+	debug("%s: %d nodes, %d phandles, %d compatible strings, "
+	      "%d aliases, %zu bytes\n", __func__, count.nodes,
+	      idx->phandle_count, idx->compat_count, idx->alias_count, size);
+	control_index = idx;
+
+	return 0;
+}
+
+int fdtdec_index_path(const void *blob, const char *path, int *nodep)
+{
+	struct fdtdec_index *idx = get_index(blob);
+	char buf[INDEX_MAX_PATH];
+	struct index_path *slot;
+	int len;
+
+	if (!idx)
+		return -1;
+
+	/* An alias, perhaps followed by a path below it */
+	if (*path != '/') {
+		const char *rest = strchr(path, '/');
+		int namelen = rest ? rest - path : strlen(path);
+		struct index_alias *alias = NULL;
+		int i;
+
+		for (i = 0; i < idx->alias_count; i++) {
+			if (!strncmp(idx->aliases[i].name, path, namelen) &&
+			    idx->aliases[i].name[namelen] == '\0') {
+				alias = &idx->aliases[i];
+				break;
+			}
+		}
+		if (!alias || alias->offset < 0)
+			return -1;
+		if (!rest) {
+			*nodep = alias->offset;
+			return 0;
+		}
+		if (strlen(alias->path) + strlen(rest) >= sizeof(buf))
+			return -1;
+		strcpy(buf, alias->path);
+		strcat(buf, rest);
+		path = buf;
+	}
+
+	len = strlen(path);
+	slot = find_path(idx, path, len);
+	if (!slot->path)
+		return -1;
+	*nodep = slot->offset;
+
+	return 0;
+}
+
+int fdtdec_index_compatible(const void *blob, int node, const char *compat,
+			    int *nodep)
+{
+	struct fdtdec_index *idx = get_index(blob);
+	int lo, hi;
+
+	if (!idx)
+		return -1;
+
+	/* Find the first entry after (compat, node) */
+	lo = 0;
+	hi = idx->compat_count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		struct index_compat *entry = &idx->compats[mid];
+		int ret = strcmp(entry->compat, compat);
+
+		if (ret < 0 || (ret == 0 && entry->offset <= node))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < idx->compat_count && !strcmp(idx->compats[lo].compat, compat))
+		*nodep = idx->compats[lo].offset;
+	else
+		*nodep = -FDT_ERR_NOTFOUND;
+
+	return 0;
+}
+
+int fdtdec_index_phandle(const void *blob, u32 phandle, int *nodep)
+{
+	struct fdtdec_index *idx = get_index(blob);
+	int lo, hi;
+
+	/* libfdt has its own error for these */
+	if (!idx || phandle == 0 || phandle == -1)
+		return -1;
+
+	lo = 0;
+	hi = idx->phandle_count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (idx->phandles[mid].phandle < phandle)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < idx->phandle_count && idx->phandles[lo].phandle == phandle)
+		*nodep = idx->phandles[lo].offset;
+	else
+		*nodep = -FDT_ERR_NOTFOUND;
+
+	return 0;
+}
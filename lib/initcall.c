@@ -28,14 +28,159 @@
 
 #include <common.h>
 #include <initcall.h>
+#include <malloc.h>
+
+#ifdef CONFIG_INITCALL_PROFILE
+DECLARE_GLOBAL_DATA_PTR;
+
+#ifndef CONFIG_INITCALL_PROFILE_COUNT
+#define CONFIG_INITCALL_PROFILE_COUNT	128
+#endif
+
+#ifndef CONFIG_INITCALL_PROFILE_MIN_US
+#define CONFIG_INITCALL_PROFILE_MIN_US	1000
+#endif
+
+struct initcall_record {
+	ulong func;		/* link-time address of the function */
+	ulong start_us;		/* when it was called */
+	ulong time_us;		/* how long it took */
+	int seq;		/* which init sequence it is in */
+};
+
+/* These are written before relocation, when BSS is not yet usable */
+static struct initcall_record record[CONFIG_INITCALL_PROFILE_COUNT]
+	__attribute__((section(".data")));
+static int record_count __attribute__((section(".data")));
+static int seq_count __attribute__((section(".data")));
+
+static const char *initcall_name(ulong func)
+{
+#ifdef CONFIG_KALLSYMS
+	ulong base;
+	const char *name;
+
+	name = symbol_lookup(func, &base);
+	if (name && base == func)
+		return name;
+#endif
+	return NULL;
+}
+
+static int initcall_call(init_fnc_t func, int seq)
+{
+	struct initcall_record *rec = NULL;
+	ulong start, end;
+	const char *name;
+	int ret;
+
+	start = timer_get_boot_us();
+	ret = func();
+	end = timer_get_boot_us();
+
+	if (record_count < CONFIG_INITCALL_PROFILE_COUNT)
+		rec = &record[record_count];
+	record_count++;
+	if (!rec)
+		return ret;
+
+	rec->func = (ulong)func;
+#ifndef CONFIG_SANDBOX
+	/* Keep the link-time address, which kallsyms and System.map use */
+	if (gd->flags & GD_FLG_RELOC)
+		rec->func -= gd->reloc_off;
+#endif
+	rec->start_us = start;
+	rec->time_us = end - start;
+	rec->seq = seq;
+
+	/* Show the slow ones in the bootstage report too */
+	if (rec->time_us >= CONFIG_INITCALL_PROFILE_MIN_US) {
+		name = initcall_name(rec->func);
+		bootstage_mark_name(BOOTSTAGE_ID_ALLOC, name ? name :
+				    "initcall");
+	}
+
+	return ret;
+}
+
+static void print_record(struct initcall_record *rec, ulong cumulative)
+{
+	const char *name = initcall_name(rec->func);
+
+	printf("%3d %10lu %10lu %10lu  ", rec->seq, rec->start_us,
+	       rec->time_us, cumulative);
+	if (name)
+		printf("%s\n", name);
+	else
+		printf("%08lx\n", rec->func);
+}
+
+static int h_compare_record(const void *r1, const void *r2)
+{
+	const struct initcall_record *rec1 = r1, *rec2 = r2;
+
+	if (rec1->time_us == rec2->time_us)
+		return rec1->start_us > rec2->start_us ? 1 : -1;
+	return rec1->time_us < rec2->time_us ? 1 : -1;
+}
+
+void initcall_report(int sort)
+{
+	struct initcall_record *rec, *sorted = NULL;
+	int count = min(record_count, CONFIG_INITCALL_PROFILE_COUNT);
+	ulong cumulative = 0;
+	int i, seq = -1;
+
+	if (sort) {
+		sorted = malloc(count * sizeof(*rec));
+		if (!sorted) {
+			puts("Not enough memory to sort\n");
+			return;
+		}
+		memcpy(sorted, record, count * sizeof(*rec));
+		qsort(sorted, count, sizeof(*rec), h_compare_record);
+	}
+
+	puts("Init function timings in microseconds:\n");
+	printf("%3s %10s %10s %10s  %s\n", "Seq", "Start", "Time",
+	       sort ? "Total" : "Seq total", "Function");
+	for (i = 0, rec = sorted ? sorted : record; i < count; i++, rec++) {
+		if (!sort && rec->seq != seq) {
+			seq = rec->seq;
+			cumulative = 0;
+		}
+		cumulative += rec->time_us;
+		print_record(rec, cumulative);
+	}
+	if (record_count > count)
+		printf("(%d more not recorded - please increase "
+		       "CONFIG_INITCALL_PROFILE_COUNT)\n", record_count - count);
+#ifndef CONFIG_KALLSYMS
+	puts("Look up function addresses in System.map\n");
+#endif
+
+	free(sorted);
+}
+#endif /* CONFIG_INITCALL_PROFILE */
 
 int initcall_run_list(init_fnc_t init_sequence[])
 {
 	init_fnc_t *init_fnc_ptr;
+#ifdef CONFIG_INITCALL_PROFILE
+	int seq = seq_count++;
+#endif
 
 	for (init_fnc_ptr = init_sequence; *init_fnc_ptr; ++init_fnc_ptr) {
+		/* Let deferred steps move on between init functions */
+		initcall_defer_poll();
+#ifdef CONFIG_INITCALL_PROFILE
+		if (initcall_call(*init_fnc_ptr, seq))
+			return -1;
+#else
 		if ((*init_fnc_ptr)())
 			return -1;
+#endif
 	}
 	return 0;
 }
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Deferred init steps. Drivers which spend most of their init time
+ * waiting for hardware (card power-up, bus enumeration, panel sequencing)
+ * can split that into start() and poll() and add themselves here. The
+ * steps are then polled in turn, between the functions of the init
+ * sequence and from initcall_defer_mdelay(), so that their waits overlap
+ * instead of adding up. Before main_loop() the board waits for them all.
+ *
+ * Everything runs on the boot CPU; there is no preemption, so a step's
+ * start() and poll() are never called while another is running.
+ */
+
+#include <common.h>
+#include <initcall.h>
+#include <watchdog.h>
+
+enum {
+	STEP_WAITING,		/* something it depends on is not done */
+	STEP_RUNNING,		/* started, waiting to be polled */
+	STEP_DONE,
+};
+
+/* initcall_run_list() polls before relocation, when BSS is not usable */
+static struct initcall_defer *step_list __attribute__((section(".data")));
+static unsigned added_mask __attribute__((section(".data")));
+static unsigned done_mask __attribute__((section(".data")));
+static unsigned failed_mask __attribute__((section(".data")));
+static int polling __attribute__((section(".data")));
+
+static void step_finish(struct initcall_defer *step, int err)
+{
+	unsigned mask = INITCALL_DEFER_MASK(step->id);
+
+	step->state = STEP_DONE;
+	step->err = err;
+	done_mask |= mask;
+	if (err) {
+		failed_mask |= mask;
+		printf("%s: init failed (err=%d)\n", step->name, err);
+	}
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, step->name);
+}
+
+static void step_call(struct initcall_defer *step, int (*func)(void))
+{
+	int ret;
+
+	ret = func ? func() : 0;
+	if (ret == INITCALL_PENDING)
+		step->state = STEP_RUNNING;
+	else
+		step_finish(step, ret);
+}
+
+/*
+ * Start or poll each step once.
+ *
+ * @param progressp	Set to 1 if any step was started or is running
+ * @return number of steps not yet finished
+ */
+static int poll_steps(int *progressp)
+{
+	struct initcall_defer *step;
+	int pending = 0;
+
+	*progressp = 0;
+	for (step = step_list; step; step = step->next) {
+		if (step->state == STEP_WAITING) {
+			if (step->depends & failed_mask) {
+				debug("%s: skipped, a dependency failed\n",
+				      step->name);
+				step_finish(step, -1);
+			} else if ((step->depends & done_mask) ==
+					step->depends) {
+				*progressp = 1;
+				step_call(step, step->start);
+			}
+		} else if (step->state == STEP_RUNNING) {
+			*progressp = 1;
+			step_call(step, step->poll);
+		}
+		if (step->state != STEP_DONE)
+			pending++;
+	}
+
+	return pending;
+}
+
+int initcall_defer_poll(void)
+{
+	struct initcall_defer *step;
+	int progress, pending = 0;
+
+	if (!polling) {
+		polling = 1;
+		pending = poll_steps(&progress);
+		polling = 0;
+	} else {
+		for (step = step_list; step; step = step->next)
+			if (step->state != STEP_DONE)
+				pending++;
+	}
+
+	return pending;
+}
+
+int initcall_defer(struct initcall_defer *step)
+{
+	struct initcall_defer **nextp;
+	unsigned mask = INITCALL_DEFER_MASK(step->id);
+
+	if (added_mask & mask) {
+		printf("%s: init step %d already added\n", step->name,
+		       step->id);
+		return -1;
+	}
+	added_mask |= mask;
+
+	/* Keep them in the order added, so earlier steps start first */
+	for (nextp = &step_list; *nextp; nextp = &(*nextp)->next)
+		;
+	step->state = STEP_WAITING;
+	step->err = 0;
+	step->next = NULL;
+	*nextp = step;
+	initcall_defer_poll();
+
+	return 0;
+}
+
+int initcall_defer_wait(unsigned mask)
+{
+	struct initcall_defer *step;
+	int progress;
+
+	/* Steps that were never added are not waited for */
+	mask &= added_mask;
+	while ((done_mask & mask) != mask) {
+		WATCHDOG_RESET();
+		if (polling) {
+			debug("%s: cannot wait from inside a step\n", __func__);
+			return -1;
+		}
+		polling = 1;
+		poll_steps(&progress);
+		polling = 0;
+		if (progress)
+			continue;
+
+		/* Nothing is running, so the rest depend on steps never added */
+		for (step = step_list; step; step = step->next) {
+			if (step->state == STEP_WAITING) {
+				debug("%s: waiting on steps %#x, never added\n",
+				      step->name, step->depends & ~added_mask);
+				step_finish(step, -1);
+			}
+		}
+	}
+
+	return failed_mask & mask ? -1 : 0;
+}
+
+void initcall_defer_mdelay(unsigned long msec)
+{
+	ulong start = get_timer(0), elapsed;
+
+	while (initcall_defer_poll()) {
+		if (get_timer(start) >= msec)
+			return;
+	}
+	elapsed = get_timer(start);
+	if (elapsed < msec)
+		mdelay(msec - elapsed);
+}
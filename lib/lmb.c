@@ -12,6 +12,7 @@
 
 #include <common.h>
 #include <lmb.h>
+#include <malloc.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
@@ -44,133 +45,114 @@ void lmb_dump_all(struct lmb *lmb)
 #endif /* DEBUG */
 }
 
-static long lmb_addrs_overlap(phys_addr_t base1,
-		phys_size_t size1, phys_addr_t base2, phys_size_t size2)
+/*
+ * Find the first region which ends after addr, or which ends at addr too
+ * if touching is set. Since regions do not overlap, their ends are sorted
+ * like their bases.
+ *
+ * @return region index, or rgn->cnt if there is none
+ */
+static unsigned long lmb_find(struct lmb_region *rgn, phys_addr_t addr,
+			      int touching)
 {
-	return ((base1 < (base2+size2)) && (base2 < (base1+size1)));
-}
+	unsigned long lo = 0, hi = rgn->cnt;
 
-static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
-		phys_addr_t base2, phys_size_t size2)
-{
-	if (base2 == base1 + size1)
-		return 1;
-	else if (base1 == base2 + size2)
-		return -1;
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+		phys_addr_t end = rgn->region[mid].base +
+			rgn->region[mid].size;
 
-	return 0;
+		if (end < addr || (end == addr && !touching))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static void lmb_init_region(struct lmb_region *rgn)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
-
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	rgn->cnt = 0;
+	rgn->max = MAX_LMB_REGIONS;
+	rgn->size = 0;
+	rgn->region = rgn->initial;
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+void lmb_init(struct lmb *lmb)
 {
-	unsigned long i;
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
+}
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-	}
-	rgn->cnt--;
+static void lmb_release_region(struct lmb_region *rgn)
+{
+	if (rgn->region && rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = NULL;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+void lmb_release(struct lmb *lmb)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	lmb_release_region(&lmb->memory);
+	lmb_release_region(&lmb->reserved);
 }
 
-void lmb_init(struct lmb *lmb)
+static int lmb_grow_region(struct lmb_region *rgn)
 {
-	/* Create a dummy zero size LMB which will get coalesced away later.
-	 * This simplifies the lmb_add() code below...
-	 */
-	lmb->memory.region[0].base = 0;
-	lmb->memory.region[0].size = 0;
-	lmb->memory.cnt = 1;
-	lmb->memory.size = 0;
-
-	/* Ditto. */
-	lmb->reserved.region[0].base = 0;
-	lmb->reserved.region[0].size = 0;
-	lmb->reserved.cnt = 1;
-	lmb->reserved.size = 0;
+	struct lmb_property *region;
+	unsigned long max = rgn->max * 2;
+
+	region = malloc(max * sizeof(*region));
+	if (!region) {
+		printf("ERROR: No memory for %lu LMB regions\n", max);
+		return -1;
+	}
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+
+	return 0;
 }
 
 /* This routine called with relocation disabled. */
 static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
+	phys_addr_t end = base + size;
+	phys_size_t merged_size = 0;
+	unsigned long first, last;
 
-	if ((rgn->cnt == 1) && (rgn->region[0].size == 0)) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
+	if (!size)
 		return 0;
-	}
-
-	/* First try and coalesce this LMB with another. */
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-
-		if ((rgnbase == base) && (rgnsize == size))
-			/* Already have this region, so we're done */
-			return 0;
-
-		adjacent = lmb_addrs_adjacent(base,size,rgnbase,rgnsize);
-		if ( adjacent > 0 ) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-		else if ( adjacent < 0 ) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-	}
 
-	if ((i < rgn->cnt-1) && lmb_regions_adjacent(rgn, i, i+1) ) {
-		lmb_coalesce_regions(rgn, i, i+1);
-		coalesced++;
-	}
+	/* Take in any regions which overlap or touch this one */
+	first = lmb_find(rgn, base, 1);
+	for (last = first; last < rgn->cnt && rgn->region[last].base <= end;
+	     last++) {
+		phys_addr_t rgnbase = rgn->region[last].base;
+		phys_addr_t rgnend = rgnbase + rgn->region[last].size;
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
-		return -1;
-
-	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i+1].base = rgn->region[i].base;
-			rgn->region[i+1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i+1].base = base;
-			rgn->region[i+1].size = size;
-			break;
-		}
+		base = min(base, rgnbase);
+		end = max(end, rgnend);
+		merged_size += rgn->region[last].size;
 	}
 
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
+	if (first == last) {
+		if (rgn->cnt == rgn->max && lmb_grow_region(rgn))
+			return -1;
+		memmove(&rgn->region[first + 1], &rgn->region[first],
+			(rgn->cnt - first) * sizeof(rgn->region[0]));
+		rgn->cnt++;
+	} else {
+		memmove(&rgn->region[first + 1], &rgn->region[last],
+			(rgn->cnt - last) * sizeof(rgn->region[0]));
+		rgn->cnt -= last - first - 1;
 	}
-
-	rgn->cnt++;
+	rgn->region[first].base = base;
+	rgn->region[first].size = end - base;
+	rgn->size += end - base - merged_size;
 
 	return 0;
 }
@@ -188,26 +170,26 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i=0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_find(rgn, base, 0);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (rgnbegin > base || end > rgnend)
 		return -1;
 
+	rgn->size -= size;
+
 	/* Check to see if we are removing entire region */
 	if ((rgnbegin == base) && (rgnend == end)) {
-		lmb_remove_region(rgn, i);
+		memmove(&rgn->region[i], &rgn->region[i + 1],
+			(rgn->cnt - i - 1) * sizeof(rgn->region[0]));
+		rgn->cnt--;
 		return 0;
 	}
 
@@ -229,6 +211,7 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	 * beginging of the hole and add the region after hole.
 	 */
 	rgn->region[i].size = base - rgn->region[i].base;
+	rgn->size -= rgnend - end;
 	return lmb_add_region(rgn, end, rgnend - end);
 }
 
@@ -244,15 +227,11 @@ long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 {
 	unsigned long i;
 
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if ( lmb_addrs_overlap(base,size,rgnbase,rgnsize) ) {
-			break;
-		}
-	}
+	i = lmb_find(rgn, base, 0);
+	if (i < rgn->cnt && size && rgn->region[i].base < base + size)
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -283,25 +262,37 @@ static phys_addr_t lmb_align_up(phys_addr_t addr, ulong size)
 	return (addr + (size - 1)) & ~(size - 1);
 }
 
+/*
+ * Work out the top of the space to allocate from in a memory region.
+ *
+ * @return 0 if the region is too small or entirely above max_addr
+ */
+static phys_addr_t lmb_alloc_top(struct lmb_property *mem, phys_size_t size,
+				 phys_addr_t max_addr)
+{
+	if (mem->size < size)
+		return 0;
+	if (max_addr == LMB_ALLOC_ANYWHERE)
+		return mem->base + mem->size;
+	if (mem->base < max_addr)
+		return min(mem->base + mem->size, max_addr);
+
+	return 0;
+}
+
 phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phys_addr_t max_addr)
 {
 	long i, j;
 	phys_addr_t base = 0;
-	phys_addr_t res_base;
+	phys_addr_t res_base, top;
 
 	for (i = lmb->memory.cnt-1; i >= 0; i--) {
 		phys_addr_t lmbbase = lmb->memory.region[i].base;
-		phys_size_t lmbsize = lmb->memory.region[i].size;
 
-		if (lmbsize < size)
-			continue;
-		if (max_addr == LMB_ALLOC_ANYWHERE)
-			base = lmb_align_down(lmbbase + lmbsize - size, align);
-		else if (lmbbase < max_addr) {
-			base = min(lmbbase + lmbsize, max_addr);
-			base = lmb_align_down(base - size, align);
-		} else
+		top = lmb_alloc_top(&lmb->memory.region[i], size, max_addr);
+		if (top < size)
 			continue;
+		base = lmb_align_down(top - size, align);
 
 		while (base && lmbbase <= base) {
 			j = lmb_overlaps_region(&lmb->reserved, base, size);
@@ -322,17 +313,58 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 	return 0;
 }
 
-int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
+/*
+ * Like __lmb_alloc_base(), but use the smallest free gap that will hold
+ * the allocation, taking from the top of it. This leaves large gaps for
+ * large allocations later.
+ */
+phys_addr_t lmb_alloc_best_fit(struct lmb *lmb, phys_size_t size,
+			       ulong align, phys_addr_t max_addr)
 {
-	int i;
+	struct lmb_region *res = &lmb->reserved;
+	phys_addr_t best = 0, best_gap = 0;
+	unsigned long i, j;
+
+	for (i = 0; i < lmb->memory.cnt; i++) {
+		phys_addr_t gap_start = lmb->memory.region[i].base;
+		phys_addr_t top, gap_end, base;
+
+		top = lmb_alloc_top(&lmb->memory.region[i], size, max_addr);
+		if (top < size)
+			continue;
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
+		/* Walk the free gaps between reserved regions up to top */
+		j = lmb_find(res, gap_start, 0);
+		while (gap_start < top) {
+			if (j < res->cnt && res->region[j].base < top)
+				gap_end = max(res->region[j].base, gap_start);
+			else
+				gap_end = top;
+
+			base = gap_end >= size ?
+				lmb_align_down(gap_end - size, align) : 0;
+			if (base && base >= gap_start &&
+			    (!best || gap_end - gap_start <= best_gap)) {
+				best = base;
+				best_gap = gap_end - gap_start;
+			}
+
+			if (gap_end == top)
+				break;
+			gap_start = res->region[j].base + res->region[j].size;
+			j++;
+		}
 	}
-	return 0;
+
+	if (best && lmb_add_region(res, best, lmb_align_up(size, align)) < 0)
+		return 0;
+
+	return best;
+}
+
+int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
+{
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
 }
 
 void __board_lmb_reserve(struct lmb *lmb)
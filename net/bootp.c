@@ -31,6 +31,10 @@
 #define PORT_BOOTPS	67		/* BOOTP server UDP port		*/
 #define PORT_BOOTPC	68		/* BOOTP client UDP port		*/
 
+#ifndef CONFIG_BOOTP_LEASE_TIMEOUT	/* ms to wait for an INIT-REBOOT ACK	*/
+#define CONFIG_BOOTP_LEASE_TIMEOUT 1000UL
+#endif
+
 #ifndef CONFIG_DHCP_MIN_EXT_LEN		/* minimal length of extension list	*/
 #define CONFIG_DHCP_MIN_EXT_LEN 64
 #endif
@@ -330,6 +334,20 @@ BootpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 }
 #endif
 
+/*
+ *	Bootp ID is the lower 4 bytes of our ethernet address
+ *	plus the current time in ms.
+ */
+static void BootpNewID(void)
+{
+	BootpID = ((ulong)NetOurEther[2] << 24)
+		| ((ulong)NetOurEther[3] << 16)
+		| ((ulong)NetOurEther[4] << 8)
+		| (ulong)NetOurEther[5];
+	BootpID += get_timer(0);
+	BootpID	 = htonl(BootpID);
+}
+
 /*
  *	Timeout on BOOTP/DHCP request.
  */
@@ -691,16 +709,7 @@ BootpRequest (void)
 	ext_len = BootpExtended((u8 *)bp->bp_vend);
 #endif
 
-	/*
-	 *	Bootp ID is the lower 4 bytes of our ethernet address
-	 *	plus the current time in ms.
-	 */
-	BootpID = ((ulong)NetOurEther[2] << 24)
-		| ((ulong)NetOurEther[3] << 16)
-		| ((ulong)NetOurEther[4] << 8)
-		| (ulong)NetOurEther[5];
-	BootpID += get_timer(0);
-	BootpID	 = htonl(BootpID);
+	BootpNewID();
 	NetCopyLong(&bp->bp_id, &BootpID);
 
 	/*
@@ -837,14 +846,13 @@ static int DhcpMessageType(unsigned char *popt)
 	return -1;
 }
 
-static void DhcpSendRequestPkt(Bootp_t *bp_offer)
+static void DhcpSendRequest(ulong *id, IPaddr_t ServerID, IPaddr_t RequestedIP)
 {
 	volatile uchar *pkt, *iphdr;
 	Bootp_t *bp;
 	int pktlen, iplen, extlen;
-	IPaddr_t OfferedIP;
 
-	debug("DhcpSendRequestPkt: Sending DHCPREQUEST\n");
+	debug("DhcpSendRequest: Sending DHCPREQUEST\n");
 	pkt = NetTxPacket;
 	memset ((void*)pkt, 0, PKTSIZE);
 
@@ -870,19 +878,9 @@ static void DhcpSendRequestPkt(Bootp_t *bp_offer)
 
 	memcpy (bp->bp_chaddr, NetOurEther, 6);
 
-	/*
-	 * ID is the id of the OFFER packet
-	 */
-
-	NetCopyLong(&bp->bp_id, &bp_offer->bp_id);
+	NetCopyLong(&bp->bp_id, id);
 
-	/*
-	 * Copy options from OFFER packet if present
-	 */
-
-	/* Copy offered IP into the parameters request list */
-	NetCopyIP(&OfferedIP, &bp_offer->bp_yiaddr);
-	extlen = DhcpExtended((u8 *)bp->bp_vend, DHCP_REQUEST, NetDHCPServerIP, OfferedIP);
+	extlen = DhcpExtended((u8 *)bp->bp_vend, DHCP_REQUEST, ServerID, RequestedIP);
 
 	pktlen = ((int)(pkt-NetTxPacket)) + BOOTP_HDR_SIZE - sizeof(bp->bp_vend) + extlen;
 	iplen = BOOTP_HDR_SIZE - sizeof(bp->bp_vend) + extlen;
@@ -895,6 +893,127 @@ static void DhcpSendRequestPkt(Bootp_t *bp_offer)
 	NetSendPacket(NetTxPacket, pktlen);
 }
 
+static void DhcpSendRequestPkt(Bootp_t *bp_offer)
+{
+	IPaddr_t OfferedIP;
+
+	/* Copy offered IP into the parameters request list */
+	NetCopyIP(&OfferedIP, &bp_offer->bp_yiaddr);
+
+	/*
+	 * ID is the id of the OFFER packet
+	 */
+	DhcpSendRequest(&bp_offer->bp_id, NetDHCPServerIP, OfferedIP);
+}
+
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+/*
+ * Start resolving the MAC addresses of the gateway and, if it is on our
+ * subnet, the server while the DHCPREQUEST is still outstanding. An ARP
+ * request for a server beyond the gateway would go unanswered.
+ */
+static void DhcpPrefetchServer(IPaddr_t OurIP, IPaddr_t ServerIP,
+			       IPaddr_t Mask, IPaddr_t Gateway)
+{
+	ArpPrefetch(Gateway);
+	if (!Gateway || (ServerIP & Mask) == (OurIP & Mask))
+		ArpPrefetch(ServerIP);
+}
+
+/*
+ * Return an IP address option from a DHCP packet of len bytes, or 0 if it
+ * has none. Only the options within the packet as received are looked at.
+ */
+static IPaddr_t DhcpGetIPOption(Bootp_t *bp, unsigned len, uchar code)
+{
+	uchar *popt = (uchar *)&bp->bp_vend[4];
+	uchar *end = (uchar *)&bp->bp_vend[OPT_SIZE];
+	IPaddr_t ip;
+
+	if ((uchar *)bp + len < end)
+		end = (uchar *)bp + len;
+	if (popt > end ||
+	    NetReadLong((ulong *)&bp->bp_vend[0]) != htonl(BOOTP_VENDOR_MAGIC))
+		return 0;
+
+	while (popt < end && *popt != 0xff) {
+		if (*popt == 0) {
+			popt++;
+			continue;
+		}
+		/* The length byte, and the data it gives, must be there */
+		if (popt + 1 >= end || popt + 2 + popt[1] > end)
+			break;
+		if (*popt == code && popt[1] >= 4) {
+			NetCopyIP(&ip, popt + 2);
+			return ip;
+		}
+		popt += popt[1] + 2;
+	}
+
+	return 0;
+}
+#endif
+
+static void DhcpBound(Bootp_t *bp)
+{
+#ifdef CONFIG_BOOTP_LEASE_CACHE
+	char tmp[22];
+#endif
+
+	if (NetReadLong((ulong*)&bp->bp_vend[0]) == htonl(BOOTP_VENDOR_MAGIC))
+		DhcpOptionsProcess((u8 *)&bp->bp_vend[4], bp);
+	BootpCopyNetParams(bp); /* Store net params from reply */
+	dhcp_state = BOUND;
+	printf ("DHCP client bound to address %pI4\n", &NetOurIP);
+#ifdef CONFIG_BOOTP_LEASE_CACHE
+	ip_to_string(NetOurIP, tmp);
+	setenv("dhcpleaseip", tmp);
+#endif
+	bootstage_mark_name(BOOTSTAGE_ID_BOOTP_STOP, "bootp_stop");
+
+	net_auto_load();
+}
+
+#ifdef CONFIG_BOOTP_LEASE_CACHE
+/*
+ *	Timeout on an INIT-REBOOT request: the server didn't answer for
+ *	our old lease, so fall back to a full DISCOVER.
+ */
+static void DhcpLeaseTimeout(void)
+{
+	puts("DHCP lease not confirmed, discovering\n");
+	BootpRequest();
+}
+
+/*
+ * Ask the server to confirm the address saved in "dhcpleaseip" by a
+ * previous boot (RFC 2131 INIT-REBOOT), skipping DISCOVER and OFFER.
+ * Returns 0 if no lease is known and nothing was sent.
+ */
+static int DhcpLeaseRequest(void)
+{
+	IPaddr_t LeaseIP = getenv_IPaddr("dhcpleaseip");
+
+	if (LeaseIP == 0)
+		return 0;
+
+	printf("DHCP requesting lease %pI4\n", &LeaseIP);
+	BootpNewID();
+	dhcp_state = REBOOTING;
+	NetSetHandler(DhcpHandler);
+	NetSetTimeout(CONFIG_BOOTP_LEASE_TIMEOUT, DhcpLeaseTimeout);
+	DhcpSendRequest(&BootpID, 0, LeaseIP);
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+	/* NetInitLoop() loaded the server and gateway of the last lease */
+	DhcpPrefetchServer(LeaseIP, NetServerIP, NetOurSubnetMask,
+			   NetOurGatewayIP);
+#endif
+
+	return 1;
+}
+#endif
+
 /*
  *	Handle DHCP received packets.
  */
@@ -936,6 +1055,21 @@ DhcpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 
 			NetSetTimeout(TIMEOUT, BootpTimeout);
 			DhcpSendRequestPkt(bp);
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+			{
+				IPaddr_t OfferedIP, ServerIP = NetServerIP;
+
+				NetCopyIP(&OfferedIP, &bp->bp_yiaddr);
+#if !defined(CONFIG_BOOTP_SERVERIP)
+				if (NetReadIP(&bp->bp_siaddr))
+					NetCopyIP(&ServerIP, &bp->bp_siaddr);
+#endif
+				/* Not the environment's, which may be stale */
+				DhcpPrefetchServer(OfferedIP, ServerIP,
+						   DhcpGetIPOption(bp, len, 1),
+						   DhcpGetIPOption(bp, len, 3));
+			}
+#endif
 #ifdef CONFIG_SYS_BOOTFILE_PREFIX
 		}
 #endif	/* CONFIG_SYS_BOOTFILE_PREFIX */
@@ -946,18 +1080,26 @@ DhcpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		debug("DHCP State: REQUESTING\n");
 
 		if ( DhcpMessageType((u8 *)bp->bp_vend) == DHCP_ACK ) {
-			if (NetReadLong((ulong*)&bp->bp_vend[0]) == htonl(BOOTP_VENDOR_MAGIC))
-				DhcpOptionsProcess((u8 *)&bp->bp_vend[4], bp);
-			BootpCopyNetParams(bp); /* Store net params from reply */
-			dhcp_state = BOUND;
-			printf ("DHCP client bound to address %pI4\n", &NetOurIP);
-			bootstage_mark_name(BOOTSTAGE_ID_BOOTP_STOP,
-					    "bootp_stop");
+			DhcpBound(bp);
+			return;
+		}
+		break;
+#ifdef CONFIG_BOOTP_LEASE_CACHE
+	case REBOOTING:
+		debug("DHCP State: REBOOTING\n");
 
-			net_auto_load();
+		switch (DhcpMessageType((u8 *)bp->bp_vend)) {
+		case DHCP_ACK:
+			DhcpBound(bp);
+			return;
+		case DHCP_NAK:
+			puts("DHCP lease refused, discovering\n");
+			setenv("dhcpleaseip", NULL);
+			BootpRequest();
 			return;
 		}
 		break;
+#endif
 	case BOUND:
 		/* DHCP client bound to address */
 		break;
@@ -970,6 +1112,10 @@ DhcpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 
 void DhcpRequest(void)
 {
+#ifdef CONFIG_BOOTP_LEASE_CACHE
+	if (DhcpLeaseRequest())
+		return;
+#endif
 	BootpRequest();
 }
 #endif	/* CONFIG_CMD_DHCP */
@@ -233,6 +233,10 @@ int eth_register(struct eth_device *dev)
 	dev->state = ETH_STATE_INIT;
 	dev->next  = eth_devices;
 	dev->index = index++;
+#ifdef CONFIG_NET_CSUM_OFFLOAD
+	/* Drivers which can offload set this after registering */
+	dev->csum_offload = 0;
+#endif
 
 	return 0;
 }
@@ -435,6 +439,9 @@ int eth_send(volatile void *packet, int length)
 	if (!eth_current)
 		return -1;
 
+	NetStats.tx_packets++;
+	NetStats.tx_bytes += length;
+
 	return eth_current->send(eth_current, packet, length);
 }
 
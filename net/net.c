@@ -171,6 +171,8 @@ uchar		NetCDPAddr[6] = { 0x01, 0x00, 0x0c, 0xcc, 0xcc, 0xcc };
 int		NetState;
 /* Tried all network devices */
 int		NetRestartWrap;
+/* Traffic counters */
+struct net_stats NetStats;
 /* Network loop restarted */
 static int	NetRestarted;
 /* At least one device configured */
@@ -229,6 +231,29 @@ volatile uchar *NetTxPacket;
 
 static int net_check_prereq(enum proto_t protocol);
 
+#ifdef CONFIG_NET_CSUM_OFFLOAD
+/* Does the current device do this IP checksum work in hardware? */
+static inline int net_csum_offloaded(int flag)
+{
+	struct eth_device *dev = eth_get_dev();
+
+	return dev && (dev->csum_offload & flag);
+}
+#else
+static inline int net_csum_offloaded(int flag)
+{
+	return 0;
+}
+#endif
+
+/* Fill in the header checksum of an outgoing IP packet */
+static inline void NetSetIPCksum(IP_t *ip)
+{
+	ip->ip_sum = 0;
+	if (!net_csum_offloaded(ETH_CSUM_TX_IP))
+		ip->ip_sum = ~NetCksum((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2);
+}
+
 static int NetTryCount;
 
 /**********************************************************************/
@@ -244,13 +269,11 @@ uchar		NetArpWaitPacketBuf[PKTSIZE_ALIGN + PKTALIGN];
 ulong		NetArpWaitTimerStart;
 int		NetArpWaitTry;
 
-void ArpRequest(void)
+static void ArpSendRequest(IPaddr_t target)
 {
 	volatile uchar *pkt;
 	ARP_t *arp;
 
-	debug("ARP broadcast %d\n", NetArpWaitTry);
-
 	pkt = NetTxPacket;
 
 	pkt += NetSetEther(pkt, NetBcastAddr, PROT_ARP);
@@ -269,6 +292,14 @@ void ArpRequest(void)
 	NetWriteIP((uchar *) &arp->ar_data[6], NetOurIP);
 	/* dest ET addr = 0 */
 	memset(&arp->ar_data[10], '\0', 6);
+	NetWriteIP((uchar *) &arp->ar_data[16], target);
+	(void) eth_send(NetTxPacket, (pkt - NetTxPacket) + ARP_HDR_SIZE);
+}
+
+void ArpRequest(void)
+{
+	debug("ARP broadcast %d\n", NetArpWaitTry);
+
 	if ((NetArpWaitPacketIP & NetOurSubnetMask) !=
 	    (NetOurIP & NetOurSubnetMask)) {
 		if (NetOurGatewayIP == 0) {
@@ -281,9 +312,95 @@ void ArpRequest(void)
 		NetArpWaitReplyIP = NetArpWaitPacketIP;
 	}
 
-	NetWriteIP((uchar *) &arp->ar_data[16], NetArpWaitReplyIP);
-	(void) eth_send(NetTxPacket, (pkt - NetTxPacket) + ARP_HDR_SIZE);
+	ArpSendRequest(NetArpWaitReplyIP);
+}
+
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+/*
+ * A handful of IP to MAC translations learnt from ARP replies, so that
+ * addresses resolved while DHCP is still in flight don't need another
+ * round trip once the transfer starts. Only the server and the gateway
+ * are ever looked up, so the oldest entry is simply replaced when full.
+ */
+#define ARP_CACHE_SIZE	4
+
+static struct {
+	IPaddr_t ip;
+	uchar ether[6];
+} ArpCache[ARP_CACHE_SIZE];
+static int ArpCacheNext;
+static struct eth_device *ArpCacheDev;	/* device the entries were seen on */
+static IPaddr_t ArpCacheIP;		/* our IP when they were, if known */
+
+/*
+ * Forget the cache if we have moved to another device or IP address
+ * since it was filled. Entries learnt before we had an address (during
+ * DHCP) are kept once we get one.
+ */
+static void ArpCacheCheck(void)
+{
+	struct eth_device *dev = eth_get_dev();
+
+	if (dev != ArpCacheDev || (ArpCacheIP && NetOurIP != ArpCacheIP)) {
+		memset(ArpCache, 0, sizeof(ArpCache));
+		ArpCacheNext = 0;
+		ArpCacheDev = dev;
+		ArpCacheIP = 0;
+	}
+	if (NetOurIP)
+		ArpCacheIP = NetOurIP;
+}
+
+static void ArpCacheAdd(IPaddr_t ip, const uchar *ether)
+{
+	int i;
+
+	if (ip == 0 || ip == 0xFFFFFFFF)
+		return;
+
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		if (ArpCache[i].ip == ip) {
+			memcpy(ArpCache[i].ether, ether, 6);
+			return;
+		}
+	}
+
+	ArpCache[ArpCacheNext].ip = ip;
+	memcpy(ArpCache[ArpCacheNext].ether, ether, 6);
+	ArpCacheNext = (ArpCacheNext + 1) % ARP_CACHE_SIZE;
+}
+
+static int ArpCacheLookup(IPaddr_t ip, uchar *ether)
+{
+	int i;
+
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		if (ip != 0 && ArpCache[i].ip == ip) {
+			memcpy(ether, ArpCache[i].ether, 6);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Send an ARP request for 'ip' without queueing a packet behind it. The
+ * reply, if any, is only entered in the cache. This may be called before
+ * we have an IP address, in which case an ARP probe (sender IP 0) goes
+ * out instead.
+ */
+void ArpPrefetch(IPaddr_t ip)
+{
+	uchar ether[6];
+
+	if (ip == 0 || ip == 0xFFFFFFFF || ArpCacheLookup(ip, ether))
+		return;
+
+	debug("ARP prefetch %pI4\n", &ip);
+	ArpSendRequest(ip);
 }
+#endif
 
 void ArpTimeoutCheck(void)
 {
@@ -421,6 +538,9 @@ restart:
 	 *	packets and timer events.
 	 */
 	NetInitLoop(protocol);
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+	ArpCacheCheck();
+#endif
 
 	switch (net_check_prereq(protocol)) {
 	case 1:
@@ -727,6 +847,16 @@ NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
 	 * if MAC address was not discovered yet, save the packet and do
 	 * an ARP request
 	 */
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+	if (memcmp(ether, NetEtherNullAddr, 6) == 0) {
+		IPaddr_t hop = dest;
+
+		if (NetOurGatewayIP && (dest & NetOurSubnetMask) !=
+		    (NetOurIP & NetOurSubnetMask))
+			hop = NetOurGatewayIP;
+		ArpCacheLookup(hop, ether);
+	}
+#endif
 	if (memcmp(ether, NetEtherNullAddr, 6) == 0) {
 
 		debug("sending ARP for %08x\n", dest);
@@ -803,7 +933,7 @@ int PingSend(void)
 	NetCopyIP((void *)&ip->ip_src, &NetOurIP);
 	/* - "" - */
 	NetCopyIP((void *)&ip->ip_dst, &NetPingIP);
-	ip->ip_sum   = ~NetCksum((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2);
+	NetSetIPCksum((IP_t *)ip);
 
 	s = &ip->udp_src;		/* XXX ICMP starts here */
 	s[0] = htons(0x0800);		/* echo-request, code */
@@ -1416,8 +1546,7 @@ static void receive_icmp(IP_t *ip, int len, IPaddr_t src_ip, Ethernet_t *et)
 		ip->ip_off = 0;
 		NetCopyIP((void *)&ip->ip_dst, &ip->ip_src);
 		NetCopyIP((void *)&ip->ip_src, &NetOurIP);
-		ip->ip_sum = ~NetCksum((uchar *)ip,
-					IP_HDR_SIZE_NO_UDP >> 1);
+		NetSetIPCksum(ip);
 
 		icmph->type = ICMP_ECHO_REPLY;
 		icmph->checksum = 0;
@@ -1459,6 +1588,9 @@ NetReceive(volatile uchar *inpkt, int len)
 	NetRxPacketLen = len;
 	et = (Ethernet_t *)inpkt;
 
+	NetStats.rx_packets++;
+	NetStats.rx_bytes += len;
+
 	/* too small packet? */
 	if (len < ETHER_HDR_SIZE)
 		return;
@@ -1569,6 +1701,19 @@ NetReceive(volatile uchar *inpkt, int len)
 		if (arp->ar_pln != 4)
 			return;
 
+#ifdef CONFIG_BOOTP_ARP_PREFETCH
+		/*
+		 * Replies to our prefetch requests may arrive before we have
+		 * an address, addressed to the 0.0.0.0 of an ARP probe.
+		 */
+		if (ntohs(arp->ar_op) == ARPOP_REPLY &&
+		    memcmp(&arp->ar_data[10], NetOurEther, 6) == 0 &&
+		    (NetReadIP(&arp->ar_data[16]) == NetOurIP ||
+		     NetReadIP(&arp->ar_data[16]) == 0))
+			ArpCacheAdd(NetReadIP(&arp->ar_data[6]),
+				    &arp->ar_data[0]);
+#endif
+
 		if (NetOurIP == 0)
 			return;
 
@@ -1684,7 +1829,8 @@ NetReceive(volatile uchar *inpkt, int len)
 		if ((ip->ip_hl_v & 0x0f) > 0x05)
 			return;
 		/* Check the Checksum of the header */
-		if (!NetCksumOk((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2)) {
+		if (!net_csum_offloaded(ETH_CSUM_RX_IP) &&
+		    !NetCksumOk((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2)) {
 			puts("checksum bad\n");
 			return;
 		}
@@ -1890,15 +2036,44 @@ NetCksumOk(uchar *ptr, int len)
 }
 
 
+/*
+ * Compute the 16-bit one's complement sum of 'len' 16-bit words.
+ *
+ * The sum is independent of the order in which the words are added, so
+ * we sum 32 bits at a time into a 64-bit accumulator and fold the
+ * carries back in at the end.  The buffer only needs to be 16-bit
+ * aligned (IP headers usually sit 14 bytes into a frame).
+ */
 unsigned
 NetCksum(uchar *ptr, int len)
 {
-	ulong	xsum;
-	ushort *p = (ushort *)ptr;
+	const ushort *p = (const ushort *)ptr;
+	const u32 *w;
+	u64	xsum = 0;
 
-	xsum = 0;
-	while (len-- > 0)
+	if (len > 0 && ((ulong)p & 2)) {
 		xsum += *p++;
+		len--;
+	}
+
+	w = (const u32 *)p;
+	while (len >= 8) {
+		xsum += w[0];
+		xsum += w[1];
+		xsum += w[2];
+		xsum += w[3];
+		w += 4;
+		len -= 8;
+	}
+	while (len >= 2) {
+		xsum += *w++;
+		len -= 2;
+	}
+	if (len > 0)
+		xsum += *(const ushort *)w;
+
+	xsum = (xsum & 0xffffffff) + (xsum >> 32);
+	xsum = (xsum & 0xffffffff) + (xsum >> 32);
 	xsum = (xsum & 0xffff) + (xsum >> 16);
 	xsum = (xsum & 0xffff) + (xsum >> 16);
 	return xsum & 0xffff;
@@ -1976,7 +2151,7 @@ NetSetIP(volatile uchar *xip, IPaddr_t dest, int dport, int sport, int len)
 	ip->udp_dst  = htons(dport);
 	ip->udp_len  = htons(8 + len);
 	ip->udp_xsum = 0;
-	ip->ip_sum   = ~NetCksum((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2);
+	NetSetIPCksum(ip);
 }
 
 void copy_filename(char *dst, const char *src, int size)
@@ -575,6 +575,7 @@ NfsTimeout (void)
 	} else {
 		puts("T ");
 		NetSetTimeout (NFS_TIMEOUT, NfsTimeout);
+		NetStats.retransmits++;
 		NfsSend ();
 	}
 }
@@ -678,8 +678,10 @@ TftpTimeout(void)
 	} else {
 		puts("T ");
 		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
-		if (TftpState != STATE_RECV_WRQ)
+		if (TftpState != STATE_RECV_WRQ) {
+			NetStats.retransmits++;
 			TftpSend();
+		}
 	}
 }
 
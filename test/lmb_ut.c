@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/* Define this to make sure that our assert()s will activate */
+#define DEBUG
+
+#include <common.h>
+#include <command.h>
+#include <lmb.h>
+
+#define RAM_BASE	0x40000000
+#define RAM_SIZE	0x10000000
+
+#define TESTEQ(a, b)						\
+	if ((a) != (b)) {					\
+		debug("Failure at %s:%d: %s, %#lx != %#lx\n",	\
+		      __func__, __LINE__, #a " != " #b,		\
+		      (ulong)(a), (ulong)(b));			\
+		return -1;					\
+	}
+
+/* Check that a region has the given base and size */
+#define TEST_REGION(rgn, i, b, s)				\
+	TESTEQ((rgn)->region[i].base, b);			\
+	TESTEQ((rgn)->region[i].size, s);
+
+static int lmb_test_reserve(struct lmb *lmb)
+{
+	struct lmb_region *res = &lmb->reserved;
+	int i;
+
+	/* More regions than fit in the initial table */
+	for (i = 0; i < MAX_LMB_REGIONS * 4; i++)
+		TESTEQ(lmb_reserve(lmb, RAM_BASE + i * 0x10000, 0x1000), 0);
+	TESTEQ(res->cnt, MAX_LMB_REGIONS * 4);
+	TESTEQ(res->size, MAX_LMB_REGIONS * 4 * 0x1000);
+	for (i = 1; i < res->cnt; i++)
+		TESTEQ(res->region[i - 1].base < res->region[i].base, 1);
+
+	TESTEQ(lmb_is_reserved(lmb, RAM_BASE + 0x20fff), 1);
+	TESTEQ(lmb_is_reserved(lmb, RAM_BASE + 0x21000), 0);
+	TESTEQ(lmb_overlaps_region(res, RAM_BASE + 0x1f000, 0x2000), 2);
+	TESTEQ(lmb_overlaps_region(res, RAM_BASE + 0x1000, 0xf000), -1);
+
+	/* Touching regions are merged, on either side */
+	TESTEQ(lmb_reserve(lmb, RAM_BASE + 0x1000, 0x1000), 0);
+	TESTEQ(lmb_reserve(lmb, RAM_BASE + 0xf000, 0x1000), 0);
+	TESTEQ(res->cnt, MAX_LMB_REGIONS * 4);
+	TEST_REGION(res, 0, RAM_BASE, 0x2000);
+	TEST_REGION(res, 1, RAM_BASE + 0xf000, 0x2000);
+
+	/* One region covering several merges them all */
+	TESTEQ(lmb_reserve(lmb, RAM_BASE + 0x800, 0x30000), 0);
+	TESTEQ(res->cnt, MAX_LMB_REGIONS * 4 - 3);
+	TEST_REGION(res, 0, RAM_BASE, 0x31000);
+	TEST_REGION(res, 1, RAM_BASE + 0x40000, 0x1000);
+
+	/* Free from the front, the end and the middle of a region */
+	TESTEQ(lmb_free(lmb, RAM_BASE, 0x1000), 0);
+	TESTEQ(lmb_free(lmb, RAM_BASE + 0x30000, 0x1000), 0);
+	TESTEQ(lmb_free(lmb, RAM_BASE + 0x10000, 0x1000), 0);
+	TEST_REGION(res, 0, RAM_BASE + 0x1000, 0xf000);
+	TEST_REGION(res, 1, RAM_BASE + 0x11000, 0x1f000);
+	TESTEQ(lmb_is_reserved(lmb, RAM_BASE + 0x10800), 0);
+
+	/* Free a whole region, and one that is not reserved */
+	TESTEQ(lmb_free(lmb, RAM_BASE + 0x40000, 0x1000), 0);
+	TESTEQ(lmb_is_reserved(lmb, RAM_BASE + 0x40000), 0);
+	TESTEQ(lmb_free(lmb, RAM_BASE + 0x40000, 0x1000), -1);
+	TESTEQ(lmb_free(lmb, RAM_BASE + 0xf000, 0x3000), -1);
+
+	return 0;
+}
+
+static int lmb_test_alloc(struct lmb *lmb)
+{
+	phys_addr_t addr;
+
+	/* Allocations come from the top, aligned */
+	addr = lmb_alloc(lmb, 0x1800, 0x1000);
+	TESTEQ(addr, RAM_BASE + RAM_SIZE - 0x2000);
+	TESTEQ(lmb_is_reserved(lmb, addr + 0x1fff), 1);
+	addr = lmb_alloc(lmb, 0x100, 0x100);
+	TESTEQ(addr, RAM_BASE + RAM_SIZE - 0x2100);
+
+	/* Below a limit, skipping over what is reserved there */
+	lmb_reserve(lmb, RAM_BASE + 0x800000, 0x100000);
+	addr = lmb_alloc_base(lmb, 0x200000, 0x1000, RAM_BASE + 0x880000);
+	TESTEQ(addr, RAM_BASE + 0x600000);
+
+	/* Too big to fit anywhere */
+	TESTEQ(__lmb_alloc_base(lmb, RAM_SIZE, 0x1000, 0), 0);
+
+	/* Best fit takes the smallest gap that is big enough */
+	lmb_reserve(lmb, RAM_BASE + 0x1000000, 0x1000);
+	lmb_reserve(lmb, RAM_BASE + 0x1003000, 0x1000);
+	lmb_reserve(lmb, RAM_BASE + 0x2000000, 0x1000);
+	lmb_reserve(lmb, RAM_BASE + 0x2009000, 0x1000);
+	addr = lmb_alloc_best_fit(lmb, 0x2000, 0x1000, 0);
+	TESTEQ(addr, RAM_BASE + 0x1001000);
+	addr = lmb_alloc_best_fit(lmb, 0x3000, 0x4000, 0);
+	TESTEQ(addr, RAM_BASE + 0x2004000);
+	TESTEQ(lmb_is_reserved(lmb, RAM_BASE + 0x2003fff), 0);
+	TESTEQ(lmb_alloc_best_fit(lmb, RAM_SIZE, 0x1000, 0), 0);
+
+	return 0;
+}
+
+static int do_ut_lmb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct lmb lmb;
+	int err;
+
+	printf("%s: Testing logical memory blocks\n", __func__);
+	lmb_init(&lmb);
+	lmb_add(&lmb, RAM_BASE, RAM_SIZE);
+	err = lmb_test_reserve(&lmb);
+	lmb_release(&lmb);
+
+	if (!err) {
+		lmb_init(&lmb);
+		lmb_add(&lmb, RAM_BASE, RAM_SIZE);
+		err = lmb_test_alloc(&lmb);
+		lmb_release(&lmb);
+	}
+	printf("%s\n", err ? "FAILED" : "PASSED");
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_lmb,	5,	1,	do_ut_lmb,
+	"Unit test of logical memory blocks",
+	""
+);
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2012 The Chromium OS Authors.
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/* Define this to make sure that our assert()s will activate */
+#define DEBUG
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <spi.h>
+#include <spi_flash.h>
+
+#ifndef CONFIG_SF_DEFAULT_SPEED
+# define CONFIG_SF_DEFAULT_SPEED	1000000
+#endif
+#ifndef CONFIG_SF_DEFAULT_MODE
+# define CONFIG_SF_DEFAULT_MODE		SPI_MODE_3
+#endif
+
+/* Above the first 16 MiB, so only 4-byte address commands reach it */
+#define TEST_BASE	0x1000000
+#define TEST_SIZE	0x20000
+
+#define TESTEQ(a, b)						\
+	if ((a) != (b)) {					\
+		debug("Failure at %s:%d: %s, %#lx != %#lx\n",	\
+		      __func__, __LINE__, #a " != " #b,		\
+		      (ulong)(a), (ulong)(b));			\
+		return -1;					\
+	}
+
+/* Check that [start, end) of the test area reads as val */
+static int sf_test_check(const u8 *buf, ulong start, ulong end, u8 val)
+{
+	ulong i;
+
+	for (i = start; i < end; i++)
+		TESTEQ(buf[i], val);
+
+	return 0;
+}
+
+/*
+ * Fill the test area with zeros, erase [start, end) of it and check that
+ * exactly that range was erased.
+ */
+static int sf_test_erase(struct spi_flash *flash, u8 *buf, ulong start,
+			 ulong end)
+{
+	memset(buf, '\0', TEST_SIZE);
+	TESTEQ(spi_flash_erase(flash, TEST_BASE, TEST_SIZE), 0);
+	TESTEQ(spi_flash_write(flash, TEST_BASE, TEST_SIZE, buf), 0);
+
+	TESTEQ(spi_flash_erase(flash, TEST_BASE + start, end - start), 0);
+	TESTEQ(spi_flash_read(flash, TEST_BASE, TEST_SIZE, buf), 0);
+	if (sf_test_check(buf, 0, start, 0) ||
+	    sf_test_check(buf, start, end, 0xff) ||
+	    sf_test_check(buf, end, TEST_SIZE, 0))
+		return -1;
+
+	return 0;
+}
+
+/*
+ * The W25Q256 offers a 32K erase (52h) but has no 4-byte form of it, and
+ * the sandbox-daemon ignores 5Ch for it as the part does. Erases of
+ * 32K-aligned ranges must still clear every byte.
+ */
+static int sf_test(struct spi_flash *flash, u8 *buf)
+{
+	int i, has_32k = 0;
+
+	TESTEQ(flash->addr_width, 4);
+	TESTEQ(flash->erase_4b & SPI_FLASH_ERASE_4B_32K, 0);
+	for (i = 0; i < SPI_FLASH_ERASE_TYPES; i++)
+		if (flash->erase_shift[i] == 15)
+			has_32k = 1;
+	TESTEQ(has_32k, 1);
+
+	/* 32K-aligned, once at a 64K boundary and once between two */
+	if (sf_test_erase(flash, buf, 0x8000, 0x10000) ||
+	    sf_test_erase(flash, buf, 0x8000, 0x18000))
+		return -1;
+
+	/* Whole 64K blocks, and a range starting within a sector */
+	if (sf_test_erase(flash, buf, 0, TEST_SIZE) ||
+	    sf_test_erase(flash, buf, 0x1000, 0x19000))
+		return -1;
+
+	return 0;
+}
+
+static int do_ut_sf(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct spi_flash *flash;
+	u8 *buf;
+	int err = -1;
+
+	printf("%s: Testing SPI flash erase on a W25Q256\n", __func__);
+	flash = spi_flash_probe(0, 0, CONFIG_SF_DEFAULT_SPEED,
+				CONFIG_SF_DEFAULT_MODE);
+	buf = malloc(TEST_SIZE);
+	if (!flash || strcmp(flash->name, "W25Q256")) {
+		printf("Needs sandbox-daemon --spi-id 0xef4019 "
+		       "--spi-page-size 256 --spi-page-count 131072\n");
+	} else if (buf) {
+		err = sf_test(flash, buf);
+	}
+	free(buf);
+	if (flash)
+		spi_flash_free(flash);
+	printf("%s\n", err ? "FAILED" : "PASSED");
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_sf,	5,	1,	do_ut_sf,
+	"Unit test of SPI flash erase",
+	""
+);
@@ -33,6 +33,9 @@
 
 static image_header_t header;
 
+/* Room for the properties which replace data when it is made external */
+#define FIT_EXTRA_SPACE		0x10000
+
 static int fit_verify_header (unsigned char *ptr, int image_size,
 			struct mkimage_params *params)
 {
@@ -47,6 +50,104 @@ static int fit_check_image_types (uint8_t type)
 		return EXIT_FAILURE;
 }
 
+/**
+ * fit_extract_data - move image data out of the FIT blob
+ * @params: mkimage parameters
+ * @tfd: file descriptor of the FIT image
+ * @fit: FIT image contents
+ * @size: FIT image size
+ *
+ * fit_extract_data() replaces the data property of each image with
+ * data-offset and data-size properties, and writes the data after the
+ * blob. A loader can then read the small blob and only the images it
+ * needs. FDT images also get a copy of their root compatible property,
+ * so that a configuration can be chosen without reading them.
+ *
+ * returns:
+ *     0, on success
+ *     -1, on failure
+ */
+static int fit_extract_data(struct mkimage_params *params, int tfd,
+			    const void *fit, size_t size)
+{
+	int images_noffset, noffset, ndepth;
+	uint8_t pad[4] = { 0 };
+	void *buf, *data;
+	size_t data_size = 0;
+	ulong base;
+	int ret = -1;
+	int err;
+
+	buf = malloc(size + FIT_EXTRA_SPACE);
+	data = calloc(1, size);
+	if (!buf || !data) {
+		fprintf(stderr, "%s: Out of memory\n", params->cmdname);
+		goto out;
+	}
+
+	err = fdt_open_into(fit, buf, size + FIT_EXTRA_SPACE);
+	images_noffset = err ? err : fdt_path_offset(buf, FIT_IMAGES_PATH);
+	for (ndepth = 0,
+	     noffset = fdt_next_node(buf, images_noffset, &ndepth);
+	     !err && (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node(buf, noffset, &ndepth)) {
+		const void *prop;
+		int len, compat_len;
+
+		if (ndepth != 1)
+			continue;
+		prop = fdt_getprop(buf, noffset, FIT_DATA_PROP, &len);
+		if (!prop)
+			continue;
+		memcpy(data + data_size, prop, len);
+
+		err = fdt_delprop(buf, noffset, FIT_DATA_PROP);
+		if (!err)
+			err = fdt_setprop_cell(buf, noffset,
+					       FIT_DATA_OFFSET_PROP, data_size);
+		if (!err)
+			err = fdt_setprop_cell(buf, noffset,
+					       FIT_DATA_SIZE_PROP, len);
+		if (!err && fit_image_check_type(buf, noffset,
+						 IH_TYPE_FLATDT) &&
+		    !fdt_check_header(data + data_size)) {
+			prop = fdt_getprop(data + data_size, 0,
+					   FIT_COMPAT_PROP, &compat_len);
+			if (prop)
+				err = fdt_setprop(buf, noffset,
+						  FIT_COMPAT_PROP, prop,
+						  compat_len);
+		}
+		data_size += (len + 3) & ~3;
+	}
+	if (!err)
+		err = fdt_pack(buf);
+	if (err) {
+		fprintf(stderr, "%s: Can't move image data out of FIT: %s\n",
+			params->cmdname, fdt_strerror(err));
+		goto out;
+	}
+
+	base = fit_get_data_base(buf);
+	if (lseek(tfd, 0, SEEK_SET) != 0 ||
+	    write(tfd, buf, fdt_totalsize(buf)) != fdt_totalsize(buf) ||
+	    write(tfd, pad, base - fdt_totalsize(buf)) !=
+			base - fdt_totalsize(buf) ||
+	    write(tfd, data, data_size) != data_size ||
+	    ftruncate(tfd, base + data_size)) {
+		fprintf(stderr, "%s: Can't write FIT image: %s\n",
+			params->cmdname, strerror(errno));
+		goto out;
+	}
+	debug("Moved 0x%zx bytes of image data after the FIT blob\n",
+	      data_size);
+	ret = 0;
+out:
+	free(data);
+	free(buf);
+	return ret;
+}
+
 /**
  * fit_handle_file - main FIT file processing function
  *
@@ -141,6 +242,12 @@ static int fit_handle_file (struct mkimage_params *params)
 	}
 	debug ("Added timestamp successfully\n");
 
+	if (params->external_data &&
+	    fit_extract_data(params, tfd, ptr, sbuf.st_size)) {
+		unlink (tmpfile);
+		return (EXIT_FAILURE);
+	}
+
 	munmap ((void *)ptr, sbuf.st_size);
 	close (tfd);
 
@@ -222,6 +222,9 @@ main (int argc, char **argv)
 				params.datafile = *++argv;
 				params.dflag = 1;
 				goto NXTARG;
+			case 'E':
+				params.external_data = 1;
+				break;
 			case 'e':
 				if (--argc <= 0)
 					usage ();
@@ -608,7 +611,8 @@ usage ()
 			 "          -d ==> use image data from 'datafile'\n"
 			 "          -x ==> set XIP (execute in place)\n",
 		params.cmdname);
-	fprintf (stderr, "       %s [-D dtc_options] -f fit-image.its fit-image\n",
+	fprintf (stderr, "       %s [-D dtc_options] [-E] -f fit-image.its fit-image\n"
+			 "          -E ==> place image data after the FIT structure\n",
 		params.cmdname);
 	fprintf (stderr, "       %s -V ==> print version information and exit\n",
 		params.cmdname);